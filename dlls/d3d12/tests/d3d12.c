@@ -1545,6 +1545,88 @@ static void test_invalid_command_queue_types(void)
     ok(!refcount, "Device has %lu references left.\n", refcount);
 }
 
+static void run_child_process(const char *test_name)
+{
+    STARTUPINFOA startup = {sizeof(startup)};
+    PROCESS_INFORMATION info;
+    char cmdline[MAX_PATH + 32];
+    char **argv;
+    BOOL ret;
+
+    winetest_get_mainargs(&argv);
+    sprintf(cmdline, "\"%s\" d3d12 %s", argv[0], test_name);
+    ret = CreateProcessA(NULL, cmdline, NULL, NULL, FALSE, 0, NULL, NULL, &startup, &info);
+    ok(ret, "Failed to create process, error %lu.\n", GetLastError());
+    if (!ret)
+        return;
+    wait_child_process(&info);
+    CloseHandle(info.hProcess);
+    CloseHandle(info.hThread);
+}
+
+static void test_shader_cache(void)
+{
+    char temp_path[MAX_PATH], cache_dir[MAX_PATH], cache_file[MAX_PATH + 32];
+    WIN32_FILE_ATTRIBUTE_DATA attr;
+    DWORD size, written;
+    HANDLE file;
+    BYTE *data;
+    BOOL ret;
+
+    if (!winetest_platform_is_wine)
+    {
+        skip("The shader cache is specific to vkd3d.\n");
+        return;
+    }
+
+    GetTempPathA(ARRAY_SIZE(temp_path), temp_path);
+    GetTempFileNameA(temp_path, "vsc", 0, cache_dir);
+    DeleteFileA(cache_dir);
+    ret = CreateDirectoryA(cache_dir, NULL);
+    ok(ret, "Failed to create directory, error %lu.\n", GetLastError());
+    sprintf(cache_file, "%s\\vkd3d-shader-cache.bin", cache_dir);
+    SetEnvironmentVariableA("VKD3D_SHADER_CACHE_PATH", cache_dir);
+
+    /* The child process draws, and checks the result. This run fills the cache. */
+    run_child_process("shader_cache");
+    if (!GetFileAttributesExA(cache_file, GetFileExInfoStandard, &attr))
+    {
+        skip("The shader cache was not created.\n");
+        goto done;
+    }
+    size = attr.nFileSizeLow;
+    ok(size, "Got empty cache file.\n");
+
+    /* This run takes the shaders from the cache. */
+    run_child_process("shader_cache");
+    ret = GetFileAttributesExA(cache_file, GetFileExInfoStandard, &attr);
+    ok(ret, "Failed to get file attributes, error %lu.\n", GetLastError());
+    ok(attr.nFileSizeLow == size, "Got size %lu, expected %lu.\n", attr.nFileSizeLow, size);
+
+    /*
+     * Overwrite everything but the first page, which holds the header, so
+     * that the index and the entries are checked instead of the whole file
+     * being reinitialised.
+     */
+    file = CreateFileA(cache_file, GENERIC_WRITE, 0, NULL, OPEN_EXISTING, 0, NULL);
+    ok(file != INVALID_HANDLE_VALUE, "Failed to open file, error %lu.\n", GetLastError());
+    data = malloc(size);
+    memset(data, 0xff, size);
+    SetFilePointer(file, 4096, NULL, FILE_BEGIN);
+    ret = WriteFile(file, data, size - 4096, &written, NULL);
+    ok(ret && written == size - 4096, "Failed to write file, error %lu.\n", GetLastError());
+    CloseHandle(file);
+    free(data);
+
+    run_child_process("shader_cache");
+    run_child_process("shader_cache");
+
+done:
+    SetEnvironmentVariableA("VKD3D_SHADER_CACHE_PATH", NULL);
+    DeleteFileA(cache_file);
+    RemoveDirectoryA(cache_dir);
+}
+
 START_TEST(d3d12)
 {
     BOOL enable_debug_layer = FALSE;
@@ -1553,6 +1635,12 @@ START_TEST(d3d12)
     char **argv;
 
     argc = winetest_get_mainargs(&argv);
+    if (argc >= 3 && !strcmp(argv[2], "shader_cache"))
+    {
+        test_draw();
+        return;
+    }
+
     for (i = 2; i < argc; ++i)
     {
         if (!strcmp(argv[i], "--validate"))
@@ -1581,4 +1669,5 @@ START_TEST(d3d12)
     test_swapchain_backbuffer_index();
     test_desktop_window();
     test_invalid_command_queue_types();
+    test_shader_cache();
 }
@@ -22,6 +22,8 @@
 #define COBJMACROS
 #include "d3dcompiler.h"
 #include "d3d11.h"
+#define VKD3D_SHADER_NO_PROTOTYPES
+#include "vkd3d_shader.h"
 #include "wine/test.h"
 
 static HRESULT (WINAPI *pD3D11CreateDevice)(IDXGIAdapter *adapter, D3D_DRIVER_TYPE driver_type,
@@ -1164,6 +1166,224 @@ static void test_semantic_reflection(void)
     }
 }
 
+#define PARALLEL_COMPILE_COUNT 64
+
+struct parallel_compile
+{
+    ID3D10Blob *blobs[PARALLEL_COMPILE_COUNT];
+    LONG next;
+};
+
+static DWORD WINAPI parallel_compile_thread(void *arg)
+{
+    static const char ps_source[] =
+        "float4 main(float4 pos : SV_POSITION, float2 t : TEXCOORD) : SV_TARGET\n"
+        "{\n"
+        "    float4 ret = float4(t, VARIANT / 64.0, 1.0);\n"
+        "    int i;\n"
+        "\n"
+        "#if VARIANT & 1\n"
+        "    ret = ret.wzyx;\n"
+        "#endif\n"
+        "    for (i = 0; i < (VARIANT & 6) + 1; ++i)\n"
+        "        ret = ret * ret + sin(ret * i);\n"
+        "#if VARIANT & 8\n"
+        "    ret = normalize(ret);\n"
+        "#endif\n"
+        "#if VARIANT & 16\n"
+        "    if (ret.x > 0.5)\n"
+        "        ret = 1.0 - ret;\n"
+        "#endif\n"
+        "#if VARIANT & 32\n"
+        "    ret = lerp(ret, ret.yzwx, 0.25);\n"
+        "#endif\n"
+        "    return ret;\n"
+        "}";
+    struct parallel_compile *compile = arg;
+    char variant[16];
+    const D3D_SHADER_MACRO macros[] =
+    {
+        {"VARIANT", variant},
+        {NULL, NULL},
+    };
+    LONG i;
+    HRESULT hr;
+
+    while ((i = InterlockedIncrement(&compile->next) - 1) < PARALLEL_COMPILE_COUNT)
+    {
+        sprintf(variant, "%ld", i);
+        hr = D3DCompile(ps_source, strlen(ps_source), NULL, macros, NULL, "main", "ps_4_0", 0, 0,
+                &compile->blobs[i], NULL);
+        ok(hr == S_OK, "Variant %ld: Got unexpected hr %#lx.\n", i, hr);
+    }
+
+    return 0;
+}
+
+/* Compiling different permutations of a shader concurrently must give the
+ * same results as compiling them one after the other. */
+static void test_parallel_compile(void)
+{
+    struct parallel_compile serial = {0}, parallel = {0};
+    DWORD serial_time, parallel_time;
+    HANDLE threads[4];
+    unsigned int i;
+
+    serial_time = GetTickCount();
+    parallel_compile_thread(&serial);
+    serial_time = GetTickCount() - serial_time;
+
+    parallel_time = GetTickCount();
+    for (i = 0; i < ARRAY_SIZE(threads); ++i)
+    {
+        threads[i] = CreateThread(NULL, 0, parallel_compile_thread, &parallel, 0, NULL);
+        ok(!!threads[i], "Failed to create thread, error %lu.\n", GetLastError());
+    }
+    for (i = 0; i < ARRAY_SIZE(threads); ++i)
+    {
+        WaitForSingleObject(threads[i], INFINITE);
+        CloseHandle(threads[i]);
+    }
+    parallel_time = GetTickCount() - parallel_time;
+
+    trace("Compiled %u shaders in %lu ms on one thread, %lu ms on %u threads.\n",
+            PARALLEL_COMPILE_COUNT, serial_time, parallel_time, (unsigned int)ARRAY_SIZE(threads));
+
+    for (i = 0; i < PARALLEL_COMPILE_COUNT; ++i)
+    {
+        winetest_push_context("Variant %u", i);
+        if (serial.blobs[i] && parallel.blobs[i])
+        {
+            ok(ID3D10Blob_GetBufferSize(serial.blobs[i]) == ID3D10Blob_GetBufferSize(parallel.blobs[i]),
+                    "Got size %Iu, expected %Iu.\n", ID3D10Blob_GetBufferSize(parallel.blobs[i]),
+                    ID3D10Blob_GetBufferSize(serial.blobs[i]));
+            if (ID3D10Blob_GetBufferSize(serial.blobs[i]) == ID3D10Blob_GetBufferSize(parallel.blobs[i]))
+                ok(!memcmp(ID3D10Blob_GetBufferPointer(serial.blobs[i]), ID3D10Blob_GetBufferPointer(parallel.blobs[i]),
+                        ID3D10Blob_GetBufferSize(serial.blobs[i])), "Shaders differ.\n");
+        }
+        if (serial.blobs[i])
+            ID3D10Blob_Release(serial.blobs[i]);
+        if (parallel.blobs[i])
+            ID3D10Blob_Release(parallel.blobs[i]);
+        winetest_pop_context();
+    }
+}
+
+#define BATCH_COMPILE_COUNT 16
+#define BATCH_COMPILE_INVALID 5
+
+/* vkd3d_shader_compile_batch() is exported by wined3d along with the rest of
+ * the bundled vkd3d-shader. */
+static void test_vkd3d_shader_compile_batch(void)
+{
+    static const char ps_source[] =
+        "float4 main() : SV_TARGET\n"
+        "{\n"
+        "    return float4(%u / 16.0, 0.0, 0.0, 1.0);\n"
+        "}\n";
+    static const char invalid_ps_source[] =
+        "float4 main() : SV_TARGET\n"
+        "{\n"
+        "    return undeclared;\n"
+        "}\n";
+    struct vkd3d_shader_hlsl_source_info hlsl_infos[BATCH_COMPILE_COUNT];
+    struct vkd3d_shader_compile_info infos[BATCH_COMPILE_COUNT];
+    PFN_vkd3d_shader_free_shader_code pvkd3d_shader_free_shader_code;
+    PFN_vkd3d_shader_compile_batch pvkd3d_shader_compile_batch;
+    PFN_vkd3d_shader_free_messages pvkd3d_shader_free_messages;
+    struct vkd3d_shader_code out[BATCH_COMPILE_COUNT], expected;
+    PFN_vkd3d_shader_compile pvkd3d_shader_compile;
+    char sources[BATCH_COMPILE_COUNT][128];
+    char *messages[BATCH_COMPILE_COUNT];
+    int results[BATCH_COMPILE_COUNT];
+    unsigned int i;
+    HMODULE module;
+    int ret;
+
+    if (!(module = LoadLibraryA("wined3d.dll")))
+    {
+        skip("wined3d is not available.\n");
+        return;
+    }
+    pvkd3d_shader_compile = (void *)GetProcAddress(module, "vkd3d_shader_compile");
+    pvkd3d_shader_compile_batch = (void *)GetProcAddress(module, "vkd3d_shader_compile_batch");
+    pvkd3d_shader_free_messages = (void *)GetProcAddress(module, "vkd3d_shader_free_messages");
+    pvkd3d_shader_free_shader_code = (void *)GetProcAddress(module, "vkd3d_shader_free_shader_code");
+    if (!pvkd3d_shader_compile_batch)
+    {
+        skip("vkd3d_shader_compile_batch() is not available.\n");
+        FreeLibrary(module);
+        return;
+    }
+
+    for (i = 0; i < BATCH_COMPILE_COUNT; ++i)
+    {
+        if (i == BATCH_COMPILE_INVALID)
+            strcpy(sources[i], invalid_ps_source);
+        else
+            sprintf(sources[i], ps_source, i);
+
+        memset(&hlsl_infos[i], 0, sizeof(hlsl_infos[i]));
+        hlsl_infos[i].type = VKD3D_SHADER_STRUCTURE_TYPE_HLSL_SOURCE_INFO;
+        hlsl_infos[i].entry_point = "main";
+        hlsl_infos[i].profile = "ps_4_0";
+
+        memset(&infos[i], 0, sizeof(infos[i]));
+        infos[i].type = VKD3D_SHADER_STRUCTURE_TYPE_COMPILE_INFO;
+        infos[i].next = &hlsl_infos[i];
+        infos[i].source.code = sources[i];
+        infos[i].source.size = strlen(sources[i]);
+        infos[i].source_type = VKD3D_SHADER_SOURCE_HLSL;
+        infos[i].target_type = VKD3D_SHADER_TARGET_DXBC_TPF;
+        infos[i].log_level = VKD3D_SHADER_LOG_ERROR;
+    }
+
+    ret = pvkd3d_shader_compile_batch(infos, 0, 0, NULL, NULL, NULL);
+    ok(ret == VKD3D_OK, "Got unexpected ret %d.\n", ret);
+
+    memset(out, 0, sizeof(out));
+    ret = pvkd3d_shader_compile_batch(infos, BATCH_COMPILE_COUNT, 4, out, messages, results);
+    ok(ret < 0, "Got unexpected ret %d.\n", ret);
+    ok(ret == results[BATCH_COMPILE_INVALID], "Got ret %d, expected %d.\n", ret, results[BATCH_COMPILE_INVALID]);
+    ok(messages[BATCH_COMPILE_INVALID] && *messages[BATCH_COMPILE_INVALID], "Expected messages.\n");
+
+    for (i = 0; i < BATCH_COMPILE_COUNT; ++i)
+    {
+        winetest_push_context("Shader %u", i);
+        pvkd3d_shader_free_messages(messages[i]);
+        if (i == BATCH_COMPILE_INVALID)
+        {
+            winetest_pop_context();
+            continue;
+        }
+
+        ok(results[i] == VKD3D_OK, "Got unexpected result %d.\n", results[i]);
+        ret = pvkd3d_shader_compile(&infos[i], &expected, NULL);
+        ok(ret == VKD3D_OK, "Got unexpected ret %d.\n", ret);
+        if (results[i] == VKD3D_OK && ret == VKD3D_OK)
+        {
+            ok(out[i].size == expected.size, "Got size %Iu, expected %Iu.\n", out[i].size, expected.size);
+            if (out[i].size == expected.size)
+                ok(!memcmp(out[i].code, expected.code, expected.size), "Shaders differ.\n");
+        }
+        pvkd3d_shader_free_shader_code(&expected);
+        pvkd3d_shader_free_shader_code(&out[i]);
+        winetest_pop_context();
+    }
+
+    /* The result of the first failure is returned without a results array as well. */
+    memset(out, 0, sizeof(out));
+    ret = pvkd3d_shader_compile_batch(infos, BATCH_COMPILE_COUNT, 4, out, NULL, NULL);
+    ok(ret == results[BATCH_COMPILE_INVALID], "Got ret %d, expected %d.\n", ret, results[BATCH_COMPILE_INVALID]);
+    for (i = 0; i < BATCH_COMPILE_COUNT; ++i)
+    {
+        if (i != BATCH_COMPILE_INVALID)
+            pvkd3d_shader_free_shader_code(&out[i]);
+    }
+
+    FreeLibrary(module);
+}
+
 #if D3D_COMPILER_VERSION >= 47
 
 static void test_D3DCreateLinker(void)
@@ -1203,6 +1423,8 @@ START_TEST(hlsl_d3d11)
 
     test_reflection();
     test_semantic_reflection();
+    test_parallel_compile();
+    test_vkd3d_shader_compile_batch();
 #if D3D_COMPILER_VERSION >= 47
     test_D3DCreateLinker();
     test_D3DCreateFunctionLinkingGraph();
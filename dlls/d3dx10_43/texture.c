@@ -145,6 +145,8 @@ static DXGI_FORMAT dxgi_format_from_d3dx_pixel_format_id(enum d3dx_pixel_format_
         case D3DX_PIXEL_FORMAT_B5G6R5_UNORM:
         case D3DX_PIXEL_FORMAT_B5G5R5A1_UNORM:
         case D3DX_PIXEL_FORMAT_B4G4R4A4_UNORM:
+        /* BC7 is newer than d3d10. */
+        case D3DX_PIXEL_FORMAT_BC7_UNORM:
             return DXGI_FORMAT_UNKNOWN;
 
         default:
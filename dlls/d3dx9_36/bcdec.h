@@ -92,10 +92,10 @@ BCDECDEF void bcdec_bc2(const void* compressedBlock, void* decompressedBlock, in
 BCDECDEF void bcdec_bc3(const void* compressedBlock, void* decompressedBlock, int destinationPitch);
 BCDECDEF void bcdec_bc4(const void* compressedBlock, void* decompressedBlock, int destinationPitch);
 BCDECDEF void bcdec_bc5(const void* compressedBlock, void* decompressedBlock, int destinationPitch);
+BCDECDEF void bcdec_bc7(const void* compressedBlock, void* decompressedBlock, int destinationPitch);
 #ifdef WINE_UNUSED  /* unused for now in Wine */
 BCDECDEF void bcdec_bc6h_float(const void* compressedBlock, void* decompressedBlock, int destinationPitch, int isSigned);
 BCDECDEF void bcdec_bc6h_half(const void* compressedBlock, void* decompressedBlock, int destinationPitch, int isSigned);
-BCDECDEF void bcdec_bc7(const void* compressedBlock, void* decompressedBlock, int destinationPitch);
 #endif  /* WINE_UNUSED */
 
 #endif /* BCDEC_HEADER_INCLUDED */
@@ -221,8 +221,6 @@ static void bcdec__smooth_alpha_block(const void* compressedBlock, void* decompr
     }
 }
 
-#ifdef WINE_UNUSED  /* unused for now in Wine */
-
 typedef struct bcdec__bitstream {
     unsigned long long low;
     unsigned long long high;
@@ -245,6 +243,8 @@ static int bcdec__bitstream_read_bit(bcdec__bitstream_t* bstream) {
     return bcdec__bitstream_read_bits(bstream, 1);
 }
 
+#ifdef WINE_UNUSED  /* unused for now in Wine */
+
 /*  reversed bits pulling, used in BC6H decoding
     why ?? just why ??? */
 static int bcdec__bitstream_read_bits_r(bcdec__bitstream_t* bstream, int numBits) {
@@ -340,10 +340,14 @@ static int bcdec__unquantize(int val, int bits, int isSigned) {
     return unq;
 }
 
+#endif  /* WINE_UNUSED */
+
 static int bcdec__interpolate(int a, int b, int* weights, int index) {
     return (a * (64 - weights[index]) + b * weights[index] + 32) >> 6;
 }
 
+#ifdef WINE_UNUSED  /* unused for now in Wine */
+
 static unsigned short bcdec__finish_unquantize(int val, int isSigned) {
     int s;
 
@@ -917,6 +921,8 @@ BCDECDEF void bcdec_bc6h_float(const void* compressedBlock, void* decompressedBl
     }
 }
 
+#endif  /* WINE_UNUSED */
+
 static void bcdec__swap_values(int* a, int* b) {
     a[0] ^= b[0], b[0] ^= a[0], a[0] ^= b[0];
 }
@@ -1274,8 +1280,6 @@ BCDECDEF void bcdec_bc7(const void* compressedBlock, void* decompressedBlock, in
     }
 }
 
-#endif  /* WINE_UNUSED */
-
 #endif /* BCDEC_IMPLEMENTATION */
 
 /* LICENSE:
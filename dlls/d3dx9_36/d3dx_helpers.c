@@ -31,6 +31,7 @@
 #define STB_DXT_STATIC
 #include "stb_dxt.h"
 #include <assert.h>
+#include <float.h>
 
 WINE_DEFAULT_DEBUG_CHANNEL(d3dx);
 
@@ -108,6 +109,7 @@ static const struct pixel_format_desc formats[] =
     {D3DX_PIXEL_FORMAT_BC4_SNORM,                { 0,  0,  0,  0}, { 0,  0,  0,  0},  1, 4, 4,  8, CTYPE_EMPTY, CTYPE_SNORM, FMT_FLAG_DXT|FMT_FLAG_DXGI},
     {D3DX_PIXEL_FORMAT_BC5_UNORM,                { 0,  0,  0,  0}, { 0,  0,  0,  0},  1, 4, 4, 16, CTYPE_EMPTY, CTYPE_UNORM, FMT_FLAG_DXT|FMT_FLAG_DXGI},
     {D3DX_PIXEL_FORMAT_BC5_SNORM,                { 0,  0,  0,  0}, { 0,  0,  0,  0},  1, 4, 4, 16, CTYPE_EMPTY, CTYPE_SNORM, FMT_FLAG_DXT|FMT_FLAG_DXGI},
+    {D3DX_PIXEL_FORMAT_BC7_UNORM,                { 0,  0,  0,  0}, { 0,  0,  0,  0},  1, 4, 4, 16, CTYPE_UNORM, CTYPE_UNORM, FMT_FLAG_DXT|FMT_FLAG_DXGI},
     {D3DX_PIXEL_FORMAT_R16_FLOAT,                { 0, 16,  0,  0}, { 0,  0,  0,  0},  2, 1, 1,  2, CTYPE_EMPTY, CTYPE_FLOAT, 0           },
     {D3DX_PIXEL_FORMAT_R16G16_FLOAT,             { 0, 16, 16,  0}, { 0,  0, 16,  0},  4, 1, 1,  4, CTYPE_EMPTY, CTYPE_FLOAT, 0           },
     {D3DX_PIXEL_FORMAT_R16G16B16A16_FLOAT,       {16, 16, 16, 16}, {48,  0, 16, 32},  8, 1, 1,  8, CTYPE_FLOAT, CTYPE_FLOAT, 0           },
@@ -427,6 +429,7 @@ enum d3dx_pixel_format_id d3dx_pixel_format_id_from_dxgi_format(uint32_t format)
         case DXGI_FORMAT_BC4_SNORM:                return D3DX_PIXEL_FORMAT_BC4_SNORM;
         case DXGI_FORMAT_BC5_UNORM:                return D3DX_PIXEL_FORMAT_BC5_UNORM;
         case DXGI_FORMAT_BC5_SNORM:                return D3DX_PIXEL_FORMAT_BC5_SNORM;
+        case DXGI_FORMAT_BC7_UNORM:                return D3DX_PIXEL_FORMAT_BC7_UNORM;
         case DXGI_FORMAT_R8G8B8A8_SNORM:           return D3DX_PIXEL_FORMAT_R8G8B8A8_SNORM;
         case DXGI_FORMAT_R8G8_SNORM:               return D3DX_PIXEL_FORMAT_R8G8_SNORM;
         case DXGI_FORMAT_R16G16_SNORM:             return D3DX_PIXEL_FORMAT_R16G16_SNORM;
@@ -2418,6 +2421,106 @@ static void copy_pixels(const BYTE *src, UINT src_row_pitch, UINT src_slice_pitc
     }
 }
 
+/*
+ * Conversions between formats with only whole-byte 8 bit channels reduce to
+ * moving bytes around, which is what the integer path of convert_argb_pixel()
+ * ends up doing for them one bit field at a time.
+ */
+struct d3dx_byte_swizzle
+{
+    unsigned int src_bpp, dst_bpp;
+    /* Source byte for each destination byte, or -1 to use fill[]. */
+    int8_t src_byte[4];
+    uint8_t fill[4];
+    DWORD fill_mask;
+    BOOL identity;
+};
+
+static BOOL d3dx_init_byte_swizzle(const struct pixel_format_desc *src_fmt, const struct pixel_format_desc *dst_fmt,
+        struct d3dx_byte_swizzle *swizzle)
+{
+    unsigned int c, i;
+
+    if (!format_types_match(src_fmt, dst_fmt) || src_fmt->bytes_per_pixel > 4 || dst_fmt->bytes_per_pixel > 4
+            || src_fmt->block_width != 1 || dst_fmt->block_width != 1)
+        return FALSE;
+
+    swizzle->src_bpp = src_fmt->bytes_per_pixel;
+    swizzle->dst_bpp = dst_fmt->bytes_per_pixel;
+    for (i = 0; i < 4; ++i)
+    {
+        swizzle->src_byte[i] = -1;
+        swizzle->fill[i] = 0;
+    }
+
+    for (c = 0; c < 4; ++c)
+    {
+        if ((src_fmt->bits[c] && (src_fmt->bits[c] != 8 || src_fmt->shift[c] % 8))
+                || (dst_fmt->bits[c] && (dst_fmt->bits[c] != 8 || dst_fmt->shift[c] % 8)))
+            return FALSE;
+
+        if (!dst_fmt->bits[c])
+            continue;
+
+        /* Channels missing from the source are set to their maximal value. */
+        if (src_fmt->bits[c])
+            swizzle->src_byte[dst_fmt->shift[c] / 8] = src_fmt->shift[c] / 8;
+        else
+            swizzle->fill[dst_fmt->shift[c] / 8] = 0xff;
+    }
+
+    swizzle->fill_mask = 0;
+    swizzle->identity = swizzle->src_bpp == swizzle->dst_bpp;
+    for (i = 0; i < 4; ++i)
+    {
+        swizzle->fill_mask |= swizzle->fill[i] << (i * 8);
+        if (i < swizzle->dst_bpp && swizzle->src_byte[i] != i)
+            swizzle->identity = FALSE;
+    }
+
+    return TRUE;
+}
+
+static inline void d3dx_swizzle_pixel(const struct d3dx_byte_swizzle *swizzle, const BYTE *src, BYTE *dst)
+{
+    unsigned int i;
+
+    for (i = 0; i < swizzle->dst_bpp; ++i)
+        dst[i] = swizzle->src_byte[i] < 0 ? swizzle->fill[i] : src[swizzle->src_byte[i]];
+}
+
+static void d3dx_swizzle_row(const struct d3dx_byte_swizzle *swizzle, const BYTE *src, BYTE *dst, unsigned int width)
+{
+    unsigned int x, i;
+
+    if (swizzle->identity)
+    {
+        memcpy(dst, src, width * swizzle->dst_bpp);
+        return;
+    }
+
+    if (swizzle->src_bpp == 4 && swizzle->dst_bpp == 4)
+    {
+        DWORD in, out;
+
+        for (x = 0; x < width; ++x)
+        {
+            memcpy(&in, src + x * 4, sizeof(in));
+            out = swizzle->fill_mask;
+            for (i = 0; i < 4; ++i)
+            {
+                if (swizzle->src_byte[i] >= 0)
+                    out |= ((in >> (swizzle->src_byte[i] * 8)) & 0xff) << (i * 8);
+            }
+            memcpy(dst + x * 4, &out, sizeof(out));
+        }
+        return;
+    }
+
+    for (x = 0; x < width; ++x)
+        d3dx_swizzle_pixel(swizzle, src + x * swizzle->src_bpp, dst + x * swizzle->dst_bpp);
+}
+
 static void convert_argb_pixel(const uint8_t *src_ptr, const struct pixel_format_desc *src_fmt,
         uint8_t *dst_ptr, const struct pixel_format_desc *dst_fmt, const PALETTEENTRY *palette,
         struct argb_conversion_info *conv_info, const struct d3dx_color_key *color_key,
@@ -2479,6 +2582,198 @@ static void convert_argb_pixel(const uint8_t *src_ptr, const struct pixel_format
     }
 }
 
+static unsigned int d3dx_get_cpu_count(void)
+{
+    static LONG cpu_count;
+    SYSTEM_INFO info;
+
+    if (!cpu_count)
+    {
+        GetSystemInfo(&info);
+        InterlockedExchange(&cpu_count, max(info.dwNumberOfProcessors, 1));
+    }
+    return cpu_count;
+}
+
+/* Below this many pixels the cost of waking up threads outweighs the gain. */
+#define D3DX_PARALLEL_MIN_PIXELS (128 * 128)
+#define D3DX_PARALLEL_MAX_BANDS 64
+
+/*
+ * Rows of independent work, split into bands which are processed on the
+ * thread pool. The calling thread takes bands as well, so all rows are
+ * processed even if no thread pool work could be created.
+ */
+struct d3dx_parallel_rows
+{
+    void (*process_row)(void *context, unsigned int row);
+    void *context;
+    unsigned int row_count, band_size, band_count;
+    LONG next_band;
+};
+
+static void d3dx_parallel_rows_process_bands(struct d3dx_parallel_rows *rows)
+{
+    unsigned int band, row, end;
+
+    while ((band = InterlockedIncrement(&rows->next_band) - 1) < rows->band_count)
+    {
+        end = min((band + 1) * rows->band_size, rows->row_count);
+        for (row = band * rows->band_size; row < end; ++row)
+            rows->process_row(rows->context, row);
+    }
+}
+
+static void CALLBACK d3dx_parallel_rows_work_callback(TP_CALLBACK_INSTANCE *instance, void *context, TP_WORK *work)
+{
+    d3dx_parallel_rows_process_bands(context);
+}
+
+static void d3dx_process_rows(void (*process_row)(void *context, unsigned int row), void *context,
+        unsigned int row_count, UINT64 pixel_count)
+{
+    unsigned int cpu_count = d3dx_get_cpu_count(), i;
+    struct d3dx_parallel_rows rows;
+    TP_WORK *work = NULL;
+
+    rows.process_row = process_row;
+    rows.context = context;
+    rows.row_count = row_count;
+    rows.next_band = 0;
+    rows.band_count = 1;
+    if (cpu_count > 1 && row_count > 1 && pixel_count >= D3DX_PARALLEL_MIN_PIXELS)
+        rows.band_count = min(min(cpu_count * 4, row_count), D3DX_PARALLEL_MAX_BANDS);
+    rows.band_size = (row_count + rows.band_count - 1) / rows.band_count;
+    rows.band_count = row_count ? (row_count + rows.band_size - 1) / rows.band_size : 0;
+
+    if (rows.band_count > 1 && (work = CreateThreadpoolWork(d3dx_parallel_rows_work_callback, &rows, NULL)))
+    {
+        TRACE("Processing %u rows in %u bands.\n", row_count, rows.band_count);
+        for (i = 1; i < min(cpu_count, rows.band_count); ++i)
+            SubmitThreadpoolWork(work);
+    }
+
+    d3dx_parallel_rows_process_bands(&rows);
+
+    if (work)
+    {
+        /* All bands are taken by now, callbacks that haven't started yet have
+         * nothing left to do. */
+        WaitForThreadpoolWorkCallbacks(work, TRUE);
+        CloseThreadpoolWork(work);
+    }
+}
+
+/*
+ * Format conversion and point filtering are done row by row, so that large
+ * images can be processed in parallel.
+ */
+struct d3dx_pixels_op
+{
+    const BYTE *src;
+    UINT src_row_pitch, src_slice_pitch;
+    const struct volume *src_size;
+    const struct pixel_format_desc *src_format;
+    BYTE *dst;
+    UINT dst_row_pitch, dst_slice_pitch;
+    const struct volume *dst_size;
+    const struct pixel_format_desc *dst_format;
+    const struct d3dx_color_key *color_key;
+    const struct pixel_format_desc *ck_format;
+    const PALETTEENTRY *palette;
+    struct argb_conversion_info conv_info, ck_conv_info;
+    struct d3dx_byte_swizzle swizzle;
+    BOOL use_swizzle;
+    BOOL point_filter;
+
+    /* Size of the area to process, rows are counted across slices. */
+    unsigned int width, height;
+};
+
+static void d3dx_pixels_op_init(struct d3dx_pixels_op *op, const BYTE *src, UINT src_row_pitch, UINT src_slice_pitch,
+        const struct volume *src_size, const struct pixel_format_desc *src_format, BYTE *dst, UINT dst_row_pitch,
+        UINT dst_slice_pitch, const struct volume *dst_size, const struct pixel_format_desc *dst_format,
+        const struct d3dx_color_key *color_key, const PALETTEENTRY *palette)
+{
+    op->src = src;
+    op->src_row_pitch = src_row_pitch;
+    op->src_slice_pitch = src_slice_pitch;
+    op->src_size = src_size;
+    op->src_format = src_format;
+    op->dst = dst;
+    op->dst_row_pitch = dst_row_pitch;
+    op->dst_slice_pitch = dst_slice_pitch;
+    op->dst_size = dst_size;
+    op->dst_format = dst_format;
+    op->color_key = color_key;
+    op->palette = palette;
+    /* Color keys are always represented in D3DFMT_A8R8G8B8 format. */
+    op->ck_format = color_key ? get_d3dx_pixel_format_info(D3DX_PIXEL_FORMAT_B8G8R8A8_UNORM) : NULL;
+
+    init_argb_conversion_info(src_format, dst_format, &op->conv_info);
+    if (color_key)
+        init_argb_conversion_info(src_format, op->ck_format, &op->ck_conv_info);
+    op->use_swizzle = !color_key && d3dx_init_byte_swizzle(src_format, dst_format, &op->swizzle);
+}
+
+static void d3dx_pixels_op_process_row(void *context, unsigned int row)
+{
+    struct d3dx_pixels_op *op = context;
+    const struct pixel_format_desc *src_format = op->src_format, *dst_format = op->dst_format;
+    unsigned int z = row / op->height, y = row % op->height, x;
+    BYTE *dst_ptr = op->dst + z * op->dst_slice_pitch + y * op->dst_row_pitch;
+    const BYTE *src_ptr;
+
+    if (!op->point_filter)
+    {
+        src_ptr = op->src + z * op->src_slice_pitch + y * op->src_row_pitch;
+
+        if (op->use_swizzle)
+        {
+            d3dx_swizzle_row(&op->swizzle, src_ptr, dst_ptr, op->width);
+            dst_ptr += op->width * dst_format->bytes_per_pixel;
+        }
+        else
+        {
+            for (x = 0; x < op->width; x++)
+            {
+                convert_argb_pixel(src_ptr, src_format, dst_ptr, dst_format, op->palette,
+                        &op->conv_info, op->color_key, op->ck_format, &op->ck_conv_info);
+
+                src_ptr += src_format->bytes_per_pixel;
+                dst_ptr += dst_format->bytes_per_pixel;
+            }
+        }
+
+        if (op->src_size->width < op->dst_size->width) /* black out remaining pixels */
+            memset(dst_ptr, 0, dst_format->bytes_per_pixel * (op->dst_size->width - op->src_size->width));
+        return;
+    }
+
+    src_ptr = op->src + op->src_slice_pitch * (z * op->src_size->depth / op->dst_size->depth)
+            + op->src_row_pitch * (y * op->src_size->height / op->dst_size->height);
+
+    for (x = 0; x < op->width; x++)
+    {
+        const BYTE *src_pixel = src_ptr + (x * op->src_size->width / op->dst_size->width) * src_format->bytes_per_pixel;
+
+        if (op->use_swizzle)
+            d3dx_swizzle_pixel(&op->swizzle, src_pixel, dst_ptr);
+        else
+            convert_argb_pixel(src_pixel, src_format, dst_ptr, dst_format, op->palette,
+                    &op->conv_info, op->color_key, op->ck_format, &op->ck_conv_info);
+        dst_ptr += dst_format->bytes_per_pixel;
+    }
+}
+
+static void d3dx_pixels_op_run(struct d3dx_pixels_op *op, unsigned int width, unsigned int height,
+        unsigned int depth)
+{
+    op->width = width;
+    op->height = height;
+    d3dx_process_rows(d3dx_pixels_op_process_row, op, height * depth, (UINT64)width * height * depth);
+}
+
 /************************************************************
  * convert_argb_pixels
  *
@@ -2491,49 +2786,26 @@ static void convert_argb_pixels(const BYTE *src, UINT src_row_pitch, UINT src_sl
         const struct volume *dst_size, const struct pixel_format_desc *dst_format, const struct d3dx_color_key *color_key,
         const PALETTEENTRY *palette)
 {
-    /* Color keys are always represented in D3DFMT_A8R8G8B8 format. */
-    const struct pixel_format_desc *ck_format = color_key ? get_d3dx_pixel_format_info(D3DX_PIXEL_FORMAT_B8G8R8A8_UNORM) : NULL;
-    struct argb_conversion_info conv_info, ck_conv_info;
+    struct d3dx_pixels_op op;
     UINT min_width, min_height, min_depth;
-    UINT x, y, z;
 
     TRACE("src %p, src_row_pitch %u, src_slice_pitch %u, src_size %p, src_format %p, dst %p, "
             "dst_row_pitch %u, dst_slice_pitch %u, dst_size %p, dst_format %p, color_key %s, palette %p.\n",
             src, src_row_pitch, src_slice_pitch, src_size, src_format, dst, dst_row_pitch, dst_slice_pitch, dst_size,
             dst_format, debug_d3dx_color_key(color_key), palette);
 
-    init_argb_conversion_info(src_format, dst_format, &conv_info);
+    d3dx_pixels_op_init(&op, src, src_row_pitch, src_slice_pitch, src_size, src_format, dst, dst_row_pitch,
+            dst_slice_pitch, dst_size, dst_format, color_key, palette);
+    op.point_filter = FALSE;
 
     min_width = min(src_size->width, dst_size->width);
     min_height = min(src_size->height, dst_size->height);
     min_depth = min(src_size->depth, dst_size->depth);
 
-    if (color_key)
-        init_argb_conversion_info(src_format, ck_format, &ck_conv_info);
-
-    for (z = 0; z < min_depth; z++) {
-        const BYTE *src_slice_ptr = src + z * src_slice_pitch;
-        BYTE *dst_slice_ptr = dst + z * dst_slice_pitch;
-
-        for (y = 0; y < min_height; y++) {
-            const BYTE *src_ptr = src_slice_ptr + y * src_row_pitch;
-            BYTE *dst_ptr = dst_slice_ptr + y * dst_row_pitch;
-
-            for (x = 0; x < min_width; x++) {
-                convert_argb_pixel(src_ptr, src_format, dst_ptr, dst_format, palette,
-                        &conv_info, color_key, ck_format, &ck_conv_info);
-
-                src_ptr += src_format->bytes_per_pixel;
-                dst_ptr += dst_format->bytes_per_pixel;
-            }
-
-            if (src_size->width < dst_size->width) /* black out remaining pixels */
-                memset(dst_ptr, 0, dst_format->bytes_per_pixel * (dst_size->width - src_size->width));
-        }
+    d3dx_pixels_op_run(&op, min_width, min_height, min_depth);
 
-        if (src_size->height < dst_size->height) /* black out remaining pixels */
-            memset(dst + src_size->height * dst_row_pitch, 0, dst_row_pitch * (dst_size->height - src_size->height));
-    }
+    if (min_depth && src_size->height < dst_size->height) /* black out remaining pixels */
+        memset(dst + src_size->height * dst_row_pitch, 0, dst_row_pitch * (dst_size->height - src_size->height));
     if (src_size->depth < dst_size->depth) /* black out remaining pixels */
         memset(dst + src_size->depth * dst_slice_pitch, 0, dst_slice_pitch * (dst_size->depth - src_size->depth));
 }
@@ -2550,40 +2822,88 @@ static void point_filter_argb_pixels(const BYTE *src, UINT src_row_pitch, UINT s
         UINT dst_slice_pitch, const struct volume *dst_size, const struct pixel_format_desc *dst_format,
         const struct d3dx_color_key *color_key, const PALETTEENTRY *palette)
 {
-    /* Color keys are always represented in D3DFMT_A8R8G8B8 format. */
-    const struct pixel_format_desc *ck_format = color_key ? get_d3dx_pixel_format_info(D3DX_PIXEL_FORMAT_B8G8R8A8_UNORM) : NULL;
-    struct argb_conversion_info conv_info, ck_conv_info;
-    UINT x, y, z;
+    struct d3dx_pixels_op op;
 
     TRACE("src %p, src_row_pitch %u, src_slice_pitch %u, src_size %p, src_format %p, dst %p, "
             "dst_row_pitch %u, dst_slice_pitch %u, dst_size %p, dst_format %p, color_key %s, palette %p.\n",
             src, src_row_pitch, src_slice_pitch, src_size, src_format, dst, dst_row_pitch, dst_slice_pitch, dst_size,
             dst_format, debug_d3dx_color_key(color_key), palette);
 
-    init_argb_conversion_info(src_format, dst_format, &conv_info);
+    d3dx_pixels_op_init(&op, src, src_row_pitch, src_slice_pitch, src_size, src_format, dst, dst_row_pitch,
+            dst_slice_pitch, dst_size, dst_format, color_key, palette);
+    op.point_filter = TRUE;
 
-    if (color_key)
-        init_argb_conversion_info(src_format, ck_format, &ck_conv_info);
+    d3dx_pixels_op_run(&op, dst_size->width, dst_size->height, dst_size->depth);
+}
+
+struct d3dx_decompress_op
+{
+    void (*decompress_bcn_block)(const void *src, void *dst, int dst_row_pitch);
+    const struct d3dx_pixels *pixels;
+    const struct pixel_format_desc *desc, *uncompressed_desc;
+    BYTE *uncompressed_mem;
+    uint32_t uncompressed_row_pitch, uncompressed_slice_pitch, block_buf_row_pitch;
+    unsigned int block_rows;
+    RECT aligned_rect;
+    BOOL is_dst;
+};
+
+/* Decompresses one row of blocks, rows are counted across slices. */
+static void d3dx_decompress_op_process_row(void *context, unsigned int row)
+{
+    const struct d3dx_decompress_op *op = context;
+    const struct pixel_format_desc *desc = op->desc, *uncompressed_desc = op->uncompressed_desc;
+    const struct d3dx_pixels *pixels = op->pixels;
+    unsigned int z = row / op->block_rows, y = (row % op->block_rows) * desc->block_height, x;
+    const uint8_t *src_ptr = &((const uint8_t *)pixels->data)[z * pixels->slice_pitch
+            + (y / desc->block_height) * pixels->row_pitch];
+    uint8_t *dst_slice = &op->uncompressed_mem[z * op->uncompressed_slice_pitch];
+    uint8_t block_buf[64];
 
-    for (z = 0; z < dst_size->depth; z++)
+    for (x = 0; x < op->aligned_rect.right; x += desc->block_width)
     {
-        BYTE *dst_slice_ptr = dst + z * dst_slice_pitch;
-        const BYTE *src_slice_ptr = src + src_slice_pitch * (z * src_size->depth / dst_size->depth);
+        struct volume dst_block_size;
+        RECT src_rect, dst_rect;
+        uint8_t *dst_ptr;
 
-        for (y = 0; y < dst_size->height; y++)
-        {
-            BYTE *dst_ptr = dst_slice_ptr + y * dst_row_pitch;
-            const BYTE *src_row_ptr = src_slice_ptr + src_row_pitch * (y * src_size->height / dst_size->height);
+        SetRect(&src_rect, x, y, x + desc->block_width, y + desc->block_height);
+        IntersectRect(&src_rect, &src_rect, &pixels->unaligned_rect);
+        dst_rect = src_rect;
+        OffsetRect(&dst_rect, -pixels->unaligned_rect.left, -pixels->unaligned_rect.top);
+
+        set_volume_struct(&dst_block_size, dst_rect.right - dst_rect.left, dst_rect.bottom - dst_rect.top, 1);
+        dst_ptr = &dst_slice[(dst_rect.top * op->uncompressed_row_pitch)];
+        dst_ptr += dst_rect.left * uncompressed_desc->bytes_per_pixel;
 
-            for (x = 0; x < dst_size->width; x++)
+        if (dst_block_size.width != desc->block_width || dst_block_size.height != desc->block_height)
+        {
+            if (!op->is_dst)
             {
-                const BYTE *src_ptr = src_row_ptr + (x * src_size->width / dst_size->width) * src_format->bytes_per_pixel;
+                unsigned int block_buf_offset;
 
-                convert_argb_pixel(src_ptr, src_format, dst_ptr, dst_format, palette,
-                        &conv_info, color_key, ck_format, &ck_conv_info);
-                dst_ptr += dst_format->bytes_per_pixel;
+                op->decompress_bcn_block(src_ptr, block_buf, op->block_buf_row_pitch);
+                block_buf_offset = (src_rect.top - y) * op->block_buf_row_pitch;
+                block_buf_offset += uncompressed_desc->bytes_per_pixel * (src_rect.left - x);
+                copy_pixels(&block_buf[block_buf_offset], op->block_buf_row_pitch, 0, dst_ptr,
+                        op->uncompressed_row_pitch, 0, &dst_block_size, uncompressed_desc);
             }
+            /*
+             * If this is the destination, we can just copy the whole
+             * block. It will be partially overwritten later.
+             */
+            else
+            {
+                dst_ptr = &dst_slice[y * op->uncompressed_row_pitch + x * uncompressed_desc->bytes_per_pixel];
+                op->decompress_bcn_block(src_ptr, dst_ptr, op->uncompressed_row_pitch);
+            }
+
+        }
+        /* Full block copy. */
+        else if (!op->is_dst)
+        {
+            op->decompress_bcn_block(src_ptr, dst_ptr, op->uncompressed_row_pitch);
         }
+        src_ptr += desc->block_byte_count;
     }
 }
 
@@ -2591,64 +2911,67 @@ static HRESULT d3dx_pixels_decompress(struct d3dx_pixels *pixels, const struct p
         BOOL is_dst, void **out_memory, uint32_t *out_row_pitch, uint32_t *out_slice_pitch,
         const struct pixel_format_desc **out_desc)
 {
-    uint32_t uncompressed_slice_pitch, uncompressed_row_pitch, block_buf_row_pitch, block_width_mask, block_height_mask;
-    void (*decompress_bcn_block)(const void *src, void *dst, int dst_row_pitch);
-    const struct pixel_format_desc *uncompressed_desc = NULL;
     const struct volume *size = &pixels->size;
-    BYTE *uncompressed_mem;
-    uint8_t block_buf[64];
-    unsigned int x, y, z;
-    RECT aligned_rect;
+    uint32_t block_width_mask, block_height_mask;
+    struct d3dx_decompress_op op;
 
+    op.uncompressed_desc = NULL;
     switch (desc->format)
     {
         case D3DX_PIXEL_FORMAT_DXT1_UNORM:
-            uncompressed_desc = get_d3dx_pixel_format_info(D3DX_PIXEL_FORMAT_R8G8B8A8_UNORM);
-            decompress_bcn_block = bcdec_bc1;
+            op.uncompressed_desc = get_d3dx_pixel_format_info(D3DX_PIXEL_FORMAT_R8G8B8A8_UNORM);
+            op.decompress_bcn_block = bcdec_bc1;
             break;
 
         case D3DX_PIXEL_FORMAT_DXT2_UNORM:
         case D3DX_PIXEL_FORMAT_DXT3_UNORM:
-            uncompressed_desc = get_d3dx_pixel_format_info(D3DX_PIXEL_FORMAT_R8G8B8A8_UNORM);
-            decompress_bcn_block = bcdec_bc2;
+            op.uncompressed_desc = get_d3dx_pixel_format_info(D3DX_PIXEL_FORMAT_R8G8B8A8_UNORM);
+            op.decompress_bcn_block = bcdec_bc2;
             break;
 
         case D3DX_PIXEL_FORMAT_DXT4_UNORM:
         case D3DX_PIXEL_FORMAT_DXT5_UNORM:
-            uncompressed_desc = get_d3dx_pixel_format_info(D3DX_PIXEL_FORMAT_R8G8B8A8_UNORM);
-            decompress_bcn_block = bcdec_bc3;
+            op.uncompressed_desc = get_d3dx_pixel_format_info(D3DX_PIXEL_FORMAT_R8G8B8A8_UNORM);
+            op.decompress_bcn_block = bcdec_bc3;
             break;
 
         case D3DX_PIXEL_FORMAT_BC4_UNORM:
         case D3DX_PIXEL_FORMAT_BC4_SNORM:
             if (desc->rgb_type == CTYPE_UNORM)
-                uncompressed_desc = get_d3dx_pixel_format_info(D3DX_PIXEL_FORMAT_R8_UNORM);
+                op.uncompressed_desc = get_d3dx_pixel_format_info(D3DX_PIXEL_FORMAT_R8_UNORM);
             else
-                uncompressed_desc = get_d3dx_pixel_format_info(D3DX_PIXEL_FORMAT_R8_SNORM);
-            decompress_bcn_block = bcdec_bc4;
+                op.uncompressed_desc = get_d3dx_pixel_format_info(D3DX_PIXEL_FORMAT_R8_SNORM);
+            op.decompress_bcn_block = bcdec_bc4;
             break;
 
         case D3DX_PIXEL_FORMAT_BC5_UNORM:
         case D3DX_PIXEL_FORMAT_BC5_SNORM:
             if (desc->rgb_type == CTYPE_UNORM)
-                uncompressed_desc = get_d3dx_pixel_format_info(D3DX_PIXEL_FORMAT_R8G8_UNORM);
+                op.uncompressed_desc = get_d3dx_pixel_format_info(D3DX_PIXEL_FORMAT_R8G8_UNORM);
             else
-                uncompressed_desc = get_d3dx_pixel_format_info(D3DX_PIXEL_FORMAT_R8G8_SNORM);
-            decompress_bcn_block = bcdec_bc5;
+                op.uncompressed_desc = get_d3dx_pixel_format_info(D3DX_PIXEL_FORMAT_R8G8_SNORM);
+            op.decompress_bcn_block = bcdec_bc5;
             break;
 
+        case D3DX_PIXEL_FORMAT_BC7_UNORM:
+            op.uncompressed_desc = get_d3dx_pixel_format_info(D3DX_PIXEL_FORMAT_R8G8B8A8_UNORM);
+            op.decompress_bcn_block = bcdec_bc7;
+            break;
 
         default:
             FIXME("Unexpected compressed texture format %u.\n", desc->format);
             return E_NOTIMPL;
     }
 
+    op.pixels = pixels;
+    op.desc = desc;
+    op.is_dst = is_dst;
     block_width_mask = desc->block_width - 1;
     block_height_mask = desc->block_height - 1;
-    block_buf_row_pitch = desc->block_width * uncompressed_desc->bytes_per_pixel;
-    uncompressed_row_pitch = size->width * uncompressed_desc->bytes_per_pixel;
-    uncompressed_slice_pitch = uncompressed_row_pitch * size->height;
-    if (!(uncompressed_mem = malloc(size->depth * uncompressed_slice_pitch)))
+    op.block_buf_row_pitch = desc->block_width * op.uncompressed_desc->bytes_per_pixel;
+    op.uncompressed_row_pitch = size->width * op.uncompressed_desc->bytes_per_pixel;
+    op.uncompressed_slice_pitch = op.uncompressed_row_pitch * size->height;
+    if (!(op.uncompressed_mem = malloc(size->depth * op.uncompressed_slice_pitch)))
         return E_OUTOFMEMORY;
 
     /*
@@ -2659,13 +2982,13 @@ static HRESULT d3dx_pixels_decompress(struct d3dx_pixels *pixels, const struct p
      */
     if (is_dst)
     {
-        SetRect(&aligned_rect, 0, 0, size->width, size->height);
+        SetRect(&op.aligned_rect, 0, 0, size->width, size->height);
 
         /*
          * If our destination covers the entire set of blocks, no
          * decompression needs to be done, just return the allocated memory.
          */
-        if (EqualRect(&aligned_rect, &pixels->unaligned_rect))
+        if (EqualRect(&op.aligned_rect, &pixels->unaligned_rect))
             goto exit;
     }
     /*
@@ -2675,73 +2998,20 @@ static HRESULT d3dx_pixels_decompress(struct d3dx_pixels *pixels, const struct p
      */
     else
     {
-        SetRect(&aligned_rect, 0, 0, (pixels->unaligned_rect.right + block_width_mask) & ~block_width_mask,
+        SetRect(&op.aligned_rect, 0, 0, (pixels->unaligned_rect.right + block_width_mask) & ~block_width_mask,
                 (pixels->unaligned_rect.bottom + block_height_mask) & ~block_height_mask);
     }
 
     TRACE("Decompressing pixels.\n");
-    for (z = 0; z < size->depth; ++z)
-    {
-        const uint8_t *src_slice = &((const uint8_t *)pixels->data)[z * pixels->slice_pitch];
-        uint8_t *dst_slice = &uncompressed_mem[z * uncompressed_slice_pitch];
-
-        for (y = 0; y < aligned_rect.bottom; y += desc->block_height)
-        {
-            const uint8_t *src_ptr = &src_slice[(y / desc->block_height) * pixels->row_pitch];
-
-            for (x = 0; x < aligned_rect.right; x += desc->block_width)
-            {
-                struct volume dst_block_size;
-                RECT src_rect, dst_rect;
-                uint8_t *dst_ptr;
-
-                SetRect(&src_rect, x, y, x + desc->block_width, y + desc->block_height);
-                IntersectRect(&src_rect, &src_rect, &pixels->unaligned_rect);
-                dst_rect = src_rect;
-                OffsetRect(&dst_rect, -pixels->unaligned_rect.left, -pixels->unaligned_rect.top);
-
-                set_volume_struct(&dst_block_size, dst_rect.right - dst_rect.left, dst_rect.bottom - dst_rect.top, 1);
-                dst_ptr = &dst_slice[(dst_rect.top * uncompressed_row_pitch)];
-                dst_ptr += dst_rect.left * uncompressed_desc->bytes_per_pixel;
-
-                if (dst_block_size.width != desc->block_width || dst_block_size.height != desc->block_height)
-                {
-                    if (!is_dst)
-                    {
-                        unsigned int block_buf_offset;
-
-                        decompress_bcn_block(src_ptr, block_buf, block_buf_row_pitch);
-                        block_buf_offset = (src_rect.top - y) * block_buf_row_pitch;
-                        block_buf_offset += uncompressed_desc->bytes_per_pixel * (src_rect.left - x);
-                        copy_pixels(&block_buf[block_buf_offset], block_buf_row_pitch, 0, dst_ptr,
-                                uncompressed_row_pitch, 0, &dst_block_size, uncompressed_desc);
-                    }
-                    /*
-                     * If this is the destination, we can just copy the whole
-                     * block. It will be partially overwritten later.
-                     */
-                    else
-                    {
-                        dst_ptr = &dst_slice[y * uncompressed_row_pitch + x * uncompressed_desc->bytes_per_pixel];
-                        decompress_bcn_block(src_ptr, dst_ptr, uncompressed_row_pitch);
-                    }
-
-                }
-                /* Full block copy. */
-                else if (!is_dst)
-                {
-                    decompress_bcn_block(src_ptr, dst_ptr, uncompressed_row_pitch);
-                }
-                src_ptr += desc->block_byte_count;
-            }
-        }
-    }
+    op.block_rows = op.aligned_rect.bottom / desc->block_height;
+    d3dx_process_rows(d3dx_decompress_op_process_row, &op, op.block_rows * size->depth,
+            (UINT64)op.aligned_rect.right * op.aligned_rect.bottom * size->depth);
 
 exit:
-    *out_memory = uncompressed_mem;
-    *out_row_pitch = uncompressed_row_pitch;
-    *out_slice_pitch = uncompressed_slice_pitch;
-    *out_desc = uncompressed_desc;
+    *out_memory = op.uncompressed_mem;
+    *out_row_pitch = op.uncompressed_row_pitch;
+    *out_slice_pitch = op.uncompressed_slice_pitch;
+    *out_desc = op.uncompressed_desc;
 
     return S_OK;
 }
@@ -2813,6 +3083,292 @@ static HRESULT d3dx_pixels_unpack_index(struct d3dx_pixels *pixels, const struct
     return S_OK;
 }
 
+/*
+ * BC7 encoder. Blocks are always encoded using mode 6, which has a single
+ * subset with 7 bit RGBA endpoints, a p-bit per endpoint and 4 bit indices.
+ * It handles both opaque and translucent blocks reasonably well, while
+ * keeping the encoder simple enough to be used at texture load time.
+ * Endpoints start out on the principal axis of the block and are refined
+ * once using least squares.
+ */
+static const uint8_t bc7_weights4[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+struct bc7_mode6_endpoints
+{
+    /* Endpoint channels are 7 bits, p-bits are appended to form 8 bit values. */
+    uint8_t color[2][4];
+    uint8_t pbit[2];
+};
+
+static void bc7_mode6_expand_endpoints(const struct bc7_mode6_endpoints *endpoints, int expanded[2][4])
+{
+    unsigned int i, c;
+
+    for (i = 0; i < 2; ++i)
+    {
+        for (c = 0; c < 4; ++c)
+            expanded[i][c] = (endpoints->color[i][c] << 1) | endpoints->pbit[i];
+    }
+}
+
+/* Quantizes one endpoint with a given p-bit and returns the squared error. */
+static float bc7_mode6_quantize_endpoint(const float value[4], unsigned int pbit, uint8_t color[4])
+{
+    float error = 0.0f, diff;
+    unsigned int c;
+    int q;
+
+    for (c = 0; c < 4; ++c)
+    {
+        q = (int)floorf((value[c] - pbit) * 0.5f + 0.5f);
+        q = min(max(q, 0), 127);
+        color[c] = q;
+        diff = ((q << 1) | pbit) - value[c];
+        error += diff * diff;
+    }
+    return error;
+}
+
+/* Quantizes both endpoints, picking the p-bit with the smallest error for each. */
+static void bc7_mode6_quantize_endpoints(const float value[2][4], struct bc7_mode6_endpoints *endpoints)
+{
+    uint8_t color[4];
+    unsigned int i;
+
+    for (i = 0; i < 2; ++i)
+    {
+        if (bc7_mode6_quantize_endpoint(value[i], 0, endpoints->color[i])
+                > bc7_mode6_quantize_endpoint(value[i], 1, color))
+        {
+            memcpy(endpoints->color[i], color, sizeof(color));
+            endpoints->pbit[i] = 1;
+        }
+        else
+        {
+            endpoints->pbit[i] = 0;
+        }
+    }
+}
+
+/*
+ * Picks the closest palette entry for each pixel, returns the total squared
+ * error. The palette lies on a line, so projecting the pixel onto it gives the
+ * best index up to rounding, and only the neighbouring entries need checking.
+ */
+static unsigned int bc7_mode6_select_indices(const uint8_t *pixels, const struct bc7_mode6_endpoints *endpoints,
+        uint8_t indices[16])
+{
+    unsigned int i, j, c, first, last, error, best_error, total_error = 0;
+    int expanded[2][4], palette[16][4], dir[4], diff, len = 0, dot;
+
+    bc7_mode6_expand_endpoints(endpoints, expanded);
+    for (i = 0; i < 16; ++i)
+    {
+        for (c = 0; c < 4; ++c)
+            palette[i][c] = (expanded[0][c] * (64 - bc7_weights4[i]) + expanded[1][c] * bc7_weights4[i] + 32) >> 6;
+    }
+    for (c = 0; c < 4; ++c)
+    {
+        dir[c] = expanded[1][c] - expanded[0][c];
+        len += dir[c] * dir[c];
+    }
+
+    for (i = 0; i < 16; ++i)
+    {
+        const uint8_t *pixel = &pixels[i * 4];
+
+        first = 0;
+        last = 15;
+        if (len)
+        {
+            dot = 0;
+            for (c = 0; c < 4; ++c)
+                dot += (pixel[c] - expanded[0][c]) * dir[c];
+            j = dot <= 0 ? 0 : min((dot * 15 + len / 2) / len, 15);
+            first = j ? j - 1 : 0;
+            last = min(j + 1, 15);
+        }
+
+        best_error = ~0u;
+        for (j = first; j <= last; ++j)
+        {
+            error = 0;
+            for (c = 0; c < 4; ++c)
+            {
+                diff = pixel[c] - palette[j][c];
+                error += diff * diff;
+            }
+            if (error < best_error)
+            {
+                best_error = error;
+                indices[i] = j;
+            }
+        }
+        total_error += best_error;
+    }
+    return total_error;
+}
+
+/*
+ * Solves for the endpoints minimizing the squared error of the interpolated
+ * colors, given the current indices.
+ */
+static BOOL bc7_mode6_fit_endpoints(const uint8_t *pixels, const uint8_t indices[16], float value[2][4])
+{
+    float a = 0.0f, b = 0.0f, d = 0.0f, x0[4] = {0}, x1[4] = {0}, t, det;
+    unsigned int i, c;
+
+    for (i = 0; i < 16; ++i)
+    {
+        t = bc7_weights4[indices[i]] / 64.0f;
+        a += (1.0f - t) * (1.0f - t);
+        b += (1.0f - t) * t;
+        d += t * t;
+        for (c = 0; c < 4; ++c)
+        {
+            x0[c] += (1.0f - t) * pixels[i * 4 + c];
+            x1[c] += t * pixels[i * 4 + c];
+        }
+    }
+
+    det = a * d - b * b;
+    if (fabsf(det) < 1e-6f)
+        return FALSE;
+
+    for (c = 0; c < 4; ++c)
+    {
+        value[0][c] = min(max((d * x0[c] - b * x1[c]) / det, 0.0f), 255.0f);
+        value[1][c] = min(max((a * x1[c] - b * x0[c]) / det, 0.0f), 255.0f);
+    }
+    return TRUE;
+}
+
+static void bc7_mode6_initial_endpoints(const uint8_t *pixels, float value[2][4])
+{
+    float mean[4] = {0}, cov[4][4] = {{0}}, axis[4] = {1.0f, 1.0f, 1.0f, 1.0f}, tmp[4], diff[4];
+    float t, t_min = FLT_MAX, t_max = -FLT_MAX, len;
+    unsigned int i, j, c;
+
+    for (i = 0; i < 16; ++i)
+    {
+        for (c = 0; c < 4; ++c)
+            mean[c] += pixels[i * 4 + c] / 16.0f;
+    }
+    for (i = 0; i < 16; ++i)
+    {
+        for (c = 0; c < 4; ++c)
+            diff[c] = pixels[i * 4 + c] - mean[c];
+        for (c = 0; c < 4; ++c)
+        {
+            for (j = 0; j < 4; ++j)
+                cov[c][j] += diff[c] * diff[j];
+        }
+    }
+
+    /* Find the principal axis using power iteration. */
+    for (i = 0; i < 8; ++i)
+    {
+        len = 0.0f;
+        for (c = 0; c < 4; ++c)
+        {
+            tmp[c] = cov[c][0] * axis[0] + cov[c][1] * axis[1] + cov[c][2] * axis[2] + cov[c][3] * axis[3];
+            len = max(len, fabsf(tmp[c]));
+        }
+        if (len < 1e-6f)
+            break;
+        for (c = 0; c < 4; ++c)
+            axis[c] = tmp[c] / len;
+    }
+
+    len = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2] + axis[3] * axis[3];
+    for (i = 0; i < 16; ++i)
+    {
+        t = 0.0f;
+        for (c = 0; c < 4; ++c)
+            t += (pixels[i * 4 + c] - mean[c]) * axis[c];
+        t /= len;
+        t_min = min(t_min, t);
+        t_max = max(t_max, t);
+    }
+
+    for (c = 0; c < 4; ++c)
+    {
+        value[0][c] = min(max(mean[c] + t_min * axis[c], 0.0f), 255.0f);
+        value[1][c] = min(max(mean[c] + t_max * axis[c], 0.0f), 255.0f);
+    }
+}
+
+static void bc7_write_bits(uint8_t *block, unsigned int *offset, unsigned int value, unsigned int count)
+{
+    unsigned int i;
+
+    for (i = 0; i < count; ++i, ++*offset)
+    {
+        if (value & (1u << i))
+            block[*offset / 8] |= 1u << (*offset % 8);
+    }
+}
+
+static void bc7_mode6_write_block(const struct bc7_mode6_endpoints *endpoints, const uint8_t indices[16],
+        uint8_t *block)
+{
+    unsigned int offset = 0, i, c;
+
+    memset(block, 0, 16);
+    bc7_write_bits(block, &offset, 1u << 6, 7);
+    for (c = 0; c < 4; ++c)
+    {
+        bc7_write_bits(block, &offset, endpoints->color[0][c], 7);
+        bc7_write_bits(block, &offset, endpoints->color[1][c], 7);
+    }
+    bc7_write_bits(block, &offset, endpoints->pbit[0], 1);
+    bc7_write_bits(block, &offset, endpoints->pbit[1], 1);
+    /* The most significant bit of the anchor index is implicitly 0. */
+    bc7_write_bits(block, &offset, indices[0], 3);
+    for (i = 1; i < 16; ++i)
+        bc7_write_bits(block, &offset, indices[i], 4);
+}
+
+/* Source pixels are 4x4 R8G8B8A8 values. */
+static void d3dx_compress_bc7_block(const uint8_t *pixels, uint8_t *block)
+{
+    struct bc7_mode6_endpoints endpoints, best_endpoints;
+    unsigned int error, best_error, i;
+    uint8_t indices[16], best_indices[16], tmp;
+    float value[2][4];
+
+    bc7_mode6_initial_endpoints(pixels, value);
+    bc7_mode6_quantize_endpoints(value, &best_endpoints);
+    best_error = bc7_mode6_select_indices(pixels, &best_endpoints, best_indices);
+
+    /* A single least squares refinement pass gets most of the possible gain. */
+    if (best_error && bc7_mode6_fit_endpoints(pixels, best_indices, value))
+    {
+        bc7_mode6_quantize_endpoints(value, &endpoints);
+        if ((error = bc7_mode6_select_indices(pixels, &endpoints, indices)) < best_error)
+        {
+            best_endpoints = endpoints;
+            memcpy(best_indices, indices, sizeof(indices));
+        }
+    }
+
+    if (best_indices[0] & 0x8)
+    {
+        for (i = 0; i < 4; ++i)
+        {
+            tmp = best_endpoints.color[0][i];
+            best_endpoints.color[0][i] = best_endpoints.color[1][i];
+            best_endpoints.color[1][i] = tmp;
+        }
+        tmp = best_endpoints.pbit[0];
+        best_endpoints.pbit[0] = best_endpoints.pbit[1];
+        best_endpoints.pbit[1] = tmp;
+        for (i = 0; i < 16; ++i)
+            best_indices[i] = 15 - best_indices[i];
+    }
+    bc7_mode6_write_block(&best_endpoints, best_indices, block);
+}
+
 static void d3dx_compress_block(enum d3dx_pixel_format_id fmt, uint8_t *block_buf, void *dst_buf)
 {
     switch (fmt)
@@ -2863,12 +3419,53 @@ static void d3dx_compress_block(enum d3dx_pixel_format_id fmt, uint8_t *block_bu
             stb_compress_bc5_block(dst_buf, block_buf);
             break;
 
+        case D3DX_PIXEL_FORMAT_BC7_UNORM:
+            d3dx_compress_bc7_block(block_buf, dst_buf);
+            break;
+
         default:
             assert(0);
             break;
     }
 }
 
+struct d3dx_compress_op
+{
+    const struct d3dx_pixels *src_pixels, *dst_pixels;
+    const struct pixel_format_desc *src_desc, *dst_desc;
+    unsigned int block_rows;
+};
+
+/* Compresses one row of blocks, rows are counted across slices. */
+static void d3dx_compress_op_process_row(void *context, unsigned int row)
+{
+    const struct d3dx_compress_op *op = context;
+    const struct pixel_format_desc *src_desc = op->src_desc, *dst_desc = op->dst_desc;
+    const struct d3dx_pixels *src_pixels = op->src_pixels, *dst_pixels = op->dst_pixels;
+    const unsigned int block_buf_row_pitch = src_desc->bytes_per_pixel * dst_desc->block_width;
+    unsigned int z = row / op->block_rows, y = (row % op->block_rows) * dst_desc->block_height, x;
+    const unsigned int tmp_src_height = min(dst_desc->block_height, src_pixels->size.height - y);
+    uint8_t *dst_ptr = &((uint8_t *)dst_pixels->data)[z * dst_pixels->slice_pitch
+            + (y / dst_desc->block_height) * dst_pixels->row_pitch];
+    const uint8_t *src_ptr = &((const uint8_t *)src_pixels->data)[z * src_pixels->slice_pitch
+            + y * src_pixels->row_pitch];
+    uint8_t block_buf[64];
+
+    for (x = 0; x < src_pixels->size.width; x += dst_desc->block_width)
+    {
+        const unsigned int tmp_src_width = min(dst_desc->block_width, src_pixels->size.width - x);
+        struct volume block_buf_size = { tmp_src_width, tmp_src_height, 1 };
+
+        if (tmp_src_width != dst_desc->block_width || tmp_src_height != dst_desc->block_height)
+            memset(block_buf, 0, sizeof(block_buf));
+        copy_pixels(src_ptr, src_pixels->row_pitch, src_pixels->slice_pitch, block_buf, block_buf_row_pitch, 0,
+                &block_buf_size, src_desc);
+        d3dx_compress_block(dst_desc->format, block_buf, dst_ptr);
+        src_ptr += (src_desc->bytes_per_pixel * dst_desc->block_width);
+        dst_ptr += dst_desc->block_byte_count;
+    }
+}
+
 /*
  * Source data passed into this function is potentially modified (currently
  * only in the case of DXT2/DXT3). As of now we only pass temporary buffers
@@ -2879,8 +3476,7 @@ static HRESULT d3dx_pixels_compress(struct d3dx_pixels *src_pixels,
         const struct pixel_format_desc *src_desc, struct d3dx_pixels *dst_pixels,
         const struct pixel_format_desc *dst_desc)
 {
-    unsigned int x, y, z, block_buf_row_pitch;
-    uint8_t block_buf[64];
+    struct d3dx_compress_op op;
 
     switch (dst_desc->format)
     {
@@ -2889,6 +3485,7 @@ static HRESULT d3dx_pixels_compress(struct d3dx_pixels *src_pixels,
         case D3DX_PIXEL_FORMAT_DXT3_UNORM:
         case D3DX_PIXEL_FORMAT_DXT4_UNORM:
         case D3DX_PIXEL_FORMAT_DXT5_UNORM:
+        case D3DX_PIXEL_FORMAT_BC7_UNORM:
             assert(src_desc->format == D3DX_PIXEL_FORMAT_R8G8B8A8_UNORM);
             break;
 
@@ -2914,33 +3511,14 @@ static HRESULT d3dx_pixels_compress(struct d3dx_pixels *src_pixels,
     }
 
     TRACE("Compressing pixels.\n");
-    block_buf_row_pitch = src_desc->bytes_per_pixel * dst_desc->block_width;
-    for (z = 0; z < src_pixels->size.depth; ++z)
-    {
-        const uint8_t *src_slice = &((const uint8_t *)src_pixels->data)[z * src_pixels->slice_pitch];
-        uint8_t *dst_slice = &((uint8_t *)dst_pixels->data)[z * dst_pixels->slice_pitch];
-
-        for (y = 0; y < src_pixels->size.height; y += dst_desc->block_height)
-        {
-            const unsigned int tmp_src_height = min(dst_desc->block_height, src_pixels->size.height - y);
-            uint8_t *dst_ptr = &dst_slice[(y / dst_desc->block_height) * dst_pixels->row_pitch];
-            const uint8_t *src_ptr = &src_slice[y * src_pixels->row_pitch];
-
-            for (x = 0; x < src_pixels->size.width; x += dst_desc->block_width)
-            {
-                const unsigned int tmp_src_width = min(dst_desc->block_width, src_pixels->size.width - x);
-                struct volume block_buf_size = { tmp_src_width, tmp_src_height, 1 };
-
-                if (tmp_src_width != dst_desc->block_width || tmp_src_height != dst_desc->block_height)
-                    memset(block_buf, 0, sizeof(block_buf));
-                copy_pixels(src_ptr, src_pixels->row_pitch, src_pixels->slice_pitch, block_buf, block_buf_row_pitch, 0,
-                        &block_buf_size, src_desc);
-                d3dx_compress_block(dst_desc->format, block_buf, dst_ptr);
-                src_ptr += (src_desc->bytes_per_pixel * dst_desc->block_width);
-                dst_ptr += dst_desc->block_byte_count;
-            }
-        }
-    }
+    op.src_pixels = src_pixels;
+    op.src_desc = src_desc;
+    op.dst_pixels = dst_pixels;
+    op.dst_desc = dst_desc;
+    op.block_rows = (src_pixels->size.height + dst_desc->block_height - 1) / dst_desc->block_height;
+    /* Compressing a block costs a lot more than converting its pixels. */
+    d3dx_process_rows(d3dx_compress_op_process_row, &op, op.block_rows * src_pixels->size.depth,
+            (UINT64)src_pixels->size.width * src_pixels->size.height * src_pixels->size.depth * 16);
 
     return S_OK;
 }
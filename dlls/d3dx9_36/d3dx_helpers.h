@@ -206,6 +206,7 @@ enum d3dx_pixel_format_id
     D3DX_PIXEL_FORMAT_BC4_SNORM,
     D3DX_PIXEL_FORMAT_BC5_UNORM,
     D3DX_PIXEL_FORMAT_BC5_SNORM,
+    D3DX_PIXEL_FORMAT_BC7_UNORM,
     D3DX_PIXEL_FORMAT_R16_FLOAT,
     D3DX_PIXEL_FORMAT_R16G16_FLOAT,
     D3DX_PIXEL_FORMAT_R16G16B16A16_FLOAT,
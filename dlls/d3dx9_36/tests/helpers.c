@@ -0,0 +1,150 @@
+/*
+ * Tests for the pixel helpers shared by d3dx9, d3dx10 and d3dx11
+ *
+ * The helpers aren't exported, and some of them, like BC7 compression,
+ * can't be reached through the d3dx9 API, so they are built into the test.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "../d3dx_helpers.c"
+#include "wine/test.h"
+
+static HRESULT load_pixels(const void *src, unsigned int src_row_pitch, enum d3dx_pixel_format_id src_format,
+        void *dst, unsigned int dst_row_pitch, enum d3dx_pixel_format_id dst_format,
+        unsigned int width, unsigned int height)
+{
+    const struct pixel_format_desc *src_desc = get_d3dx_pixel_format_info(src_format);
+    const struct pixel_format_desc *dst_desc = get_d3dx_pixel_format_info(dst_format);
+    struct d3dx_pixels src_pixels, dst_pixels;
+    HRESULT hr;
+
+    hr = d3dx_pixels_init(src, src_row_pitch, 0, NULL, src_format, 0, 0, width, height, 0, 1, &src_pixels);
+    ok(hr == S_OK, "Unexpected hr %#lx.\n", hr);
+    hr = d3dx_pixels_init(dst, dst_row_pitch, 0, NULL, dst_format, 0, 0, width, height, 0, 1, &dst_pixels);
+    ok(hr == S_OK, "Unexpected hr %#lx.\n", hr);
+    return d3dx_load_pixels_from_pixels(&dst_pixels, dst_desc, &src_pixels, src_desc, D3DX_FILTER_NONE, 0);
+}
+
+static void test_bc7_round_trip(void)
+{
+    static const struct
+    {
+        unsigned int width, height;
+        BOOL collinear;
+    }
+    tests[] =
+    {
+        /*
+         * The colors of each block lie on a line through zero, so mode 6 can
+         * represent them accurately, including the zero padding of partial blocks.
+         */
+        {  16,  16, TRUE  },
+        /* Partial blocks at the right and bottom edges. */
+        {  13,   7, TRUE  },
+        /* Large enough to be compressed and decompressed in parallel. */
+        { 512, 256, FALSE },
+    };
+    unsigned int i, x, y, c, block_count, src_pitch, bc7_pitch, diff, max_diff;
+    BYTE *src, *bc7, *dst, block[16], block_src[4 * 4 * 4];
+    HRESULT hr;
+
+    for (i = 0; i < ARRAY_SIZE(tests); ++i)
+    {
+        const unsigned int width = tests[i].width, height = tests[i].height;
+
+        winetest_push_context("Test %u", i);
+
+        src_pitch = width * 4;
+        bc7_pitch = ((width + 3) / 4) * 16;
+        block_count = ((width + 3) / 4) * ((height + 3) / 4);
+        src = malloc(src_pitch * height);
+        dst = malloc(src_pitch * height);
+        bc7 = calloc(block_count, 16);
+
+        for (y = 0; y < height; ++y)
+        {
+            for (x = 0; x < width; ++x)
+            {
+                BYTE *pixel = &src[y * src_pitch + x * 4];
+
+                if (tests[i].collinear)
+                {
+                    const unsigned int k = x % 4 + 1;
+
+                    pixel[0] = k * 60;
+                    pixel[1] = k * (30 + (y / 4) * 5);
+                    pixel[2] = k * 50;
+                    pixel[3] = k * 63;
+                }
+                else
+                {
+                    pixel[0] = x / 2;
+                    pixel[1] = y;
+                    pixel[2] = (x + y) / 3;
+                    pixel[3] = 255 - x / 4;
+                }
+            }
+        }
+
+        hr = load_pixels(src, src_pitch, D3DX_PIXEL_FORMAT_R8G8B8A8_UNORM, bc7, bc7_pitch,
+                D3DX_PIXEL_FORMAT_BC7_UNORM, width, height);
+        ok(hr == S_OK, "Unexpected hr %#lx.\n", hr);
+
+        /* Every block is encoded in mode 6. */
+        for (x = 0; x < block_count; ++x)
+        {
+            if ((bc7[x * 16] & 0x7f) != 0x40)
+                break;
+        }
+        ok(x == block_count, "Got unexpected mode bits %#x for block %u.\n", x < block_count ? bc7[x * 16] & 0x7f : 0, x);
+
+        /* Blocks only depend on their own pixels, however they were split across threads. */
+        if (width >= 8 && height >= 8)
+        {
+            for (y = 0; y < 4; ++y)
+                memcpy(&block_src[y * 16], &src[(4 + y) * src_pitch + 4 * 4], 16);
+            hr = load_pixels(block_src, 16, D3DX_PIXEL_FORMAT_R8G8B8A8_UNORM, block, 16,
+                    D3DX_PIXEL_FORMAT_BC7_UNORM, 4, 4);
+            ok(hr == S_OK, "Unexpected hr %#lx.\n", hr);
+            ok(!memcmp(block, &bc7[bc7_pitch + 16], sizeof(block)), "Got unexpected block data.\n");
+        }
+
+        hr = load_pixels(bc7, bc7_pitch, D3DX_PIXEL_FORMAT_BC7_UNORM, dst, src_pitch,
+                D3DX_PIXEL_FORMAT_R8G8B8A8_UNORM, width, height);
+        ok(hr == S_OK, "Unexpected hr %#lx.\n", hr);
+
+        max_diff = 0;
+        for (y = 0; y < height; ++y)
+        {
+            for (c = 0; c < src_pitch; ++c)
+            {
+                diff = abs((int)dst[y * src_pitch + c] - (int)src[y * src_pitch + c]);
+                max_diff = max(max_diff, diff);
+            }
+        }
+        ok(max_diff <= 8, "Got unexpected maximum difference %u.\n", max_diff);
+
+        free(bc7);
+        free(dst);
+        free(src);
+        winetest_pop_context();
+    }
+}
+
+START_TEST(helpers)
+{
+    test_bc7_round_trip();
+}
@@ -4905,6 +4905,106 @@ static void test_save_surface_iffs(IDirect3DDevice9 *device)
     }
 }
 
+static void test_large_dxt_round_trip(IDirect3DDevice9 *device)
+{
+    static const unsigned int size = 1024;
+    static const struct
+    {
+        D3DFORMAT format;
+        unsigned int max_diff;
+    }
+    tests[] =
+    {
+        { D3DFMT_DXT1, 24 },
+        { D3DFMT_DXT3, 24 },
+        { D3DFMT_DXT5, 24 },
+    };
+    IDirect3DSurface9 *compressed, *uncompressed;
+    unsigned int i, c, x, y, diff, max_diff;
+    LARGE_INTEGER freq, start, end;
+    D3DLOCKED_RECT lock_rect;
+    IDirect3DTexture9 *tex;
+    DWORD *src;
+    RECT rect;
+    HRESULT hr;
+
+    hr = IDirect3DDevice9_CreateOffscreenPlainSurface(device, size, size, D3DFMT_A8R8G8B8, D3DPOOL_SCRATCH,
+            &uncompressed, NULL);
+    if (FAILED(hr))
+    {
+        skip("Failed to create surface, hr %#lx.\n", hr);
+        return;
+    }
+
+    src = malloc(size * size * sizeof(*src));
+    SetRect(&rect, 0, 0, size, size);
+    QueryPerformanceFrequency(&freq);
+
+    for (i = 0; i < ARRAY_SIZE(tests); ++i)
+    {
+        winetest_push_context("Test %u", i);
+
+        /* Smooth gradients, with alpha varying across the image unless the format only has 1 bit alpha. */
+        for (y = 0; y < size; ++y)
+        {
+            for (x = 0; x < size; ++x)
+                src[y * size + x] = ((tests[i].format == D3DFMT_DXT1 ? 0xff : x / 4) << 24) | ((y / 4) << 16)
+                        | (((x + y) / 8) << 8) | (255 - y / 4);
+        }
+
+        hr = IDirect3DDevice9_CreateTexture(device, size, size, 1, 0, tests[i].format, D3DPOOL_SCRATCH, &tex, NULL);
+        if (FAILED(hr))
+        {
+            skip("Failed to create texture, hr %#lx.\n", hr);
+            winetest_pop_context();
+            continue;
+        }
+        hr = IDirect3DTexture9_GetSurfaceLevel(tex, 0, &compressed);
+        ok(hr == D3D_OK, "Unexpected hr %#lx.\n", hr);
+
+        QueryPerformanceCounter(&start);
+        hr = D3DXLoadSurfaceFromMemory(compressed, NULL, NULL, src, D3DFMT_A8R8G8B8, size * sizeof(*src),
+                NULL, &rect, D3DX_FILTER_NONE, 0);
+        QueryPerformanceCounter(&end);
+        ok(hr == D3D_OK, "Unexpected hr %#lx.\n", hr);
+        trace("Compressed %ux%u pixels in %.2f ms.\n", size, size,
+                (end.QuadPart - start.QuadPart) * 1000.0 / freq.QuadPart);
+
+        QueryPerformanceCounter(&start);
+        hr = D3DXLoadSurfaceFromSurface(uncompressed, NULL, NULL, compressed, NULL, NULL, D3DX_FILTER_NONE, 0);
+        QueryPerformanceCounter(&end);
+        ok(hr == D3D_OK, "Unexpected hr %#lx.\n", hr);
+        trace("Decompressed %ux%u pixels in %.2f ms.\n", size, size,
+                (end.QuadPart - start.QuadPart) * 1000.0 / freq.QuadPart);
+
+        hr = IDirect3DSurface9_LockRect(uncompressed, &lock_rect, NULL, D3DLOCK_READONLY);
+        ok(hr == D3D_OK, "Unexpected hr %#lx.\n", hr);
+        max_diff = 0;
+        for (y = 0; y < size; ++y)
+        {
+            const DWORD *row = (const DWORD *)((const BYTE *)lock_rect.pBits + y * lock_rect.Pitch);
+
+            for (x = 0; x < size; ++x)
+            {
+                for (c = 0; c < 32; c += 8)
+                {
+                    diff = abs((int)((row[x] >> c) & 0xff) - (int)((src[y * size + x] >> c) & 0xff));
+                    max_diff = max(max_diff, diff);
+                }
+            }
+        }
+        IDirect3DSurface9_UnlockRect(uncompressed);
+        ok(max_diff <= tests[i].max_diff, "Got unexpected maximum difference %u.\n", max_diff);
+
+        check_release((IUnknown *)compressed, 1);
+        check_release((IUnknown *)tex, 0);
+        winetest_pop_context();
+    }
+
+    free(src);
+    check_release((IUnknown *)uncompressed, 0);
+}
+
 static void test_D3DXSaveSurfaceToFileInMemory(IDirect3DDevice9 *device)
 {
     static const struct dds_pixel_format d3dfmt_a8r8g8b8_pf = { 32, DDS_PF_RGB | DDS_PF_ALPHA, 0, 32,
@@ -5253,6 +5353,7 @@ START_TEST(surface)
 
     test_D3DXGetImageInfo();
     test_D3DXLoadSurface(device);
+    test_large_dxt_round_trip(device);
     test_D3DXSaveSurfaceToFileInMemory(device);
     test_D3DXSaveSurfaceToFile(device);
 
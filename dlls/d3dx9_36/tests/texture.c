@@ -1270,6 +1270,134 @@ static void WINAPI fillfunc(D3DXVECTOR4 *value, const D3DXVECTOR2 *texcoord,
     value->w = 1.0f;
 }
 
+static void test_large_texture_load(IDirect3DDevice9 *device)
+{
+    static const unsigned int size = 1024;
+    static const struct
+    {
+        D3DFORMAT format;
+        BOOL swap_rb;
+    }
+    tests[] =
+    {
+        { D3DFMT_X8R8G8B8 },
+        { D3DFMT_A8R8G8B8 },
+        { D3DFMT_A8B8G8R8, TRUE },
+    };
+    unsigned int i, j, k, x, y, level, mismatches;
+    D3DLOCKED_RECT lock_rect, top_rect;
+    LARGE_INTEGER freq, start, end;
+    IDirect3DSurface9 *surface;
+    IDirect3DTexture9 *tex;
+    DWORD *src, expected;
+    RECT rect;
+    HRESULT hr;
+
+    hr = IDirect3DDevice9_CreateTexture(device, size, size, 0, 0, D3DFMT_A8R8G8B8, D3DPOOL_SCRATCH, &tex, NULL);
+    if (FAILED(hr))
+    {
+        skip("Failed to create texture, hr %#lx.\n", hr);
+        return;
+    }
+
+    src = malloc(size * size * sizeof(*src));
+    for (y = 0; y < size; ++y)
+    {
+        for (x = 0; x < size; ++x)
+            src[y * size + x] = (x * 0x00010203) ^ (y * 0x03020100) ^ 0x40000000;
+    }
+    SetRect(&rect, 0, 0, size, size);
+    QueryPerformanceFrequency(&freq);
+
+    hr = IDirect3DTexture9_GetSurfaceLevel(tex, 0, &surface);
+    ok(hr == D3D_OK, "Unexpected hr %#lx.\n", hr);
+
+    for (i = 0; i < ARRAY_SIZE(tests); ++i)
+    {
+        winetest_push_context("Test %u", i);
+
+        QueryPerformanceCounter(&start);
+        hr = D3DXLoadSurfaceFromMemory(surface, NULL, NULL, src, tests[i].format, size * sizeof(*src),
+                NULL, &rect, D3DX_FILTER_NONE, 0);
+        QueryPerformanceCounter(&end);
+        ok(hr == D3D_OK, "Unexpected hr %#lx.\n", hr);
+        trace("Converted %ux%u pixels in %.2f ms.\n", size, size,
+                (end.QuadPart - start.QuadPart) * 1000.0 / freq.QuadPart);
+
+        hr = IDirect3DSurface9_LockRect(surface, &lock_rect, NULL, D3DLOCK_READONLY);
+        ok(hr == D3D_OK, "Unexpected hr %#lx.\n", hr);
+        mismatches = 0;
+        for (y = 0; y < size; ++y)
+        {
+            const DWORD *row = (const DWORD *)((const BYTE *)lock_rect.pBits + y * lock_rect.Pitch);
+
+            for (x = 0; x < size; ++x)
+            {
+                expected = src[y * size + x];
+                if (tests[i].format == D3DFMT_X8R8G8B8)
+                    expected |= 0xff000000;
+                if (tests[i].swap_rb)
+                    expected = (expected & 0xff00ff00) | (expected & 0xff) << 16 | (expected >> 16 & 0xff);
+                if (row[x] != expected && !mismatches++)
+                    ok(0, "Got %#lx at (%u, %u), expected %#lx.\n", row[x], x, y, expected);
+            }
+        }
+        ok(!mismatches, "Got %u mismatching pixels.\n", mismatches);
+        IDirect3DSurface9_UnlockRect(surface);
+
+        winetest_pop_context();
+    }
+
+    IDirect3DSurface9_Release(surface);
+
+    QueryPerformanceCounter(&start);
+    hr = D3DXFilterTexture((IDirect3DBaseTexture9 *)tex, NULL, 0, D3DX_FILTER_POINT);
+    QueryPerformanceCounter(&end);
+    ok(hr == D3D_OK, "Unexpected hr %#lx.\n", hr);
+    trace("Generated %u mip levels in %.2f ms.\n", IDirect3DTexture9_GetLevelCount(tex) - 1,
+            (end.QuadPart - start.QuadPart) * 1000.0 / freq.QuadPart);
+
+    /* Each point filtered pixel must come from its footprint in the top level. */
+    hr = IDirect3DTexture9_LockRect(tex, 0, &top_rect, NULL, D3DLOCK_READONLY);
+    ok(hr == D3D_OK, "Unexpected hr %#lx.\n", hr);
+    for (level = 1; level < IDirect3DTexture9_GetLevelCount(tex); ++level)
+    {
+        unsigned int block = 1u << level;
+
+        winetest_push_context("Level %u", level);
+        hr = IDirect3DTexture9_LockRect(tex, level, &lock_rect, NULL, D3DLOCK_READONLY);
+        ok(hr == D3D_OK, "Unexpected hr %#lx.\n", hr);
+        mismatches = 0;
+        for (y = 0; y < size / block; ++y)
+        {
+            const DWORD *row = (const DWORD *)((const BYTE *)lock_rect.pBits + y * lock_rect.Pitch);
+
+            for (x = 0; x < size / block; ++x)
+            {
+                BOOL found = FALSE;
+
+                for (j = 0; j < block && !found; ++j)
+                {
+                    const DWORD *top_row = (const DWORD *)((const BYTE *)top_rect.pBits
+                            + (y * block + j) * top_rect.Pitch) + x * block;
+
+                    for (k = 0; k < block && !found; ++k)
+                        found = top_row[k] == row[x];
+                }
+                if (!found && !mismatches++)
+                    ok(0, "Got unexpected %#lx at (%u, %u).\n", row[x], x, y);
+            }
+        }
+        ok(!mismatches, "Got %u mismatching pixels.\n", mismatches);
+        IDirect3DTexture9_UnlockRect(tex, level);
+        winetest_pop_context();
+    }
+    IDirect3DTexture9_UnlockRect(tex, 0);
+
+    free(src);
+    IDirect3DTexture9_Release(tex);
+}
+
 static void test_D3DXFillTexture(IDirect3DDevice9 *device)
 {
     static const struct
@@ -4020,6 +4148,7 @@ START_TEST(texture)
     test_D3DXCheckVolumeTextureRequirements(device);
     test_D3DXCreateTexture(device);
     test_D3DXFilterTexture(device);
+    test_large_texture_load(device);
     test_D3DXFillTexture(device);
     test_D3DXFillCubeTexture(device);
     test_D3DXFillVolumeTexture(device);
@@ -263,6 +263,7 @@ struct dwrite_fontface
     IDWriteFontFileStream *stream;
     IDWriteFontFile *file;
     UINT32 index;
+    UINT32 glyph_bitmap_file;
 
     IDWriteFactory7 *factory;
     struct fontfacecached *cached;
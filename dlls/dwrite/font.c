@@ -188,6 +188,194 @@ void dwrite_fontface_get_glyph_bbox(IDWriteFontFace *iface, struct dwrite_glyphb
     LeaveCriticalSection(&fontface->cs);
 }
 
+/* Process-wide cache of rendered glyph bitmaps, shared by all font faces created from the same local file. */
+struct glyph_bitmap_key
+{
+    UINT32 file;
+    UINT32 index;
+    float size;
+    unsigned short glyph;
+    unsigned short simulations;
+    unsigned int mode;
+};
+
+struct glyph_bitmap
+{
+    struct wine_rb_entry entry;
+    struct list mru;
+    struct glyph_bitmap_key key;
+    unsigned int is_1bpp;
+    unsigned int size;
+    BYTE bits[1];
+};
+
+struct glyph_bitmap_file
+{
+    struct list entry;
+    UINT32 id;
+    UINT32 key_size;
+    BYTE key[1];
+};
+
+static int glyph_bitmap_cache_compare(const void *k, const struct wine_rb_entry *e)
+{
+    const struct glyph_bitmap *bitmap = WINE_RB_ENTRY_VALUE(e, const struct glyph_bitmap, entry);
+    const struct glyph_bitmap_key *key = k, *key2 = &bitmap->key;
+
+    if (key->file != key2->file) return key->file < key2->file ? -1 : 1;
+    if (key->index != key2->index) return key->index < key2->index ? -1 : 1;
+    if (key->size != key2->size) return key->size < key2->size ? -1 : 1;
+    if (key->glyph != key2->glyph) return (int)key->glyph - (int)key2->glyph;
+    if (key->simulations != key2->simulations) return (int)key->simulations - (int)key2->simulations;
+    if (key->mode != key2->mode) return key->mode < key2->mode ? -1 : 1;
+    return 0;
+}
+
+static struct
+{
+    struct wine_rb_tree tree;
+    struct list mru;
+    struct list files;
+    size_t size;
+    size_t max_size;
+    UINT32 file_id;
+    unsigned int hits;
+    unsigned int misses;
+} glyph_bitmap_cache =
+{
+    { glyph_bitmap_cache_compare },
+    LIST_INIT(glyph_bitmap_cache.mru),
+    LIST_INIT(glyph_bitmap_cache.files),
+    0,
+    0x400000,
+};
+
+static CRITICAL_SECTION glyph_bitmap_cache_cs;
+static CRITICAL_SECTION_DEBUG glyph_bitmap_cache_cs_debug =
+{
+    0, 0, &glyph_bitmap_cache_cs,
+    { &glyph_bitmap_cache_cs_debug.ProcessLocksList, &glyph_bitmap_cache_cs_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": glyph_bitmap_cache_cs") }
+};
+static CRITICAL_SECTION glyph_bitmap_cache_cs = { &glyph_bitmap_cache_cs_debug, -1, 0, 0, 0, 0 };
+
+/* Returns a process-wide identifier for the file contents, or 0 if the file can't be identified.
+   Only local files are supported, their reference keys contain the path and the last write time. */
+static UINT32 glyph_bitmap_cache_get_file_id(IDWriteFontFile *file)
+{
+    struct glyph_bitmap_file *cached;
+    IDWriteFontFileLoader *loader;
+    UINT32 key_size, id = 0;
+    const void *key;
+
+    if (FAILED(IDWriteFontFile_GetLoader(file, &loader)))
+        return 0;
+    IDWriteFontFileLoader_Release(loader);
+    if (loader != get_local_fontfile_loader())
+        return 0;
+
+    if (FAILED(IDWriteFontFile_GetReferenceKey(file, &key, &key_size)))
+        return 0;
+
+    EnterCriticalSection(&glyph_bitmap_cache_cs);
+    LIST_FOR_EACH_ENTRY(cached, &glyph_bitmap_cache.files, struct glyph_bitmap_file, entry)
+    {
+        if (cached->key_size == key_size && !memcmp(cached->key, key, key_size))
+        {
+            id = cached->id;
+            break;
+        }
+    }
+    if (!id && (cached = malloc(FIELD_OFFSET(struct glyph_bitmap_file, key[key_size]))))
+    {
+        cached->id = id = ++glyph_bitmap_cache.file_id;
+        cached->key_size = key_size;
+        memcpy(cached->key, key, key_size);
+        list_add_tail(&glyph_bitmap_cache.files, &cached->entry);
+    }
+    LeaveCriticalSection(&glyph_bitmap_cache_cs);
+
+    return id;
+}
+
+static void glyph_bitmap_cache_trace(void)
+{
+    if ((glyph_bitmap_cache.hits + glyph_bitmap_cache.misses) % 4096) return;
+    TRACE("Glyph bitmap cache: %u hits, %u misses, %Iu bytes.\n", glyph_bitmap_cache.hits,
+            glyph_bitmap_cache.misses, glyph_bitmap_cache.size);
+}
+
+static BOOL glyph_bitmap_cache_get(const struct glyph_bitmap_key *key, BYTE *buf, unsigned int size,
+        unsigned int *is_1bpp)
+{
+    struct glyph_bitmap *bitmap = NULL;
+    struct wine_rb_entry *e;
+
+    EnterCriticalSection(&glyph_bitmap_cache_cs);
+    if ((e = wine_rb_get(&glyph_bitmap_cache.tree, key)))
+    {
+        bitmap = WINE_RB_ENTRY_VALUE(e, struct glyph_bitmap, entry);
+        if (bitmap->size == size)
+        {
+            memcpy(buf, bitmap->bits, size);
+            *is_1bpp = bitmap->is_1bpp;
+            list_remove(&bitmap->mru);
+            list_add_head(&glyph_bitmap_cache.mru, &bitmap->mru);
+        }
+        else
+            bitmap = NULL;
+    }
+    if (bitmap) glyph_bitmap_cache.hits++;
+    else glyph_bitmap_cache.misses++;
+    glyph_bitmap_cache_trace();
+    LeaveCriticalSection(&glyph_bitmap_cache_cs);
+
+    return !!bitmap;
+}
+
+static void glyph_bitmap_cache_add(const struct glyph_bitmap_key *key, const BYTE *bits, unsigned int size,
+        unsigned int is_1bpp)
+{
+    struct glyph_bitmap *bitmap, *old_bitmap;
+    struct wine_rb_entry *e;
+
+    if (size > glyph_bitmap_cache.max_size / 16)
+        return;
+
+    if (!(bitmap = malloc(FIELD_OFFSET(struct glyph_bitmap, bits[size]))))
+        return;
+    bitmap->key = *key;
+    bitmap->is_1bpp = !!is_1bpp;
+    bitmap->size = size;
+    memcpy(bitmap->bits, bits, size);
+
+    EnterCriticalSection(&glyph_bitmap_cache_cs);
+
+    if ((e = wine_rb_get(&glyph_bitmap_cache.tree, key)))
+    {
+        old_bitmap = WINE_RB_ENTRY_VALUE(e, struct glyph_bitmap, entry);
+        wine_rb_remove(&glyph_bitmap_cache.tree, &old_bitmap->entry);
+        list_remove(&old_bitmap->mru);
+        glyph_bitmap_cache.size -= FIELD_OFFSET(struct glyph_bitmap, bits[old_bitmap->size]);
+        free(old_bitmap);
+    }
+
+    wine_rb_put(&glyph_bitmap_cache.tree, key, &bitmap->entry);
+    list_add_head(&glyph_bitmap_cache.mru, &bitmap->mru);
+    glyph_bitmap_cache.size += FIELD_OFFSET(struct glyph_bitmap, bits[size]);
+
+    while (glyph_bitmap_cache.size > glyph_bitmap_cache.max_size)
+    {
+        old_bitmap = LIST_ENTRY(list_tail(&glyph_bitmap_cache.mru), struct glyph_bitmap, mru);
+        wine_rb_remove(&glyph_bitmap_cache.tree, &old_bitmap->entry);
+        list_remove(&old_bitmap->mru);
+        glyph_bitmap_cache.size -= FIELD_OFFSET(struct glyph_bitmap, bits[old_bitmap->size]);
+        free(old_bitmap);
+    }
+
+    LeaveCriticalSection(&glyph_bitmap_cache_cs);
+}
+
 static unsigned int get_glyph_bitmap_pitch(DWRITE_RENDERING_MODE1 rendering_mode, INT width)
 {
     return rendering_mode == DWRITE_RENDERING_MODE1_ALIASED ? ((width + 31) >> 5) << 2 : (width + 3) / 4 * 4;
@@ -223,6 +411,24 @@ static HRESULT dwrite_fontface_get_glyph_bitmap(struct dwrite_fontface *fontface
     {
         UNIX_CALL(get_glyph_bitmap, &params);
     }
+    else if (fontface->glyph_bitmap_file)
+    {
+        struct glyph_bitmap_key bitmap_key;
+
+        memset(&bitmap_key, 0, sizeof(bitmap_key));
+        bitmap_key.file = fontface->glyph_bitmap_file;
+        bitmap_key.index = fontface->index;
+        bitmap_key.size = bitmap->emsize;
+        bitmap_key.glyph = bitmap->glyph;
+        bitmap_key.simulations = fontface->simulations;
+        bitmap_key.mode = rendering_mode;
+
+        if (!glyph_bitmap_cache_get(&bitmap_key, bitmap->buf, bitmap_size, is_1bpp))
+        {
+            UNIX_CALL(get_glyph_bitmap, &params);
+            glyph_bitmap_cache_add(&bitmap_key, bitmap->buf, bitmap_size, *is_1bpp);
+        }
+    }
     else if ((entry = fontface_get_cache_entry(fontface, bitmap_size, &key)))
     {
         if (entry->has_bitmap)
@@ -5244,6 +5450,7 @@ HRESULT create_fontface(const struct fontface_desc *desc, struct list *cached_li
     IDWriteFactory7_AddRef(fontface->factory);
     fontface->file = desc->file;
     IDWriteFontFile_AddRef(fontface->file);
+    fontface->glyph_bitmap_file = glyph_bitmap_cache_get_file_id(fontface->file);
     fontface->stream = desc->stream;
     IDWriteFontFileStream_AddRef(fontface->stream);
     InitializeCriticalSection(&fontface->cs);
@@ -6287,6 +6287,102 @@ static void test_CreateGlyphRunAnalysis(void)
     ok(ref == 0, "factory not released, %lu\n", ref);
 }
 
+static BYTE *get_glyph_texture(IDWriteFactory *factory, IDWriteFontFace *face, UINT16 glyph, float size,
+        DWRITE_RENDERING_MODE mode, RECT *rect, UINT32 *texture_size)
+{
+    DWRITE_TEXTURE_TYPE type = mode == DWRITE_RENDERING_MODE_ALIASED ? DWRITE_TEXTURE_ALIASED_1x1 : DWRITE_TEXTURE_CLEARTYPE_3x1;
+    IDWriteGlyphRunAnalysis *analysis;
+    DWRITE_GLYPH_OFFSET offset = { 0 };
+    DWRITE_GLYPH_RUN run;
+    float advance = 0.0f;
+    BYTE *bits;
+    HRESULT hr;
+
+    memset(&run, 0, sizeof(run));
+    run.fontFace = face;
+    run.fontEmSize = size;
+    run.glyphCount = 1;
+    run.glyphIndices = &glyph;
+    run.glyphAdvances = &advance;
+    run.glyphOffsets = &offset;
+
+    hr = IDWriteFactory_CreateGlyphRunAnalysis(factory, &run, 1.0f, NULL, mode, DWRITE_MEASURING_MODE_NATURAL,
+            0.0f, 0.0f, &analysis);
+    ok(hr == S_OK, "Unexpected hr %#lx.\n", hr);
+
+    hr = IDWriteGlyphRunAnalysis_GetAlphaTextureBounds(analysis, type, rect);
+    ok(hr == S_OK, "Unexpected hr %#lx.\n", hr);
+    *texture_size = (rect->right - rect->left) * (rect->bottom - rect->top);
+    if (type == DWRITE_TEXTURE_CLEARTYPE_3x1) *texture_size *= 3;
+
+    bits = calloc(1, *texture_size + 1);
+    hr = IDWriteGlyphRunAnalysis_CreateAlphaTexture(analysis, type, rect, bits, *texture_size);
+    ok(hr == S_OK, "Unexpected hr %#lx.\n", hr);
+
+    IDWriteGlyphRunAnalysis_Release(analysis);
+    return bits;
+}
+
+static void test_glyph_bitmap_sharing(void)
+{
+    static const DWRITE_RENDERING_MODE modes[] =
+    {
+        DWRITE_RENDERING_MODE_ALIASED,
+        DWRITE_RENDERING_MODE_NATURAL,
+    };
+    IDWriteFactory *factory, *factory2;
+    IDWriteFontFace *face, *face2;
+    UINT32 ch, size, size2;
+    BYTE *bits, *bits2;
+    RECT rect, rect2;
+    UINT16 glyph;
+    unsigned int i, j;
+    HRESULT hr;
+
+    /* Faces from different isolated factories share rendered bitmaps, the result must
+       not depend on which face or rendering mode rendered a glyph first. */
+    factory = create_factory();
+    factory2 = create_factory();
+    face = create_fontface(factory);
+    face2 = create_fontface(factory2);
+    ok(face != face2, "Unexpected shared face.\n");
+
+    ch = 'g';
+    glyph = 0;
+    hr = IDWriteFontFace_GetGlyphIndices(face, &ch, 1, &glyph);
+    ok(hr == S_OK, "Unexpected hr %#lx.\n", hr);
+    ok(glyph > 0, "Unexpected glyph %u.\n", glyph);
+
+    for (i = 0; i < ARRAY_SIZE(modes); ++i)
+    {
+        for (j = 0; j < 2; ++j)
+        {
+            winetest_push_context("mode %u, size %u", modes[i], 17 + j);
+
+            bits = get_glyph_texture(factory, face, glyph, 17.0f + j, modes[i], &rect, &size);
+            bits2 = get_glyph_texture(factory2, face2, glyph, 17.0f + j, modes[(i + 1) % ARRAY_SIZE(modes)],
+                    &rect2, &size2);
+            free(bits2);
+            bits2 = get_glyph_texture(factory2, face2, glyph, 17.0f + j, modes[i], &rect2, &size2);
+
+            ok(EqualRect(&rect, &rect2), "Unexpected rect %s, expected %s.\n", wine_dbgstr_rect(&rect2),
+                    wine_dbgstr_rect(&rect));
+            ok(size == size2, "Unexpected size %u, expected %u.\n", size2, size);
+            if (size == size2)
+                ok(!memcmp(bits, bits2, size), "Unexpected texture data.\n");
+
+            free(bits);
+            free(bits2);
+            winetest_pop_context();
+        }
+    }
+
+    IDWriteFontFace_Release(face2);
+    IDWriteFontFace_Release(face);
+    IDWriteFactory_Release(factory2);
+    IDWriteFactory_Release(factory);
+}
+
 #define round(x) ((int)floor((x) + 0.5))
 
 struct VDMX_Header
@@ -10728,6 +10824,7 @@ START_TEST(font)
     test_GetKerningPairAdjustments();
     test_CreateRenderingParams();
     test_CreateGlyphRunAnalysis();
+    test_glyph_bitmap_sharing();
     test_GetGdiCompatibleMetrics();
     test_GetPanose();
     test_GetGdiCompatibleGlyphAdvances();
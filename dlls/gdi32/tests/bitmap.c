@@ -5987,6 +5987,67 @@ static void test_D3DKMTCreateDCFromMemory( void )
     ok(ret, "Failed to free memory, error %lu.\n", GetLastError());
 }
 
+/* Large fills are drawn by several threads on Wine, the faults taken on write watched
+ * memory must still be handled. */
+static void test_D3DKMTCreateDCFromMemory_write_watch( void )
+{
+    static const unsigned int width = 1024, height = 640, size = 1024 * 640 * 4;
+    TRIVERTEX vert[2] = {{ 0, 0, 0xff00, 0x8000, 0x0000, 0xff00 }, { 1024, 640, 0x0000, 0x8000, 0xff00, 0xff00 }};
+    GRADIENT_RECT rect = { 0, 1 };
+    D3DKMT_DESTROYDCFROMMEMORY destroy_desc;
+    D3DKMT_CREATEDCFROMMEMORY create_desc;
+    ULONG_PTR count;
+    ULONG granularity;
+    NTSTATUS status;
+    DWORD *bits;
+    void **pages;
+    UINT ret;
+
+    if (!pD3DKMTCreateDCFromMemory || !pGdiGradientFill)
+    {
+        win_skip("D3DKMTCreateDCFromMemory() or GdiGradientFill() is not available.\n");
+        return;
+    }
+
+    bits = VirtualAlloc( NULL, size, MEM_RESERVE | MEM_COMMIT | MEM_WRITE_WATCH, PAGE_READWRITE );
+    ok(!!bits, "Failed to allocate memory, error %lu.\n", GetLastError());
+    pages = malloc( size / 4096 * sizeof(*pages) );
+
+    create_desc.pMemory = bits;
+    create_desc.Format = D3DDDIFMT_A8R8G8B8;
+    create_desc.Width = width;
+    create_desc.Height = height;
+    create_desc.Pitch = width * 4;
+    create_desc.hDeviceDc = CreateCompatibleDC( NULL );
+    create_desc.pColorTable = NULL;
+
+    status = pD3DKMTCreateDCFromMemory( &create_desc );
+    ok(!status, "Got unexpected status %#lx.\n", status);
+
+    ret = ResetWriteWatch( bits, size );
+    ok(!ret, "ResetWriteWatch failed.\n");
+
+    ret = pGdiGradientFill( create_desc.hDc, vert, 2, &rect, 1, GRADIENT_FILL_RECT_H );
+    ok(ret, "GdiGradientFill failed.\n");
+    ok((bits[0] & 0xffffff) == 0xff8000, "Got first pixel %#lx.\n", bits[0]);
+    ok(!memcmp( bits, bits + (height - 1) * width, width * 4 ), "First and last rows differ.\n");
+
+    count = size / 4096;
+    ret = GetWriteWatch( 0, bits, size, pages, &count, &granularity );
+    ok(!ret, "GetWriteWatch failed.\n");
+    ok(count == size / granularity, "Got %Iu written pages.\n", count);
+
+    destroy_desc.hDc = create_desc.hDc;
+    destroy_desc.hBitmap = create_desc.hBitmap;
+    status = pD3DKMTDestroyDCFromMemory( &destroy_desc );
+    ok(!status, "Got unexpected status %#lx.\n", status);
+    DeleteDC( create_desc.hDeviceDc );
+
+    free( pages );
+    ret = VirtualFree( bits, 0, MEM_RELEASE );
+    ok(ret, "Failed to free memory, error %lu.\n", GetLastError());
+}
+
 static void test_arcs(void)
 {
     static const unsigned int dib_width = 100, dib_height = 100;
@@ -6360,5 +6421,6 @@ START_TEST(bitmap)
     test_SetDIBitsToDevice();
     test_SetDIBitsToDevice_RLE8();
     test_D3DKMTCreateDCFromMemory();
+    test_D3DKMTCreateDCFromMemory_write_watch();
     test_arcs();
 }
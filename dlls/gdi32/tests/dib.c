@@ -3529,11 +3529,382 @@ static void test_simple_graphics(void)
     DeleteDC(mem_dc);
 }
 
+/* Formats that have SIMD versions of their primitives in the DIB engine. Each
+ * operation is drawn once across the whole rectangle and once column by column
+ * through a one pixel wide clip region, which only exercises the scalar edge
+ * handling; both must give the same bits. */
+
+struct primitive_format
+{
+    const char *name;
+    WORD bpp;
+    DWORD compression;
+    DWORD masks[3];
+};
+
+static const struct primitive_format primitive_formats[] =
+{
+    { "8888",     32, BI_RGB },
+    { "a8b8g8r8", 32, BI_BITFIELDS, { 0x0000ff, 0x00ff00, 0xff0000 } },
+    { "888",      24, BI_RGB },
+};
+
+enum primitive_op
+{
+    OP_PATINVERT,
+    OP_DSTINVERT,
+    OP_SRCINVERT,
+    OP_SRCAND,
+    OP_MONO_SRCCOPY,
+    OP_MONO_SRCINVERT,
+    OP_ALPHABLEND,
+    OP_ALPHABLEND_CONST,
+    OP_ALPHABLEND_NO_ALPHA,
+    OP_TEXT,
+    OP_CONVERT,
+    OP_COUNT
+};
+
+static const char * const primitive_op_names[OP_COUNT] =
+{
+    "PatBlt PATINVERT", "PatBlt DSTINVERT", "BitBlt SRCINVERT", "BitBlt SRCAND",
+    "mono BitBlt SRCCOPY", "mono BitBlt SRCINVERT", "AlphaBlend per-pixel alpha",
+    "AlphaBlend per-pixel and constant alpha", "AlphaBlend constant alpha", "ExtTextOut", "24 bpp BitBlt",
+};
+
+struct primitive_dcs
+{
+    HDC dst, src, mono, argb, rgb;
+    void *dst_bits, *src_bits;
+    HBITMAP bitmaps[5], orig[5];
+    SIZE size;
+};
+
+static int get_primitive_image_size( WORD bpp, int width, int height )
+{
+    return (width * bpp + 31) / 32 * 4 * height;
+}
+
+static HBITMAP create_primitive_dib( const struct primitive_format *format, int width, int height, void **bits )
+{
+    char bmibuf[sizeof(BITMAPINFO) + 2 * sizeof(RGBQUAD)];
+    BITMAPINFO *bmi = (BITMAPINFO *)bmibuf;
+    HBITMAP dib;
+
+    memset( bmibuf, 0, sizeof(bmibuf) );
+    bmi->bmiHeader.biSize = sizeof(bmi->bmiHeader);
+    bmi->bmiHeader.biWidth = width;
+    bmi->bmiHeader.biHeight = -height;
+    bmi->bmiHeader.biPlanes = 1;
+    bmi->bmiHeader.biBitCount = format->bpp;
+    bmi->bmiHeader.biCompression = format->compression;
+    if (format->compression == BI_BITFIELDS) memcpy( bmi->bmiColors, format->masks, sizeof(format->masks) );
+    if (format->bpp == 1)
+    {
+        bmi->bmiColors[0].rgbRed = 0x20;
+        bmi->bmiColors[0].rgbGreen = 0x90;
+        bmi->bmiColors[1].rgbBlue = 0xc0;
+        bmi->bmiColors[1].rgbRed = 0x55;
+    }
+    dib = CreateDIBSection( 0, bmi, DIB_RGB_COLORS, bits, NULL, 0 );
+    ok( dib != NULL, "failed to create %u bpp dib\n", format->bpp );
+    return dib;
+}
+
+static void fill_primitive_bits( void *bits, int size, BOOL premultiply, DWORD seed )
+{
+    DWORD *ptr = bits, alpha;
+    int i;
+
+    for (i = 0; i < size / 4; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        ptr[i] = seed ^ (seed >> 13);
+        if (!premultiply || !(i % 37)) continue;
+        /* mostly premultiplied, with some stray pixels */
+        alpha = ptr[i] >> 24;
+        ptr[i] = alpha << 24 | ((ptr[i] >> 16) & 0xff) * alpha / 255 << 16 |
+                 ((ptr[i] >> 8) & 0xff) * alpha / 255 << 8 | (ptr[i] & 0xff) * alpha / 255;
+    }
+}
+
+static void create_primitive_dcs( struct primitive_dcs *dcs, const struct primitive_format *format, int width, int height )
+{
+    static const struct primitive_format mono = { "1", 1, BI_RGB }, argb = { "8888", 32, BI_RGB };
+    static const struct primitive_format rgb = { "888", 24, BI_RGB };
+    HDC *hdcs[5] = { &dcs->dst, &dcs->src, &dcs->mono, &dcs->argb, &dcs->rgb };
+    const struct primitive_format *formats[5] = { format, format, &mono, &argb, &rgb };
+    LOGFONTA lf;
+    void *bits;
+    int i;
+
+    dcs->size.cx = width;
+    dcs->size.cy = height;
+    for (i = 0; i < ARRAY_SIZE(hdcs); i++)
+    {
+        *hdcs[i] = CreateCompatibleDC( NULL );
+        dcs->bitmaps[i] = create_primitive_dib( formats[i], width, height, &bits );
+        dcs->orig[i] = SelectObject( *hdcs[i], dcs->bitmaps[i] );
+        fill_primitive_bits( bits, get_primitive_image_size( formats[i]->bpp, width, height ), i == 3, 0x1234 + i );
+        if (i == 0) dcs->dst_bits = bits;
+        if (i == 1) dcs->src_bits = bits;
+    }
+
+    SelectObject( dcs->dst, CreateSolidBrush( RGB( 0x31, 0xc4, 0x7e )));
+    memset( &lf, 0, sizeof(lf) );
+    lf.lfHeight = -14;
+    lf.lfQuality = ANTIALIASED_QUALITY;
+    strcpy( lf.lfFaceName, "Arial" );
+    SelectObject( dcs->dst, CreateFontIndirectA( &lf ));
+    SetTextColor( dcs->dst, RGB( 0x10, 0x80, 0xf0 ));
+    SetBkMode( dcs->dst, TRANSPARENT );
+}
+
+static void destroy_primitive_dcs( struct primitive_dcs *dcs )
+{
+    HDC hdcs[5] = { dcs->dst, dcs->src, dcs->mono, dcs->argb, dcs->rgb };
+    int i;
+
+    DeleteObject( SelectObject( dcs->dst, GetStockObject( WHITE_BRUSH )));
+    DeleteObject( SelectObject( dcs->dst, GetStockObject( SYSTEM_FONT )));
+    for (i = 0; i < ARRAY_SIZE(hdcs); i++)
+    {
+        SelectObject( hdcs[i], dcs->orig[i] );
+        DeleteObject( dcs->bitmaps[i] );
+        DeleteDC( hdcs[i] );
+    }
+}
+
+static void draw_primitive( const struct primitive_dcs *dcs, enum primitive_op op, const RECT *rect )
+{
+    static const char text[] = "The quick brown fox jumps over the lazy dog";
+    BLENDFUNCTION blend = { AC_SRC_OVER, 0, 255, AC_SRC_ALPHA };
+    int x = rect->left, y = rect->top, width = rect->right - rect->left, height = rect->bottom - rect->top;
+    int i;
+
+    switch (op)
+    {
+    case OP_PATINVERT:
+        PatBlt( dcs->dst, x, y, width, height, PATINVERT );
+        break;
+    case OP_DSTINVERT:
+        PatBlt( dcs->dst, x, y, width, height, DSTINVERT );
+        break;
+    case OP_SRCINVERT:
+        BitBlt( dcs->dst, x, y, width, height, dcs->src, x + 3, y + 1, SRCINVERT );
+        break;
+    case OP_SRCAND:
+        BitBlt( dcs->dst, x, y, width, height, dcs->src, x / 2, y, SRCAND );
+        break;
+    case OP_MONO_SRCCOPY:
+        BitBlt( dcs->dst, x, y, width, height, dcs->mono, x + 3, y, SRCCOPY );
+        break;
+    case OP_MONO_SRCINVERT:
+        BitBlt( dcs->dst, x, y, width, height, dcs->mono, x + 13, y + 2, SRCINVERT );
+        break;
+    case OP_ALPHABLEND_CONST:
+        blend.SourceConstantAlpha = 100;
+        /* fall through */
+    case OP_ALPHABLEND:
+        GdiAlphaBlend( dcs->dst, x, y, width, height, dcs->argb, x + 1, y, width, height, blend );
+        break;
+    case OP_ALPHABLEND_NO_ALPHA:
+        blend.SourceConstantAlpha = 77;
+        blend.AlphaFormat = 0;
+        GdiAlphaBlend( dcs->dst, x, y, width, height, dcs->argb, x, y + 1, width, height, blend );
+        break;
+    case OP_TEXT:
+        for (i = 0; i < height; i += 16)
+            ExtTextOutA( dcs->dst, x - (i % 7), y + i, 0, NULL, text, ARRAY_SIZE(text) - 1, NULL );
+        break;
+    case OP_CONVERT:
+        BitBlt( dcs->dst, x, y, width, height, dcs->rgb, x + 2, y, SRCCOPY );
+        break;
+    case OP_COUNT:
+        break;
+    }
+}
+
+static void test_primitive_edges(void)
+{
+    static const int shifts[] = { -7, -2, -1, 1, 3, 18 };
+    static const DWORD rops[] = { SRCINVERT, SRCPAINT, NOTSRCCOPY };
+    const int width = 131, height = 37;
+    RECT rect = { 1, 2, 1 + 121, 2 + 33 }, column;
+    struct primitive_dcs dcs, ref;
+    int i, size, op, x, shift;
+    HRGN rgn;
+    BYTE *expect;
+
+    for (i = 0; i < ARRAY_SIZE(primitive_formats); i++)
+    {
+        const struct primitive_format *format = &primitive_formats[i];
+
+        winetest_push_context( "%s", format->name );
+        create_primitive_dcs( &dcs, format, width, height );
+        size = get_primitive_image_size( format->bpp, width, height );
+        expect = malloc( size );
+
+        for (op = 0; op < OP_COUNT; op++)
+        {
+            fill_primitive_bits( dcs.dst_bits, size, FALSE, op );
+            draw_primitive( &dcs, op, &rect );
+            memcpy( expect, dcs.dst_bits, size );
+
+            fill_primitive_bits( dcs.dst_bits, size, FALSE, op );
+            column = rect;
+            for (x = rect.left; x < rect.right; x++)
+            {
+                column.left = x;
+                column.right = x + 1;
+                rgn = CreateRectRgnIndirect( &column );
+                SelectClipRgn( dcs.dst, rgn );
+                DeleteObject( rgn );
+                draw_primitive( &dcs, op, &rect );
+            }
+            SelectClipRgn( dcs.dst, NULL );
+            ok( !memcmp( expect, dcs.dst_bits, size ), "%s: wide and narrow results differ\n",
+                primitive_op_names[op] );
+        }
+
+        /* blits onto the same bitmap must behave as if the source was copied first */
+        create_primitive_dcs( &ref, format, width, height );
+        for (shift = 0; shift < ARRAY_SIZE(shifts); shift++)
+        {
+            for (op = 0; op < ARRAY_SIZE(rops); op++)
+            {
+                fill_primitive_bits( dcs.dst_bits, size, FALSE, shift );
+                fill_primitive_bits( ref.dst_bits, size, FALSE, shift );
+                fill_primitive_bits( ref.src_bits, size, FALSE, shift );
+                BitBlt( dcs.dst, 10 + shifts[shift], 3, 100, 30, dcs.dst, 10, 3 + (shift & 1), rops[op] );
+                BitBlt( ref.dst, 10 + shifts[shift], 3, 100, 30, ref.src, 10, 3 + (shift & 1), rops[op] );
+                ok( !memcmp( ref.dst_bits, dcs.dst_bits, size ), "shift %d rop %06lx: overlapping blit differs\n",
+                    shifts[shift], rops[op] );
+            }
+        }
+        destroy_primitive_dcs( &ref );
+
+        free( expect );
+        destroy_primitive_dcs( &dcs );
+        winetest_pop_context();
+    }
+}
+
+/* Large operations are drawn in bands by several threads; drawing them through
+ * clip strips small enough to stay on one thread must give the same bits. */
+static void draw_banded_op( HDC hdc, HDC src_dc, int op, int width, int height )
+{
+    static const BLENDFUNCTION blend = { AC_SRC_OVER, 0, 200, AC_SRC_ALPHA };
+    TRIVERTEX vert[3] =
+    {
+        {   10,    5, 0x1000, 0xff00, 0x8000, 0xc000 },
+        { width - 20, height - 3, 0xf000, 0x0800, 0x7700, 0x4000 },
+        {   30, height - 40, 0x0000, 0x8800, 0xff00, 0xff00 },
+    };
+    GRADIENT_RECT rect = { 0, 1 };
+    GRADIENT_TRIANGLE tri = { 0, 1, 2 };
+
+    switch (op)
+    {
+    case 0:
+        SetStretchBltMode( hdc, COLORONCOLOR );
+        StretchBlt( hdc, 3, 1, width - 7, height - 2, src_dc, 5, 2, width / 3, height / 3, SRCCOPY );
+        break;
+    case 1:
+        SetStretchBltMode( hdc, BLACKONWHITE );
+        StretchBlt( hdc, 0, 2, width - 2, height - 5, src_dc, 1, 0, width - 5, height - 20, SRCCOPY );
+        break;
+    case 2:
+        SetStretchBltMode( hdc, COLORONCOLOR );
+        StretchBlt( hdc, width - 1, height - 1, -width + 2, -height + 4, src_dc, 0, 0, width / 2 + 3, height - 9, SRCCOPY );
+        break;
+    case 3:
+        GdiAlphaBlend( hdc, 2, 3, width - 4, height - 6, src_dc, 1, 1, width - 4, height - 6, blend );
+        break;
+    case 4:
+        GdiGradientFill( hdc, vert, 2, &rect, 1, GRADIENT_FILL_RECT_H );
+        break;
+    case 5:
+        GdiGradientFill( hdc, vert, 2, &rect, 1, GRADIENT_FILL_RECT_V );
+        break;
+    case 6:
+        GdiGradientFill( hdc, vert, 3, &tri, 1, GRADIENT_FILL_TRIANGLE );
+        break;
+    }
+}
+
+static void test_banded_operations(void)
+{
+    const int width = 1024, height = 640, strip = 48;
+    int i, op, y, size;
+    struct primitive_dcs dcs;
+    HRGN rgn;
+    BYTE *expect;
+
+    for (i = 0; i < ARRAY_SIZE(primitive_formats); i++)
+    {
+        winetest_push_context( "%s", primitive_formats[i].name );
+        create_primitive_dcs( &dcs, &primitive_formats[i], width, height );
+        size = get_primitive_image_size( primitive_formats[i].bpp, width, height );
+        expect = malloc( size );
+
+        for (op = 0; op < 7; op++)
+        {
+            fill_primitive_bits( dcs.dst_bits, size, FALSE, op );
+            draw_banded_op( dcs.dst, op == 3 ? dcs.argb : dcs.src, op, width, height );
+            memcpy( expect, dcs.dst_bits, size );
+
+            fill_primitive_bits( dcs.dst_bits, size, FALSE, op );
+            for (y = 0; y < height; y += strip)
+            {
+                rgn = CreateRectRgn( 0, y, width, y + strip );
+                SelectClipRgn( dcs.dst, rgn );
+                DeleteObject( rgn );
+                draw_banded_op( dcs.dst, op == 3 ? dcs.argb : dcs.src, op, width, height );
+            }
+            SelectClipRgn( dcs.dst, NULL );
+            ok( !memcmp( expect, dcs.dst_bits, size ), "op %d: results differ\n", op );
+        }
+
+        free( expect );
+        destroy_primitive_dcs( &dcs );
+        winetest_pop_context();
+    }
+}
+
+static void test_primitive_performance(void)
+{
+    const int width = 1024, height = 256, count = 8;
+    RECT rect = { 8, 2, 1000, 252 };
+    LARGE_INTEGER freq, start, end;
+    struct primitive_dcs dcs;
+    int i, op, iter;
+
+    QueryPerformanceFrequency( &freq );
+
+    for (i = 0; i < ARRAY_SIZE(primitive_formats); i++)
+    {
+        create_primitive_dcs( &dcs, &primitive_formats[i], width, height );
+        for (op = 0; op < OP_COUNT; op++)
+        {
+            QueryPerformanceCounter( &start );
+            for (iter = 0; iter < count; iter++) draw_primitive( &dcs, op, &rect );
+            QueryPerformanceCounter( &end );
+            trace( "%s: %s: %.1f Mpixels/s\n", primitive_formats[i].name, primitive_op_names[op],
+                   (double)(rect.right - rect.left) * (rect.bottom - rect.top) * count * freq.QuadPart / max( end.QuadPart - start.QuadPart, 1 ) / 1e6 );
+        }
+        destroy_primitive_dcs( &dcs );
+    }
+}
+
 START_TEST(dib)
 {
     CryptAcquireContextW(&crypt_prov, NULL, NULL, PROV_RSA_FULL, CRYPT_VERIFYCONTEXT);
 
     test_simple_graphics();
+    test_primitive_edges();
+    test_banded_operations();
+    test_primitive_performance();
 
     CryptReleaseContext(crypt_prov, 0);
 }
@@ -5781,6 +5781,73 @@ static void test_fullname2(void)
 
 }
 
+static void test_GetGlyphOutline_shared_bitmaps(void)
+{
+    static const UINT formats[] = { GGO_BITMAP, GGO_GRAY2_BITMAP, GGO_GRAY4_BITMAP, GGO_GRAY8_BITMAP };
+    HFONT hfont, hfont2, old_hfont;
+    GLYPHMETRICS gm, gm2;
+    BYTE *buf, *buf2;
+    DWORD size, size2;
+    LOGFONTA lf;
+    unsigned int i;
+    HDC hdc;
+
+    if (!is_truetype_font_installed("Tahoma"))
+    {
+        skip("Tahoma is not installed\n");
+        return;
+    }
+
+    /* two fonts that differ only by their output precision resolve to the same face and size,
+     * rendering a glyph with one of them must not change the result for the other */
+    memset(&lf, 0, sizeof(lf));
+    lf.lfHeight = -17;
+    lstrcpyA(lf.lfFaceName, "Tahoma");
+    hfont = CreateFontIndirectA(&lf);
+    ok(hfont != 0, "CreateFontIndirectA error %lu\n", GetLastError());
+    lf.lfOutPrecision = OUT_TT_PRECIS;
+    hfont2 = CreateFontIndirectA(&lf);
+    ok(hfont2 != 0, "CreateFontIndirectA error %lu\n", GetLastError());
+
+    hdc = GetDC(NULL);
+    old_hfont = SelectObject(hdc, hfont);
+
+    for (i = 0; i < ARRAY_SIZE(formats); i++)
+    {
+        winetest_push_context("format %u", formats[i]);
+
+        SelectObject(hdc, hfont);
+        size = GetGlyphOutlineA(hdc, 'g', formats[i], &gm, 0, NULL, &mat);
+        ok(size != GDI_ERROR && size, "GetGlyphOutlineA failed\n");
+        buf = malloc(size);
+        memset(buf, 0, size);
+        size = GetGlyphOutlineA(hdc, 'g', formats[i], &gm, size, buf, &mat);
+        ok(size != GDI_ERROR, "GetGlyphOutlineA failed\n");
+
+        SelectObject(hdc, hfont2);
+        size2 = GetGlyphOutlineA(hdc, 'g', formats[(i + 1) % ARRAY_SIZE(formats)], &gm2, 0, NULL, &mat);
+        ok(size2 != GDI_ERROR, "GetGlyphOutlineA failed\n");
+        size2 = GetGlyphOutlineA(hdc, 'g', formats[i], &gm2, 0, NULL, &mat);
+        ok(size2 == size, "got size %lu, expected %lu\n", size2, size);
+        buf2 = malloc(size2);
+        memset(buf2, 0, size2);
+        size2 = GetGlyphOutlineA(hdc, 'g', formats[i], &gm2, size2, buf2, &mat);
+        ok(size2 == size, "got size %lu, expected %lu\n", size2, size);
+
+        ok(!memcmp(&gm, &gm2, sizeof(gm)), "glyph metrics differ\n");
+        if (size2 == size) ok(!memcmp(buf, buf2, size), "glyph bitmaps differ\n");
+
+        free(buf2);
+        free(buf);
+        winetest_pop_context();
+    }
+
+    SelectObject(hdc, old_hfont);
+    ReleaseDC(NULL, hdc);
+    DeleteObject(hfont2);
+    DeleteObject(hfont);
+}
+
 static void test_GetGlyphOutline_empty_contour(void)
 {
     HDC hdc;
@@ -7892,6 +7959,167 @@ static void test_font_weight(void)
     ok(bret, "got error %ld\n", GetLastError());
 }
 
+static INT CALLBACK font_index_face_proc( const LOGFONTW *lf, const TEXTMETRICW *tm, DWORD type, LPARAM lparam )
+{
+    const ENUMLOGFONTEXW *elf = (const ENUMLOGFONTEXW *)lf;
+    const NEWTEXTMETRICEXW *ntm = (const NEWTEXTMETRICEXW *)tm;
+
+    fprintf( (FILE *)lparam, "%ls|%ls|%ls|%u|%lu|%ld|", lf->lfFaceName, elf->elfFullName, elf->elfStyle,
+             lf->lfCharSet, type, tm->tmWeight );
+    if (type & TRUETYPE_FONTTYPE)
+        fprintf( (FILE *)lparam, "%lx|%lx|%lx\n", ntm->ntmTm.ntmFlags, ntm->ntmFontSig.fsCsb[0],
+                 ntm->ntmFontSig.fsUsb[0] );
+    else
+        fprintf( (FILE *)lparam, "%ld\n", tm->tmHeight );
+    return 1;
+}
+
+static INT CALLBACK font_index_family_proc( const LOGFONTW *lf, const TEXTMETRICW *tm, DWORD type, LPARAM lparam )
+{
+    LOGFONTW face = { 0 };
+    HDC hdc = CreateCompatibleDC( 0 );
+
+    face.lfCharSet = lf->lfCharSet;
+    lstrcpyW( face.lfFaceName, lf->lfFaceName );
+    EnumFontFamiliesExW( hdc, &face, font_index_face_proc, lparam, 0 );
+    DeleteDC( hdc );
+    return 1;
+}
+
+/* runs in a child process, so that the fonts are loaded with the index set up by the parent */
+static void test_font_index_child( const char *file )
+{
+    LOGFONTW lf = { 0 };
+    FILE *f;
+    HDC hdc;
+
+    f = fopen( file, "w" );
+    ok( !!f, "failed to open %s\n", file );
+    if (!f) return;
+
+    hdc = CreateCompatibleDC( 0 );
+    lf.lfCharSet = DEFAULT_CHARSET;
+    EnumFontFamiliesExW( hdc, &lf, font_index_family_proc, (LPARAM)f, 0 );
+    DeleteDC( hdc );
+    fclose( f );
+}
+
+static char *read_font_index_output( const char *file, DWORD *size )
+{
+    HANDLE handle;
+    char *data;
+
+    handle = CreateFileA( file, GENERIC_READ, 0, NULL, OPEN_EXISTING, 0, NULL );
+    ok( handle != INVALID_HANDLE_VALUE, "failed to open %s, error %lu\n", file, GetLastError() );
+    *size = 0;
+    if (handle == INVALID_HANDLE_VALUE) return NULL;
+    *size = GetFileSize( handle, NULL );
+    data = malloc( *size + 1 );
+    ReadFile( handle, data, *size, size, NULL );
+    CloseHandle( handle );
+    DeleteFileA( file );
+    return data;
+}
+
+static void run_font_index_child( const char *file )
+{
+    STARTUPINFOA startup = { sizeof(startup) };
+    char cmdline[MAX_PATH * 2];
+    PROCESS_INFORMATION info;
+    char **argv;
+
+    winetest_get_mainargs( &argv );
+    sprintf( cmdline, "\"%s\" font font_index \"%s\"", argv[0], file );
+    ok( CreateProcessA( NULL, cmdline, NULL, NULL, FALSE, 0, NULL, NULL, &startup, &info ),
+        "CreateProcess failed, error %lu\n", GetLastError() );
+    wait_child_process( &info );
+    CloseHandle( info.hProcess );
+    CloseHandle( info.hThread );
+}
+
+static BOOL find_font_index( const char *dir, char *index, DWORD *size )
+{
+    WIN32_FIND_DATAA data;
+    HANDLE handle;
+
+    sprintf( index, "%s\\wine\\fontindex-*", dir );
+    if ((handle = FindFirstFileA( index, &data )) == INVALID_HANDLE_VALUE) return FALSE;
+    FindClose( handle );
+    sprintf( index, "%s\\wine\\%s", dir, data.cFileName );
+    *size = data.nFileSizeLow;
+    return TRUE;
+}
+
+/* Wine keeps an index of the system fonts in $XDG_CACHE_HOME/wine, the fonts must be the
+ * same whether they were parsed or read from the index, and a damaged index must be ignored
+ * and rewritten. */
+static void test_font_index(void)
+{
+    char *(CDECL *pwine_get_unix_file_name)( const WCHAR *dos );
+    char dir[MAX_PATH], file[MAX_PATH], index[MAX_PATH];
+    char *unix_dir, *expect, *data, *old_cache = NULL;
+    DWORD expect_size, data_size, index_size, size;
+    WCHAR dirW[MAX_PATH];
+    HANDLE handle;
+
+    pwine_get_unix_file_name = (void *)GetProcAddress( GetModuleHandleA( "kernel32.dll" ), "wine_get_unix_file_name" );
+    if (!pwine_get_unix_file_name)
+    {
+        win_skip( "Not running on Wine, skipping font index tests.\n" );
+        return;
+    }
+
+    GetTempPathA( ARRAY_SIZE(dir), dir );
+    strcat( dir, "wine_font_index" );
+    CreateDirectoryA( dir, NULL );
+    sprintf( file, "%s\\fonts.txt", dir );
+    MultiByteToWideChar( CP_ACP, 0, dir, -1, dirW, ARRAY_SIZE(dirW) );
+    unix_dir = pwine_get_unix_file_name( dirW );
+    ok( !!unix_dir, "failed to get the unix name of %s\n", dir );
+
+    if ((size = GetEnvironmentVariableA( "XDG_CACHE_HOME", NULL, 0 )))
+    {
+        old_cache = malloc( size );
+        GetEnvironmentVariableA( "XDG_CACHE_HOME", old_cache, size );
+    }
+    SetEnvironmentVariableA( "XDG_CACHE_HOME", unix_dir );
+
+    /* no index yet, every font is parsed and the index is written */
+    run_font_index_child( file );
+    expect = read_font_index_output( file, &expect_size );
+    ok( expect_size > 0, "no fonts enumerated\n" );
+    ok( find_font_index( dir, index, &index_size ), "font index not written\n" );
+
+    /* every font comes from the index */
+    run_font_index_child( file );
+    data = read_font_index_output( file, &data_size );
+    ok( data && data_size == expect_size && !memcmp( data, expect, data_size ), "fonts differ with the index\n" );
+    free( data );
+
+    /* a truncated index is ignored and replaced */
+    handle = CreateFileA( index, GENERIC_WRITE, 0, NULL, OPEN_EXISTING, 0, NULL );
+    ok( handle != INVALID_HANDLE_VALUE, "failed to open %s, error %lu\n", index, GetLastError() );
+    SetFilePointer( handle, index_size / 2, NULL, FILE_BEGIN );
+    SetEndOfFile( handle );
+    CloseHandle( handle );
+
+    run_font_index_child( file );
+    data = read_font_index_output( file, &data_size );
+    ok( data && data_size == expect_size && !memcmp( data, expect, data_size ), "fonts differ with a bad index\n" );
+    free( data );
+    ok( find_font_index( dir, index, &size ), "font index not written\n" );
+    ok( size == index_size, "got index size %lu, expected %lu\n", size, index_size );
+
+    SetEnvironmentVariableA( "XDG_CACHE_HOME", old_cache );
+    free( old_cache );
+    free( expect );
+    HeapFree( GetProcessHeap(), 0, unix_dir );
+    DeleteFileA( index );
+    sprintf( index, "%s\\wine", dir );
+    RemoveDirectoryA( index );
+    RemoveDirectoryA( dir );
+}
+
 START_TEST(font)
 {
     static const char *test_names[] =
@@ -7910,6 +8138,8 @@ START_TEST(font)
     {
         if (!strcmp(argv[2], "AddFontMemResource"))
             test_AddFontMemResource();
+        else if (argc >= 4 && !strcmp(argv[2], "font_index"))
+            test_font_index_child(argv[3]);
         return;
     }
 
@@ -7955,6 +8185,7 @@ START_TEST(font)
     test_RealizationInfo();
     test_GetTextFace();
     test_GetGlyphOutline();
+    test_GetGlyphOutline_shared_bitmaps();
     test_GetTextMetrics2("Tahoma", -11);
     test_GetTextMetrics2("Tahoma", -55);
     test_GetTextMetrics2("Tahoma", -110);
@@ -7982,6 +8213,7 @@ START_TEST(font)
     test_char_width();
     test_select_object();
     test_font_weight();
+    test_font_index();
 
     /* These tests should be last test until RemoveFontResource
      * is properly implemented.
@@ -36,6 +36,7 @@
 #include "kernelbase.h"
 #include "wine/exception.h"
 #include "wine/debug.h"
+#include "wine/heapinfo.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(heap);
 WINE_DECLARE_DEBUG_CHANNEL(virtual);
@@ -791,10 +792,7 @@ BOOL WINAPI HeapSetInformation( HANDLE heap, HEAP_INFORMATION_CLASS infoclass, P
  */
 BOOL WINAPI HeapSummary( HANDLE heap, DWORD flags, LPHEAP_SUMMARY heap_summary )
 {
-    SIZE_T allocated = 0;
-    SIZE_T committed = 0;
-    SIZE_T uncommitted = 0;
-    PROCESS_HEAP_ENTRY entry;
+    HEAP_WINE_SUMMARY_INFORMATION info;
 
     if (heap_summary->cb != sizeof(*heap_summary))
     {
@@ -803,35 +801,12 @@ BOOL WINAPI HeapSummary( HANDLE heap, DWORD flags, LPHEAP_SUMMARY heap_summary )
         return FALSE;
     }
 
-    memset( &entry, 0, sizeof(entry) );
-
-    if (!HeapLock( heap ))
-        return FALSE;
-
-    while (HeapWalk( heap, &entry ))
-    {
-        if (entry.wFlags & PROCESS_HEAP_ENTRY_BUSY)
-        {
-            allocated += entry.cbData;
-        }
-        else if (entry.wFlags & PROCESS_HEAP_REGION)
-        {
-            committed += entry.Region.dwCommittedSize;
-            uncommitted += entry.Region.dwUnCommittedSize;
-        }
-    }
-
-    if (GetLastError() != ERROR_NO_MORE_ITEMS)
-    {
-        /* HeapWalk unsuccessful */
-        HeapUnlock( heap );
+    if (!set_ntstatus( RtlQueryHeapInformation( heap, HeapWineSummaryInformation, &info, sizeof(info), NULL )))
         return FALSE;
-    }
 
-    HeapUnlock( heap );
-    heap_summary->cbAllocated = allocated;
-    heap_summary->cbCommitted = committed;
-    heap_summary->cbReserved = committed + uncommitted;
+    heap_summary->cbAllocated = info.AllocatedSize;
+    heap_summary->cbCommitted = info.CommittedSize;
+    heap_summary->cbReserved = info.ReservedSize;
     heap_summary->cbMaxReserve = heap_summary->cbReserved;
 
     return TRUE;
@@ -31,6 +31,7 @@
 #include "wine/debug.h"
 #include "wine/list.h"
 #include "wine/mfinternal.h"
+#include "wine/mftrace.h"
 
 #include "mf_private.h"
 
@@ -3902,6 +3903,14 @@ static void session_deliver_sample_to_node(struct media_session *session, struct
             {
                 if (sample)
                 {
+                    LONGLONG time = 0;
+
+                    if (__wine_rtwq_trace_enabled())
+                    {
+                        IMFSample_GetSampleTime(sample, &time);
+                        __wine_rtwq_trace(WINE_MF_TRACE_SAMPLE_PRESENT, topo_node->object.sink_stream, time);
+                    }
+
                     if (FAILED(hr = IMFStreamSink_ProcessSample(topo_node->object.sink_stream, sample)))
                     {
                         WARN("Stream sink failed to process sample, hr %#lx.\n", hr);
@@ -3953,6 +3962,7 @@ static HRESULT session_request_sample_from_node(struct media_session *session, s
     switch (topo_node->type)
     {
         case MF_TOPOLOGY_SOURCESTREAM_NODE:
+            __wine_rtwq_trace(WINE_MF_TRACE_SAMPLE_REQUEST, topo_node->object.source_stream, 0);
             if (FAILED(hr = IMFMediaStream_RequestSample(topo_node->object.source_stream, NULL)))
                 WARN("Sample request failed, hr %#lx.\n", hr);
             break;
@@ -4025,6 +4035,7 @@ static void session_request_sample(struct media_session *session, IMFStreamSink
 static void session_deliver_sample(struct media_session *session, IMFMediaStream *stream, const PROPVARIANT *value)
 {
     struct topo_node *source_node = NULL, *node;
+    LONGLONG time = 0;
     DWORD input;
 
     if (value && (value->vt != VT_UNKNOWN || !value->punkVal))
@@ -4033,6 +4044,13 @@ static void session_deliver_sample(struct media_session *session, IMFMediaStream
         return;
     }
 
+    if (__wine_rtwq_trace_enabled())
+    {
+        if (value)
+            IMFSample_GetSampleTime((IMFSample *)value->punkVal, &time);
+        __wine_rtwq_trace(WINE_MF_TRACE_SAMPLE_DELIVER, stream, time);
+    }
+
     LIST_FOR_EACH_ENTRY(node, &session->presentation.nodes, struct topo_node, entry)
     {
         if (node->type == MF_TOPOLOGY_SOURCESTREAM_NODE && node->object.source_stream == stream)
@@ -5679,6 +5679,125 @@ failed:
     CoUninitialize();
 }
 
+/* Feeds the test stream pass_count times in a row, and returns the number of decoded frames. */
+static unsigned int decode_h264_passes(unsigned int pass_count)
+{
+    static const DWORD actual_width = 82, actual_height = 84;
+    static const DWORD aligned_width = 96, aligned_height = 96;
+
+    const struct attribute_desc input_type_desc[] =
+    {
+        ATTR_GUID(MF_MT_MAJOR_TYPE, MFMediaType_Video, .required = TRUE),
+        ATTR_GUID(MF_MT_SUBTYPE, MFVideoFormat_H264, .required = TRUE),
+        ATTR_RATIO(MF_MT_FRAME_SIZE, actual_width, actual_height),
+        {0},
+    };
+
+    const BYTE *h264_encoded_data, *h264_data;
+    IMFSample *input_sample, *output_sample;
+    ULONG h264_encoded_data_len, h264_len;
+    unsigned int pass = 0, frame_count = 0;
+    IMFMediaType *output_type;
+    IMFTransform *transform;
+    DWORD output_status;
+    BOOL draining = FALSE;
+    HRESULT hr;
+
+    if (FAILED(hr = CoCreateInstance(&CLSID_MSH264DecoderMFT, NULL, CLSCTX_INPROC_SERVER,
+            &IID_IMFTransform, (void **)&transform)))
+        return 0;
+
+    load_resource(L"h264data.bin", &h264_encoded_data, &h264_encoded_data_len);
+    h264_data = h264_encoded_data;
+    h264_len = h264_encoded_data_len;
+
+    check_mft_set_input_type(transform, input_type_desc, S_OK);
+
+    output_type = transform_find_available_output_type(transform, &MFVideoFormat_NV12);
+    hr = IMFTransform_SetOutputType(transform, 0, output_type, 0);
+    ok(hr == S_OK, "Unexpected hr %#lx.\n", hr);
+    IMFMediaType_Release(output_type);
+
+    hr = IMFTransform_ProcessMessage(transform, MFT_MESSAGE_NOTIFY_START_OF_STREAM, 0);
+    ok(hr == S_OK, "Unexpected hr %#lx.\n", hr);
+
+    output_sample = create_sample(NULL, aligned_width * aligned_height * 3 / 2);
+    for (;;)
+    {
+        MFT_OUTPUT_DATA_BUFFER output = {.pSample = output_sample};
+
+        hr = IMFTransform_ProcessOutput(transform, 0, 1, &output, &output_status);
+        ok(hr == S_OK || hr == MF_E_TRANSFORM_STREAM_CHANGE || hr == MF_E_TRANSFORM_NEED_MORE_INPUT,
+                "ProcessOutput returned %#lx\n", hr);
+
+        if (hr == S_OK)
+            frame_count++;
+        else if (hr == MF_E_TRANSFORM_STREAM_CHANGE)
+        {
+            output_type = transform_find_available_output_type(transform, &MFVideoFormat_NV12);
+            hr = IMFTransform_SetOutputType(transform, 0, output_type, 0);
+            ok(hr == S_OK, "Unexpected hr %#lx.\n", hr);
+            IMFMediaType_Release(output_type);
+        }
+        else if (hr == MF_E_TRANSFORM_NEED_MORE_INPUT)
+        {
+            if (h264_len <= 4 && ++pass < pass_count)
+            {
+                h264_data = h264_encoded_data;
+                h264_len = h264_encoded_data_len;
+            }
+
+            if (h264_len > 4)
+            {
+                input_sample = next_h264_sample(&h264_data, &h264_len);
+                hr = IMFTransform_ProcessInput(transform, 0, input_sample, 0);
+                ok(hr == S_OK, "ProcessInput returned %#lx\n", hr);
+                IMFSample_Release(input_sample);
+            }
+            else if (!draining)
+            {
+                hr = IMFTransform_ProcessMessage(transform, MFT_MESSAGE_COMMAND_DRAIN, 0);
+                ok(hr == S_OK, "Unexpected hr %#lx.\n", hr);
+                draining = TRUE;
+            }
+            else
+                break;
+        }
+        else
+            break;
+    }
+    IMFSample_Release(output_sample);
+
+    IMFTransform_Release(transform);
+
+    return frame_count;
+}
+
+static void test_h264_decoder_throughput(void)
+{
+    static const unsigned int pass_count = 20;
+    LARGE_INTEGER freq, start, end;
+    unsigned int frame_count;
+    double elapsed;
+    HRESULT hr;
+
+    hr = CoInitialize(NULL);
+    ok(hr == S_OK, "Failed to initialize, hr %#lx.\n", hr);
+
+    QueryPerformanceFrequency(&freq);
+
+    QueryPerformanceCounter(&start);
+    frame_count = decode_h264_passes(pass_count);
+    QueryPerformanceCounter(&end);
+
+    elapsed = (double)(end.QuadPart - start.QuadPart) / freq.QuadPart;
+    if (frame_count && elapsed > 0.0)
+        trace("h264dec: decoded %u frames in %.3f ms, %.1f frames/s.\n", frame_count, elapsed * 1000.0,
+                frame_count / elapsed);
+
+    CoUninitialize();
+}
+
 static void test_h264_decoder_concat_streams(void)
 {
     const struct buffer_desc output_buffer_desc[] =
@@ -11266,6 +11385,7 @@ START_TEST(transform)
     test_h264_decoder();
     test_h264_decoder_timestamps();
     test_h264_decoder_alignment();
+    test_h264_decoder_throughput();
     test_wmv_encoder();
     test_wmv_decoder();
     test_wmv_decoder_timestamps();
@@ -172,7 +172,8 @@ static ULONG WINAPI memory_buffer_Release(IMFMediaBuffer *iface)
             clear_attributes_object(&buffer->dxgi_surface.attributes);
         }
         DeleteCriticalSection(&buffer->cs);
-        free(buffer->_2d.linear_buffer);
+        if (buffer->_2d.linear_buffer != buffer->data)
+            free(buffer->_2d.linear_buffer);
         _aligned_free(buffer->data);
         free(buffer);
     }
@@ -290,6 +291,20 @@ static HRESULT WINAPI memory_1d_2d_buffer_QueryInterface(IMFMediaBuffer *iface,
     return S_OK;
 }
 
+static BOOL memory_2d_buffer_is_linear(const struct buffer *buffer)
+{
+    int pitch = buffer->_2d.pitch;
+
+    if (pitch < 0)
+        pitch = -pitch;
+
+    /* Rows are not padded and planes don't need to be rearranged, so backing memory already has the
+       linear layout. */
+    return pitch == buffer->_2d.width
+            && (!buffer->_2d.copy_image || buffer->_2d.copy_image == copy_image_nv12)
+            && buffer->_2d.plane_size <= buffer->max_length;
+}
+
 static HRESULT WINAPI memory_1d_2d_buffer_Lock(IMFMediaBuffer *iface, BYTE **data, DWORD *max_length, DWORD *current_length)
 {
     struct buffer *buffer = impl_from_IMFMediaBuffer(iface);
@@ -309,10 +324,11 @@ static HRESULT WINAPI memory_1d_2d_buffer_Lock(IMFMediaBuffer *iface, BYTE **dat
         hr = MF_E_INVALIDREQUEST;
     else if (!buffer->_2d.linear_buffer)
     {
-        if (!(buffer->_2d.linear_buffer = malloc(buffer->_2d.plane_size)))
+        if (memory_2d_buffer_is_linear(buffer))
+            buffer->_2d.linear_buffer = buffer->data;
+        else if (!(buffer->_2d.linear_buffer = malloc(buffer->_2d.plane_size)))
             hr = E_OUTOFMEMORY;
-
-        if (SUCCEEDED(hr))
+        else
         {
             int pitch = buffer->_2d.pitch;
 
@@ -350,12 +366,16 @@ static HRESULT WINAPI memory_1d_2d_buffer_Unlock(IMFMediaBuffer *iface)
     {
         int pitch = buffer->_2d.pitch;
 
-        if (pitch < 0)
-            pitch = -pitch;
-        copy_image(buffer, buffer->data, pitch, buffer->_2d.linear_buffer, buffer->_2d.width,
-                buffer->_2d.width, buffer->_2d.height);
+        /* Nothing to copy back when linear buffer points to backing memory. */
+        if (buffer->_2d.linear_buffer != buffer->data)
+        {
+            if (pitch < 0)
+                pitch = -pitch;
+            copy_image(buffer, buffer->data, pitch, buffer->_2d.linear_buffer, buffer->_2d.width,
+                    buffer->_2d.width, buffer->_2d.height);
 
-        free(buffer->_2d.linear_buffer);
+            free(buffer->_2d.linear_buffer);
+        }
         buffer->_2d.linear_buffer = NULL;
     }
 
@@ -35,6 +35,7 @@
 #include "uuids.h"
 
 #include "wine/list.h"
+#include "wine/mftrace.h"
 
 #include "mfplat_private.h"
 #include "mfreadwrite.h"
@@ -1615,12 +1616,30 @@ HRESULT WINAPI MFShutdown(void)
     return S_OK;
 }
 
-/***********************************************************************
- *      MFCopyImage (mfplat.@)
- */
-HRESULT WINAPI MFCopyImage(BYTE *dest, LONG deststride, const BYTE *src, LONG srcstride, DWORD width, DWORD lines)
+/* Images larger than this are split in stripes, copied by several threadpool workers. */
+#define COPY_IMAGE_PARALLEL_THRESHOLD (2 * 1024 * 1024)
+#define COPY_IMAGE_STRIPE_LINES 64
+#define COPY_IMAGE_MAX_WORKERS 4
+
+struct copy_image_context
 {
-    TRACE("%p, %ld, %p, %ld, %lu, %lu.\n", dest, deststride, src, srcstride, width, lines);
+    BYTE *dest;
+    LONG deststride;
+    const BYTE *src;
+    LONG srcstride;
+    DWORD width;
+    DWORD lines;
+    LONG next_stripe;
+};
+
+static void copy_image_lines(BYTE *dest, LONG deststride, const BYTE *src, LONG srcstride, DWORD width, DWORD lines)
+{
+    /* Rows are adjacent in both images, copy everything at once. */
+    if (deststride == srcstride && srcstride == width)
+    {
+        memcpy(dest, src, (SIZE_T)width * lines);
+        return;
+    }
 
     while (lines--)
     {
@@ -1628,6 +1647,89 @@ HRESULT WINAPI MFCopyImage(BYTE *dest, LONG deststride, const BYTE *src, LONG sr
         dest += deststride;
         src += srcstride;
     }
+}
+
+static void copy_image_stripes(struct copy_image_context *context)
+{
+    DWORD first, lines;
+
+    for (;;)
+    {
+        first = (InterlockedIncrement(&context->next_stripe) - 1) * COPY_IMAGE_STRIPE_LINES;
+        if (first >= context->lines)
+            break;
+
+        lines = min(COPY_IMAGE_STRIPE_LINES, context->lines - first);
+        copy_image_lines(context->dest + (INT_PTR)first * context->deststride, context->deststride,
+                context->src + (INT_PTR)first * context->srcstride, context->srcstride, context->width, lines);
+    }
+}
+
+static void CALLBACK copy_image_worker(TP_CALLBACK_INSTANCE *instance, void *context, TP_WORK *work)
+{
+    copy_image_stripes(context);
+}
+
+static unsigned int get_copy_image_workers(void)
+{
+    static LONG workers;
+    SYSTEM_INFO info;
+
+    if (!workers)
+    {
+        GetSystemInfo(&info);
+        InterlockedExchange(&workers, max(1, min(info.dwNumberOfProcessors, COPY_IMAGE_MAX_WORKERS)));
+    }
+
+    return workers;
+}
+
+static void copy_image(BYTE *dest, LONG deststride, const BYTE *src, LONG srcstride, DWORD width, DWORD lines)
+{
+    struct copy_image_context context;
+    unsigned int i, workers;
+    TP_WORK *work;
+
+    if ((UINT64)width * lines < COPY_IMAGE_PARALLEL_THRESHOLD || lines < 2 * COPY_IMAGE_STRIPE_LINES
+            || (workers = get_copy_image_workers()) < 2)
+    {
+        copy_image_lines(dest, deststride, src, srcstride, width, lines);
+        return;
+    }
+
+    context.dest = dest;
+    context.deststride = deststride;
+    context.src = src;
+    context.srcstride = srcstride;
+    context.width = width;
+    context.lines = lines;
+    context.next_stripe = 0;
+
+    if (!(work = CreateThreadpoolWork(copy_image_worker, &context, NULL)))
+    {
+        copy_image_lines(dest, deststride, src, srcstride, width, lines);
+        return;
+    }
+
+    /* Calling thread takes part in the copy, helpers pick remaining stripes. Once the calling thread
+       runs out of stripes, callbacks that haven't started have nothing left to do. */
+    for (i = 1; i < workers; ++i)
+        SubmitThreadpoolWork(work);
+    copy_image_stripes(&context);
+    WaitForThreadpoolWorkCallbacks(work, TRUE);
+    CloseThreadpoolWork(work);
+}
+
+/***********************************************************************
+ *      MFCopyImage (mfplat.@)
+ */
+HRESULT WINAPI MFCopyImage(BYTE *dest, LONG deststride, const BYTE *src, LONG srcstride, DWORD width, DWORD lines)
+{
+    TRACE("%p, %ld, %p, %ld, %lu, %lu.\n", dest, deststride, src, srcstride, width, lines);
+
+    __wine_rtwq_trace(WINE_MF_TRACE_COPY_BEGIN, dest, (LONGLONG)width * lines);
+    copy_image(dest, deststride, src, srcstride, width, lines);
+    __wine_rtwq_trace(WINE_MF_TRACE_COPY_END, dest, (LONGLONG)width * lines);
 
     return S_OK;
 }
@@ -4232,7 +4232,9 @@ static void test_allocate_queue(void)
 
 static void test_MFCopyImage(void)
 {
+    BYTE *dest_image, *src_image;
     DWORD dest[4], src[4];
+    unsigned int i;
     HRESULT hr;
 
     if (!pMFCopyImage)
@@ -4276,6 +4278,25 @@ static void test_MFCopyImage(void)
     hr = pMFCopyImage((BYTE *)dest, 8, (const BYTE *)src, 8, 8, 2);
     ok(hr == S_OK, "Failed to copy image %#lx.\n", hr);
     ok(!memcmp(dest, src, 16), "Unexpected buffer contents.\n");
+
+    /* Large image, with padded rows. */
+    src_image = malloc(4160 * 1088);
+    dest_image = malloc(4224 * 1088);
+    for (i = 0; i < 4160 * 1088; ++i)
+        src_image[i] = i % 251;
+    memset(dest_image, 0xaa, 4224 * 1088);
+
+    hr = pMFCopyImage(dest_image, 4224, src_image, 4160, 4096, 1088);
+    ok(hr == S_OK, "Failed to copy image %#lx.\n", hr);
+    for (i = 0; i < 1088; ++i)
+    {
+        if (memcmp(dest_image + i * 4224, src_image + i * 4160, 4096)) break;
+        if (dest_image[i * 4224 + 4096] != 0xaa || dest_image[i * 4224 + 4223] != 0xaa) break;
+    }
+    ok(i == 1088, "Unexpected contents at line %u.\n", i);
+
+    free(dest_image);
+    free(src_image);
 }
 
 static void test_MFCreateCollection(void)
@@ -7847,6 +7868,43 @@ static void test_MFCreate2DMediaBuffer(void)
         IMF2DBuffer_Release(_2dbuffer);
         IMFMediaBuffer_Release(buffer);
     }
+
+    /* Rows that don't need padding, linear and 2D layouts are the same. */
+    hr = pMFCreate2DMediaBuffer(64, 4, MAKEFOURCC('N','V','1','2'), FALSE, &buffer);
+    ok(hr == S_OK, "Failed to create a buffer, hr %#lx.\n", hr);
+
+    hr = IMFMediaBuffer_QueryInterface(buffer, &IID_IMF2DBuffer, (void **)&_2dbuffer);
+    ok(hr == S_OK, "Failed to get interface, hr %#lx.\n", hr);
+
+    hr = IMF2DBuffer_Lock2D(_2dbuffer, &data, &pitch);
+    ok(hr == S_OK, "Failed to lock buffer, hr %#lx.\n", hr);
+    ok(pitch == 64, "Unexpected pitch %ld.\n", pitch);
+    for (i = 0; i < 64 * 6; ++i)
+        data[i] = i % 251;
+    hr = IMF2DBuffer_Unlock2D(_2dbuffer);
+    ok(hr == S_OK, "Failed to unlock buffer, hr %#lx.\n", hr);
+
+    hr = IMFMediaBuffer_Lock(buffer, &data, &max_length, &length);
+    ok(hr == S_OK, "Failed to lock buffer, hr %#lx.\n", hr);
+    ok(length == 64 * 6, "Unexpected length %lu.\n", length);
+    for (i = 0; i < 64 * 6; ++i)
+        if (data[i] != i % 251) break;
+    ok(i == 64 * 6, "Unexpected byte %02x at %d.\n", i < 64 * 6 ? data[i] : 0, i);
+    for (i = 0; i < 64 * 6; ++i)
+        data[i] = (i + 7) % 251;
+    hr = IMFMediaBuffer_Unlock(buffer);
+    ok(hr == S_OK, "Failed to unlock buffer, hr %#lx.\n", hr);
+
+    hr = IMF2DBuffer_Lock2D(_2dbuffer, &data, &pitch);
+    ok(hr == S_OK, "Failed to lock buffer, hr %#lx.\n", hr);
+    for (i = 0; i < 64 * 6; ++i)
+        if (data[i] != (i + 7) % 251) break;
+    ok(i == 64 * 6, "Unexpected byte %02x at %d.\n", i < 64 * 6 ? data[i] : 0, i);
+    hr = IMF2DBuffer_Unlock2D(_2dbuffer);
+    ok(hr == S_OK, "Failed to unlock buffer, hr %#lx.\n", hr);
+
+    IMF2DBuffer_Release(_2dbuffer);
+    IMFMediaBuffer_Release(buffer);
 }
 
 static void test_MFCreateMediaBufferFromMediaType(void)
@@ -35,8 +35,10 @@
 #include "ntdll_misc.h"
 #include "wine/list.h"
 #include "wine/debug.h"
+#include "wine/heapinfo.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(heap);
+WINE_DECLARE_DEBUG_CHANNEL(heapstats);
 
 /* HeapCompatibilityInformation values */
 
@@ -269,6 +271,12 @@ struct bin
      * hopefully in separate cache lines.
      */
     struct group **affinity_group_base;
+
+    /* LFH statistics, only updated when enabled for the heap */
+    LONG stat_alloc;
+    LONG stat_freed;
+    LONG stat_affinity_hits;
+    LONG stat_cache_hits;
 };
 
 static inline struct group **bin_get_affinity_group( struct bin *bin, BYTE affinity )
@@ -289,6 +297,7 @@ struct heap
     /* end of the Windows 10 compatible struct layout */
 
     LONG             compat_info;   /* HeapCompatibilityInformation / heap frontend type */
+    LONG             stats_enabled; /* HeapWineStatisticsInformation / whether LFH counters are updated */
     struct list      entry;         /* Entry in process heap list */
     struct list      subheap_list;  /* Sub-heap list */
     struct list      large_list;    /* Large blocks list */
@@ -310,6 +319,13 @@ C_ASSERT( offsetof(struct heap, subheap) <= REGION_ALIGN - 1 );
 
 #define HEAP_MAGIC       ((DWORD)('H' | ('E'<<8) | ('A'<<16) | ('P'<<24)))
 
+/* the statistics are opt-in, and updated without interlocked operations to keep the LFH fast path cheap */
+static inline void heap_stat_increment( const struct heap *heap, LONG *counter )
+{
+    if (!ReadNoFence( &heap->stats_enabled )) return;
+    WriteNoFence( counter, ReadNoFence( counter ) + 1 );
+}
+
 #define HEAP_INITIAL_SIZE      0x10000
 #define HEAP_INITIAL_GROW_SIZE 0x100000
 #define HEAP_MAX_GROW_SIZE     0xfd0000
@@ -330,6 +346,24 @@ C_ASSERT( HEAP_MIN_LARGE_BLOCK_SIZE <= HEAP_INITIAL_GROW_SIZE );
 
 static struct heap *process_heap;  /* main process heap */
 
+/* thread local caches of freed LFH blocks, in front of the process heap LFH */
+#define THREAD_CACHE_BIN_COUNT  0x30  /* blocks up to BIN_SIZE_MIN_3 */
+#define THREAD_CACHE_DEPTH      16
+#define THREAD_CACHE_STAT_BATCH 256   /* cache hits counted locally before updating the shared bin statistics */
+
+struct thread_cache
+{
+    BYTE          count[THREAD_CACHE_BIN_COUNT];
+    struct block *blocks[THREAD_CACHE_BIN_COUNT][THREAD_CACHE_DEPTH];
+    ULONG         hits[THREAD_CACHE_BIN_COUNT];
+};
+
+C_ASSERT( BLOCK_BIN_SIZE( THREAD_CACHE_BIN_COUNT - 1 ) == BIN_SIZE_MIN_3 );
+C_ASSERT( THREAD_CACHE_DEPTH <= 0xff );
+C_ASSERT( sizeof(struct thread_cache) > BIN_SIZE_MIN_3 );
+
+static LONG thread_cache_enabled;
+
 static NTSTATUS heap_free_block_lfh( struct heap *heap, ULONG flags, struct block *block );
 
 /* check if memory range a contains memory range b */
@@ -1525,6 +1559,7 @@ HANDLE WINAPI RtlCreateHeap( ULONG flags, void *addr, SIZE_T total_size, SIZE_T
     heap->auto_flags    = (flags & HEAP_GROWABLE);
     heap->flags         = (flags & ~HEAP_SHARED);
     heap->compat_info   = HEAP_STD;
+    heap->stats_enabled = TRACE_ON(heapstats);
     heap->magic         = HEAP_MAGIC;
     heap->grow_size     = HEAP_INITIAL_GROW_SIZE;
     heap->min_size      = commit_size;
@@ -1863,7 +1898,10 @@ static struct group *heap_acquire_bin_group( struct heap *heap, ULONG flags, SIZ
     SLIST_ENTRY *entry;
 
     if ((group = InterlockedExchangePointer( (void *)bin_get_affinity_group( bin, affinity ), NULL )))
+    {
+        heap_stat_increment( heap, &bin->stat_affinity_hits );
         return group;
+    }
 
     if ((entry = RtlInterlockedPopEntrySList( &bin->groups )))
         return CONTAINING_RECORD( entry, struct group, entry );
@@ -1939,6 +1977,7 @@ static NTSTATUS heap_allocate_block_lfh( struct heap *heap, ULONG flags, SIZE_T
         initialize_block( block, 0, size, flags );
         mark_block_tail( block, flags );
         *ret = block + 1;
+        heap_stat_increment( heap, &bin->stat_alloc );
     }
 
     return block ? STATUS_SUCCESS : STATUS_NO_MEMORY;
@@ -1961,6 +2000,7 @@ static NTSTATUS heap_free_block_lfh( struct heap *heap, ULONG flags, struct bloc
     block_set_type( block, BLOCK_TYPE_FREE );
     block_set_flags( block, (BYTE)~BLOCK_FLAG_LFH, BLOCK_FLAG_FREE );
     mark_block_free( block + 1, (char *)block + block_size - (char *)(block + 1), flags );
+    heap_stat_increment( heap, &bin->stat_freed );
 
     /* if this was the last used block in a group and GROUP_FLAG_FREE was set */
     if (InterlockedOr( &group->free_bits, 1 << i ) == ~(1 << i))
@@ -2002,6 +2042,93 @@ static void bin_try_enable( struct heap *heap, struct bin *bin )
     WriteRelease( &bin->enabled, TRUE );
 }
 
+/* cached blocks skip free and tail checking, only use the caches when heap debugging is disabled */
+static inline BOOL heap_can_use_thread_cache( struct heap *heap, ULONG flags )
+{
+    static const ULONG check_flags = HEAP_TAIL_CHECKING_ENABLED | HEAP_FREE_CHECKING_ENABLED | HEAP_CHECKING_ENABLED |
+                                     HEAP_VALIDATE | HEAP_VALIDATE_ALL | HEAP_VALIDATE_PARAMS;
+    return heap == process_heap && !(flags & check_flags) && !heap->pending_free;
+}
+
+static inline BOOL heap_use_thread_cache( struct heap *heap, ULONG flags )
+{
+    return ReadNoFence( &thread_cache_enabled ) && heap_can_use_thread_cache( heap, flags );
+}
+
+/* allocate a block from the thread cache, cached blocks are LFH blocks marked as delay freed */
+static NTSTATUS heap_allocate_block_cache( struct heap *heap, ULONG flags, SIZE_T block_size,
+                                           SIZE_T size, void **ret )
+{
+    SIZE_T bin = BLOCK_SIZE_BIN( block_size );
+    struct thread_cache *cache;
+    struct block *block;
+
+    if (bin >= THREAD_CACHE_BIN_COUNT || !heap_use_thread_cache( heap, flags )) return STATUS_UNSUCCESSFUL;
+    if (!(cache = NtCurrentTeb()->ReservedForPerf) || !cache->count[bin]) return STATUS_UNSUCCESSFUL;
+
+    block = cache->blocks[bin][--cache->count[bin]];
+    block_set_type( block, BLOCK_TYPE_USED );
+    block_set_flags( block, (BYTE)~BLOCK_FLAG_LFH, BLOCK_USER_FLAGS( flags ) );
+    block->tail_size = block_get_size( block ) - sizeof(*block) - size;
+    initialize_block( block, 0, size, flags );
+    mark_block_tail( block, flags );
+    *ret = block + 1;
+
+    /* keep the shared bin statistics out of the fast path, they are updated in batches */
+    if (ReadNoFence( &heap->stats_enabled ) && ++cache->hits[bin] == THREAD_CACHE_STAT_BATCH)
+    {
+        InterlockedAdd( &heap->bins[bin].stat_cache_hits, cache->hits[bin] );
+        cache->hits[bin] = 0;
+    }
+
+    return STATUS_SUCCESS;
+}
+
+/* keep a freed LFH block in the thread cache, the block is released to its group if the cache is full */
+static NTSTATUS heap_free_block_cache( struct heap *heap, ULONG flags, struct block *block )
+{
+    SIZE_T bin = BLOCK_SIZE_BIN( block_get_size( block ) );
+    struct thread_cache *cache;
+
+    if (!(block_get_flags( block ) & BLOCK_FLAG_LFH)) return STATUS_UNSUCCESSFUL;
+    if (bin >= THREAD_CACHE_BIN_COUNT || !heap_use_thread_cache( heap, flags )) return STATUS_UNSUCCESSFUL;
+
+    if (!(cache = NtCurrentTeb()->ReservedForPerf))
+    {
+        /* the cache is larger than the cached block sizes, and won't recurse */
+        if (!(cache = RtlAllocateHeap( heap, HEAP_ZERO_MEMORY, sizeof(*cache) ))) return STATUS_UNSUCCESSFUL;
+        NtCurrentTeb()->ReservedForPerf = cache;
+    }
+    if (cache->count[bin] == THREAD_CACHE_DEPTH) return STATUS_UNSUCCESSFUL;
+
+    valgrind_make_writable( block, sizeof(*block) );
+    block_set_type( block, BLOCK_TYPE_DEAD );
+    cache->blocks[bin][cache->count[bin]++] = block;
+    return STATUS_SUCCESS;
+}
+
+static void heap_thread_detach_cache( struct heap *heap )
+{
+    struct thread_cache *cache;
+    ULONG bin;
+
+    if (!(cache = NtCurrentTeb()->ReservedForPerf)) return;
+    NtCurrentTeb()->ReservedForPerf = NULL;
+
+    for (bin = 0; bin < THREAD_CACHE_BIN_COUNT; bin++)
+    {
+        if (cache->hits[bin]) InterlockedAdd( &heap->bins[bin].stat_cache_hits, cache->hits[bin] );
+        while (cache->count[bin])
+        {
+            struct block *block = cache->blocks[bin][--cache->count[bin]];
+            block_set_type( block, BLOCK_TYPE_USED );
+            heap_free_block_lfh( heap, heap->flags, block );
+        }
+    }
+
+    RtlFreeHeap( heap, 0, cache );
+}
+
 static void heap_thread_detach_bin_groups( struct heap *heap )
 {
     ULONG i, affinity = NtCurrentTeb()->HeapVirtualAffinity;
@@ -2021,6 +2148,8 @@ void heap_thread_detach(void)
 {
     struct heap *heap;
 
+    heap_thread_detach_cache( process_heap );
+
     RtlEnterCriticalSection( &process_heap->cs );
 
     LIST_FOR_EACH_ENTRY( heap, &process_heap->entry, struct heap, entry )
@@ -2047,6 +2176,8 @@ void *WINAPI DECLSPEC_HOTPATCH RtlAllocateHeap( HANDLE handle, ULONG flags, SIZE
         status = STATUS_NO_MEMORY;
     else if (block_size >= HEAP_MIN_LARGE_BLOCK_SIZE)
         status = heap_allocate_large( heap, heap_flags, block_size, size, &ptr );
+    else if (heap->bins && !heap_allocate_block_cache( heap, heap_flags, block_size, size, &ptr ))
+        status = STATUS_SUCCESS;
     else if (heap->bins && !heap_allocate_block_lfh( heap, heap_flags, block_size, size, &ptr ))
         status = STATUS_SUCCESS;
     else
@@ -2093,6 +2224,8 @@ BOOLEAN WINAPI DECLSPEC_HOTPATCH RtlFreeHeap( HANDLE handle, ULONG flags, void *
         status = heap_free_large( heap, heap_flags, block );
     else if (!(block = heap_delay_free( heap, heap_flags, block )))
         status = STATUS_SUCCESS;
+    else if (!heap_free_block_cache( heap, heap_flags, block ))
+        status = STATUS_SUCCESS;
     else if (!heap_free_block_lfh( heap, heap_flags, block ))
         status = STATUS_SUCCESS;
     else
@@ -2552,6 +2685,145 @@ ULONG WINAPI RtlGetProcessHeaps( ULONG count, HANDLE *heaps )
     return total;
 }
 
+/* compute the heap summary statistics, heap must be locked */
+static void heap_get_summary( const struct heap *heap, HEAP_WINE_SUMMARY_INFORMATION *info )
+{
+    const struct block *block;
+    const ARENA_LARGE *large;
+    const SUBHEAP *subheap;
+
+    memset( info, 0, sizeof(*info) );
+
+    LIST_FOR_EACH_ENTRY( subheap, &heap->subheap_list, SUBHEAP, entry )
+    {
+        const char *base = subheap_base( subheap );
+
+        info->SubheapCount++;
+        info->CommittedSize += (const char *)subheap_commit_end( subheap ) - base;
+        info->ReservedSize += subheap_size( subheap );
+
+        for (block = first_block( subheap ); block; block = next_block( subheap, block ))
+        {
+            SIZE_T size = block_get_size( block ) - block_get_overhead( block );
+
+            if (block_get_flags( block ) & BLOCK_FLAG_FREE)
+            {
+                info->FreeBlockCount++;
+                info->FreeSize += size;
+            }
+            else
+            {
+                info->BusyBlockCount++;
+                info->AllocatedSize += size;
+            }
+        }
+    }
+
+    LIST_FOR_EACH_ENTRY( large, &heap->large_list, ARENA_LARGE, entry )
+    {
+        SIZE_T size = offsetof( ARENA_LARGE, block ) + large->block_size;
+
+        info->LargeBlockCount++;
+        info->AllocatedSize += large->data_size;
+        info->CommittedSize += size;
+        info->ReservedSize += size;
+    }
+}
+
+/* add the used blocks of an LFH group to the bin statistics */
+static void bin_info_add_group( HEAP_WINE_BIN_INFORMATION *info, ULONG count, const struct block *block )
+{
+    const struct group *group = (const struct group *)(block + 1);
+    ULONG bin = BLOCK_SIZE_BIN( block_get_size( &group->first_block ) );
+    ULONG free_bits = ReadNoFence( &group->free_bits ) & ~GROUP_FLAG_FREE, used = GROUP_BLOCK_COUNT;
+
+    if (bin >= count) return;
+    for (; free_bits; free_bits &= free_bits - 1) used--;
+    info[bin].GroupCount++;
+    info[bin].UsedBlockCount += used;
+}
+
+/* compute the per size class statistics, heap must be locked */
+static void heap_get_bin_info( const struct heap *heap, HEAP_WINE_BIN_INFORMATION *info, ULONG count )
+{
+    const struct block *block;
+    const ARENA_LARGE *large;
+    const struct thread_cache *cache = heap == process_heap ? NtCurrentTeb()->ReservedForPerf : NULL;
+    const SUBHEAP *subheap;
+    ULONG i;
+
+    for (i = 0; i < count; i++)
+    {
+        const struct bin *bin = heap->bins + i;
+
+        info[i].BlockSize = BLOCK_BIN_SIZE( i );
+        info[i].Enabled = ReadNoFence( &bin->enabled );
+        info[i].BackendAllocCount = ReadNoFence( &bin->count_alloc );
+        info[i].BackendFreeCount = ReadNoFence( &bin->count_freed );
+        info[i].AllocCount = ReadNoFence( &bin->stat_alloc );
+        info[i].FreeCount = ReadNoFence( &bin->stat_freed );
+        info[i].AffinityHitCount = ReadNoFence( &bin->stat_affinity_hits );
+        info[i].CacheHitCount = ReadNoFence( &bin->stat_cache_hits );
+        /* other threads cache hits are only included in batches */
+        if (cache && i < THREAD_CACHE_BIN_COUNT) info[i].CacheHitCount += cache->hits[i];
+        info[i].GroupCount = 0;
+        info[i].UsedBlockCount = 0;
+    }
+
+    /* LFH groups are busy blocks of the backend */
+    LIST_FOR_EACH_ENTRY( subheap, &heap->subheap_list, SUBHEAP, entry )
+    {
+        for (block = first_block( subheap ); block; block = next_block( subheap, block ))
+            if ((block_get_flags( block ) & (BLOCK_FLAG_FREE | BLOCK_FLAG_LFH)) == BLOCK_FLAG_LFH)
+                bin_info_add_group( info, count, block );
+    }
+    LIST_FOR_EACH_ENTRY( large, &heap->large_list, ARENA_LARGE, entry )
+        if (block_get_flags( &large->block ) & BLOCK_FLAG_LFH) bin_info_add_group( info, count, &large->block );
+}
+
+static void heap_dump_stats( struct heap *heap )
+{
+    HEAP_WINE_BIN_INFORMATION info[BLOCK_SIZE_BIN_COUNT - 1];
+    HEAP_WINE_SUMMARY_INFORMATION summary;
+    ULONG i, count = heap->bins ? ARRAY_SIZE(info) : 0;
+
+    heap_lock( heap, 0 );
+    heap_get_summary( heap, &summary );
+    if (count) heap_get_bin_info( heap, info, count );
+    heap_unlock( heap, 0 );
+
+    TRACE_(heapstats)( "heap %p: allocated %#Ix free %#Ix committed %#Ix reserved %#Ix, "
+                       "%lu subheaps, %lu large, %lu busy, %lu free blocks\n", heap,
+                       summary.AllocatedSize, summary.FreeSize, summary.CommittedSize, summary.ReservedSize,
+                       summary.SubheapCount, summary.LargeBlockCount, summary.BusyBlockCount,
+                       summary.FreeBlockCount );
+
+    for (i = 0; i < count; i++)
+    {
+        if (!info[i].AllocCount && !info[i].BackendAllocCount) continue;
+        TRACE_(heapstats)( "  bin %3lu size %#5Ix%s: backend alloc %lu free %lu, lfh alloc %lu free %lu "
+                           "affinity hits %lu, cache hits %lu, %lu groups, %lu used blocks\n", i, info[i].BlockSize,
+                           info[i].Enabled ? " (lfh)" : "", info[i].BackendAllocCount, info[i].BackendFreeCount,
+                           info[i].AllocCount, info[i].FreeCount, info[i].AffinityHitCount, info[i].CacheHitCount,
+                           info[i].GroupCount, info[i].UsedBlockCount );
+    }
+}
+
+/* dump the statistics of all the process heaps, called at process exit */
+void heap_process_detach(void)
+{
+    struct heap *heap;
+
+    if (!TRACE_ON(heapstats)) return;
+
+    heap_dump_stats( process_heap );
+
+    RtlEnterCriticalSection( &process_heap->cs );
+    LIST_FOR_EACH_ENTRY( heap, &process_heap->entry, struct heap, entry )
+        heap_dump_stats( heap );
+    RtlLeaveCriticalSection( &process_heap->cs );
+}
+
 /***********************************************************************
  *           RtlQueryHeapInformation    (NTDLL.@)
  */
@@ -2563,7 +2835,7 @@ NTSTATUS WINAPI RtlQueryHeapInformation( HANDLE handle, HEAP_INFORMATION_CLASS i
 
     TRACE( "handle %p, info_class %u, info %p, size_in %Iu, size_out %p.\n", handle, info_class, info, size_in, size_out );
 
-    switch (info_class)
+    switch ((ULONG)info_class)  /* Wine-specific classes are not part of the enumeration */
     {
     case HeapCompatibilityInformation:
         if (!(heap = unsafe_heap_from_handle( handle, 0, &flags ))) return STATUS_ACCESS_VIOLATION;
@@ -2572,6 +2844,44 @@ NTSTATUS WINAPI RtlQueryHeapInformation( HANDLE handle, HEAP_INFORMATION_CLASS i
         *(ULONG *)info = ReadNoFence( &heap->compat_info );
         return STATUS_SUCCESS;
 
+    case HeapWineSummaryInformation:
+        if (!(heap = unsafe_heap_from_handle( handle, 0, &flags ))) return STATUS_ACCESS_VIOLATION;
+        if (size_out) *size_out = sizeof(HEAP_WINE_SUMMARY_INFORMATION);
+        if (size_in < sizeof(HEAP_WINE_SUMMARY_INFORMATION)) return STATUS_BUFFER_TOO_SMALL;
+        heap_lock( heap, flags );
+        heap_get_summary( heap, info );
+        heap_unlock( heap, flags );
+        return STATUS_SUCCESS;
+
+    case HeapWineBinInformation:
+    {
+        ULONG count;
+
+        if (!(heap = unsafe_heap_from_handle( handle, 0, &flags ))) return STATUS_ACCESS_VIOLATION;
+        count = heap->bins ? BLOCK_SIZE_BIN_COUNT - 1 : 0;  /* the last bin is never used by the LFH */
+        if (size_out) *size_out = count * sizeof(HEAP_WINE_BIN_INFORMATION);
+        if (size_in < count * sizeof(HEAP_WINE_BIN_INFORMATION)) return STATUS_BUFFER_TOO_SMALL;
+        if (!count) return STATUS_SUCCESS;
+        heap_lock( heap, flags );
+        heap_get_bin_info( heap, info, count );
+        heap_unlock( heap, flags );
+        return STATUS_SUCCESS;
+    }
+
+    case HeapWineStatisticsInformation:
+        if (!(heap = unsafe_heap_from_handle( handle, 0, &flags ))) return STATUS_ACCESS_VIOLATION;
+        if (size_out) *size_out = sizeof(ULONG);
+        if (size_in < sizeof(ULONG)) return STATUS_BUFFER_TOO_SMALL;
+        *(ULONG *)info = ReadNoFence( &heap->stats_enabled );
+        return STATUS_SUCCESS;
+
+    case HeapWineThreadCacheInformation:
+        if (!(heap = unsafe_heap_from_handle( handle, 0, &flags ))) return STATUS_ACCESS_VIOLATION;
+        if (size_out) *size_out = sizeof(ULONG);
+        if (size_in < sizeof(ULONG)) return STATUS_BUFFER_TOO_SMALL;
+        *(ULONG *)info = heap_use_thread_cache( heap, flags );
+        return STATUS_SUCCESS;
+
     default:
         FIXME( "HEAP_INFORMATION_CLASS %u not implemented!\n", info_class );
         return STATUS_INVALID_INFO_CLASS;
@@ -2597,7 +2907,7 @@ NTSTATUS WINAPI RtlSetHeapInformation( HANDLE handle, HEAP_INFORMATION_CLASS inf
 
     TRACE( "handle %p, info_class %u, info %p, size %Iu.\n", handle, info_class, info, size );
 
-    switch (info_class)
+    switch ((ULONG)info_class)
     {
     case HeapCompatibilityInformation:
     {
@@ -2618,6 +2928,27 @@ NTSTATUS WINAPI RtlSetHeapInformation( HANDLE handle, HEAP_INFORMATION_CLASS inf
         return STATUS_SUCCESS;
     }
 
+    case HeapWineStatisticsInformation:
+        if (size < sizeof(ULONG)) return STATUS_BUFFER_TOO_SMALL;
+        if (!(heap = unsafe_heap_from_handle( handle, 0, &flags ))) return STATUS_INVALID_HANDLE;
+        WriteNoFence( &heap->stats_enabled, !!*(ULONG *)info );
+        return STATUS_SUCCESS;
+
+    case HeapWineThreadCacheInformation:
+    {
+        ULONG enable;
+
+        if (size < sizeof(ULONG)) return STATUS_BUFFER_TOO_SMALL;
+        if (!(heap = unsafe_heap_from_handle( handle, 0, &flags ))) return STATUS_INVALID_HANDLE;
+        if (heap != process_heap) return STATUS_INVALID_PARAMETER;
+
+        enable = !!*(ULONG *)info;
+        if (enable && !heap_can_use_thread_cache( heap, flags )) return STATUS_UNSUCCESSFUL;
+        /* when disabling, blocks already cached are only released on thread exit */
+        WriteNoFence( &thread_cache_enabled, enable );
+        return STATUS_SUCCESS;
+    }
+
     default:
         FIXME( "HEAP_INFORMATION_CLASS %u not implemented!\n", info_class );
         return STATUS_SUCCESS;
@@ -33,6 +33,7 @@
 
 #include "wine/exception.h"
 #include "wine/debug.h"
+#include "wine/heapinfo.h"
 #include "wine/list.h"
 #include "ntdll_misc.h"
 #include "ddk/ntddk.h"
@@ -43,6 +44,7 @@ WINE_DECLARE_DEBUG_CHANNEL(relay);
 WINE_DECLARE_DEBUG_CHANNEL(snoop);
 WINE_DECLARE_DEBUG_CHANNEL(loaddll);
 WINE_DECLARE_DEBUG_CHANNEL(imports);
+WINE_DECLARE_DEBUG_CHANNEL(loaderprofile);
 
 #ifdef _WIN64
 #define DEFAULT_SECURITY_COOKIE_64  (((ULONGLONG)0x00002b99 << 32) | 0x2ddfa232)
@@ -133,6 +135,17 @@ struct file_id
 #define HASH_MAP_SIZE 32
 static LIST_ENTRY hash_table[HASH_MAP_SIZE];
 
+/* hash index of the export names, built on first lookup */
+struct export_index
+{
+    DWORD names_rva;       /* AddressOfNames the index was built for */
+    DWORD count;           /* NumberOfNames the index was built for */
+    DWORD mask;
+    DWORD slots[1];        /* name position + 1, 0 for empty slots */
+};
+
+#define EXPORT_INDEX_MIN_NAMES 64
+
 /* internal representation of loaded modules */
 typedef struct _wine_modref
 {
@@ -140,6 +153,7 @@ typedef struct _wine_modref
     struct file_id        id;
     ULONG                 CheckSum;
     BOOL                  system;
+    struct export_index  *export_index;
 } WINE_MODREF;
 
 static UINT tls_module_count = 32;     /* number of modules with TLS directory */
@@ -195,7 +209,7 @@ static NTSTATUS process_attach( LDR_DDAG_NODE *node, LPVOID lpReserved );
 static FARPROC find_ordinal_export( HMODULE module, const IMAGE_EXPORT_DIRECTORY *exports,
                                     DWORD exp_size, DWORD ordinal, LPCWSTR load_path,
                                     WINE_MODREF *importer, BOOL is_dynamic );
-static FARPROC find_named_export( HMODULE module, const IMAGE_EXPORT_DIRECTORY *exports, DWORD exp_size,
+static FARPROC find_named_export( WINE_MODREF *wm, const IMAGE_EXPORT_DIRECTORY *exports, DWORD exp_size,
                                   const char *name, int hint, LPCWSTR load_path,
                                   WINE_MODREF *importer, BOOL is_dynamic );
 
@@ -995,8 +1009,7 @@ static FARPROC find_forwarded_export( HMODULE module, const char *forward, LPCWS
                                         atoi(name+1) - exports->Base, load_path,
                                         importer, is_dynamic );
         } else
-            proc = find_named_export( wm->ldr.DllBase, exports, exp_size, name, -1, load_path,
-                                      importer, is_dynamic );
+            proc = find_named_export( wm, exports, exp_size, name, -1, load_path, importer, is_dynamic );
     }
 
     if (!proc)
@@ -1075,18 +1088,108 @@ static int find_name_in_exports( HMODULE module, const IMAGE_EXPORT_DIRECTORY *e
 }
 
 
+/* elapsed time in microseconds since start, for the loaderprofile channel */
+static ULONGLONG loader_profile_elapsed( const LARGE_INTEGER *start )
+{
+    LARGE_INTEGER now, freq;
+
+    RtlQueryPerformanceCounter( &now );
+    RtlQueryPerformanceFrequency( &freq );
+    return (now.QuadPart - start->QuadPart) * 1000000 / freq.QuadPart;
+}
+
+static inline DWORD hash_export_name( const char *name )
+{
+    DWORD hash = 0x811c9dc5;  /* FNV-1a */
+    while (*name) hash = (hash ^ (BYTE)*name++) * 0x01000193;
+    return hash;
+}
+
+
+/*************************************************************************
+ *		get_export_index
+ *
+ * Get the export names hash index of a module, building it if needed.
+ * The loader_section must be locked while calling this function.
+ */
+static const struct export_index *get_export_index( WINE_MODREF *wm, const IMAGE_EXPORT_DIRECTORY *exports )
+{
+    HMODULE module = wm->ldr.DllBase;
+    const DWORD *names = get_rva( module, exports->AddressOfNames );
+    struct export_index *index = wm->export_index;
+    LARGE_INTEGER start;
+    DWORD i, j, size;
+
+    if (exports->NumberOfNames < EXPORT_INDEX_MIN_NAMES) return NULL;
+
+    /* the export directory may have been patched since the index was built */
+    if (index && index->names_rva == exports->AddressOfNames && index->count == exports->NumberOfNames)
+        return index;
+
+    RtlFreeHeap( GetProcessHeap(), 0, index );
+    wm->export_index = NULL;
+
+    if (TRACE_ON(loaderprofile)) RtlQueryPerformanceCounter( &start );
+
+    if (exports->NumberOfNames > 0x1000000) return NULL;  /* bogus export table, use binary search */
+    for (size = EXPORT_INDEX_MIN_NAMES; size < 2 * exports->NumberOfNames; size *= 2) ;
+    if (!(index = RtlAllocateHeap( GetProcessHeap(), HEAP_ZERO_MEMORY,
+                                   offsetof( struct export_index, slots[size] ) )))
+        return NULL;
+    index->names_rva = exports->AddressOfNames;
+    index->count = exports->NumberOfNames;
+    index->mask = size - 1;
+
+    for (i = 0; i < exports->NumberOfNames; i++)
+    {
+        j = hash_export_name( get_rva( module, names[i] ) ) & index->mask;
+        while (index->slots[j]) j = (j + 1) & index->mask;
+        index->slots[j] = i + 1;
+    }
+
+    if (TRACE_ON(loaderprofile))
+        TRACE_(loaderprofile)( "%s: indexed %lu exports in %I64u us\n", debugstr_w(wm->ldr.BaseDllName.Buffer),
+                               exports->NumberOfNames, loader_profile_elapsed( &start ) );
+
+    return wm->export_index = index;
+}
+
+
+/*************************************************************************
+ *		find_name_in_export_index
+ *
+ * Helper for find_named_export.
+ */
+static int find_name_in_export_index( HMODULE module, const IMAGE_EXPORT_DIRECTORY *exports,
+                                      const struct export_index *index, const char *name )
+{
+    const WORD *ordinals = get_rva( module, exports->AddressOfNameOrdinals );
+    const DWORD *names = get_rva( module, exports->AddressOfNames );
+    DWORD pos, i = hash_export_name( name ) & index->mask;
+
+    while ((pos = index->slots[i]))
+    {
+        if (!strcmp( get_rva( module, names[pos - 1] ), name )) return ordinals[pos - 1];
+        i = (i + 1) & index->mask;
+    }
+    return -1;
+}
+
+
 /*************************************************************************
  *		find_named_export
  *
  * Find an exported function by name.
  * The loader_section must be locked while calling this function.
  */
-static FARPROC find_named_export( HMODULE module, const IMAGE_EXPORT_DIRECTORY *exports, DWORD exp_size,
+static FARPROC find_named_export( WINE_MODREF *wm, const IMAGE_EXPORT_DIRECTORY *exports, DWORD exp_size,
                                   const char *name, int hint, LPCWSTR load_path, WINE_MODREF *importer,
                                   BOOL is_dynamic )
 {
+    HMODULE module = wm->ldr.DllBase;
     const WORD *ordinals = get_rva( module, exports->AddressOfNameOrdinals );
     const DWORD *names = get_rva( module, exports->AddressOfNames );
+    const struct export_index *index;
     int ordinal;
 
     /* first check the hint */
@@ -1097,10 +1200,12 @@ static FARPROC find_named_export( HMODULE module, const IMAGE_EXPORT_DIRECTORY *
             return find_ordinal_export( module, exports, exp_size, ordinals[hint], load_path, importer, is_dynamic );
     }
 
-    /* then do a binary search */
-    if ((ordinal = find_name_in_exports( module, exports, name )) == -1) return NULL;
-    return find_ordinal_export( module, exports, exp_size, ordinal, load_path, importer, is_dynamic );
+    /* then use the hash index, or do a binary search for small export tables */
+    if ((index = get_export_index( wm, exports ))) ordinal = find_name_in_export_index( module, exports, index, name );
+    else ordinal = find_name_in_exports( module, exports, name );
 
+    if (ordinal == -1) return NULL;
+    return find_ordinal_export( module, exports, exp_size, ordinal, load_path, importer, is_dynamic );
 }
 
 
@@ -1152,8 +1257,9 @@ static BOOL import_dll( WINE_MODREF *wm, const IMAGE_IMPORT_DESCRIPTOR *descr, L
     const char *name = get_rva( module, descr->Name );
     DWORD len = strlen(name);
     PVOID protect_base;
-    SIZE_T protect_size = 0;
+    SIZE_T protect_size = 0, count;
     DWORD protect_old;
+    LARGE_INTEGER start;
 
     thunk_list = get_rva( module, (DWORD)descr->FirstThunk );
     if (descr->OriginalFirstThunk)
@@ -1182,9 +1288,12 @@ static BOOL import_dll( WINE_MODREF *wm, const IMAGE_IMPORT_DESCRIPTOR *descr, L
         return FALSE;
     }
 
+    if (TRACE_ON(loaderprofile)) RtlQueryPerformanceCounter( &start );
+
     /* unprotect the import address table since it can be located in
      * readonly section */
     while (import_list[protect_size].u1.Ordinal) protect_size++;
+    count = protect_size;
     protect_base = thunk_list;
     protect_size *= sizeof(*thunk_list);
     NtProtectVirtualMemory( NtCurrentProcess(), &protect_base,
@@ -1240,7 +1349,7 @@ static BOOL import_dll( WINE_MODREF *wm, const IMAGE_IMPORT_DESCRIPTOR *descr, L
         {
             IMAGE_IMPORT_BY_NAME *pe_name;
             pe_name = get_rva( module, (DWORD)import_list->u1.AddressOfData );
-            thunk_list->u1.Function = (ULONG_PTR)find_named_export( imp_mod, exports, exp_size,
+            thunk_list->u1.Function = (ULONG_PTR)find_named_export( wmImp, exports, exp_size,
                                                                     (const char*)pe_name->Name,
                                                                     pe_name->Hint, load_path, wm, FALSE );
             if (!thunk_list->u1.Function)
@@ -1260,6 +1369,10 @@ static BOOL import_dll( WINE_MODREF *wm, const IMAGE_IMPORT_DESCRIPTOR *descr, L
 done:
     /* restore old protection of the import address table */
     NtProtectVirtualMemory( NtCurrentProcess(), &protect_base, &protect_size, protect_old, &protect_old );
+
+    if (TRACE_ON(loaderprofile))
+        TRACE_(loaderprofile)( "%s: resolved %Iu imports from %s in %I64u us\n",
+                               debugstr_w(wm->ldr.BaseDllName.Buffer), count, name, loader_profile_elapsed( &start ) );
     *pwm = wmImp;
     return TRUE;
 }
@@ -2076,7 +2189,7 @@ NTSTATUS WINAPI LdrGetProcedureAddress(HMODULE module, const ANSI_STRING *name,
     else if ((exports = RtlImageDirectoryEntryToData( module, TRUE,
                                                       IMAGE_DIRECTORY_ENTRY_EXPORT, &exp_size )))
     {
-        void *proc = name ? find_named_export( module, exports, exp_size, name->Buffer, -1, NULL, wm, TRUE )
+        void *proc = name ? find_named_export( wm, exports, exp_size, name->Buffer, -1, NULL, wm, TRUE )
                           : find_ordinal_export( module, exports, exp_size, ord - exports->Base, NULL, wm, TRUE );
         if (proc)
         {
@@ -3883,6 +3996,7 @@ void WINAPI LdrShutdownProcess(void)
         RtlProcessFlsData( NtCurrentTeb()->FlsSlots, 1 );
 
     process_detach();
+    heap_process_detach();
 }
 
 
@@ -4006,6 +4120,7 @@ static void free_modref( WINE_MODREF *wm )
     NtUnmapViewOfSection( NtCurrentProcess(), wm->ldr.DllBase );
     if (cached_modref == wm) cached_modref = NULL;
     RtlFreeUnicodeString( &wm->ldr.FullDllName );
+    RtlFreeHeap( GetProcessHeap(), 0, wm->export_index );
     RtlFreeHeap( GetProcessHeap(), 0, wm );
 }
 
@@ -4151,6 +4266,7 @@ static void load_global_options(void)
 {
     OBJECT_ATTRIBUTES attr;
     UNICODE_STRING bootstrap_mode_str = RTL_CONSTANT_STRING( L"WINEBOOTSTRAPMODE" );
+    UNICODE_STRING heap_cache_str = RTL_CONSTANT_STRING( L"WINEHEAPTHREADCACHE" );
     UNICODE_STRING session_manager_str =
         RTL_CONSTANT_STRING( L"\\Registry\\Machine\\System\\CurrentControlSet\\Control\\Session Manager" );
     UNICODE_STRING val_str;
@@ -4160,6 +4276,13 @@ static void load_global_options(void)
     is_prefix_bootstrap =
         RtlQueryEnvironmentVariable_U( NULL, &bootstrap_mode_str, &val_str ) != STATUS_VARIABLE_NOT_FOUND;
 
+    val_str.MaximumLength = 0;
+    if (RtlQueryEnvironmentVariable_U( NULL, &heap_cache_str, &val_str ) != STATUS_VARIABLE_NOT_FOUND)
+    {
+        ULONG enable = TRUE;
+        RtlSetHeapInformation( GetProcessHeap(), HeapWineThreadCacheInformation, &enable, sizeof(enable) );
+    }
+
     InitializeObjectAttributes( &attr, &session_manager_str, OBJ_CASE_INSENSITIVE, 0, NULL );
     if (!NtOpenKey( &hkey, KEY_QUERY_VALUE, &attr ))
     {
@@ -4397,6 +4520,7 @@ void loader_init( CONTEXT *context, void **entry )
     static int attach_done;
     NTSTATUS status;
     ULONG_PTR cookie, port = 0;
+    LARGE_INTEGER start;
     WINE_MODREF *wm;
 
     if (process_detaching) NtTerminateThread( GetCurrentThread(), 0 );
@@ -4464,10 +4588,14 @@ void loader_init( CONTEXT *context, void **entry )
         if (needs_elevation())
             elevate_token();
         get_env_var( L"WINESYSTEMDLLPATH", 0, &system_dll_path );
+        if (TRACE_ON(loaderprofile)) RtlQueryPerformanceCounter( &start );
         if (wm->ldr.Flags & LDR_COR_ILONLY)
             status = fixup_imports_ilonly( wm, NULL, entry );
         else
             status = fixup_imports( wm, NULL );
+        if (TRACE_ON(loaderprofile))
+            TRACE_(loaderprofile)( "%s: loaded dlls and resolved imports in %I64u us\n",
+                                   debugstr_w(wm->ldr.BaseDllName.Buffer), loader_profile_elapsed( &start ) );
 
         if (status)
         {
@@ -38,6 +38,7 @@
 #include "ddk/ntifs.h"
 #include "wine/test.h"
 #include "wine/asm.h"
+#include "wine/heapinfo.h"
 #include "wine/rbtree.h"
 
 #ifndef __WINE_WINTERNL_H
@@ -3719,6 +3720,246 @@ static void test_RtlCreateHeap(void)
     ok(ret, "Unexpected return value.\n");
 }
 
+static ULONG heap_lfh_alloc_count(HANDLE heap, HEAP_WINE_BIN_INFORMATION *info, ULONG count, ULONG *freed)
+{
+    ULONG i, alloc = 0;
+    NTSTATUS status;
+
+    status = RtlQueryHeapInformation(heap, HeapWineBinInformation, info, count * sizeof(*info), NULL);
+    ok(!status, "got status %#lx\n", status);
+    for (i = 0, *freed = 0; i < count; i++)
+    {
+        alloc += info[i].AllocCount;
+        *freed += info[i].FreeCount;
+    }
+    return alloc;
+}
+
+static void test_heap_wine_information(void)
+{
+    HEAP_WINE_BIN_INFORMATION *info;
+    HEAP_WINE_SUMMARY_INFORMATION summary;
+    ULONG i, count, enabled, alloc, freed;
+    void *ptrs[256];
+    NTSTATUS status;
+    HANDLE heap;
+    SIZE_T size;
+
+    heap = RtlCreateHeap(HEAP_GROWABLE, NULL, 0, 0, NULL, NULL);
+    ok(!!heap, "RtlCreateHeap failed\n");
+
+    status = RtlQueryHeapInformation(heap, HeapWineStatisticsInformation, &enabled, sizeof(enabled), &size);
+    if (status)
+    {
+        win_skip("HeapWineStatisticsInformation not supported, status %#lx\n", status);
+        RtlDestroyHeap(heap);
+        return;
+    }
+    ok(size == sizeof(ULONG), "got size %Iu\n", size);
+
+    size = 0;
+    status = RtlQueryHeapInformation(heap, HeapWineBinInformation, NULL, 0, &size);
+    ok(status == STATUS_BUFFER_TOO_SMALL, "got status %#lx\n", status);
+    ok(size && !(size % sizeof(*info)), "got size %Iu\n", size);
+    count = size / sizeof(*info);
+    info = malloc(size);
+
+    /* the counters are only updated once enabled */
+    enabled = FALSE;
+    status = RtlSetHeapInformation(heap, HeapWineStatisticsInformation, &enabled, sizeof(enabled));
+    ok(!status, "got status %#lx\n", status);
+    for (i = 0; i < ARRAY_SIZE(ptrs); i++) ptrs[i] = RtlAllocateHeap(heap, 0, 40);
+    for (i = 0; i < ARRAY_SIZE(ptrs); i++) RtlFreeHeap(heap, 0, ptrs[i]);
+    alloc = heap_lfh_alloc_count(heap, info, count, &freed);
+    ok(!alloc, "got %lu LFH allocations\n", alloc);
+    ok(!freed, "got %lu LFH frees\n", freed);
+
+    enabled = TRUE;
+    status = RtlSetHeapInformation(heap, HeapWineStatisticsInformation, &enabled, sizeof(enabled));
+    ok(!status, "got status %#lx\n", status);
+    status = RtlQueryHeapInformation(heap, HeapWineStatisticsInformation, &enabled, sizeof(enabled), NULL);
+    ok(!status, "got status %#lx\n", status);
+    ok(enabled == TRUE, "got enabled %lu\n", enabled);
+
+    /* the previous allocations have enabled the LFH for this size class */
+    for (i = 0; i < ARRAY_SIZE(ptrs); i++)
+    {
+        ptrs[i] = RtlAllocateHeap(heap, 0, 40);
+        ok(!!ptrs[i], "RtlAllocateHeap failed\n");
+    }
+    alloc = heap_lfh_alloc_count(heap, info, count, &freed);
+    ok(alloc == ARRAY_SIZE(ptrs), "got %lu LFH allocations\n", alloc);
+    ok(!freed, "got %lu LFH frees\n", freed);
+    for (i = 0; i < count; i++) if (info[i].AllocCount) break;
+    ok(i < count, "no size class with LFH allocations\n");
+    if (i < count)
+    {
+        ok(info[i].Enabled, "LFH not enabled for size %#Ix\n", info[i].BlockSize);
+        ok(info[i].BlockSize >= 40, "got size %#Ix\n", info[i].BlockSize);
+        ok(info[i].UsedBlockCount == ARRAY_SIZE(ptrs), "got %lu used blocks\n", info[i].UsedBlockCount);
+        ok(info[i].GroupCount > 0, "got %lu groups\n", info[i].GroupCount);
+    }
+
+    status = RtlQueryHeapInformation(heap, HeapWineSummaryInformation, &summary, sizeof(summary) - 1, &size);
+    ok(status == STATUS_BUFFER_TOO_SMALL, "got status %#lx\n", status);
+    ok(size == sizeof(summary), "got size %Iu\n", size);
+    status = RtlQueryHeapInformation(heap, HeapWineSummaryInformation, &summary, sizeof(summary), NULL);
+    ok(!status, "got status %#lx\n", status);
+    ok(summary.SubheapCount >= 1, "got %lu subheaps\n", summary.SubheapCount);
+    ok(summary.CommittedSize <= summary.ReservedSize, "got committed %#Ix reserved %#Ix\n",
+       summary.CommittedSize, summary.ReservedSize);
+    ok(summary.AllocatedSize <= summary.CommittedSize, "got allocated %#Ix committed %#Ix\n",
+       summary.AllocatedSize, summary.CommittedSize);
+    ok(summary.BusyBlockCount > 0, "got %lu busy blocks\n", summary.BusyBlockCount);
+
+    for (i = 0; i < ARRAY_SIZE(ptrs); i++) RtlFreeHeap(heap, 0, ptrs[i]);
+    alloc = heap_lfh_alloc_count(heap, info, count, &freed);
+    ok(alloc == ARRAY_SIZE(ptrs), "got %lu LFH allocations\n", alloc);
+    ok(freed == ARRAY_SIZE(ptrs), "got %lu LFH frees\n", freed);
+
+    free(info);
+    RtlDestroyHeap(heap);
+}
+
+static LONG heap_bench_start;
+
+static DWORD WINAPI heap_bench_thread(void *arg)
+{
+    static const SIZE_T sizes[] = {8, 24, 40, 64, 100, 200, 256, 500, 1000};
+    HANDLE heap = GetProcessHeap();
+    void *ptrs[64] = {0};
+    unsigned int i, j;
+
+    while (!ReadAcquire(&heap_bench_start)) YieldProcessor();
+
+    for (i = 0; i < 100000; i++)
+    {
+        j = i % ARRAY_SIZE(ptrs);
+        RtlFreeHeap(heap, 0, ptrs[j]);
+        ptrs[j] = RtlAllocateHeap(heap, 0, sizes[(i * 7) % ARRAY_SIZE(sizes)]);
+        if (!ptrs[j]) return 1;
+        memset(ptrs[j], 0xcc, 8);
+    }
+    for (j = 0; j < ARRAY_SIZE(ptrs); j++) RtlFreeHeap(heap, 0, ptrs[j]);
+
+    return 0;
+}
+
+static DWORD run_heap_bench(void)
+{
+    HANDLE threads[8];
+    DWORD i, ticks, code;
+
+    heap_bench_start = 0;
+    for (i = 0; i < ARRAY_SIZE(threads); i++)
+    {
+        threads[i] = CreateThread(NULL, 0, heap_bench_thread, NULL, 0, NULL);
+        ok(threads[i] != NULL, "CreateThread failed, error %lu\n", GetLastError());
+    }
+
+    ticks = GetTickCount();
+    WriteRelease(&heap_bench_start, 1);
+    WaitForMultipleObjects(ARRAY_SIZE(threads), threads, TRUE, INFINITE);
+    ticks = GetTickCount() - ticks;
+
+    for (i = 0; i < ARRAY_SIZE(threads); i++)
+    {
+        GetExitCodeThread(threads[i], &code);
+        ok(!code, "thread %lu failed to allocate\n", i);
+        CloseHandle(threads[i]);
+    }
+
+    return ticks;
+}
+
+static void test_heap_thread_cache(void)
+{
+    HEAP_WINE_BIN_INFORMATION info[256];
+    HANDLE heap = GetProcessHeap(), other;
+    DWORD ticks_cache, ticks_lfh;
+    ULONG enabled, enable, stats, hits;
+    NTSTATUS status;
+    SIZE_T size;
+    BYTE *ptr, *ptr2;
+    unsigned int i;
+
+    status = RtlQueryHeapInformation(heap, HeapWineThreadCacheInformation, &enabled, sizeof(enabled), &size);
+    if (status)
+    {
+        win_skip("HeapWineThreadCacheInformation not supported, status %#lx\n", status);
+        return;
+    }
+    ok(size == sizeof(ULONG), "got size %Iu\n", size);
+
+    enable = TRUE;
+    other = RtlCreateHeap(HEAP_GROWABLE, NULL, 0, 0, NULL, NULL);
+    status = RtlSetHeapInformation(other, HeapWineThreadCacheInformation, &enable, sizeof(enable));
+    ok(status == STATUS_INVALID_PARAMETER, "got status %#lx\n", status);
+    RtlDestroyHeap(other);
+
+    status = RtlSetHeapInformation(heap, HeapWineThreadCacheInformation, &enable, sizeof(enable));
+    if (status == STATUS_UNSUCCESSFUL)
+    {
+        skip("heap thread cache disabled with heap debugging\n");
+        return;
+    }
+    ok(!status, "got status %#lx\n", status);
+
+    /* warm up the LFH bins, only LFH blocks are cached */
+    run_heap_bench();
+
+    status = RtlQueryHeapInformation(heap, HeapWineStatisticsInformation, &stats, sizeof(stats), NULL);
+    ok(!status, "got status %#lx\n", status);
+    status = RtlSetHeapInformation(heap, HeapWineStatisticsInformation, &enable, sizeof(enable));
+    ok(!status, "got status %#lx\n", status);
+    status = RtlQueryHeapInformation(heap, HeapWineBinInformation, info, sizeof(info), &size);
+    ok(!status, "got status %#lx\n", status);
+    for (i = 0, hits = 0; i < size / sizeof(*info); i++) hits -= info[i].CacheHitCount;
+
+    /* cached blocks are still detected as freed, and are zeroed when reused */
+    for (i = 0; i < 0x1000; i++)
+    {
+        ptr = RtlAllocateHeap(heap, 0, 40);
+        ok(!!ptr, "RtlAllocateHeap failed\n");
+        memset(ptr, 0xcc, 40);
+        RtlFreeHeap(heap, 0, ptr);
+    }
+
+    /* the current thread hits are included even before they are added to the shared counters */
+    status = RtlQueryHeapInformation(heap, HeapWineBinInformation, info, sizeof(info), &size);
+    ok(!status, "got status %#lx\n", status);
+    for (i = 0; i < size / sizeof(*info); i++) hits += info[i].CacheHitCount;
+    ok(hits >= 0xfff, "got %lu cache hits\n", hits);
+    status = RtlSetHeapInformation(heap, HeapWineStatisticsInformation, &stats, sizeof(stats));
+    ok(!status, "got status %#lx\n", status);
+    ptr = RtlAllocateHeap(heap, 0, 40);
+    memset(ptr, 0xcc, 40);
+    RtlFreeHeap(heap, 0, ptr);
+    ptr2 = RtlAllocateHeap(heap, HEAP_ZERO_MEMORY, 40);
+    ok(ptr2 == ptr, "got %p, expected cached %p\n", ptr2, ptr);
+    for (i = 0; i < 40; i++) if (ptr2[i]) break;
+    ok(i == 40, "block not zeroed at %u\n", i);
+    ok(RtlValidateHeap(heap, 0, ptr2), "RtlValidateHeap failed\n");
+    RtlFreeHeap(heap, 0, ptr2);
+    ok(!RtlValidateHeap(heap, 0, ptr2), "RtlValidateHeap succeeded on a cached block\n");
+    ok(RtlValidateHeap(heap, 0, NULL), "RtlValidateHeap failed\n");
+
+    ticks_cache = run_heap_bench();
+
+    enable = FALSE;
+    status = RtlSetHeapInformation(heap, HeapWineThreadCacheInformation, &enable, sizeof(enable));
+    ok(!status, "got status %#lx\n", status);
+    status = RtlQueryHeapInformation(heap, HeapWineThreadCacheInformation, &enable, sizeof(enable), NULL);
+    ok(!status, "got status %#lx\n", status);
+    ok(!enable, "thread cache still enabled\n");
+
+    ticks_lfh = run_heap_bench();
+    trace("8 threads, 100000 alloc/free each: %lu ms with thread cache, %lu ms without\n", ticks_cache, ticks_lfh);
+
+    status = RtlSetHeapInformation(heap, HeapWineThreadCacheInformation, &enabled, sizeof(enabled));
+    ok(!status, "got status %#lx\n", status);
+}
+
 static void test_RtlFirstFreeAce(void)
 {
     PACL acl;
@@ -5520,6 +5761,8 @@ START_TEST(rtl)
     test_DbgPrint();
     test_RtlDestroyHeap();
     test_RtlCreateHeap();
+    test_heap_wine_information();
+    test_heap_thread_cache();
     test_RtlFirstFreeAce();
     test_RtlInitializeSid();
     test_RtlValidSecurityDescriptor();
@@ -168,6 +168,9 @@ static const BYTE VIRTUAL_Win32Flags[16] =
 
 static struct wine_rb_tree views_tree;
 static pthread_mutex_t virtual_mutex;
+static LONG views_seq;             /* seqlock protecting views_tree and pages_vprot, odd while virtual_mutex is held */
+static unsigned int views_lock_depth;  /* recursion depth of virtual_mutex, protected by virtual_mutex */
+static const unsigned int views_max_depth = 128;  /* upper bound of the views tree height */
 
 static const UINT page_shift = 12;
 static const UINT_PTR page_mask = 0xfff;
@@ -261,6 +264,58 @@ static inline BOOL is_vprot_exec_write( BYTE vprot )
     return (vprot & VPROT_EXEC) && (vprot & (VPROT_WRITE | VPROT_WRITECOPY));
 }
 
+/***********************************************************************
+ *           virtual_mutex_lock
+ *
+ * Acquire the virtual mutex, blocking server signals unless sigset is NULL.
+ * Lock-free readers see views_seq odd for as long as the mutex is held.
+ */
+static void virtual_mutex_lock( sigset_t *sigset )
+{
+    if (sigset) server_enter_uninterrupted_section( &virtual_mutex, sigset );
+    else mutex_lock( &virtual_mutex );
+    if (!views_lock_depth++) InterlockedIncrement( &views_seq );
+}
+
+
+/***********************************************************************
+ *           virtual_mutex_unlock
+ */
+static void virtual_mutex_unlock( sigset_t *sigset )
+{
+    if (!--views_lock_depth) InterlockedIncrement( &views_seq );
+    if (sigset) server_leave_uninterrupted_section( &virtual_mutex, sigset );
+    else mutex_unlock( &virtual_mutex );
+}
+
+
+/***********************************************************************
+ *           views_read_begin
+ *
+ * Start a lock-free read of the views tree and page protections.
+ * Returns FALSE if the mutex is currently held, in which case the caller
+ * should fall back to locking.
+ */
+static inline BOOL views_read_begin( LONG *seq )
+{
+    *seq = ReadNoFence( &views_seq );
+    __atomic_thread_fence( __ATOMIC_ACQUIRE );
+    return !(*seq & 1);
+}
+
+
+/***********************************************************************
+ *           views_read_end
+ *
+ * Check that no writer modified the views since views_read_begin.
+ */
+static inline BOOL views_read_end( LONG seq )
+{
+    __atomic_thread_fence( __ATOMIC_ACQUIRE );
+    return ReadNoFence( &views_seq ) == seq;
+}
+
+
 /* mmap() anonymous memory at a fixed address */
 void *anon_mmap_fixed( void *start, size_t size, int prot, int flags )
 {
@@ -818,7 +873,7 @@ void *get_builtin_so_handle( void *module )
     void *ret = NULL;
     struct builtin_module *builtin;
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_mutex_lock( &sigset );
     LIST_FOR_EACH_ENTRY( builtin, &builtin_modules, struct builtin_module, entry )
     {
         if (builtin->module != module) continue;
@@ -826,7 +881,7 @@ void *get_builtin_so_handle( void *module )
         if (ret) builtin->refcount++;
         break;
     }
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_mutex_unlock( &sigset );
     return ret;
 }
 
@@ -841,7 +896,7 @@ static NTSTATUS get_builtin_unix_funcs( void *module, BOOL wow, const void **fun
     NTSTATUS status = STATUS_DLL_NOT_FOUND;
     struct builtin_module *builtin;
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_mutex_lock( &sigset );
     LIST_FOR_EACH_ENTRY( builtin, &builtin_modules, struct builtin_module, entry )
     {
         if (builtin->module != module) continue;
@@ -858,7 +913,7 @@ static NTSTATUS get_builtin_unix_funcs( void *module, BOOL wow, const void **fun
         }
         break;
     }
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_mutex_unlock( &sigset );
     return status;
 }
 
@@ -872,7 +927,7 @@ NTSTATUS load_builtin_unixlib( void *module, const char *name )
     NTSTATUS status = STATUS_SUCCESS;
     struct builtin_module *builtin;
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_mutex_lock( &sigset );
     LIST_FOR_EACH_ENTRY( builtin, &builtin_modules, struct builtin_module, entry )
     {
         if (builtin->module != module) continue;
@@ -880,7 +935,7 @@ NTSTATUS load_builtin_unixlib( void *module, const char *name )
         else status = STATUS_IMAGE_ALREADY_LOADED;
         break;
     }
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_mutex_unlock( &sigset );
     return status;
 }
 
@@ -1415,12 +1470,12 @@ static void VIRTUAL_Dump(void)
     struct file_view *view;
 
     TRACE( "Dump of all virtual memory views:\n" );
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_mutex_lock( &sigset );
     WINE_RB_FOR_EACH_ENTRY( view, &views_tree, struct file_view, entry )
     {
         dump_view( view );
     }
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_mutex_unlock( &sigset );
 }
 #endif
 
@@ -1456,6 +1511,37 @@ static struct file_view *find_view( const void *addr, size_t size )
 }
 
 
+/***********************************************************************
+ *           find_view_lockless
+ *
+ * Find the view containing a given address without holding virtual_mutex.
+ * Must be called between views_read_begin and views_read_end; the result
+ * is only meaningful if views_read_end succeeds. View structures are never
+ * unmapped so the walk is safe, but it is bounded in case the tree is
+ * being rebalanced concurrently.
+ */
+static struct file_view *find_view_lockless( const void *addr, size_t size )
+{
+    struct wine_rb_entry *ptr = views_tree.root;
+    unsigned int depth;
+
+    if ((const char *)addr + size < (const char *)addr) return NULL; /* overflow */
+
+    for (depth = 0; ptr && depth < views_max_depth; depth++)
+    {
+        struct file_view *view = WINE_RB_ENTRY_VALUE( ptr, struct file_view, entry );
+        const char *base = view->base;
+        size_t view_size = view->size;
+
+        if (base > (const char *)addr) ptr = ptr->left;
+        else if (base + view_size <= (const char *)addr) ptr = ptr->right;
+        else if (base + view_size < (const char *)addr + size) break;  /* size too large */
+        else return view;
+    }
+    return NULL;
+}
+
+
 /***********************************************************************
  *           is_write_watch_range
  */
@@ -3037,15 +3123,43 @@ static IMAGE_BASE_RELOCATION *process_relocation_block( char *page, IMAGE_BASE_R
 }
 
 
+/***********************************************************************
+ *           copy_reloc_sections
+ *
+ * Copy the relocated sections of an image into a buffer laid out as in memory,
+ * to be written to the file shared with other processes once virtual_mutex is released.
+ */
+static void copy_reloc_sections( char *copy, const char *ptr, const IMAGE_SECTION_HEADER *sec,
+                                 unsigned int nb_sec, SIZE_T align_mask )
+{
+    unsigned int i;
+
+    for (i = 0; i < nb_sec; i++)
+    {
+        SIZE_T map_size;
+
+        if (!sec[i].PointerToRawData || !sec[i].SizeOfRawData) continue;
+        if (!sec[i].Misc.VirtualSize)
+            map_size = ROUND_SIZE( 0, sec[i].SizeOfRawData, align_mask );
+        else
+            map_size = ROUND_SIZE( 0, sec[i].Misc.VirtualSize, align_mask );
+
+        memcpy( copy + sec[i].VirtualAddress, ptr + sec[i].VirtualAddress, map_size );
+    }
+}
+
+
 /***********************************************************************
  *           map_image_into_view
  *
  * Map an executable (PE format) image into an existing view.
+ * If reloc_fd is valid, the sections are mapped from the already relocated copy.
+ * If reloc_copy is set, the relocated sections are copied to it.
  * virtual_mutex must be held by caller.
  */
 static NTSTATUS map_image_into_view( struct file_view *view, const UNICODE_STRING *nt_name, int fd,
                                      struct pe_image_info *image_info, USHORT machine,
-                                     int shared_fd, BOOL removable )
+                                     int shared_fd, BOOL removable, int reloc_fd, char *reloc_copy )
 {
     IMAGE_DOS_HEADER *dos;
     IMAGE_NT_HEADERS *nt;
@@ -3059,6 +3173,7 @@ static NTSTATUS map_image_into_view( struct file_view *view, const UNICODE_STRIN
     char *ptr = view->base;
     SIZE_T header_size, header_map_size, total_size = view->size;
     SIZE_T align_mask = max( image_info->alignment - 1, page_mask );
+    BOOL use_reloc_file = (reloc_fd != -1);
     INT_PTR delta;
 
     TRACE_(module)( "mapping PE file %s at %p-%p\n", debugstr_us(nt_name), ptr, ptr + total_size );
@@ -3186,8 +3301,26 @@ static NTSTATUS map_image_into_view( struct file_view *view, const UNICODE_STRIN
         end = file_start + file_size;
         if (sec[i].PointerToRawData >= st.st_size ||
             end > ((st.st_size + sector_align) & ~sector_align) ||
-            end < file_start ||
-            map_file_into_view( view, fd, sec[i].VirtualAddress, file_size, file_start,
+            end < file_start)
+        {
+            ERR_(module)( "Could not map %s section %.8s, file probably truncated\n",
+                          debugstr_us(nt_name), sec[i].Name );
+            goto done;
+        }
+
+        if (use_reloc_file)
+        {
+            /* the relocated copy is laid out as in memory, including the zero-filled tail */
+            if (map_file_into_view( view, reloc_fd, sec[i].VirtualAddress, map_size, sec[i].VirtualAddress,
+                                    VPROT_COMMITTED | VPROT_READ | VPROT_WRITECOPY, FALSE ) != STATUS_SUCCESS)
+            {
+                ERR_(module)( "Could not map %s relocated section %.8s\n", debugstr_us(nt_name), sec[i].Name );
+                goto done;
+            }
+            continue;
+        }
+
+        if (map_file_into_view( view, fd, sec[i].VirtualAddress, file_size, file_start,
                                 VPROT_COMMITTED | VPROT_READ | VPROT_WRITECOPY,
                                 removable ) != STATUS_SUCCESS)
         {
@@ -3240,7 +3373,9 @@ static NTSTATUS map_image_into_view( struct file_view *view, const UNICODE_STRIN
         else
             ((IMAGE_NT_HEADERS32 *)nt)->OptionalHeader.ImageBase = image_info->map_addr;
 
-        if ((dir = get_data_dir( nt, total_size, IMAGE_DIRECTORY_ENTRY_BASERELOC )))
+        if (use_reloc_file)
+            TRACE_(module)( "using shared relocated copy of %s\n", debugstr_us(nt_name) );
+        else if ((dir = get_data_dir( nt, total_size, IMAGE_DIRECTORY_ENTRY_BASERELOC )))
         {
             IMAGE_BASE_RELOCATION *rel = (IMAGE_BASE_RELOCATION *)(ptr + dir->VirtualAddress);
             IMAGE_BASE_RELOCATION *end = (IMAGE_BASE_RELOCATION *)((char *)rel + dir->Size);
@@ -3248,6 +3383,9 @@ static NTSTATUS map_image_into_view( struct file_view *view, const UNICODE_STRIN
             while (rel && rel < end - 1 && rel->SizeOfBlock && rel->VirtualAddress < total_size)
                 rel = process_relocation_block( ptr + rel->VirtualAddress, rel, delta );
         }
+
+        if (reloc_copy)
+            copy_reloc_sections( reloc_copy, ptr, sec, nt->FileHeader.NumberOfSections, align_mask );
     }
 
     /* set the image protections */
@@ -3396,6 +3534,70 @@ static NTSTATUS map_image_view( struct file_view **view_ret, struct pe_image_inf
 }
 
 
+/***********************************************************************
+ *             set_image_reloc_file_ready
+ *
+ * Tell the server whether the relocated copy of the image has been filled.
+ */
+static void set_image_reloc_file_ready( HANDLE mapping, client_ptr_t base, BOOL success )
+{
+    SERVER_START_REQ( set_image_reloc_file_ready )
+    {
+        req->handle  = wine_server_obj_handle( mapping );
+        req->base    = base;
+        req->success = success;
+        wine_server_call( req );
+    }
+    SERVER_END_REQ;
+}
+
+
+/***********************************************************************
+ *             get_image_reloc_fd
+ *
+ * Get the file holding a relocated copy of the image shared between processes,
+ * if the image will need to be relocated at its server assigned address.
+ * If the copy isn't filled yet, the caller is the only one allowed to write it,
+ * and must report the result with set_image_reloc_file_ready().
+ * virtual_mutex must not be held by caller.
+ */
+static int get_image_reloc_fd( HANDLE mapping, const struct pe_image_info *image_info,
+                               BOOL *ready, int *needs_close )
+{
+    HANDLE file = 0;
+    int fd = -1;
+
+    if (!image_info->map_addr || image_info->map_addr == image_info->base) return -1;
+    if (image_info->image_flags & IMAGE_FLAGS_ImageMappedFlat) return -1;
+#ifdef __aarch64__
+    /* ARM64X images are patched differently depending on the process machine */
+    if (image_info->machine == IMAGE_FILE_MACHINE_ARM64) return -1;
+#endif
+
+    SERVER_START_REQ( get_image_reloc_file )
+    {
+        req->handle = wine_server_obj_handle( mapping );
+        req->base   = image_info->map_addr;
+        if (!wine_server_call( req ))
+        {
+            file = wine_server_ptr_handle( reply->file );
+            *ready = reply->ready;
+        }
+    }
+    SERVER_END_REQ;
+
+    if (!file) return -1;
+    if (server_get_unix_fd( file, *ready ? FILE_READ_DATA : FILE_READ_DATA | FILE_WRITE_DATA,
+                            &fd, needs_close, NULL, NULL ))
+    {
+        if (!*ready) set_image_reloc_file_ready( mapping, image_info->map_addr, FALSE );
+        fd = -1;
+    }
+    NtClose( file );
+    return fd;
+}
+
+
 /***********************************************************************
  *             virtual_map_image
  *
@@ -3408,6 +3610,9 @@ static NTSTATUS virtual_map_image( HANDLE mapping, void **addr_ptr, SIZE_T *size
 {
     int unix_fd = -1, needs_close;
     int shared_fd = -1, shared_needs_close = 0;
+    int reloc_fd = -1, reloc_needs_close = 0;
+    BOOL reloc_ready = FALSE, reloc_filler = FALSE, reloc_filled = FALSE;
+    char *reloc_copy = NULL;
     SIZE_T size = image_info->map_size;
     struct file_view *view;
     unsigned int status;
@@ -3435,12 +3640,30 @@ static NTSTATUS virtual_map_image( HANDLE mapping, void **addr_ptr, SIZE_T *size
         SERVER_END_REQ;
     }
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    if (shared_fd == -1 && !needs_close)
+        reloc_fd = get_image_reloc_fd( mapping, image_info, &reloc_ready, &reloc_needs_close );
+    if (reloc_fd != -1 && !reloc_ready)
+    {
+        reloc_filler = TRUE;
+        reloc_copy = calloc( 1, size );
+    }
+
+    virtual_mutex_lock( &sigset );
 
     status = map_image_view( &view, image_info, size, limit_low, limit_high, alloc_type );
     if (status) goto done;
 
-    status = map_image_into_view( view, nt_name, unix_fd, image_info, machine, shared_fd, needs_close );
+    if (reloc_fd != -1 && wine_server_client_ptr( view->base ) != image_info->map_addr)
+    {
+        /* not mapped at the address the copy is relocated for */
+        free( reloc_copy );
+        reloc_copy = NULL;
+        reloc_ready = FALSE;
+    }
+
+    status = map_image_into_view( view, nt_name, unix_fd, image_info, machine, shared_fd, needs_close,
+                                  reloc_ready ? reloc_fd : -1, reloc_copy );
+    reloc_filled = (reloc_copy && status == STATUS_SUCCESS);
     if (status == STATUS_SUCCESS)
     {
         image_info->base = wine_server_client_ptr( view->base );
@@ -3465,9 +3688,20 @@ static NTSTATUS virtual_map_image( HANDLE mapping, void **addr_ptr, SIZE_T *size
     else delete_view( view );
 
 done:
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_mutex_unlock( &sigset );
+    if (reloc_filler)
+    {
+        if (reloc_filled && pwrite( reloc_fd, reloc_copy, size, 0 ) != size)
+        {
+            WARN_(module)( "failed to write relocated image %s: %s\n", debugstr_us(nt_name), strerror(errno) );
+            reloc_filled = FALSE;
+        }
+        set_image_reloc_file_ready( mapping, image_info->map_addr, reloc_filled );
+    }
+    free( reloc_copy );
     if (needs_close) close( unix_fd );
     if (shared_needs_close) close( shared_fd );
+    if (reloc_needs_close) close( reloc_fd );
     return status;
 }
 
@@ -3571,7 +3805,7 @@ static unsigned int virtual_map_section( HANDLE handle, PVOID *addr_ptr, ULONG_P
 
     if ((res = server_get_unix_fd( handle, 0, &unix_handle, &needs_close, NULL, NULL ))) return res;
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_mutex_lock( &sigset );
 
     res = map_view( &view, base, size, alloc_type, vprot, limit_low, limit_high, 0 );
     if (res) goto done;
@@ -3605,7 +3839,7 @@ static unsigned int virtual_map_section( HANDLE handle, PVOID *addr_ptr, ULONG_P
     else delete_view( view );
 
 done:
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_mutex_unlock( &sigset );
     if (needs_close) close( unix_handle );
     return res;
 }
@@ -3878,7 +4112,7 @@ NTSTATUS virtual_create_builtin_view( void *module, const UNICODE_STRING *nt_nam
     void *base = wine_server_get_ptr( info->base );
     int i;
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_mutex_lock( &sigset );
     status = create_view( &view, base, size, SEC_IMAGE | SEC_FILE | VPROT_SYSTEM |
                           VPROT_COMMITTED | VPROT_READ | VPROT_WRITECOPY | VPROT_EXEC );
     if (!status)
@@ -3915,7 +4149,7 @@ NTSTATUS virtual_create_builtin_view( void *module, const UNICODE_STRING *nt_nam
         }
         else delete_view( view );
     }
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_mutex_unlock( &sigset );
 
     return status;
 }
@@ -4089,7 +4323,7 @@ NTSTATUS virtual_alloc_teb( TEB **ret_teb )
     NTSTATUS status = STATUS_SUCCESS;
     SIZE_T block_size = signal_stack_mask + 1;
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_mutex_lock( &sigset );
     if (next_free_teb)
     {
         ptr = next_free_teb;
@@ -4105,7 +4339,7 @@ NTSTATUS virtual_alloc_teb( TEB **ret_teb )
             if ((status = NtAllocateVirtualMemory( NtCurrentProcess(), &ptr, user_space_wow_limit,
                                                    &total, MEM_RESERVE, PAGE_READWRITE )))
             {
-                server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+                virtual_mutex_unlock( &sigset );
                 return status;
             }
             teb_block = ptr;
@@ -4122,7 +4356,7 @@ NTSTATUS virtual_alloc_teb( TEB **ret_teb )
         *(void **)ptr = next_free_teb;
         next_free_teb = ptr;
     }
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_mutex_unlock( &sigset );
     return status;
 }
 
@@ -4161,14 +4395,14 @@ void virtual_free_teb( TEB *teb )
         NtFreeVirtualMemory( GetCurrentProcess(), &ptr, &size, MEM_RELEASE );
     }
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_mutex_lock( &sigset );
     signal_free_thread( teb );
     list_remove( &thread_data->entry );
     ptr = teb;
     if (!is_win64) ptr = (char *)ptr - teb_offset;
     *(void **)ptr = next_free_teb;
     next_free_teb = ptr;
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_mutex_unlock( &sigset );
 }
 
 
@@ -4277,10 +4511,10 @@ NTSTATUS WINAPI NtSetLdtEntries( ULONG sel1, LDT_ENTRY entry1, ULONG sel2, LDT_E
     if (is_win64 && !is_wow64()) return STATUS_NOT_IMPLEMENTED;
     if (sel1 >> 16 || sel2 >> 16) return STATUS_INVALID_LDT_DESCRIPTOR;
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_mutex_lock( &sigset );
     if (sel1) ldt_update_entry( sel1, entry1 );
     if (sel2) ldt_update_entry( sel2, entry2 );
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_mutex_unlock( &sigset );
     return STATUS_SUCCESS;
 }
 
@@ -4308,7 +4542,7 @@ NTSTATUS virtual_clear_tls_index( ULONG index )
 
     if (index < TLS_MINIMUM_AVAILABLE)
     {
-        server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+        virtual_mutex_lock( &sigset );
         LIST_FOR_EACH_ENTRY( thread_data, &teb_list, struct ntdll_thread_data, entry )
         {
             TEB *teb = CONTAINING_RECORD( thread_data, TEB, GdiTebBatch );
@@ -4319,14 +4553,14 @@ NTSTATUS virtual_clear_tls_index( ULONG index )
 #endif
             teb->TlsSlots[index] = 0;
         }
-        server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+        virtual_mutex_unlock( &sigset );
     }
     else
     {
         index -= TLS_MINIMUM_AVAILABLE;
         if (index >= 8 * sizeof(peb->TlsExpansionBitmapBits)) return STATUS_INVALID_PARAMETER;
 
-        server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+        virtual_mutex_lock( &sigset );
         LIST_FOR_EACH_ENTRY( thread_data, &teb_list, struct ntdll_thread_data, entry )
         {
             TEB *teb = CONTAINING_RECORD( thread_data, TEB, GdiTebBatch );
@@ -4341,7 +4575,7 @@ NTSTATUS virtual_clear_tls_index( ULONG index )
 #endif
             if (teb->TlsExpansionSlots) teb->TlsExpansionSlots[index] = 0;
         }
-        server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+        virtual_mutex_unlock( &sigset );
     }
     return STATUS_SUCCESS;
 }
@@ -4365,7 +4599,7 @@ NTSTATUS virtual_alloc_thread_stack( INITIAL_TEB *stack, ULONG_PTR limit_low, UL
     if (size < 1024 * 1024) size = 1024 * 1024;  /* Xlib needs a large stack */
     size = ROUND_SIZE( 0, size, granularity_mask );
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_mutex_lock( &sigset );
 
     status = map_view( &view, NULL, size, 0, VPROT_READ | VPROT_WRITE | VPROT_COMMITTED,
                        limit_low, limit_high, 0 );
@@ -4392,7 +4626,7 @@ NTSTATUS virtual_alloc_thread_stack( INITIAL_TEB *stack, ULONG_PTR limit_low, UL
     stack->StackBase = (char *)view->base + view->size;
     stack->StackLimit = (char *)view->base + (guard_page ? 2 * host_page_size : 0);
 done:
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_mutex_unlock( &sigset );
     return status;
 }
 
@@ -4555,8 +4789,25 @@ NTSTATUS virtual_handle_fault( EXCEPTION_RECORD *rec, void *stack )
     void *addr = (void *)rec->ExceptionInformation[1];
     char *page = ROUND_ADDR( addr, host_page_mask );
     BYTE vprot;
+    LONG seq;
+
+    /* plain access violations don't need to modify anything, check for them without locking */
+    if (views_read_begin( &seq ))
+    {
+        vprot = get_host_page_vprot( page );
+        if (!(vprot & (VPROT_GUARD | VPROT_WRITEWATCH)) &&
+            (err != EXCEPTION_WRITE_FAULT || !(get_unix_prot( vprot ) & PROT_WRITE)) &&
+#ifdef __APPLE__
+            (err != EXCEPTION_READ_FAULT || !(get_unix_prot( vprot ) & PROT_READ)) &&
+#endif
+            views_read_end( seq ))
+        {
+            rec->ExceptionCode = ret;
+            return ret;
+        }
+    }
 
-    mutex_lock( &virtual_mutex );  /* no need for signal masking inside signal handler */
+    virtual_mutex_lock( NULL );  /* no need for signal masking inside signal handler */
     vprot = get_host_page_vprot( page );
 
 #ifdef __APPLE__
@@ -4602,7 +4853,7 @@ NTSTATUS virtual_handle_fault( EXCEPTION_RECORD *rec, void *stack )
                 ret = STATUS_SUCCESS;
         }
     }
-    mutex_unlock( &virtual_mutex );
+    virtual_mutex_unlock( NULL );
     rec->ExceptionCode = ret;
     return ret;
 }
@@ -4642,13 +4893,13 @@ void *virtual_setup_exception( void *stack_ptr, size_t size, EXCEPTION_RECORD *r
     else if (stack < stack_info.limit)
     {
         char *page = ROUND_ADDR( stack, host_page_mask );
-        mutex_lock( &virtual_mutex );  /* no need for signal masking inside signal handler */
+        virtual_mutex_lock( NULL );  /* no need for signal masking inside signal handler */
         if ((get_host_page_vprot( page ) & VPROT_GUARD) && grow_thread_stack( page, &stack_info ))
         {
             rec->ExceptionCode = STATUS_STACK_OVERFLOW;
             rec->NumberParameters = 0;
         }
-        mutex_unlock( &virtual_mutex );
+        virtual_mutex_unlock( NULL );
     }
 #if defined(VALGRIND_MAKE_MEM_UNDEFINED)
     VALGRIND_MAKE_MEM_UNDEFINED( stack, size );
@@ -4697,14 +4948,14 @@ unsigned int virtual_locked_server_call( void *req_ptr )
 
     if (!size) return wine_server_call( req_ptr );
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_mutex_lock( &sigset );
     if (!(ret = check_write_access( addr, size, &has_write_watch )))
     {
         ret = server_call_unlocked( req );
         if (has_write_watch) update_write_watches( addr, size, wine_server_reply_size( req ));
     }
     else memset( &req->u.reply, 0, sizeof(req->u.reply) );
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_mutex_unlock( &sigset );
     return ret;
 }
 
@@ -4721,14 +4972,14 @@ ssize_t virtual_locked_read( int fd, void *addr, size_t size )
     ssize_t ret = read( fd, addr, size );
     if (ret != -1 || use_kernel_writewatch || errno != EFAULT) return ret;
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_mutex_lock( &sigset );
     if (!check_write_access( addr, size, &has_write_watch ))
     {
         ret = read( fd, addr, size );
         err = errno;
         if (has_write_watch) update_write_watches( addr, size, max( 0, ret ));
     }
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_mutex_unlock( &sigset );
     errno = err;
     return ret;
 }
@@ -4746,14 +4997,14 @@ ssize_t virtual_locked_pread( int fd, void *addr, size_t size, off_t offset )
     ssize_t ret = pread( fd, addr, size, offset );
     if (ret != -1 || use_kernel_writewatch || errno != EFAULT) return ret;
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_mutex_lock( &sigset );
     if (!check_write_access( addr, size, &has_write_watch ))
     {
         ret = pread( fd, addr, size, offset );
         err = errno;
         if (has_write_watch) update_write_watches( addr, size, max( 0, ret ));
     }
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_mutex_unlock( &sigset );
     errno = err;
     return ret;
 }
@@ -4772,7 +5023,7 @@ ssize_t virtual_locked_recvmsg( int fd, struct msghdr *hdr, int flags )
     ssize_t ret = recvmsg( fd, hdr, flags );
     if (ret != -1 || use_kernel_writewatch || errno != EFAULT) return ret;
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_mutex_lock( &sigset );
     for (i = 0; i < hdr->msg_iovlen; i++)
         if (check_write_access( hdr->msg_iov[i].iov_base, hdr->msg_iov[i].iov_len, &has_write_watch ))
             break;
@@ -4784,7 +5035,7 @@ ssize_t virtual_locked_recvmsg( int fd, struct msghdr *hdr, int flags )
     if (has_write_watch)
         while (i--) update_write_watches( hdr->msg_iov[i].iov_base, hdr->msg_iov[i].iov_len, 0 );
 
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_mutex_unlock( &sigset );
     errno = err;
     return ret;
 }
@@ -4798,11 +5049,20 @@ BOOL virtual_is_valid_code_address( const void *addr, SIZE_T size )
     struct file_view *view;
     BOOL ret = FALSE;
     sigset_t sigset;
+    LONG seq;
+
+    if (views_read_begin( &seq ))
+    {
+        if ((view = find_view_lockless( addr, size )))
+            ret = !(view->protect & VPROT_SYSTEM);  /* system views are not visible to the app */
+        if (views_read_end( seq )) return ret;
+        ret = FALSE;
+    }
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_mutex_lock( &sigset );
     if ((view = find_view( addr, size )))
         ret = !(view->protect & VPROT_SYSTEM);  /* system views are not visible to the app */
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_mutex_unlock( &sigset );
     return ret;
 }
 
@@ -4889,7 +5149,7 @@ SIZE_T virtual_uninterrupted_read_memory( const void *addr, void *buffer, SIZE_T
 
     if (!size) return 0;
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_mutex_lock( &sigset );
     if ((view = find_view( addr, size )))
     {
         if (!(view->protect & VPROT_SYSTEM))
@@ -4905,7 +5165,7 @@ SIZE_T virtual_uninterrupted_read_memory( const void *addr, void *buffer, SIZE_T
             }
         }
     }
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_mutex_unlock( &sigset );
     return bytes_read;
 }
 
@@ -4925,13 +5185,13 @@ NTSTATUS virtual_uninterrupted_write_memory( void *addr, const void *buffer, SIZ
 
     if (!size) return STATUS_SUCCESS;
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_mutex_lock( &sigset );
     if (!(ret = check_write_access( addr, size, &has_write_watch )))
     {
         memcpy( addr, buffer, size );
         if (has_write_watch) update_write_watches( addr, size, size );
     }
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_mutex_unlock( &sigset );
     return ret;
 }
 
@@ -4946,7 +5206,7 @@ void virtual_set_force_exec( BOOL enable )
     struct file_view *view;
     sigset_t sigset;
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_mutex_lock( &sigset );
     if (!force_exec_prot != !enable)  /* change all existing views */
     {
         force_exec_prot = enable;
@@ -4959,7 +5219,7 @@ void virtual_set_force_exec( BOOL enable )
             mprotect_range( view->base, view->size, commit, 0 );
         }
     }
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_mutex_unlock( &sigset );
 }
 
 
@@ -4971,7 +5231,7 @@ void virtual_enable_write_exceptions( BOOL enable )
     struct file_view *view;
     sigset_t sigset;
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_mutex_lock( &sigset );
     if (!enable_write_exceptions && enable)  /* change all existing views */
     {
         WINE_RB_FOR_EACH_ENTRY( view, &views_tree, struct file_view, entry )
@@ -4979,7 +5239,7 @@ void virtual_enable_write_exceptions( BOOL enable )
                 mprotect_range( view->base, view->size, 0, 0 );
     }
     enable_write_exceptions = enable;
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_mutex_unlock( &sigset );
 }
 
 
@@ -5115,7 +5375,7 @@ static NTSTATUS allocate_virtual_memory( void **ret, SIZE_T *size_ptr, ULONG typ
 
     /* Reserve the memory */
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_mutex_lock( &sigset );
 
     if ((type & MEM_RESERVE) || !base)
     {
@@ -5165,7 +5425,7 @@ static NTSTATUS allocate_virtual_memory( void **ret, SIZE_T *size_ptr, ULONG typ
 
     if (!status) VIRTUAL_DEBUG_DUMP_VIEW( view );
 
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_mutex_unlock( &sigset );
 
     if (status == STATUS_SUCCESS)
     {
@@ -5419,7 +5679,7 @@ NTSTATUS WINAPI NtFreeVirtualMemory( HANDLE process, PVOID *addr_ptr, SIZE_T *si
     if (size) size = ROUND_SIZE( addr, size, page_mask );
     base = ROUND_ADDR( addr, page_mask );
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_mutex_lock( &sigset );
 
     /* avoid freeing the DOS area when a broken app passes a NULL pointer */
     if (!base)
@@ -5464,7 +5724,7 @@ NTSTATUS WINAPI NtFreeVirtualMemory( HANDLE process, PVOID *addr_ptr, SIZE_T *si
         *addr_ptr = base;
         *size_ptr = size;
     }
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_mutex_unlock( &sigset );
     return status;
 }
 
@@ -5519,7 +5779,7 @@ NTSTATUS WINAPI NtProtectVirtualMemory( HANDLE process, PVOID *addr_ptr, SIZE_T
     size = ROUND_SIZE( addr, size, page_mask );
     base = ROUND_ADDR( addr, page_mask );
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_mutex_lock( &sigset );
 
     if ((view = find_view( base, size )))
     {
@@ -5535,7 +5795,7 @@ NTSTATUS WINAPI NtProtectVirtualMemory( HANDLE process, PVOID *addr_ptr, SIZE_T
 
     if (!status) VIRTUAL_DEBUG_DUMP_VIEW( view );
 
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_mutex_unlock( &sigset );
 
     if (status == STATUS_SUCCESS)
     {
@@ -5548,37 +5808,51 @@ NTSTATUS WINAPI NtProtectVirtualMemory( HANDLE process, PVOID *addr_ptr, SIZE_T
 }
 
 
-static struct file_view *get_memory_region_size( char *base, char **region_start, char **region_end,
-                                                 BOOL *fake_reserved )
+/* find the view containing base, or the free region between views around it.
+ * The walk is bounded so that it can also be used for lock-free lookups. */
+static struct file_view *find_view_region( char *base, char **region_start, char **region_end )
 {
-    struct wine_rb_entry *ptr;
-    struct file_view *view;
+    struct wine_rb_entry *ptr = views_tree.root;
+    unsigned int depth;
 
-    *fake_reserved = FALSE;
     *region_start = NULL;
     *region_end = working_set_limit;
 
-    ptr = views_tree.root;
-    while (ptr)
+    for (depth = 0; ptr && depth < views_max_depth; depth++)
     {
-        view = WINE_RB_ENTRY_VALUE( ptr, struct file_view, entry );
-        if ((char *)view->base > base)
+        struct file_view *view = WINE_RB_ENTRY_VALUE( ptr, struct file_view, entry );
+        char *view_base = view->base;
+        char *view_end = view_base + view->size;
+
+        if (view_base > base)
         {
-            *region_end = view->base;
+            *region_end = view_base;
             ptr = ptr->left;
         }
-        else if ((char *)view->base + view->size <= base)
+        else if (view_end <= base)
         {
-            *region_start = (char *)view->base + view->size;
+            *region_start = view_end;
             ptr = ptr->right;
         }
         else
         {
-            *region_start = view->base;
-            *region_end = (char *)view->base + view->size;
+            *region_start = view_base;
+            *region_end = view_end;
             return view;
         }
     }
+    return NULL;
+}
+
+
+static struct file_view *get_memory_region_size( char *base, char **region_start, char **region_end,
+                                                 BOOL *fake_reserved )
+{
+    struct file_view *view;
+
+    *fake_reserved = FALSE;
+    if ((view = find_view_region( base, region_start, region_end ))) return view;
+
 #ifdef __i386__
     {
         struct reserved_area *area;
@@ -5623,6 +5897,55 @@ static struct file_view *get_memory_region_size( char *base, char **region_start
 }
 
 
+/* lock-free version of fill_basic_memory_info, returns FALSE if the caller needs to take the lock */
+static BOOL fill_basic_memory_info_lockless( char *base, MEMORY_BASIC_INFORMATION *info )
+{
+    char *alloc_base, *alloc_end;
+    struct file_view *view;
+    unsigned int protect;
+    SIZE_T size;
+    BYTE vprot;
+    LONG seq;
+
+    if (!views_read_begin( &seq )) return FALSE;
+    view = find_view_region( base, &alloc_base, &alloc_end );
+    protect = view ? view->protect : 0;
+    /* make sure the view bounds are consistent before accessing its vprot bytes */
+    if (!views_read_end( seq )) return FALSE;
+
+    if (!view)
+    {
+#ifdef __i386__
+        return FALSE;  /* reserved areas need to be checked under the lock */
+#else
+        info->BaseAddress       = base;
+        info->RegionSize        = alloc_end - base;
+        info->State             = MEM_FREE;
+        info->Protect           = PAGE_NOACCESS;
+        info->AllocationBase    = 0;
+        info->AllocationProtect = 0;
+        info->Type              = 0;
+        return TRUE;
+#endif
+    }
+    if (protect & SEC_RESERVE) return FALSE;  /* committed state needs a server call */
+
+    size = get_vprot_range_size( base, alloc_end - base, ~VPROT_WRITEWATCH, &vprot );
+    if (!views_read_end( seq )) return FALSE;
+
+    info->BaseAddress       = base;
+    info->AllocationBase    = alloc_base;
+    info->RegionSize        = size;
+    info->State             = (vprot & VPROT_COMMITTED) ? MEM_COMMIT : MEM_RESERVE;
+    info->Protect           = (vprot & VPROT_COMMITTED) ? get_win32_prot( vprot, protect ) : 0;
+    info->AllocationProtect = get_win32_prot( protect, protect );
+    if (protect & SEC_IMAGE) info->Type = MEM_IMAGE;
+    else if (protect & (SEC_FILE | SEC_RESERVE | SEC_COMMIT)) info->Type = MEM_MAPPED;
+    else info->Type = MEM_PRIVATE;
+    return TRUE;
+}
+
+
 static unsigned int fill_basic_memory_info( const void *addr, MEMORY_BASIC_INFORMATION *info )
 {
     char *base, *alloc_base, *alloc_end;
@@ -5634,9 +5957,11 @@ static unsigned int fill_basic_memory_info( const void *addr, MEMORY_BASIC_INFOR
 
     if (is_beyond_limit( base, 1, working_set_limit )) return STATUS_INVALID_PARAMETER;
 
+    if (fill_basic_memory_info_lockless( base, info )) return STATUS_SUCCESS;
+
     /* Find the view containing the address */
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_mutex_lock( &sigset );
     view = get_memory_region_size( base, &alloc_base, &alloc_end, &fake_reserved );
 
     /* Fill the info structure */
@@ -5676,7 +6001,7 @@ static unsigned int fill_basic_memory_info( const void *addr, MEMORY_BASIC_INFOR
         else if (view->protect & (SEC_FILE | SEC_RESERVE | SEC_COMMIT)) info->Type = MEM_MAPPED;
         else info->Type = MEM_PRIVATE;
     }
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_mutex_unlock( &sigset );
 
     return STATUS_SUCCESS;
 }
@@ -5748,7 +6073,7 @@ static unsigned int get_memory_region_info( HANDLE process, LPCVOID addr, MEMORY
 
     if (is_beyond_limit( base, 1, working_set_limit )) return STATUS_INVALID_PARAMETER;
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_mutex_lock( &sigset );
 
     if ((view = get_memory_region_size( base, &region_start, &region_end, &fake_reserved )))
     {
@@ -5775,7 +6100,7 @@ static unsigned int get_memory_region_info( HANDLE process, LPCVOID addr, MEMORY
     {
         if (!fake_reserved)
         {
-            server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+            virtual_mutex_unlock( &sigset );
             return STATUS_INVALID_ADDRESS;
         }
         info->AllocationBase = region_start;
@@ -5785,7 +6110,7 @@ static unsigned int get_memory_region_info( HANDLE process, LPCVOID addr, MEMORY
         info->CommitSize = 0;
     }
 
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_mutex_unlock( &sigset );
 
     if (res_len) *res_len = sizeof(*info);
     return STATUS_SUCCESS;
@@ -5977,7 +6302,7 @@ static NTSTATUS get_working_set_ex( HANDLE process, LPCVOID addr,
     start = ref[0].addr;
     end = ref[count - 1].addr + page_size;
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_mutex_lock( &sigset );
     init_fill_working_set_info_data( &data, end );
 
     view = find_view_range( start, end - start );
@@ -6008,7 +6333,7 @@ static NTSTATUS get_working_set_ex( HANDLE process, LPCVOID addr,
 
     free_fill_working_set_info_data( &data );
     if (ref != ref_buffer) free( ref );
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_mutex_unlock( &sigset );
 
     if (res_len)
         *res_len = len;
@@ -6389,7 +6714,7 @@ static NTSTATUS unmap_view_of_section( HANDLE process, PVOID addr, ULONG flags )
         return status;
     }
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_mutex_lock( &sigset );
     if (!(view = find_view( addr, 0 )) || is_view_valloc( view )) goto done;
 
     if (flags & MEM_PRESERVE_PLACEHOLDER && !(view->protect & VPROT_PLACEHOLDER))
@@ -6408,7 +6733,7 @@ static NTSTATUS unmap_view_of_section( HANDLE process, PVOID addr, ULONG flags )
             {
                 TRACE( "not freeing in-use builtin %p\n", view->base );
                 builtin->refcount--;
-                server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+                virtual_mutex_unlock( &sigset );
                 return STATUS_SUCCESS;
             }
         }
@@ -6428,7 +6753,7 @@ static NTSTATUS unmap_view_of_section( HANDLE process, PVOID addr, ULONG flags )
     }
     else FIXME( "failed to unmap %p %x\n", view->base, status );
 done:
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_mutex_unlock( &sigset );
     return status;
 }
 
@@ -6580,7 +6905,7 @@ NTSTATUS WINAPI NtFlushVirtualMemory( HANDLE process, LPCVOID *addr_ptr,
         return result.virtual_flush.status;
     }
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_mutex_lock( &sigset );
     if (!(view = find_view( addr, *size_ptr ))) status = STATUS_INVALID_PARAMETER;
     else
     {
@@ -6591,7 +6916,7 @@ NTSTATUS WINAPI NtFlushVirtualMemory( HANDLE process, LPCVOID *addr_ptr,
             status = STATUS_NOT_MAPPED_DATA;
 #endif
     }
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_mutex_unlock( &sigset );
     return status;
 }
 
@@ -6618,7 +6943,7 @@ NTSTATUS WINAPI NtGetWriteWatch( HANDLE process, ULONG flags, PVOID base, SIZE_T
     TRACE( "%p %x %p-%p %p %lu\n", process, flags, base, (char *)base + size,
            addresses, *count );
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_mutex_lock( &sigset );
 
     if (is_write_watch_range( base, size ))
     {
@@ -6650,7 +6975,7 @@ NTSTATUS WINAPI NtGetWriteWatch( HANDLE process, ULONG flags, PVOID base, SIZE_T
     }
     else status = STATUS_INVALID_PARAMETER;
 
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_mutex_unlock( &sigset );
     return status;
 }
 
@@ -6671,14 +6996,14 @@ NTSTATUS WINAPI NtResetWriteWatch( HANDLE process, PVOID base, SIZE_T size )
 
     if (!size) return STATUS_INVALID_PARAMETER;
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_mutex_lock( &sigset );
 
     if (is_write_watch_range( base, size ))
         reset_write_watches( base, size );
     else
         status = STATUS_INVALID_PARAMETER;
 
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_mutex_unlock( &sigset );
     return status;
 }
 
@@ -6770,7 +7095,7 @@ NTSTATUS WINAPI NtAreMappedFilesTheSame(PVOID addr1, PVOID addr2)
 
     TRACE("%p %p\n", addr1, addr2);
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_mutex_lock( &sigset );
 
     view1 = find_view( addr1, 0 );
     view2 = find_view( addr2, 0 );
@@ -6794,7 +7119,7 @@ NTSTATUS WINAPI NtAreMappedFilesTheSame(PVOID addr1, PVOID addr2)
         SERVER_END_REQ;
     }
 
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_mutex_unlock( &sigset );
     return status;
 }
 
@@ -6836,7 +7161,7 @@ static NTSTATUS set_dirty_state_information( ULONG_PTR count, MEMORY_RANGE_ENTRY
     sigset_t sigset;
     NTSTATUS ret = STATUS_SUCCESS;
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_mutex_lock( &sigset );
     for (i = 0; i < count; i++)
     {
         void *base = ROUND_ADDR( addresses[i].VirtualAddress, page_mask );
@@ -6852,7 +7177,7 @@ static NTSTATUS set_dirty_state_information( ULONG_PTR count, MEMORY_RANGE_ENTRY
         else if (set_page_vprot_exec_write_protect( base, size ))
             mprotect_range( base, size, 0, 0 );
     }
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_mutex_unlock( &sigset );
     return ret;
 }
 
@@ -23,6 +23,7 @@
 #include "rtworkq.h"
 #include "wine/debug.h"
 #include "wine/list.h"
+#include "wine/mftrace.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(mfplat);
 
@@ -76,6 +77,17 @@ static CRITICAL_SECTION_DEBUG async_result_cache_critsect_debug =
 static CRITICAL_SECTION async_result_cache_section = { &async_result_cache_critsect_debug, -1, 0, 0, 0, 0 };
 struct list async_result_cache = LIST_INIT(async_result_cache);
 
+static CRITICAL_SECTION work_item_cache_section;
+static CRITICAL_SECTION_DEBUG work_item_cache_critsect_debug =
+{
+    0, 0, &work_item_cache_section,
+    { &work_item_cache_critsect_debug.ProcessLocksList, &work_item_cache_critsect_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": work_item_cache_section") }
+};
+static CRITICAL_SECTION work_item_cache_section = { &work_item_cache_critsect_debug, -1, 0, 0, 0, 0 };
+static struct list work_item_cache = LIST_INIT(work_item_cache);
+static unsigned int work_item_cache_size;
+
 static LONG startup_count;
 static LONG platform_lock;
 static CO_MTA_USAGE_COOKIE mta_cookie;
@@ -141,6 +153,7 @@ struct work_item
     IUnknown IUnknown_iface;
     LONG refcount;
     struct list entry;
+    struct list work_entry;
     IRtwqAsyncResult *result;
     IRtwqAsyncResult *reply_result;
     struct queue *queue;
@@ -151,7 +164,6 @@ struct work_item
     enum work_item_type type;
     union
     {
-        TP_WORK *work_object;
         TP_WAIT *wait_object;
         TP_TIMER *timer_object;
     } u;
@@ -195,6 +207,11 @@ struct queue
     CRITICAL_SECTION cs;
     struct list pending_items;
     DWORD id;
+    /* Data used for pool queues only. */
+    TP_WORK *work_object;
+    struct list work_items[ARRAY_SIZE(priorities)];
+    unsigned int active_workers;
+    unsigned int max_workers;
     /* Data used for serial queues only. */
     PTP_SIMPLE_CALLBACK finalization_callback;
     DWORD target_queue;
@@ -332,6 +349,8 @@ static void CALLBACK standard_queue_cleanup_callback(void *object_data, void *gr
 {
 }
 
+static void CALLBACK pool_queue_worker(TP_CALLBACK_INSTANCE *instance, void *context, TP_WORK *work);
+
 static HRESULT pool_queue_init(const struct queue_desc *desc, struct queue *queue)
 {
     TP_CALLBACK_ENVIRON_V3 env;
@@ -350,6 +369,7 @@ static HRESULT pool_queue_init(const struct queue_desc *desc, struct queue *queu
     {
         queue->envs[i] = env;
         queue->envs[i].CallbackPriority = priorities[i];
+        list_init(&queue->work_items[i]);
     }
     list_init(&queue->pending_items);
     InitializeCriticalSection(&queue->cs);
@@ -359,6 +379,12 @@ static HRESULT pool_queue_init(const struct queue_desc *desc, struct queue *queu
     SetThreadpoolThreadMinimum(queue->pool, 1);
     SetThreadpoolThreadMaximum(queue->pool, max_thread);
 
+    /* All work items share a single work object, items themselves are kept in per-priority lists. */
+    queue->work_object = CreateThreadpoolWork(pool_queue_worker, queue,
+            (TP_CALLBACK_ENVIRON *)&queue->envs[TP_CALLBACK_PRIORITY_NORMAL]);
+    queue->active_workers = 0;
+    queue->max_workers = max_thread;
+
     if (desc->queue_type == RTWQ_WINDOW_WORKQUEUE)
         FIXME("RTWQ_WINDOW_WORKQUEUE is not supported.\n");
 
@@ -367,19 +393,41 @@ static HRESULT pool_queue_init(const struct queue_desc *desc, struct queue *queu
 
 static BOOL pool_queue_shutdown(struct queue *queue)
 {
+    struct work_item *item, *item2;
+    unsigned int i;
+
     if (!queue->pool)
         return FALSE;
 
+    /* Work object is submitted under the queue lock, once it's cleared nothing can submit it anymore. */
+    EnterCriticalSection(&queue->cs);
+    queue->work_object = NULL;
+    LeaveCriticalSection(&queue->cs);
+
+    /* Pending work callbacks are not cancelled, so work item lists are drained here. */
     CloseThreadpoolCleanupGroupMembers(queue->envs[0].CleanupGroup, FALSE, NULL);
     CloseThreadpool(queue->pool);
     queue->pool = NULL;
 
+    EnterCriticalSection(&queue->cs);
+    for (i = 0; i < ARRAY_SIZE(queue->work_items); ++i)
+    {
+        LIST_FOR_EACH_ENTRY_SAFE(item, item2, &queue->work_items[i], struct work_item, work_entry)
+        {
+            list_remove(&item->work_entry);
+            if (item->finalization_callback)
+                IUnknown_Release(&item->IUnknown_iface);
+            IUnknown_Release(&item->IUnknown_iface);
+        }
+    }
+    LeaveCriticalSection(&queue->cs);
+
     return TRUE;
 }
 
-static void CALLBACK standard_queue_worker(TP_CALLBACK_INSTANCE *instance, void *context, TP_WORK *work)
+static void invoke_work_item(TP_CALLBACK_INSTANCE *instance, struct work_item *item)
 {
-    struct work_item *item = context;
+    PTP_SIMPLE_CALLBACK finalization_callback = item->finalization_callback;
     RTWQASYNCRESULT *result = (RTWQASYNCRESULT *)item->result;
 
     TRACE("result object %p.\n", result);
@@ -388,15 +436,55 @@ static void CALLBACK standard_queue_worker(TP_CALLBACK_INSTANCE *instance, void
        It's submitted to user callback still, but when invoked, special serial queue callback will be used
        to ensure correct destination queue. */
 
+    __wine_rtwq_trace(WINE_MF_TRACE_WORK_ITEM_BEGIN, result->pCallback, 0);
     IRtwqAsyncCallback_Invoke(result->pCallback, item->reply_result ? item->reply_result : item->result);
+    __wine_rtwq_trace(WINE_MF_TRACE_WORK_ITEM_END, result->pCallback, 0);
 
     IUnknown_Release(&item->IUnknown_iface);
+
+    if (finalization_callback)
+        finalization_callback(instance, item);
+}
+
+static struct work_item *pool_queue_get_next(struct queue *queue)
+{
+    struct list *head;
+    unsigned int i;
+
+    for (i = 0; i < ARRAY_SIZE(queue->work_items); ++i)
+    {
+        if ((head = list_head(&queue->work_items[i])))
+        {
+            list_remove(head);
+            return LIST_ENTRY(head, struct work_item, work_entry);
+        }
+    }
+
+    return NULL;
+}
+
+static void CALLBACK pool_queue_worker(TP_CALLBACK_INSTANCE *instance, void *context, TP_WORK *work)
+{
+    struct queue *queue = context;
+    struct work_item *item;
+
+    for (;;)
+    {
+        EnterCriticalSection(&queue->cs);
+        if (!(item = pool_queue_get_next(queue)))
+            queue->active_workers--;
+        LeaveCriticalSection(&queue->cs);
+
+        if (!item)
+            break;
+
+        invoke_work_item(instance, item);
+    }
 }
 
 static void pool_queue_submit(struct queue *queue, struct work_item *item)
 {
     TP_CALLBACK_PRIORITY callback_priority;
-    TP_CALLBACK_ENVIRON_V3 env;
 
     if (item->priority == 0)
         callback_priority = TP_CALLBACK_PRIORITY_NORMAL;
@@ -405,17 +493,38 @@ static void pool_queue_submit(struct queue *queue, struct work_item *item)
     else
         callback_priority = TP_CALLBACK_PRIORITY_HIGH;
 
-    env = queue->envs[callback_priority];
-    env.FinalizationCallback = item->finalization_callback;
     /* Worker pool callback will release one reference. Grab one more to keep object alive when
        we need finalization callback. */
     if (item->finalization_callback)
         IUnknown_AddRef(&item->IUnknown_iface);
-    item->u.work_object = CreateThreadpoolWork(standard_queue_worker, item, (TP_CALLBACK_ENVIRON *)&env);
     item->type = WORK_ITEM_WORK;
-    SubmitThreadpoolWork(item->u.work_object);
 
-    TRACE("dispatched %p.\n", item->result);
+    /* Running workers keep draining the lists until they are empty, so new callback is only requested
+       when there's room for another worker. Bursts of submitted items are then handled by already
+       running callbacks, without a threadpool round trip per item. */
+    EnterCriticalSection(&queue->cs);
+    if (queue->work_object)
+    {
+        list_add_tail(&queue->work_items[callback_priority], &item->work_entry);
+        if (queue->active_workers < queue->max_workers)
+        {
+            queue->active_workers++;
+            SubmitThreadpoolWork(queue->work_object);
+        }
+        item = NULL;
+    }
+    LeaveCriticalSection(&queue->cs);
+
+    if (item)
+    {
+        WARN("Queue %p was shut down, dropping item %p.\n", queue, item);
+        if (item->finalization_callback)
+            IUnknown_Release(&item->IUnknown_iface);
+        IUnknown_Release(&item->IUnknown_iface);
+        return;
+    }
+
+    TRACE("dispatched item to queue %p.\n", queue);
 }
 
 static const struct queue_ops pool_queue_ops =
@@ -548,6 +657,66 @@ static const struct queue_ops serial_queue_ops =
     serial_queue_submit,
 };
 
+/* Released work items are kept for reuse, same way as async result objects are. The cache is
+   only meant to absorb allocation churn, a burst of queued items doesn't need to stay allocated. */
+
+#define MAX_CACHED_WORK_ITEMS 256
+
+static BOOL work_item_cache_push(struct work_item *item)
+{
+    BOOL pushed;
+
+    EnterCriticalSection(&work_item_cache_section);
+    if ((pushed = startup_count > 0 && work_item_cache_size < MAX_CACHED_WORK_ITEMS))
+    {
+        list_add_head(&work_item_cache, &item->entry);
+        work_item_cache_size++;
+    }
+    LeaveCriticalSection(&work_item_cache_section);
+
+    return pushed;
+}
+
+static struct work_item *work_item_cache_pop(void)
+{
+    struct work_item *item;
+    struct list *head;
+
+    EnterCriticalSection(&work_item_cache_section);
+
+    if ((head = list_head(&work_item_cache)))
+    {
+        list_remove(head);
+        work_item_cache_size--;
+    }
+
+    LeaveCriticalSection(&work_item_cache_section);
+
+    if (!head)
+        return NULL;
+
+    item = LIST_ENTRY(head, struct work_item, entry);
+    memset(item, 0, sizeof(*item));
+
+    return item;
+}
+
+static void work_item_cache_clear(void)
+{
+    struct work_item *cur, *cur2;
+
+    EnterCriticalSection(&work_item_cache_section);
+
+    LIST_FOR_EACH_ENTRY_SAFE(cur, cur2, &work_item_cache, struct work_item, entry)
+    {
+        list_remove(&cur->entry);
+        free(cur);
+    }
+    work_item_cache_size = 0;
+
+    LeaveCriticalSection(&work_item_cache_section);
+}
+
 static HRESULT WINAPI work_item_QueryInterface(IUnknown *iface, REFIID riid, void **obj)
 {
     if (IsEqualIID(riid, &IID_IUnknown))
@@ -577,7 +746,6 @@ static ULONG WINAPI work_item_Release(IUnknown *iface)
         switch (item->type)
         {
             case WORK_ITEM_WORK:
-                if (item->u.work_object) CloseThreadpoolWork(item->u.work_object);
                 break;
             case WORK_ITEM_WAIT:
                 if (item->u.wait_object) CloseThreadpoolWait(item->u.wait_object);
@@ -589,7 +757,8 @@ static ULONG WINAPI work_item_Release(IUnknown *iface)
         if (item->reply_result)
             IRtwqAsyncResult_Release(item->reply_result);
         IRtwqAsyncResult_Release(item->result);
-        free(item);
+        if (!work_item_cache_push(item))
+            free(item);
     }
 
     return refcount;
@@ -608,7 +777,8 @@ static struct work_item * alloc_work_item(struct queue *queue, LONG priority, IR
     DWORD flags = 0, queue_id = 0;
     struct work_item *item;
 
-    item = calloc(1, sizeof(*item));
+    if (!(item = work_item_cache_pop()) && !(item = calloc(1, sizeof(*item))))
+        return NULL;
 
     item->IUnknown_iface.lpVtbl = &work_item_vtbl;
     item->result = result;
@@ -1323,6 +1493,8 @@ HRESULT WINAPI RtwqShutdown(void)
     {
         shutdown_system_queues();
         async_result_cache_clear();
+        work_item_cache_clear();
+        __wine_rtwq_trace_dump(NULL);
         RtwqUnlockPlatform();
     }
 
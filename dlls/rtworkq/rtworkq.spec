@@ -35,3 +35,9 @@
 @ stdcall RtwqUnlockWorkQueue(long)
 @ stdcall RtwqUnregisterPlatformEvents(ptr)
 @ stdcall RtwqUnregisterPlatformFromMMCSS()
+
+################################################################
+# Wine internal extensions
+@ stdcall __wine_rtwq_trace(long ptr int64)
+@ stdcall __wine_rtwq_trace_dump(wstr)
+@ stdcall __wine_rtwq_trace_enabled()
@@ -669,6 +669,114 @@ static void test_queue_shutdown(void)
     IRtwqAsyncCallback_Release(&test_callback2->IRtwqAsyncCallback_iface);
 }
 
+struct counting_callback
+{
+    IRtwqAsyncCallback IRtwqAsyncCallback_iface;
+    LONG count;
+    LONG expected;
+    HANDLE event;
+};
+
+static struct counting_callback *impl_counting_from_IRtwqAsyncCallback(IRtwqAsyncCallback *iface)
+{
+    return CONTAINING_RECORD(iface, struct counting_callback, IRtwqAsyncCallback_iface);
+}
+
+static ULONG WINAPI counting_callback_AddRef(IRtwqAsyncCallback *iface)
+{
+    return 2;
+}
+
+static ULONG WINAPI counting_callback_Release(IRtwqAsyncCallback *iface)
+{
+    return 1;
+}
+
+static HRESULT WINAPI counting_callback_Invoke(IRtwqAsyncCallback *iface, IRtwqAsyncResult *result)
+{
+    struct counting_callback *callback = impl_counting_from_IRtwqAsyncCallback(iface);
+
+    if (InterlockedIncrement(&callback->count) == callback->expected)
+        SetEvent(callback->event);
+
+    return S_OK;
+}
+
+static const IRtwqAsyncCallbackVtbl counting_callback_vtbl =
+{
+    testcallback_QueryInterface,
+    counting_callback_AddRef,
+    counting_callback_Release,
+    testcallback_GetParameters,
+    counting_callback_Invoke,
+};
+
+static void test_work_item_throughput(void)
+{
+    static const struct
+    {
+        DWORD queue;
+        const char *name;
+    }
+    tests[] =
+    {
+        { RTWQ_CALLBACK_QUEUE_STANDARD, "standard" },
+        { RTWQ_CALLBACK_QUEUE_MULTITHREADED, "multithreaded" },
+    };
+    static const LONG item_count = 20000;
+    struct counting_callback callback;
+    LARGE_INTEGER freq, start, end;
+    IRtwqAsyncResult *result;
+    unsigned int i;
+    double elapsed;
+    LONG j;
+    DWORD res;
+    HRESULT hr;
+
+    hr = RtwqStartup();
+    ok(hr == S_OK, "Failed to start up, hr %#lx.\n", hr);
+
+    QueryPerformanceFrequency(&freq);
+
+    callback.IRtwqAsyncCallback_iface.lpVtbl = &counting_callback_vtbl;
+    callback.event = CreateEventA(NULL, FALSE, FALSE, NULL);
+    callback.expected = item_count;
+
+    for (i = 0; i < ARRAY_SIZE(tests); ++i)
+    {
+        winetest_push_context("%s", tests[i].name);
+
+        callback.count = 0;
+
+        QueryPerformanceCounter(&start);
+        for (j = 0; j < item_count; ++j)
+        {
+            if (FAILED(hr = RtwqCreateAsyncResult(NULL, &callback.IRtwqAsyncCallback_iface, NULL, &result)))
+                break;
+            hr = RtwqPutWorkItem(tests[i].queue, 0, result);
+            IRtwqAsyncResult_Release(result);
+            if (FAILED(hr)) break;
+        }
+        ok(hr == S_OK, "Failed to submit item %ld, hr %#lx.\n", j, hr);
+
+        res = WaitForSingleObject(callback.event, 10000);
+        QueryPerformanceCounter(&end);
+        ok(res == WAIT_OBJECT_0, "Unexpected wait result %#lx.\n", res);
+        ok(callback.count == item_count, "Unexpected item count %ld.\n", callback.count);
+
+        elapsed = (double)(end.QuadPart - start.QuadPart) / freq.QuadPart;
+        if (res == WAIT_OBJECT_0 && elapsed > 0.0)
+            trace("%ld items in %.3f ms, %.0f items/s.\n", item_count, elapsed * 1000.0, item_count / elapsed);
+
+        winetest_pop_context();
+    }
+
+    CloseHandle(callback.event);
+
+    hr = RtwqShutdown();
+    ok(hr == S_OK, "Failed to shut down, hr %#lx.\n", hr);
+}
+
 START_TEST(rtworkq)
 {
     test_platform_init();
@@ -676,4 +784,5 @@ START_TEST(rtworkq)
     test_work_queue();
     test_scheduled_items();
     test_queue_shutdown();
+    test_work_item_throughput();
 }
@@ -0,0 +1,180 @@
+/*
+ * Media Foundation pipeline event tracing
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "windef.h"
+#include "winbase.h"
+
+#include "wine/debug.h"
+#include "wine/mftrace.h"
+
+WINE_DEFAULT_DEBUG_CHANNEL(mfplat);
+
+#define EVENT_RING_SIZE 65536
+
+struct trace_entry
+{
+    LONG64 seq;
+    LARGE_INTEGER time;
+    DWORD tid;
+    enum wine_mf_trace_event event;
+    const void *object;
+    LONGLONG value;
+};
+
+static struct trace_entry *trace_ring;
+static LONG64 trace_pos;
+static WCHAR *trace_path;
+static INIT_ONCE trace_init_once = INIT_ONCE_STATIC_INIT;
+
+static BOOL WINAPI trace_init(INIT_ONCE *once, void *param, void **context)
+{
+    DWORD len;
+
+    if (!(len = GetEnvironmentVariableW(L"WINE_MF_TRACE", NULL, 0)))
+        return TRUE;
+
+    /* Every process inherits the variable, each one writes its own file. */
+    len += 11;
+    if (!(trace_path = malloc(len * sizeof(WCHAR))))
+        return TRUE;
+    GetEnvironmentVariableW(L"WINE_MF_TRACE", trace_path, len);
+    swprintf(trace_path + wcslen(trace_path), 12, L".%lu", GetCurrentProcessId());
+
+    if (!(trace_ring = calloc(EVENT_RING_SIZE, sizeof(*trace_ring))))
+    {
+        free(trace_path);
+        trace_path = NULL;
+        return TRUE;
+    }
+
+    TRACE("Recording pipeline events to %s.\n", debugstr_w(trace_path));
+
+    return TRUE;
+}
+
+static BOOL trace_enabled(void)
+{
+    InitOnceExecuteOnce(&trace_init_once, trace_init, NULL, NULL);
+    return !!trace_ring;
+}
+
+BOOL WINAPI __wine_rtwq_trace_enabled(void)
+{
+    return trace_enabled();
+}
+
+void WINAPI __wine_rtwq_trace(enum wine_mf_trace_event event, const void *object, LONGLONG value)
+{
+    struct trace_entry *entry;
+    LONG64 pos;
+
+    if (!trace_enabled())
+        return;
+
+    pos = InterlockedIncrement64(&trace_pos) - 1;
+    entry = &trace_ring[pos % EVENT_RING_SIZE];
+
+    /* Invalidate the slot while it's being written, readers skip entries whose sequence
+     * number doesn't match their position. */
+    InterlockedCompareExchange64(&entry->seq, 0, pos + 1 - EVENT_RING_SIZE);
+    QueryPerformanceCounter(&entry->time);
+    entry->tid = GetCurrentThreadId();
+    entry->event = event;
+    entry->object = object;
+    entry->value = value;
+    WriteRelease64(&entry->seq, pos + 1);
+}
+
+static const struct
+{
+    const char *name;
+    const char *category;
+    char phase;
+}
+trace_events[] =
+{
+    [WINE_MF_TRACE_SAMPLE_REQUEST] = {"request", "session", 'i'},
+    [WINE_MF_TRACE_SAMPLE_READY] = {"ready", "source", 'i'},
+    [WINE_MF_TRACE_SAMPLE_DELIVER] = {"deliver", "session", 'i'},
+    [WINE_MF_TRACE_DECODE_BEGIN] = {"decode", "transform", 'B'},
+    [WINE_MF_TRACE_DECODE_END] = {"decode", "transform", 'E'},
+    [WINE_MF_TRACE_SAMPLE_PRESENT] = {"present", "session", 'i'},
+    [WINE_MF_TRACE_WORK_ITEM_BEGIN] = {"work item", "rtwq", 'B'},
+    [WINE_MF_TRACE_WORK_ITEM_END] = {"work item", "rtwq", 'E'},
+    [WINE_MF_TRACE_COPY_BEGIN] = {"copy", "mfplat", 'B'},
+    [WINE_MF_TRACE_COPY_END] = {"copy", "mfplat", 'E'},
+};
+
+BOOL WINAPI __wine_rtwq_trace_dump(const WCHAR *path)
+{
+    LARGE_INTEGER frequency;
+    struct trace_entry entry;
+    LONG64 pos, end;
+    BOOL first = TRUE;
+    FILE *file;
+
+    TRACE("%s.\n", debugstr_w(path));
+
+    if (!trace_enabled())
+        return FALSE;
+
+    if (!path)
+        path = trace_path;
+
+    if (!(file = _wfopen(path, L"w")))
+    {
+        WARN("Failed to open %s.\n", debugstr_w(path));
+        return FALSE;
+    }
+
+    QueryPerformanceFrequency(&frequency);
+
+    end = ReadAcquire64(&trace_pos);
+    pos = end > EVENT_RING_SIZE ? end - EVENT_RING_SIZE : 0;
+
+    fprintf(file, "{\"traceEvents\":[\n");
+
+    for (; pos < end; ++pos)
+    {
+        struct trace_entry *slot = &trace_ring[pos % EVENT_RING_SIZE];
+
+        if (ReadAcquire64(&slot->seq) != pos + 1)
+            continue;
+        entry = *slot;
+        if (ReadAcquire64(&slot->seq) != pos + 1 || entry.event >= ARRAY_SIZE(trace_events))
+            continue;
+
+        fprintf(file, "%s{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":%lu,\"tid\":%lu,",
+                first ? "" : ",\n", trace_events[entry.event].name, trace_events[entry.event].category,
+                trace_events[entry.event].phase, entry.time.QuadPart * 1000000.0 / frequency.QuadPart,
+                GetCurrentProcessId(), entry.tid);
+        if (trace_events[entry.event].phase == 'i')
+            fprintf(file, "\"s\":\"t\",");
+        fprintf(file, "\"args\":{\"object\":\"%p\",\"value\":%I64d}}", entry.object, entry.value);
+        first = FALSE;
+    }
+
+    fprintf(file, "\n]}\n");
+    fclose(file);
+
+    return TRUE;
+}
@@ -23,7 +23,12 @@
 #endif
 
 #include <assert.h>
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
 
+#include "ntstatus.h"
+#define WIN32_NO_STATUS
 #include "ntgdi_private.h"
 #include "dibdrv.h"
 
@@ -585,17 +590,208 @@ static void mask_rect( dib_info *dst, const RECT *dst_rect, const dib_info *src,
     }
 }
 
+/* Large blends, gradients and stretches are split into horizontal bands that are drawn in
+ * parallel by a small pool of worker threads, the calling thread drawing its share as well.
+ * Bands never share a row and each band is drawn exactly as the single threaded code would,
+ * so the result doesn't depend on the number of threads.
+ *
+ * The workers are plain pthreads with no TEB and all signals blocked, so a page fault that
+ * Wine would normally resolve in its signal handler (write watches, guard pages) kills the
+ * process instead. Bands are therefore only used when all the bits involved are either
+ * allocated by the unix side, or committed private memory that can't fault that way; see
+ * is_band_safe_bits(). An application changing the protection of the bits while they are
+ * being drawn is not handled. */
+
+#define BAND_MIN_PIXELS   (512 * 512)  /* smaller operations stay on the calling thread */
+#define BAND_MIN_ROWS     16
+#define BAND_MAX_THREADS  8
+#define BAND_MAX_COUNT    64
+
+struct band_job
+{
+    void        (*func)( void *ctx, int band );
+    void         *ctx;
+    int           count;  /* total number of bands */
+    int           next;   /* next band to draw */
+    int           done;   /* number of bands drawn */
+};
+
+static pthread_mutex_t band_job_mutex = PTHREAD_MUTEX_INITIALIZER;  /* held by the thread owning the pool */
+static pthread_mutex_t band_mutex = PTHREAD_MUTEX_INITIALIZER;      /* protects the fields below */
+static pthread_cond_t band_start_cond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t band_done_cond = PTHREAD_COND_INITIALIZER;
+static struct band_job *band_job;
+static pthread_once_t band_once = PTHREAD_ONCE_INIT;
+static int band_threads;
+
+static void *band_thread( void *arg )
+{
+    struct band_job *job;
+    int band;
+
+    pthread_mutex_lock( &band_mutex );
+    for (;;)
+    {
+        while (!(job = band_job) || job->next == job->count)
+            pthread_cond_wait( &band_start_cond, &band_mutex );
+        band = job->next++;
+        pthread_mutex_unlock( &band_mutex );
+
+        job->func( job->ctx, band );
+
+        pthread_mutex_lock( &band_mutex );
+        if (++job->done == job->count) pthread_cond_signal( &band_done_cond );
+    }
+    return NULL;
+}
+
+static void init_band_threads(void)
+{
+    long cpus = sysconf( _SC_NPROCESSORS_ONLN );
+    pthread_attr_t attr;
+    sigset_t sigset, old_sigset;
+    pthread_t thread;
+    int i;
+
+    /* the workers only ever touch pixels, keep them away from Wine's signals */
+    sigfillset( &sigset );
+    pthread_sigmask( SIG_SETMASK, &sigset, &old_sigset );
+    pthread_attr_init( &attr );
+    pthread_attr_setdetachstate( &attr, PTHREAD_CREATE_DETACHED );
+    for (i = 0; i < min( cpus, BAND_MAX_THREADS + 1 ) - 1; i++)
+    {
+        if (pthread_create( &thread, &attr, band_thread, NULL )) break;
+        band_threads++;
+    }
+    pthread_attr_destroy( &attr );
+    pthread_sigmask( SIG_SETMASK, &old_sigset, NULL );
+
+    TRACE( "using %d band threads\n", band_threads );
+}
+
+/* check that the band threads can access the bits of a dib without faulting */
+static BOOL is_band_safe_bits( const dib_info *dib, BOOL write )
+{
+    MEMORY_BASIC_INFORMATION info;
+    char *base = dib->bits.ptr;
+    SIZE_T size = (SIZE_T)abs( dib->stride ) * dib->height, count = 1;
+    ULONG granularity;
+    void *addr;
+
+    if (dib->stride < 0) base += (SSIZE_T)(dib->height - 1) * dib->stride;
+    if (NtQueryVirtualMemory( GetCurrentProcess(), base, MemoryBasicInformation, &info, sizeof(info), NULL ))
+        return FALSE;
+    /* not in any view, so not application memory, e.g. bitmap bits from calloc() */
+    if (info.State == MEM_FREE) return TRUE;
+
+    if (info.State != MEM_COMMIT || info.Type != MEM_PRIVATE) return FALSE;
+    if (info.Protect != PAGE_READWRITE && (write || info.Protect != PAGE_READONLY)) return FALSE;
+    if ((char *)info.BaseAddress + info.RegionSize < base + size) return FALSE;
+    if (!write) return TRUE;
+    /* write watched pages fault on the first write after each reset */
+    return NtGetWriteWatch( GetCurrentProcess(), 0, base, size, &addr, &count, &granularity ) == STATUS_INVALID_PARAMETER;
+}
+
+/* number of bands to split an operation of the given size into, 1 if it's not worth it */
+static int get_band_count( const dib_info *dst, const dib_info *src, int width, int height )
+{
+    if ((LONGLONG)width * height < BAND_MIN_PIXELS) return 1;
+    pthread_once( &band_once, init_band_threads );
+    if (!band_threads) return 1;
+    if (!is_band_safe_bits( dst, TRUE ) || (src && !is_band_safe_bits( src, FALSE ))) return 1;
+    return max( 1, min( min( height / BAND_MIN_ROWS, 4 * (band_threads + 1) ), BAND_MAX_COUNT ));
+}
+
+static void run_bands( void (*func)( void *ctx, int band ), void *ctx, int count )
+{
+    struct band_job job = { func, ctx, count };
+    int band;
+
+    /* another thread is already using the pool, don't wait for it */
+    if (count <= 1 || pthread_mutex_trylock( &band_job_mutex ))
+    {
+        for (band = 0; band < count; band++) func( ctx, band );
+        return;
+    }
+
+    pthread_mutex_lock( &band_mutex );
+    band_job = &job;
+    pthread_cond_broadcast( &band_start_cond );
+    while (job.next < job.count)
+    {
+        band = job.next++;
+        pthread_mutex_unlock( &band_mutex );
+        func( ctx, band );
+        pthread_mutex_lock( &band_mutex );
+        job.done++;
+    }
+    while (job.done < job.count) pthread_cond_wait( &band_done_cond, &band_mutex );
+    band_job = NULL;
+    pthread_mutex_unlock( &band_mutex );
+    pthread_mutex_unlock( &band_job_mutex );
+}
+
+/* the rows covered by a band of the given bounds */
+static void get_band_rows( const RECT *bounds, int band, int count, int *top, int *bottom )
+{
+    int height = bounds->bottom - bounds->top;
+
+    *top = bounds->top + (LONGLONG)height * band / count;
+    *bottom = bounds->top + (LONGLONG)height * (band + 1) / count;
+}
+
+struct blend_bands
+{
+    const dib_info          *dst;
+    const dib_info          *src;
+    const struct clipped_rects *clipped_rects;
+    RECT                     bounds;
+    POINT                    offset;
+    BLENDFUNCTION            blend;
+    int                      count;
+};
+
+static void blend_band( void *ctx, int band )
+{
+    const struct blend_bands *bands = ctx;
+    RECT rect;
+    int i, top, bottom;
+
+    get_band_rows( &bands->bounds, band, bands->count, &top, &bottom );
+    for (i = 0; i < bands->clipped_rects->count; i++)
+    {
+        rect = bands->clipped_rects->rects[i];
+        rect.top = max( rect.top, top );
+        rect.bottom = min( rect.bottom, bottom );
+        if (rect.top >= rect.bottom) continue;
+        bands->dst->funcs->blend_rects( bands->dst, 1, &rect, bands->src, &bands->offset, bands->blend );
+    }
+}
+
 static DWORD blend_rect( dib_info *dst, const RECT *dst_rect, const dib_info *src, const RECT *src_rect,
                          HRGN clip, BLENDFUNCTION blend )
 {
-    POINT offset;
+    struct blend_bands bands;
     struct clipped_rects clipped_rects;
 
     if (!get_clipped_rects( dst, dst_rect, clip, &clipped_rects )) return ERROR_SUCCESS;
 
-    offset.x = src_rect->left - dst_rect->left;
-    offset.y = src_rect->top  - dst_rect->top;
-    dst->funcs->blend_rects( dst, clipped_rects.count, clipped_rects.rects, src, &offset, blend );
+    bands.offset.x = src_rect->left - dst_rect->left;
+    bands.offset.y = src_rect->top  - dst_rect->top;
+    bands.bounds.top = clipped_rects.rects[0].top;
+    bands.bounds.bottom = clipped_rects.rects[clipped_rects.count - 1].bottom;
+    bands.count = get_band_count( dst, src, dst_rect->right - dst_rect->left,
+                                  bands.bounds.bottom - bands.bounds.top );
+
+    if (bands.count > 1)
+    {
+        bands.dst = dst;
+        bands.src = src;
+        bands.clipped_rects = &clipped_rects;
+        bands.blend = blend;
+        run_bands( blend_band, &bands, bands.count );
+    }
+    else dst->funcs->blend_rects( dst, clipped_rects.count, clipped_rects.rects, src, &bands.offset, blend );
 
     free_clipped_rects( &clipped_rects );
     return ERROR_SUCCESS;
@@ -680,16 +876,68 @@ static void get_gradient_triangle_vertices( const GRADIENT_TRIANGLE *tri, const
     bounds->bottom = v[2].y;
 }
 
+struct gradient_bands
+{
+    const dib_info          *dib;
+    const struct clipped_rects *clipped_rects;
+    const TRIVERTEX         *v;
+    RECT                     bounds;
+    int                      mode;
+    int                      count;
+    LONG                     failed;
+};
+
+static void gradient_band( void *ctx, int band )
+{
+    struct gradient_bands *bands = ctx;
+    RECT rect;
+    int i, top, bottom;
+
+    get_band_rows( &bands->bounds, band, bands->count, &top, &bottom );
+    for (i = 0; i < bands->clipped_rects->count; i++)
+    {
+        rect = bands->clipped_rects->rects[i];
+        rect.top = max( rect.top, top );
+        rect.bottom = min( rect.bottom, bottom );
+        if (rect.top >= rect.bottom) continue;
+        if (!bands->dib->funcs->gradient_rect( bands->dib, &rect, bands->v, bands->mode ))
+        {
+            InterlockedExchange( &bands->failed, TRUE );
+            break;
+        }
+    }
+}
+
 static BOOL gradient_rect( dib_info *dib, TRIVERTEX *v, int mode, HRGN clip, const RECT *bounds )
 {
     int i;
     struct clipped_rects clipped_rects;
+    struct gradient_bands bands;
     BOOL ret = TRUE;
 
     if (!get_clipped_rects( dib, bounds, clip, &clipped_rects )) return TRUE;
-    for (i = 0; i < clipped_rects.count; i++)
+
+    bands.bounds.top = clipped_rects.rects[0].top;
+    bands.bounds.bottom = clipped_rects.rects[clipped_rects.count - 1].bottom;
+    bands.count = get_band_count( dib, NULL, bounds->right - bounds->left,
+                                  bands.bounds.bottom - bands.bounds.top );
+
+    if (bands.count > 1)
     {
-        if (!(ret = dib->funcs->gradient_rect( dib, &clipped_rects.rects[i], v, mode ))) break;
+        bands.dib = dib;
+        bands.clipped_rects = &clipped_rects;
+        bands.v = v;
+        bands.mode = mode;
+        bands.failed = FALSE;
+        run_bands( gradient_band, &bands, bands.count );
+        ret = !bands.failed;
+    }
+    else
+    {
+        for (i = 0; i < clipped_rects.count; i++)
+        {
+            if (!(ret = dib->funcs->gradient_rect( dib, &clipped_rects.rects[i], v, mode ))) break;
+        }
     }
     free_clipped_rects( &clipped_rects );
     return ret;
@@ -1198,6 +1446,149 @@ static DWORD calc_1d_stretch_params( INT dst_start, INT dst_length, INT dst_vis_
 }
 
 
+struct stretch_band
+{
+    POINT        dst_start;
+    POINT        src_start;
+    int          err;
+    unsigned int length;  /* number of vertical steps */
+};
+
+struct stretch_bands
+{
+    dib_info                     *dst_dib;
+    const dib_info               *src_dib;
+    const struct stretch_params  *v_params;
+    const struct stretch_params  *h_params;
+    void                        (*row_fn)( const dib_info *dst_dib, const POINT *dst_start,
+                                           const dib_info *src_dib, const POINT *src_start,
+                                           const struct stretch_params *params, int mode, BOOL keep_dst );
+    int                           mode;
+    int                           width;
+    BOOL                          vstretch;
+    struct stretch_band           bands[BAND_MAX_COUNT];
+};
+
+static void stretch_band( void *ctx, int index )
+{
+    const struct stretch_bands *bands = ctx;
+    const struct stretch_params *v_params = bands->v_params;
+    const struct stretch_band *band = &bands->bands[index];
+    POINT dst_start = band->dst_start, src_start = band->src_start;
+    unsigned int length = band->length;
+    int err = band->err;
+
+    if (bands->vstretch)
+    {
+        BOOL need_row = TRUE;
+        RECT last_row, this_row;
+        last_row.left = 0;
+        last_row.right = bands->width;
+
+        while (length--)
+        {
+            if (need_row)
+            {
+                bands->row_fn( bands->dst_dib, &dst_start, bands->src_dib, &src_start,
+                               bands->h_params, bands->mode, FALSE );
+                need_row = FALSE;
+            }
+            else
+            {
+                last_row.top = dst_start.y - v_params->dst_inc;
+                last_row.bottom = last_row.top + 1;
+                this_row = last_row;
+                OffsetRect( &this_row, 0, v_params->dst_inc );
+                copy_rect( bands->dst_dib, &this_row, bands->dst_dib, &last_row, NULL, R2_COPYPEN );
+            }
+
+            if (err > 0)
+            {
+                src_start.y += v_params->src_inc;
+                need_row = TRUE;
+                err += v_params->err_add_1;
+            }
+            else err += v_params->err_add_2;
+            dst_start.y += v_params->dst_inc;
+        }
+    }
+    else
+    {
+        int merged_rows = 0;
+
+        while (length--)
+        {
+            if (bands->mode != STRETCH_DELETESCANS || !merged_rows)
+                bands->row_fn( bands->dst_dib, &dst_start, bands->src_dib, &src_start,
+                               bands->h_params, bands->mode, merged_rows != 0 );
+            merged_rows++;
+
+            if (err > 0)
+            {
+                dst_start.y += v_params->dst_inc;
+                merged_rows = 0;
+                err += v_params->err_add_1;
+            }
+            else err += v_params->err_add_2;
+            src_start.y += v_params->src_inc;
+        }
+    }
+}
+
+/* Walk the vertical steps to find where each band starts. A band may only start on a new
+ * destination row, where the single threaded code would draw the row from scratch or, when
+ * stretching, draw the same source row again instead of copying the previous one. */
+static int get_stretch_bands( struct stretch_bands *bands, POINT dst_start, POINT src_start,
+                              int count, int rows_per_band )
+{
+    const struct stretch_params *v_params = bands->v_params;
+    unsigned int i;
+    int err = v_params->err_start, band = 0, rows = 0;
+    BOOL new_row = TRUE;
+
+    bands->bands[0].length = 0;
+    for (i = 0; i < v_params->length; i++)
+    {
+        if (new_row && rows >= rows_per_band && band + 1 < count)
+        {
+            band++;
+            rows = 0;
+            bands->bands[band].length = 0;
+        }
+        if (!bands->bands[band].length)
+        {
+            bands->bands[band].dst_start = dst_start;
+            bands->bands[band].src_start = src_start;
+            bands->bands[band].err = err;
+        }
+        bands->bands[band].length++;
+
+        if (bands->vstretch)
+        {
+            if (err > 0)
+            {
+                src_start.y += v_params->src_inc;
+                err += v_params->err_add_1;
+            }
+            else err += v_params->err_add_2;
+            dst_start.y += v_params->dst_inc;
+            rows++;
+        }
+        else
+        {
+            if ((new_row = err > 0))
+            {
+                dst_start.y += v_params->dst_inc;
+                err += v_params->err_add_1;
+                rows++;
+            }
+            else err += v_params->err_add_2;
+            src_start.y += v_params->src_inc;
+        }
+    }
+    return band + 1;
+}
+
 DWORD stretch_bitmapinfo( const BITMAPINFO *src_info, void *src_bits, struct bitblt_coords *src,
                           const BITMAPINFO *dst_info, void *dst_bits, struct bitblt_coords *dst,
                           INT mode )
@@ -1207,11 +1598,9 @@ DWORD stretch_bitmapinfo( const BITMAPINFO *src_info, void *src_bits, struct bit
     RECT rect;
     BOOL hstretch, vstretch;
     struct stretch_params v_params, h_params;
-    int err;
+    struct stretch_bands bands;
+    int count, height;
     DWORD ret;
-    void (* row_fn)(const dib_info *dst_dib, const POINT *dst_start,
-                    const dib_info *src_dib, const POINT *src_start,
-                    const struct stretch_params *params, int mode, BOOL keep_dst);
 
     TRACE("dst %d, %d - %d x %d visrect %s src %d, %d - %d x %d visrect %s\n",
           dst->x, dst->y, dst->width, dst->height, wine_dbgstr_rect(&dst->visrect),
@@ -1251,63 +1640,28 @@ DWORD stretch_bitmapinfo( const BITMAPINFO *src_info, void *src_bits, struct bit
     dst_start.x -= dst->visrect.left;
     dst_start.y -= dst->visrect.top;
 
-    err = v_params.err_start;
-
-    row_fn = hstretch ? dst_dib.funcs->stretch_row : dst_dib.funcs->shrink_row;
-
-    if (vstretch)
+    bands.dst_dib = &dst_dib;
+    bands.src_dib = &src_dib;
+    bands.v_params = &v_params;
+    bands.h_params = &h_params;
+    bands.row_fn = hstretch ? dst_dib.funcs->stretch_row : dst_dib.funcs->shrink_row;
+    bands.mode = (vstretch && hstretch) ? STRETCH_DELETESCANS : mode;
+    bands.width = dst->visrect.right - dst->visrect.left;
+    bands.vstretch = vstretch;
+
+    height = dst->visrect.bottom - dst->visrect.top;
+    if (dst_dib.funcs != &funcs_null && (count = get_band_count( &dst_dib, &src_dib, bands.width, height )) > 1)
     {
-        BOOL need_row = TRUE;
-        RECT last_row, this_row;
-        if (hstretch) mode = STRETCH_DELETESCANS;
-        last_row.left = 0;
-        last_row.right = dst->visrect.right - dst->visrect.left;
-
-        while (v_params.length--)
-        {
-            if (need_row)
-            {
-                row_fn( &dst_dib, &dst_start, &src_dib, &src_start, &h_params, mode, FALSE );
-                need_row = FALSE;
-            }
-            else
-            {
-                last_row.top = dst_start.y - v_params.dst_inc;
-                last_row.bottom = last_row.top + 1;
-                this_row = last_row;
-                OffsetRect( &this_row, 0, v_params.dst_inc );
-                copy_rect( &dst_dib, &this_row, &dst_dib, &last_row, NULL, R2_COPYPEN );
-            }
-
-            if (err > 0)
-            {
-                src_start.y += v_params.src_inc;
-                need_row = TRUE;
-                err += v_params.err_add_1;
-            }
-            else err += v_params.err_add_2;
-            dst_start.y += v_params.dst_inc;
-        }
+        count = get_stretch_bands( &bands, dst_start, src_start, count, (height + count - 1) / count );
+        run_bands( stretch_band, &bands, count );
     }
     else
     {
-        int merged_rows = 0;
-
-        while (v_params.length--)
-        {
-            if (mode != STRETCH_DELETESCANS || !merged_rows)
-                row_fn( &dst_dib, &dst_start, &src_dib, &src_start, &h_params, mode, merged_rows != 0 );
-            merged_rows++;
-
-            if (err > 0)
-            {
-                dst_start.y += v_params.dst_inc;
-                merged_rows = 0;
-                err += v_params.err_add_1;
-            }
-            else err += v_params.err_add_2;
-            src_start.y += v_params.src_inc;
-        }
+        bands.bands[0].dst_start = dst_start;
+        bands.bands[0].src_start = src_start;
+        bands.bands[0].err = v_params.err_start;
+        bands.bands[0].length = v_params.length;
+        stretch_band( &bands, 0 );
     }
 
 done:
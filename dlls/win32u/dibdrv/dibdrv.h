@@ -213,9 +213,9 @@ typedef struct primitive_funcs
                                     const dib_info *src_dib, const struct bitblt_coords *src);
 } primitive_funcs;
 
-extern const primitive_funcs funcs_8888;
-extern const primitive_funcs funcs_32;
-extern const primitive_funcs funcs_24;
+extern primitive_funcs funcs_8888;
+extern primitive_funcs funcs_32;
+extern primitive_funcs funcs_24;
 extern const primitive_funcs funcs_555;
 extern const primitive_funcs funcs_16;
 extern const primitive_funcs funcs_8;
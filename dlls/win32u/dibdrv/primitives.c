@@ -23,7 +23,15 @@
 #endif
 
 #include <assert.h>
+#if (defined(__i386__) || defined(__x86_64__)) && defined(__GNUC__)
+#include <immintrin.h>
+#define HAVE_DIB_SIMD
+#endif
 
+#include "ntstatus.h"
+#define WIN32_NO_STATUS
+#include "winternl.h"
+#include "ddk/wdm.h"
 #include "ntgdi_private.h"
 #include "dibdrv.h"
 
@@ -8036,7 +8044,687 @@ static void halftone_null( const dib_info *dst_dib, const struct bitblt_coords *
                            const dib_info *src_dib, const struct bitblt_coords *src )
 {}
 
-const primitive_funcs funcs_8888 =
+#ifdef HAVE_DIB_SIMD
+
+/* SSE2 and AVX2 versions of the hottest 32 and 24 bpp primitives. They must give exactly the
+ * same results as the generic versions, which they fall back to for the cases they don't handle. */
+
+#define SSE2_TARGET __attribute__((target("sse2")))
+#define AVX2_TARGET __attribute__((target("avx2")))
+
+static const struct _KUSER_SHARED_DATA *user_shared_data = (struct _KUSER_SHARED_DATA *)0x7ffe0000;
+
+static inline void SSE2_TARGET do_rop_line_32_sse2( DWORD *ptr, DWORD and, DWORD xor, int len )
+{
+    const __m128i and_vec = _mm_set1_epi32( and ), xor_vec = _mm_set1_epi32( xor );
+    __m128i d;
+
+    for (; len >= 4; len -= 4, ptr += 4)
+    {
+        d = _mm_loadu_si128( (const __m128i *)ptr );
+        _mm_storeu_si128( (__m128i *)ptr, _mm_xor_si128( _mm_and_si128( d, and_vec ), xor_vec ));
+    }
+    for (; len > 0; len--) do_rop_32( ptr++, and, xor );
+}
+
+static inline void AVX2_TARGET do_rop_line_32_avx2( DWORD *ptr, DWORD and, DWORD xor, int len )
+{
+    const __m256i and_vec = _mm256_set1_epi32( and ), xor_vec = _mm256_set1_epi32( xor );
+    __m256i d;
+
+    for (; len >= 8; len -= 8, ptr += 8)
+    {
+        d = _mm256_loadu_si256( (const __m256i *)ptr );
+        _mm256_storeu_si256( (__m256i *)ptr, _mm256_xor_si256( _mm256_and_si256( d, and_vec ), xor_vec ));
+    }
+    do_rop_line_32_sse2( ptr, and, xor, len );
+}
+
+/* and and xor point to 48 bytes of a pattern repeating every 3 bytes, starting at the first byte */
+static inline void SSE2_TARGET do_rop_line_24_sse2( BYTE *ptr, const BYTE *and, const BYTE *xor, int len )
+{
+    __m128i and_vec[3], xor_vec[3], d;
+    int i;
+
+    for (i = 0; i < 3; i++)
+    {
+        and_vec[i] = _mm_loadu_si128( (const __m128i *)and + i );
+        xor_vec[i] = _mm_loadu_si128( (const __m128i *)xor + i );
+    }
+    for (; len >= 48; len -= 48, ptr += 48)
+    {
+        for (i = 0; i < 3; i++)
+        {
+            d = _mm_loadu_si128( (const __m128i *)ptr + i );
+            _mm_storeu_si128( (__m128i *)ptr + i, _mm_xor_si128( _mm_and_si128( d, and_vec[i] ), xor_vec[i] ));
+        }
+    }
+    for (i = 0; i < len; i++) do_rop_8( ptr + i, and[i], xor[i] );
+}
+
+/* same as above with 96 bytes of pattern */
+static inline void AVX2_TARGET do_rop_line_24_avx2( BYTE *ptr, const BYTE *and, const BYTE *xor, int len )
+{
+    __m256i and_vec[3], xor_vec[3], d;
+    int i;
+
+    for (i = 0; i < 3; i++)
+    {
+        and_vec[i] = _mm256_loadu_si256( (const __m256i *)and + i );
+        xor_vec[i] = _mm256_loadu_si256( (const __m256i *)xor + i );
+    }
+    for (; len >= 96; len -= 96, ptr += 96)
+    {
+        for (i = 0; i < 3; i++)
+        {
+            d = _mm256_loadu_si256( (const __m256i *)ptr + i );
+            _mm256_storeu_si256( (__m256i *)ptr + i, _mm256_xor_si256( _mm256_and_si256( d, and_vec[i] ), xor_vec[i] ));
+        }
+    }
+    do_rop_line_24_sse2( ptr, and, xor, len );
+}
+
+static inline void SSE2_TARGET do_rop_codes_line_8_sse2( BYTE *dst, const BYTE *src, struct rop_codes *codes, int len )
+{
+    const __m128i a1 = _mm_set1_epi32( codes->a1 ), a2 = _mm_set1_epi32( codes->a2 );
+    const __m128i x1 = _mm_set1_epi32( codes->x1 ), x2 = _mm_set1_epi32( codes->x2 );
+    __m128i s, d;
+
+    for (; len >= 16; len -= 16, src += 16, dst += 16)
+    {
+        s = _mm_loadu_si128( (const __m128i *)src );
+        d = _mm_loadu_si128( (const __m128i *)dst );
+        d = _mm_xor_si128( _mm_and_si128( d, _mm_xor_si128( _mm_and_si128( s, a1 ), a2 )),
+                           _mm_xor_si128( _mm_and_si128( s, x1 ), x2 ));
+        _mm_storeu_si128( (__m128i *)dst, d );
+    }
+    do_rop_codes_line_8( dst, src, codes, len );
+}
+
+static inline void SSE2_TARGET do_rop_codes_line_rev_8_sse2( BYTE *dst, const BYTE *src, struct rop_codes *codes, int len )
+{
+    const __m128i a1 = _mm_set1_epi32( codes->a1 ), a2 = _mm_set1_epi32( codes->a2 );
+    const __m128i x1 = _mm_set1_epi32( codes->x1 ), x2 = _mm_set1_epi32( codes->x2 );
+    __m128i s, d;
+
+    for (src += len, dst += len; len >= 16; len -= 16)
+    {
+        src -= 16;
+        dst -= 16;
+        s = _mm_loadu_si128( (const __m128i *)src );
+        d = _mm_loadu_si128( (const __m128i *)dst );
+        d = _mm_xor_si128( _mm_and_si128( d, _mm_xor_si128( _mm_and_si128( s, a1 ), a2 )),
+                           _mm_xor_si128( _mm_and_si128( s, x1 ), x2 ));
+        _mm_storeu_si128( (__m128i *)dst, d );
+    }
+    do_rop_codes_line_rev_8( dst - len, src - len, codes, len );
+}
+
+static inline void AVX2_TARGET do_rop_codes_line_8_avx2( BYTE *dst, const BYTE *src, struct rop_codes *codes, int len )
+{
+    const __m256i a1 = _mm256_set1_epi32( codes->a1 ), a2 = _mm256_set1_epi32( codes->a2 );
+    const __m256i x1 = _mm256_set1_epi32( codes->x1 ), x2 = _mm256_set1_epi32( codes->x2 );
+    __m256i s, d;
+
+    for (; len >= 32; len -= 32, src += 32, dst += 32)
+    {
+        s = _mm256_loadu_si256( (const __m256i *)src );
+        d = _mm256_loadu_si256( (const __m256i *)dst );
+        d = _mm256_xor_si256( _mm256_and_si256( d, _mm256_xor_si256( _mm256_and_si256( s, a1 ), a2 )),
+                              _mm256_xor_si256( _mm256_and_si256( s, x1 ), x2 ));
+        _mm256_storeu_si256( (__m256i *)dst, d );
+    }
+    do_rop_codes_line_8_sse2( dst, src, codes, len );
+}
+
+static inline void AVX2_TARGET do_rop_codes_line_rev_8_avx2( BYTE *dst, const BYTE *src, struct rop_codes *codes, int len )
+{
+    const __m256i a1 = _mm256_set1_epi32( codes->a1 ), a2 = _mm256_set1_epi32( codes->a2 );
+    const __m256i x1 = _mm256_set1_epi32( codes->x1 ), x2 = _mm256_set1_epi32( codes->x2 );
+    __m256i s, d;
+
+    for (src += len, dst += len; len >= 32; len -= 32)
+    {
+        src -= 32;
+        dst -= 32;
+        s = _mm256_loadu_si256( (const __m256i *)src );
+        d = _mm256_loadu_si256( (const __m256i *)dst );
+        d = _mm256_xor_si256( _mm256_and_si256( d, _mm256_xor_si256( _mm256_and_si256( s, a1 ), a2 )),
+                              _mm256_xor_si256( _mm256_and_si256( s, x1 ), x2 ));
+        _mm256_storeu_si256( (__m256i *)dst, d );
+    }
+    do_rop_codes_line_rev_8_sse2( dst - len, src - len, codes, len );
+}
+
+static inline void solid_rects_32_simd( const dib_info *dib, int num, const RECT *rc, DWORD and, DWORD xor,
+                                        void (*rop_line)( DWORD *, DWORD, DWORD, int ) )
+{
+    DWORD *start;
+    int y, i;
+
+    if (!and)  /* memset_32() is already as fast as it gets */
+    {
+        solid_rects_32( dib, num, rc, and, xor );
+        return;
+    }
+
+    for (i = 0; i < num; i++, rc++)
+    {
+        assert( !IsRectEmpty( rc ));
+
+        start = get_pixel_ptr_32( dib, rc->left, rc->top );
+        for (y = rc->top; y < rc->bottom; y++, start += dib->stride / 4)
+            rop_line( start, and, xor, rc->right - rc->left );
+    }
+}
+
+static void SSE2_TARGET solid_rects_32_sse2( const dib_info *dib, int num, const RECT *rc, DWORD and, DWORD xor )
+{
+    solid_rects_32_simd( dib, num, rc, and, xor, do_rop_line_32_sse2 );
+}
+
+static void AVX2_TARGET solid_rects_32_avx2( const dib_info *dib, int num, const RECT *rc, DWORD and, DWORD xor )
+{
+    solid_rects_32_simd( dib, num, rc, and, xor, do_rop_line_32_avx2 );
+}
+
+static inline void solid_rects_24_simd( const dib_info *dib, int num, const RECT *rc, DWORD and, DWORD xor,
+                                        void (*rop_line)( BYTE *, const BYTE *, const BYTE *, int ) )
+{
+    BYTE and_bytes[96], xor_bytes[96], *start;
+    int y, i;
+
+    for (i = 0; i < ARRAY_SIZE(and_bytes); i++)
+    {
+        and_bytes[i] = and >> (8 * (i % 3));
+        xor_bytes[i] = xor >> (8 * (i % 3));
+    }
+
+    for (i = 0; i < num; i++, rc++)
+    {
+        assert( !IsRectEmpty( rc ));
+
+        start = get_pixel_ptr_24( dib, rc->left, rc->top );
+        for (y = rc->top; y < rc->bottom; y++, start += dib->stride)
+            rop_line( start, and_bytes, xor_bytes, (rc->right - rc->left) * 3 );
+    }
+}
+
+static void SSE2_TARGET solid_rects_24_sse2( const dib_info *dib, int num, const RECT *rc, DWORD and, DWORD xor )
+{
+    solid_rects_24_simd( dib, num, rc, and, xor, do_rop_line_24_sse2 );
+}
+
+static void AVX2_TARGET solid_rects_24_avx2( const dib_info *dib, int num, const RECT *rc, DWORD and, DWORD xor )
+{
+    solid_rects_24_simd( dib, num, rc, and, xor, do_rop_line_24_avx2 );
+}
+
+static inline void copy_rect_simd( const dib_info *dst, const RECT *rc, const dib_info *src, const POINT *origin,
+                                   int rop2, int overlap, int bpp,
+                                   void (*rop_line)( BYTE *, const BYTE *, struct rop_codes *, int ),
+                                   void (*rop_line_rev)( BYTE *, const BYTE *, struct rop_codes *, int ) )
+{
+    BYTE *dst_start, *src_start;
+    int y, dst_stride, src_stride, len = (rc->right - rc->left) * bpp / 8;
+    struct rop_codes codes;
+
+    if (overlap & OVERLAP_BELOW)
+    {
+        dst_start = (BYTE *)dst->bits.ptr + (dst->rect.top + rc->bottom - 1) * dst->stride;
+        src_start = (BYTE *)src->bits.ptr + (src->rect.top + origin->y + rc->bottom - rc->top - 1) * src->stride;
+        dst_stride = -dst->stride;
+        src_stride = -src->stride;
+    }
+    else
+    {
+        dst_start = (BYTE *)dst->bits.ptr + (dst->rect.top + rc->top) * dst->stride;
+        src_start = (BYTE *)src->bits.ptr + (src->rect.top + origin->y) * src->stride;
+        dst_stride = dst->stride;
+        src_stride = src->stride;
+    }
+    dst_start += (dst->rect.left + rc->left) * bpp / 8;
+    src_start += (src->rect.left + origin->x) * bpp / 8;
+
+    get_rop_codes( rop2, &codes );
+    for (y = rc->top; y < rc->bottom; y++, dst_start += dst_stride, src_start += src_stride)
+    {
+        if (overlap & OVERLAP_RIGHT)
+            rop_line_rev( dst_start, src_start, &codes, len );
+        else
+            rop_line( dst_start, src_start, &codes, len );
+    }
+}
+
+static void SSE2_TARGET copy_rect_32_sse2( const dib_info *dst, const RECT *rc, const dib_info *src,
+                                           const POINT *origin, int rop2, int overlap )
+{
+    if (rop2 == R2_COPYPEN) copy_rect_32( dst, rc, src, origin, rop2, overlap );
+    else copy_rect_simd( dst, rc, src, origin, rop2, overlap, 32,
+                         do_rop_codes_line_8_sse2, do_rop_codes_line_rev_8_sse2 );
+}
+
+static void AVX2_TARGET copy_rect_32_avx2( const dib_info *dst, const RECT *rc, const dib_info *src,
+                                           const POINT *origin, int rop2, int overlap )
+{
+    if (rop2 == R2_COPYPEN) copy_rect_32( dst, rc, src, origin, rop2, overlap );
+    else copy_rect_simd( dst, rc, src, origin, rop2, overlap, 32,
+                         do_rop_codes_line_8_avx2, do_rop_codes_line_rev_8_avx2 );
+}
+
+static void SSE2_TARGET copy_rect_24_sse2( const dib_info *dst, const RECT *rc, const dib_info *src,
+                                           const POINT *origin, int rop2, int overlap )
+{
+    if (rop2 == R2_COPYPEN) copy_rect_24( dst, rc, src, origin, rop2, overlap );
+    else copy_rect_simd( dst, rc, src, origin, rop2, overlap, 24,
+                         do_rop_codes_line_8_sse2, do_rop_codes_line_rev_8_sse2 );
+}
+
+static void AVX2_TARGET copy_rect_24_avx2( const dib_info *dst, const RECT *rc, const dib_info *src,
+                                           const POINT *origin, int rop2, int overlap )
+{
+    if (rop2 == R2_COPYPEN) copy_rect_24( dst, rc, src, origin, rop2, overlap );
+    else copy_rect_simd( dst, rc, src, origin, rop2, overlap, 24,
+                         do_rop_codes_line_8_avx2, do_rop_codes_line_rev_8_avx2 );
+}
+
+/* (val + 127) / 255 for each 16-bit lane, exact for val <= 255 * 255 */
+static inline __m128i SSE2_TARGET div_255_round_epu16( __m128i val )
+{
+    val = _mm_add_epi16( val, _mm_set1_epi16( 127 ));
+    val = _mm_add_epi16( _mm_add_epi16( val, _mm_set1_epi16( 1 )), _mm_srli_epi16( val, 8 ));
+    return _mm_srli_epi16( val, 8 );
+}
+
+static inline __m128i SSE2_TARGET broadcast_alpha_epi16( __m128i val )
+{
+    val = _mm_shufflelo_epi16( val, _MM_SHUFFLE( 3, 3, 3, 3 ));
+    return _mm_shufflehi_epi16( val, _MM_SHUFFLE( 3, 3, 3, 3 ));
+}
+
+/* Blends four premultiplied pixels like blend_argb_alpha(). Returns FALSE without touching dst
+ * if a color component exceeds its alpha, as the scalar code then lets it carry into the next one. */
+static inline BOOL SSE2_TARGET blend_argb_sse2( DWORD *dst, const DWORD *src, DWORD alpha )
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i s = _mm_loadu_si128( (const __m128i *)src ), d = _mm_loadu_si128( (const __m128i *)dst );
+    __m128i s_lo = _mm_unpacklo_epi8( s, zero ), s_hi = _mm_unpackhi_epi8( s, zero );
+    __m128i a_lo = broadcast_alpha_epi16( s_lo ), a_hi = broadcast_alpha_epi16( s_hi );
+    __m128i d_lo, d_hi;
+
+    if (_mm_movemask_epi8( _mm_or_si128( _mm_cmpgt_epi16( s_lo, a_lo ), _mm_cmpgt_epi16( s_hi, a_hi ))))
+        return FALSE;
+
+    if (alpha != 255)
+    {
+        const __m128i scale = _mm_set1_epi16( alpha );
+        s_lo = div_255_round_epu16( _mm_mullo_epi16( s_lo, scale ));
+        s_hi = div_255_round_epu16( _mm_mullo_epi16( s_hi, scale ));
+        a_lo = broadcast_alpha_epi16( s_lo );
+        a_hi = broadcast_alpha_epi16( s_hi );
+    }
+
+    a_lo = _mm_sub_epi16( _mm_set1_epi16( 255 ), a_lo );
+    a_hi = _mm_sub_epi16( _mm_set1_epi16( 255 ), a_hi );
+    d_lo = _mm_add_epi16( s_lo, div_255_round_epu16( _mm_mullo_epi16( _mm_unpacklo_epi8( d, zero ), a_lo )));
+    d_hi = _mm_add_epi16( s_hi, div_255_round_epu16( _mm_mullo_epi16( _mm_unpackhi_epi8( d, zero ), a_hi )));
+    _mm_storeu_si128( (__m128i *)dst, _mm_packus_epi16( d_lo, d_hi ));
+    return TRUE;
+}
+
+/* Blends four pixels with a constant alpha like blend_argb_constant_alpha(). */
+static inline void SSE2_TARGET blend_argb_constant_alpha_sse2( DWORD *dst, const DWORD *src, DWORD alpha, DWORD src_or )
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i scale = _mm_set1_epi16( alpha ), inv_scale = _mm_set1_epi16( 255 - alpha );
+    __m128i s = _mm_or_si128( _mm_loadu_si128( (const __m128i *)src ), _mm_set1_epi32( src_or ));
+    __m128i d = _mm_loadu_si128( (const __m128i *)dst ), lo, hi;
+
+    lo = _mm_add_epi16( _mm_mullo_epi16( _mm_unpacklo_epi8( s, zero ), scale ),
+                        _mm_mullo_epi16( _mm_unpacklo_epi8( d, zero ), inv_scale ));
+    hi = _mm_add_epi16( _mm_mullo_epi16( _mm_unpackhi_epi8( s, zero ), scale ),
+                        _mm_mullo_epi16( _mm_unpackhi_epi8( d, zero ), inv_scale ));
+    _mm_storeu_si128( (__m128i *)dst, _mm_packus_epi16( div_255_round_epu16( lo ), div_255_round_epu16( hi )));
+}
+
+static void SSE2_TARGET blend_rects_8888_sse2( const dib_info *dst, int num, const RECT *rc,
+                                               const dib_info *src, const POINT *offset, BLENDFUNCTION blend )
+{
+    DWORD alpha = blend.SourceConstantAlpha, src_or = (src->compression == BI_RGB) ? 0 : 0xff000000;
+    int i, j, x, y, width;
+
+    for (i = 0; i < num; i++, rc++)
+    {
+        DWORD *src_ptr = get_pixel_ptr_32( src, rc->left + offset->x, rc->top + offset->y );
+        DWORD *dst_ptr = get_pixel_ptr_32( dst, rc->left, rc->top );
+
+        width = rc->right - rc->left;
+        for (y = rc->top; y < rc->bottom; y++, dst_ptr += dst->stride / 4, src_ptr += src->stride / 4)
+        {
+            if (blend.AlphaFormat & AC_SRC_ALPHA)
+            {
+                for (x = 0; x + 4 <= width; x += 4)
+                {
+                    if (blend_argb_sse2( dst_ptr + x, src_ptr + x, alpha )) continue;
+                    for (j = x; j < x + 4; j++)
+                        dst_ptr[j] = alpha == 255 ? blend_argb( dst_ptr[j], src_ptr[j] )
+                                                  : blend_argb_alpha( dst_ptr[j], src_ptr[j], alpha );
+                }
+                for (; x < width; x++)
+                    dst_ptr[x] = alpha == 255 ? blend_argb( dst_ptr[x], src_ptr[x] )
+                                              : blend_argb_alpha( dst_ptr[x], src_ptr[x], alpha );
+            }
+            else
+            {
+                for (x = 0; x + 4 <= width; x += 4)
+                    blend_argb_constant_alpha_sse2( dst_ptr + x, src_ptr + x, alpha, src_or );
+                for (; x < width; x++)
+                    dst_ptr[x] = blend_argb_constant_alpha( dst_ptr[x], src_ptr[x] | src_or, alpha );
+            }
+        }
+    }
+}
+
+static void SSE2_TARGET mask_rect_32_sse2( const dib_info *dst, const RECT *rc,
+                                           const dib_info *src, const POINT *origin, int rop2 )
+{
+    DWORD *dst_start = get_pixel_ptr_32( dst, rc->left, rc->top ), dst_colors[2];
+    const RGBQUAD *color_table = get_dib_color_table( src );
+    BYTE *src_start = get_pixel_ptr_1( src, origin->x, origin->y );
+    int i, x, y, pos, width = rc->right - rc->left;
+    __m128i bits_lo, bits_hi, color0, color1, a1, a2, x1, x2, val, sel;
+    struct rop_codes codes;
+
+    if (width < 16)
+    {
+        mask_rect_32( dst, rc, src, origin, rop2 );
+        return;
+    }
+
+    if (dst->funcs == &funcs_8888)
+        for (i = 0; i < 2; i++)
+            dst_colors[i] = color_table[i].rgbRed << 16 | color_table[i].rgbGreen << 8 |
+                color_table[i].rgbBlue;
+    else
+        for (i = 0; i < 2; i++)
+            dst_colors[i] = rgbquad_to_pixel_masks( dst, color_table[i] );
+
+    get_rop_codes( rop2, &codes );
+    bits_lo = _mm_setr_epi32( 0x80, 0x40, 0x20, 0x10 );
+    bits_hi = _mm_setr_epi32( 0x08, 0x04, 0x02, 0x01 );
+    color0 = _mm_set1_epi32( dst_colors[0] );
+    color1 = _mm_set1_epi32( dst_colors[1] );
+    a1 = _mm_set1_epi32( codes.a1 );
+    a2 = _mm_set1_epi32( codes.a2 );
+    x1 = _mm_set1_epi32( codes.x1 );
+    x2 = _mm_set1_epi32( codes.x2 );
+
+#define MASK_PIXELS( bits, ptr )                                                              \
+    sel = _mm_cmpeq_epi32( _mm_and_si128( val, bits ), _mm_setzero_si128() );                 \
+    sel = _mm_or_si128( _mm_and_si128( sel, color0 ), _mm_andnot_si128( sel, color1 ));       \
+    if (rop2 != R2_COPYPEN)                                                                   \
+        sel = _mm_xor_si128( _mm_and_si128( _mm_loadu_si128( (const __m128i *)(ptr) ),        \
+                                            _mm_xor_si128( _mm_and_si128( sel, a1 ), a2 )),   \
+                             _mm_xor_si128( _mm_and_si128( sel, x1 ), x2 ));                  \
+    _mm_storeu_si128( (__m128i *)(ptr), sel );
+
+    for (y = rc->top; y < rc->bottom; y++, dst_start += dst->stride / 4, src_start += src->stride)
+    {
+        pos = origin->x & 7;
+        for (x = 0; pos & 7; x++, pos++)
+            do_rop_codes_32( dst_start + x, dst_colors[(src_start[pos / 8] >> (7 - pos % 8)) & 1], &codes );
+        for (; x + 8 <= width; x += 8, pos += 8)
+        {
+            val = _mm_set1_epi32( src_start[pos / 8] );
+            MASK_PIXELS( bits_lo, dst_start + x )
+            MASK_PIXELS( bits_hi, dst_start + x + 4 )
+        }
+        for (; x < width; x++, pos++)
+            do_rop_codes_32( dst_start + x, dst_colors[(src_start[pos / 8] >> (7 - pos % 8)) & 1], &codes );
+    }
+#undef MASK_PIXELS
+}
+
+static void SSE2_TARGET draw_glyph_8888_sse2( const dib_info *dib, const RECT *rect, const dib_info *glyph,
+                                              const POINT *origin, DWORD text_pixel, const struct intensity_range *ranges )
+{
+    DWORD *dst_ptr = get_pixel_ptr_32( dib, rect->left, rect->top );
+    const BYTE *glyph_ptr = get_pixel_ptr_8( glyph, origin->x, origin->y );
+    const __m128i one = _mm_set1_epi8( 1 ), sixteen = _mm_set1_epi8( 16 ), text = _mm_set1_epi32( text_pixel );
+    __m128i val, solid, mask;
+    int i, x, y, width = rect->right - rect->left;
+
+    for (y = rect->top; y < rect->bottom; y++, dst_ptr += dib->stride / 4, glyph_ptr += glyph->stride)
+    {
+        for (x = 0; x < width; x++)
+        {
+            if (!(x & 15) && x + 16 <= width)
+            {
+                /* fast path for runs of transparent and solid pixels */
+                val = _mm_loadu_si128( (const __m128i *)(glyph_ptr + x) );
+                solid = _mm_cmpeq_epi8( _mm_max_epu8( val, sixteen ), val );
+                mask = _mm_or_si128( solid, _mm_cmpeq_epi8( _mm_subs_epu8( val, one ), _mm_setzero_si128() ));
+                if (_mm_movemask_epi8( mask ) == 0xffff)
+                {
+                    for (i = 0; i < 4; i++, solid = _mm_srli_si128( solid, 4 ))
+                    {
+                        mask = _mm_unpacklo_epi8( solid, solid );
+                        mask = _mm_unpacklo_epi16( mask, mask );
+                        val = _mm_loadu_si128( (const __m128i *)(dst_ptr + x) + i );
+                        val = _mm_or_si128( _mm_and_si128( mask, text ), _mm_andnot_si128( mask, val ));
+                        _mm_storeu_si128( (__m128i *)(dst_ptr + x) + i, val );
+                    }
+                    x += 15;
+                    continue;
+                }
+            }
+            if (glyph_ptr[x] <= 1) continue;
+            if (glyph_ptr[x] >= 16) { dst_ptr[x] = text_pixel; continue; }
+            dst_ptr[x] = aa_rgb( dst_ptr[x] >> 16, dst_ptr[x] >> 8, dst_ptr[x], text_pixel, ranges + glyph_ptr[x] );
+        }
+    }
+}
+
+static void SSE2_TARGET convert_to_8888_sse2( dib_info *dst, const dib_info *src, const RECT *src_rect, BOOL dither )
+{
+    DWORD *dst_start = get_pixel_ptr_32( dst, 0, 0 ), *dst_pixel;
+    int x, y, width = src_rect->right - src_rect->left, pad_size = (dst->width - width) * 4;
+    const __m128i mask = _mm_set1_epi32( 0xff );
+    __m128i val;
+
+    if (src->bit_count == 24)
+    {
+        BYTE *src_start = get_pixel_ptr_24( src, src_rect->left, src_rect->top ), *src_pixel;
+
+        for (y = src_rect->top; y < src_rect->bottom; y++)
+        {
+            dst_pixel = dst_start;
+            src_pixel = src_start;
+            /* each 16 byte load covers four pixels, don't read past the end of the row */
+            for (x = 0; x + 6 <= width; x += 4, src_pixel += 12, dst_pixel += 4)
+            {
+                val = _mm_loadu_si128( (const __m128i *)src_pixel );
+                val = _mm_unpacklo_epi64( _mm_unpacklo_epi32( val, _mm_srli_si128( val, 3 )),
+                                          _mm_unpacklo_epi32( _mm_srli_si128( val, 6 ), _mm_srli_si128( val, 9 )));
+                _mm_storeu_si128( (__m128i *)dst_pixel, _mm_and_si128( val, _mm_set1_epi32( 0xffffff )));
+            }
+            for (; x < width; x++, src_pixel += 3)
+                *dst_pixel++ = src_pixel[2] << 16 | src_pixel[1] << 8 | src_pixel[0];
+            if (pad_size) memset( dst_pixel, 0, pad_size );
+            dst_start += dst->stride / 4;
+            src_start += src->stride;
+        }
+    }
+    else if (src->bit_count == 32 && src->funcs != &funcs_8888 &&
+             src->red_len == 8 && src->green_len == 8 && src->blue_len == 8)
+    {
+        DWORD *src_start = get_pixel_ptr_32( src, src_rect->left, src_rect->top ), *src_pixel, src_val;
+        const __m128i red = _mm_cvtsi32_si128( src->red_shift );
+        const __m128i green = _mm_cvtsi32_si128( src->green_shift );
+        const __m128i blue = _mm_cvtsi32_si128( src->blue_shift );
+
+        for (y = src_rect->top; y < src_rect->bottom; y++)
+        {
+            dst_pixel = dst_start;
+            src_pixel = src_start;
+            for (x = 0; x + 4 <= width; x += 4, src_pixel += 4, dst_pixel += 4)
+            {
+                val = _mm_loadu_si128( (const __m128i *)src_pixel );
+                val = _mm_or_si128( _mm_or_si128( _mm_slli_epi32( _mm_and_si128( _mm_srl_epi32( val, red ), mask ), 16 ),
+                                                  _mm_slli_epi32( _mm_and_si128( _mm_srl_epi32( val, green ), mask ), 8 )),
+                                    _mm_and_si128( _mm_srl_epi32( val, blue ), mask ));
+                _mm_storeu_si128( (__m128i *)dst_pixel, val );
+            }
+            for (; x < width; x++)
+            {
+                src_val = *src_pixel++;
+                *dst_pixel++ = (((src_val >> src->red_shift)   & 0xff) << 16) |
+                               (((src_val >> src->green_shift) & 0xff) <<  8) |
+                                ((src_val >> src->blue_shift)  & 0xff);
+            }
+            if (pad_size) memset( dst_pixel, 0, pad_size );
+            dst_start += dst->stride / 4;
+            src_start += src->stride / 4;
+        }
+    }
+    else convert_to_8888( dst, src, src_rect, dither );
+}
+
+static const primitive_funcs funcs_8888_sse2 =
+{
+    solid_rects_32_sse2,
+    solid_line_32,
+    pattern_rects_32,
+    copy_rect_32_sse2,
+    blend_rects_8888_sse2,
+    gradient_rect_8888,
+    mask_rect_32_sse2,
+    draw_glyph_8888_sse2,
+    draw_subpixel_glyph_8888,
+    get_pixel_32,
+    colorref_to_pixel_888,
+    pixel_to_colorref_888,
+    convert_to_8888_sse2,
+    create_rop_masks_32,
+    create_dither_masks_null,
+    stretch_row_32,
+    shrink_row_32,
+    halftone_888
+};
+
+static const primitive_funcs funcs_8888_avx2 =
+{
+    solid_rects_32_avx2,
+    solid_line_32,
+    pattern_rects_32,
+    copy_rect_32_avx2,
+    blend_rects_8888_sse2,
+    gradient_rect_8888,
+    mask_rect_32_sse2,
+    draw_glyph_8888_sse2,
+    draw_subpixel_glyph_8888,
+    get_pixel_32,
+    colorref_to_pixel_888,
+    pixel_to_colorref_888,
+    convert_to_8888_sse2,
+    create_rop_masks_32,
+    create_dither_masks_null,
+    stretch_row_32,
+    shrink_row_32,
+    halftone_888
+};
+
+static const primitive_funcs funcs_32_sse2 =
+{
+    solid_rects_32_sse2,
+    solid_line_32,
+    pattern_rects_32,
+    copy_rect_32_sse2,
+    blend_rects_32,
+    gradient_rect_32,
+    mask_rect_32_sse2,
+    draw_glyph_32,
+    draw_subpixel_glyph_32,
+    get_pixel_32,
+    colorref_to_pixel_masks,
+    pixel_to_colorref_masks,
+    convert_to_32,
+    create_rop_masks_32,
+    create_dither_masks_null,
+    stretch_row_32,
+    shrink_row_32,
+    halftone_32
+};
+
+static const primitive_funcs funcs_32_avx2 =
+{
+    solid_rects_32_avx2,
+    solid_line_32,
+    pattern_rects_32,
+    copy_rect_32_avx2,
+    blend_rects_32,
+    gradient_rect_32,
+    mask_rect_32_sse2,
+    draw_glyph_32,
+    draw_subpixel_glyph_32,
+    get_pixel_32,
+    colorref_to_pixel_masks,
+    pixel_to_colorref_masks,
+    convert_to_32,
+    create_rop_masks_32,
+    create_dither_masks_null,
+    stretch_row_32,
+    shrink_row_32,
+    halftone_32
+};
+
+static const primitive_funcs funcs_24_sse2 =
+{
+    solid_rects_24_sse2,
+    solid_line_24,
+    pattern_rects_24,
+    copy_rect_24_sse2,
+    blend_rects_24,
+    gradient_rect_24,
+    mask_rect_24,
+    draw_glyph_24,
+    draw_subpixel_glyph_24,
+    get_pixel_24,
+    colorref_to_pixel_888,
+    pixel_to_colorref_888,
+    convert_to_24,
+    create_rop_masks_24,
+    create_dither_masks_null,
+    stretch_row_24,
+    shrink_row_24,
+    halftone_24
+};
+
+static const primitive_funcs funcs_24_avx2 =
+{
+    solid_rects_24_avx2,
+    solid_line_24,
+    pattern_rects_24,
+    copy_rect_24_avx2,
+    blend_rects_24,
+    gradient_rect_24,
+    mask_rect_24,
+    draw_glyph_24,
+    draw_subpixel_glyph_24,
+    get_pixel_24,
+    colorref_to_pixel_888,
+    pixel_to_colorref_888,
+    convert_to_24,
+    create_rop_masks_24,
+    create_dither_masks_null,
+    stretch_row_24,
+    shrink_row_24,
+    halftone_24
+};
+
+#endif /* HAVE_DIB_SIMD */
+
+primitive_funcs funcs_8888 =
 {
     solid_rects_32,
     solid_line_32,
@@ -8058,7 +8746,7 @@ const primitive_funcs funcs_8888 =
     halftone_888
 };
 
-const primitive_funcs funcs_32 =
+primitive_funcs funcs_32 =
 {
     solid_rects_32,
     solid_line_32,
@@ -8080,7 +8768,7 @@ const primitive_funcs funcs_32 =
     halftone_32
 };
 
-const primitive_funcs funcs_24 =
+primitive_funcs funcs_24 =
 {
     solid_rects_24,
     solid_line_24,
@@ -8233,3 +8921,30 @@ const primitive_funcs funcs_null =
     shrink_row_null,
     halftone_null
 };
+
+/***********************************************************************
+ *           init_dib_primitives
+ *
+ * Switch the 32 and 24 bpp primitives to their SIMD versions where available.
+ */
+void init_dib_primitives(void)
+{
+#ifdef HAVE_DIB_SIMD
+    /* AVX2 also needs the OS to save the ymm registers, which ntdll reports from xgetbv */
+    if (user_shared_data->ProcessorFeatures[PF_AVX2_INSTRUCTIONS_AVAILABLE] &&
+        (user_shared_data->XState.EnabledFeatures & (1 << XSTATE_AVX)))
+    {
+        TRACE( "using AVX2 primitives\n" );
+        funcs_8888 = funcs_8888_avx2;
+        funcs_32 = funcs_32_avx2;
+        funcs_24 = funcs_24_avx2;
+    }
+    else if (user_shared_data->ProcessorFeatures[PF_XMMI64_INSTRUCTIONS_AVAILABLE])
+    {
+        TRACE( "using SSE2 primitives\n" );
+        funcs_8888 = funcs_8888_sse2;
+        funcs_32 = funcs_32_sse2;
+        funcs_24 = funcs_24_sse2;
+    }
+#endif
+}
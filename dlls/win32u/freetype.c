@@ -38,6 +38,7 @@
 #include <dirent.h>
 #include <stdio.h>
 #include <assert.h>
+#include <pthread.h>
 #include <unistd.h>
 
 #ifdef __APPLE__
@@ -1045,24 +1046,461 @@ static void unix_face_destroy( struct unix_face *This )
     free( This );
 }
 
+/*************************************************************
+ * Persistent font index
+ *
+ * Parsing the name and OS/2 tables of every system font is a large part
+ * of the process startup time. The results are stored in a per-user index
+ * file, keyed by unix file name, size and modification time, which is
+ * mapped read-only at startup and shared by all processes. New or modified
+ * files are parsed as usual and the index is rewritten to a temporary file
+ * that atomically replaces the old one. The whole index is discarded when
+ * the Wine or FreeType version changes, as either may parse faces
+ * differently. Files that fail to parse are not recorded, so a transient
+ * failure doesn't hide a font until the file changes.
+ */
+
+#define FONT_INDEX_MAGIC   0x58494657  /* "WFIX" */
+#define FONT_INDEX_VERSION 2
+
+#define FONT_INDEX_VALID        0x01  /* face was loaded successfully */
+#define FONT_INDEX_SCALABLE     0x02
+#define FONT_INDEX_ALLOW_BITMAP 0x04  /* face was parsed with ADDFONT_ALLOW_BITMAP */
+
+struct font_index_header
+{
+    UINT magic;
+    UINT version;
+    UINT lcid;
+    UINT count;
+    UINT strings;  /* offset of the string table */
+    UINT size;     /* total size of the file */
+    UINT entry_size;
+    UINT ft_version;
+    char wine_version[32];
+};
+
+struct font_index_entry
+{
+    UINT   hash;
+    UINT   path;   /* offset of the unix file name */
+    UINT64 file_size;
+    INT64  file_mtime;
+    UINT   file_mtime_nsec;
+    UINT   face_index;
+    UINT   flags;
+    UINT   num_faces;
+    UINT   ntm_flags;
+    UINT   weight;
+    UINT   version;
+    FONTSIGNATURE fs;
+    struct bitmap_font_size size;
+    UINT   family_name;  /* string offsets, 0 if not present */
+    UINT   second_name;
+    UINT   style_name;
+    UINT   full_name;
+};
+
+struct font_index_item
+{
+    struct font_index_entry entry;
+    char  *path;
+    WCHAR *names[4];
+};
+
+static BOOL font_index_active;
+static char *font_index_file;
+static const struct font_index_header *font_index;
+static SIZE_T font_index_size;
+static BYTE *font_index_used;
+static struct font_index_item *font_index_items;
+static UINT font_index_item_count, font_index_item_size;
+static UINT font_index_hits, font_index_start;
+
+static UINT get_mtime_nsec( const struct stat *st )
+{
+#ifdef HAVE_STRUCT_STAT_ST_MTIM
+    return st->st_mtim.tv_nsec;
+#elif defined(HAVE_STRUCT_STAT_ST_MTIMESPEC)
+    return st->st_mtimespec.tv_nsec;
+#else
+    return 0;
+#endif
+}
+
+static UINT font_index_hash( const char *path )
+{
+    UINT hash = 2166136261u;
+    while (*path) hash = (hash ^ (unsigned char)*path++) * 16777619;
+    return hash;
+}
+
+static const void *font_index_string( UINT offset )
+{
+    if (!offset) return NULL;
+    return (const char *)font_index + offset;
+}
+
+static const struct font_index_entry *font_index_entries(void)
+{
+    return (const struct font_index_entry *)(font_index + 1);
+}
+
+static BOOL font_index_validate( const struct font_index_header *header, SIZE_T size )
+{
+    const struct font_index_entry *entries = (const struct font_index_entry *)(header + 1);
+    UINT i;
+
+    if (size < sizeof(*header) + sizeof(WCHAR)) return FALSE;
+    if (header->magic != FONT_INDEX_MAGIC || header->version != FONT_INDEX_VERSION) return FALSE;
+    if (header->lcid != system_lcid || header->size != size || (size & 1)) return FALSE;
+    if (header->entry_size != sizeof(*entries) || header->ft_version != FT_SimpleVersion) return FALSE;
+    if (strncmp( header->wine_version, PACKAGE_VERSION, sizeof(header->wine_version) )) return FALSE;
+    if (header->count > (size - sizeof(*header)) / sizeof(*entries)) return FALSE;
+    if (header->strings < sizeof(*header) + header->count * sizeof(*entries)) return FALSE;
+    if (header->strings >= size) return FALSE;
+    /* the string table ends with a null WCHAR, so no string can run past the end */
+    if (*(const WCHAR *)((const char *)header + size - sizeof(WCHAR))) return FALSE;
+
+    for (i = 0; i < header->count; i++)
+    {
+        const UINT *offsets = &entries[i].family_name;
+        UINT j;
+
+        if (entries[i].path < header->strings || entries[i].path >= size) return FALSE;
+        for (j = 0; j < 4; j++)
+            if (offsets[j] && (offsets[j] < header->strings || offsets[j] >= size || (offsets[j] & 1)))
+                return FALSE;
+    }
+    return TRUE;
+}
+
+static void font_index_open(void)
+{
+    const char *dir = getenv( "XDG_CACHE_HOME" ), *subdir = "/wine";
+    struct stat st;
+    void *ptr;
+    int fd;
+
+    if (!dir || dir[0] != '/')
+    {
+        if (!(dir = getenv( "HOME" ))) return;
+        subdir = "/.cache/wine";
+    }
+    if (!(font_index_file = malloc( strlen( dir ) + strlen( subdir ) + sizeof("/fontindex-0000") ))) return;
+    sprintf( font_index_file, "%s%s/fontindex-%04x", dir, subdir, LANGIDFROMLCID(system_lcid) );
+
+    font_index_active = TRUE;
+    font_index_start = NtGetTickCount();
+
+    if ((fd = open( font_index_file, O_RDONLY )) == -1) return;
+    if (!fstat( fd, &st ) && st.st_size > 0 && st.st_size < 0x7fffffff)
+    {
+        ptr = mmap( NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0 );
+        if (ptr != MAP_FAILED)
+        {
+            if (font_index_validate( ptr, st.st_size ) &&
+                (font_index_used = calloc( ((const struct font_index_header *)ptr)->count + 1, 1 )))
+            {
+                font_index = ptr;
+                font_index_size = st.st_size;
+                TRACE( "mapped %u entries from %s\n", font_index->count, debugstr_a(font_index_file) );
+            }
+            else
+            {
+                WARN( "ignoring invalid font index %s\n", debugstr_a(font_index_file) );
+                munmap( ptr, st.st_size );
+            }
+        }
+    }
+    close( fd );
+}
+
+static BOOL font_index_file_unchanged( const struct font_index_entry *entry, const struct stat *st )
+{
+    return entry->file_size == st->st_size && entry->file_mtime == st->st_mtime &&
+           entry->file_mtime_nsec == get_mtime_nsec( st );
+}
+
+static BOOL font_index_match( const struct font_index_entry *entry, const char *path, const struct stat *st,
+                              UINT face_index, UINT flags )
+{
+    return entry->face_index == face_index &&
+           !(entry->flags & FONT_INDEX_ALLOW_BITMAP) == !(flags & ADDFONT_ALLOW_BITMAP) &&
+           font_index_file_unchanged( entry, st ) && !strcmp( font_index_string( entry->path ), path );
+}
+
+static const struct font_index_entry *font_index_find( const char *path, const struct stat *st,
+                                                       UINT face_index, UINT flags )
+{
+    const struct font_index_entry *entries;
+    UINT hash, min = 0, max, pos;
+
+    if (!font_index) return NULL;
+
+    entries = font_index_entries();
+    hash = font_index_hash( path );
+    max = font_index->count;
+    while (min < max)
+    {
+        pos = (min + max) / 2;
+        if (entries[pos].hash < hash) min = pos + 1;
+        else max = pos;
+    }
+
+    for (pos = min; pos < font_index->count && entries[pos].hash == hash; pos++)
+    {
+        if (!font_index_match( &entries[pos], path, st, face_index, flags )) continue;
+        font_index_used[pos] = 1;
+        font_index_hits++;
+        return &entries[pos];
+    }
+    return NULL;
+}
+
+static struct font_index_item *font_index_add_item(void)
+{
+    struct font_index_item *items;
+    UINT size;
+
+    if (font_index_item_count == font_index_item_size)
+    {
+        size = max( 64, font_index_item_size * 2 );
+        if (!(items = realloc( font_index_items, size * sizeof(*items) ))) return NULL;
+        font_index_items = items;
+        font_index_item_size = size;
+    }
+    items = &font_index_items[font_index_item_count++];
+    memset( items, 0, sizeof(*items) );
+    return items;
+}
+
+static void font_index_add( const char *path, const struct stat *st, UINT face_index, UINT flags,
+                            const struct unix_face *face )
+{
+    struct font_index_item *item;
+
+    if (!(item = font_index_add_item())) return;
+
+    item->entry.hash = font_index_hash( path );
+    item->entry.file_size = st->st_size;
+    item->entry.file_mtime = st->st_mtime;
+    item->entry.file_mtime_nsec = get_mtime_nsec( st );
+    item->entry.face_index = face_index;
+    if (flags & ADDFONT_ALLOW_BITMAP) item->entry.flags |= FONT_INDEX_ALLOW_BITMAP;
+    item->path = strdup( path );
+    if (face)
+    {
+        item->entry.flags |= FONT_INDEX_VALID;
+        if (face->scalable) item->entry.flags |= FONT_INDEX_SCALABLE;
+        item->entry.num_faces = face->num_faces;
+        item->entry.ntm_flags = face->ntm_flags;
+        item->entry.weight = face->weight;
+        item->entry.version = face->font_version;
+        item->entry.fs = face->fs;
+        if (!face->scalable) item->entry.size = face->size;
+        if (face->family_name) item->names[0] = wcsdup( face->family_name );
+        if (face->second_name) item->names[1] = wcsdup( face->second_name );
+        if (face->style_name) item->names[2] = wcsdup( face->style_name );
+        if (face->full_name) item->names[3] = wcsdup( face->full_name );
+    }
+}
+
+/* keep the entries that were used or whose file is still unchanged */
+static void font_index_keep_entries(void)
+{
+    const struct font_index_entry *entries = font_index_entries();
+    struct font_index_item *item;
+    const WCHAR *name;
+    const char *path;
+    struct stat st;
+    UINT i, j;
+
+    for (i = 0; i < font_index->count; i++)
+    {
+        path = font_index_string( entries[i].path );
+        if (!font_index_used[i] &&
+            (stat( path, &st ) || !font_index_file_unchanged( &entries[i], &st )))
+            continue;
+        if (!(item = font_index_add_item())) return;
+        item->entry = entries[i];
+        item->path = strdup( path );
+        for (j = 0; j < 4; j++)
+            if ((name = font_index_string( (&entries[i].family_name)[j] ))) item->names[j] = wcsdup( name );
+    }
+}
+
+static int font_index_item_cmp( const void *a, const void *b )
+{
+    const struct font_index_item *item1 = a, *item2 = b;
+
+    if (item1->entry.hash != item2->entry.hash) return item1->entry.hash < item2->entry.hash ? -1 : 1;
+    return item1->entry.face_index - item2->entry.face_index;
+}
+
+static UINT font_index_put_string( BYTE *buffer, UINT pos, const void *str, UINT len )
+{
+    memcpy( buffer + pos, str, len );
+    return (pos + len + 1) & ~1;
+}
+
+static BOOL font_index_write(void)
+{
+    struct font_index_header *header;
+    struct font_index_entry *entry;
+    struct font_index_item *item;
+    BYTE *buffer;
+    char *tmp = NULL, *p;
+    UINT i, j, pos, size;
+    BOOL ret = FALSE;
+    int fd;
+
+    qsort( font_index_items, font_index_item_count, sizeof(*font_index_items), font_index_item_cmp );
+
+    size = sizeof(*header) + font_index_item_count * sizeof(*entry) + 2 * sizeof(WCHAR);
+    for (i = 0; i < font_index_item_count; i++)
+    {
+        item = &font_index_items[i];
+        size += (strlen( item->path ) + 2) & ~1;
+        for (j = 0; j < 4; j++)
+            if (item->names[j]) size += (wcslen( item->names[j] ) + 1) * sizeof(WCHAR);
+    }
+    if (!(buffer = calloc( 1, size ))) return FALSE;
+
+    header = (struct font_index_header *)buffer;
+    header->magic = FONT_INDEX_MAGIC;
+    header->version = FONT_INDEX_VERSION;
+    header->lcid = system_lcid;
+    header->count = font_index_item_count;
+    header->strings = sizeof(*header) + font_index_item_count * sizeof(*entry);
+    header->size = size;
+    header->entry_size = sizeof(*entry);
+    header->ft_version = FT_SimpleVersion;
+    snprintf( header->wine_version, sizeof(header->wine_version), "%s", PACKAGE_VERSION );
+
+    /* offset 0 is used for missing names, skip the first WCHAR of the string table */
+    pos = header->strings + sizeof(WCHAR);
+    entry = (struct font_index_entry *)(header + 1);
+    for (i = 0; i < font_index_item_count; i++, entry++)
+    {
+        item = &font_index_items[i];
+        *entry = item->entry;
+        entry->path = pos;
+        entry->family_name = entry->second_name = entry->style_name = entry->full_name = 0;
+        pos = font_index_put_string( buffer, pos, item->path, strlen( item->path ) + 1 );
+        for (j = 0; j < 4; j++)
+        {
+            if (!item->names[j]) continue;
+            (&entry->family_name)[j] = pos;
+            pos = font_index_put_string( buffer, pos, item->names[j], (wcslen( item->names[j] ) + 1) * sizeof(WCHAR) );
+        }
+    }
+    /* the buffer ends with a null WCHAR, checked in font_index_validate */
+    assert( pos + sizeof(WCHAR) == size );
+
+    /* create the cache directory if needed */
+    if (!(tmp = malloc( strlen( font_index_file ) + 32 ))) goto done;
+    strcpy( tmp, font_index_file );
+    for (p = strchr( tmp + 1, '/' ); p; p = strchr( p + 1, '/' ))
+    {
+        *p = 0;
+        mkdir( tmp, 0777 );
+        *p = '/';
+    }
+
+    sprintf( tmp, "%s.%u.tmp", font_index_file, (unsigned int)getpid() );
+    if ((fd = open( tmp, O_WRONLY | O_CREAT | O_TRUNC, 0666 )) == -1) goto done;
+    ret = write( fd, buffer, size ) == size;
+    close( fd );
+    if (ret && rename( tmp, font_index_file )) ret = FALSE;
+    if (!ret) unlink( tmp );
+
+done:
+    if (!ret) WARN( "failed to write font index %s\n", debugstr_a(font_index_file) );
+    free( tmp );
+    free( buffer );
+    return ret;
+}
+
+static void font_index_close(void)
+{
+    UINT i, j, parsed = font_index_item_count;
+
+    if (!font_index_active) return;
+    font_index_active = FALSE;
+
+    if (font_index_item_count)
+    {
+        if (font_index) font_index_keep_entries();
+        if (font_index_write())
+            TRACE( "wrote %u entries to %s\n", font_index_item_count, debugstr_a(font_index_file) );
+    }
+
+    TRACE( "loaded fonts in %u ms, %u faces from index, %u parsed\n",
+           NtGetTickCount() - font_index_start, font_index_hits, parsed );
+
+    for (i = 0; i < font_index_item_count; i++)
+    {
+        free( font_index_items[i].path );
+        for (j = 0; j < 4; j++) free( font_index_items[i].names[j] );
+    }
+    free( font_index_items );
+    font_index_items = NULL;
+    font_index_item_count = font_index_item_size = font_index_hits = 0;
+    if (font_index) munmap( (void *)font_index, font_index_size );
+    font_index = NULL;
+    free( font_index_used );
+    font_index_used = NULL;
+    free( font_index_file );
+    font_index_file = NULL;
+}
+
+static int add_indexed_face( const struct font_index_entry *entry, const WCHAR *file, DWORD face_index,
+                             DWORD flags, DWORD *num_faces )
+{
+    int ret;
+
+    if (!(entry->flags & FONT_INDEX_VALID)) return 0;
+
+    if (!HIWORD( flags )) flags |= ADDFONT_AA_FLAGS( default_aa_flags );
+
+    ret = add_gdi_face( font_index_string( entry->family_name ), font_index_string( entry->second_name ),
+                        font_index_string( entry->style_name ), font_index_string( entry->full_name ),
+                        file, NULL, 0, face_index, entry->fs, entry->ntm_flags, entry->weight,
+                        entry->version, flags, (entry->flags & FONT_INDEX_SCALABLE) ? NULL : &entry->size );
+
+    if (num_faces) *num_faces = entry->num_faces;
+    return ret;
+}
+
 static int add_unix_face( const char *unix_name, const WCHAR *file, void *data_ptr, SIZE_T data_size,
                           DWORD face_index, DWORD flags, DWORD *num_faces )
 {
+    const struct font_index_entry *entry;
     struct unix_face *unix_face;
+    struct stat st;
+    BOOL indexed;
     int ret;
 
     if (num_faces) *num_faces = 0;
 
+    indexed = font_index_active && unix_name && !data_ptr && !stat( unix_name, &st );
+    if (indexed && (entry = font_index_find( unix_name, &st, face_index, flags )))
+        return add_indexed_face( entry, file, face_index, flags, num_faces );
+
     if (!(unix_face = unix_face_create( unix_name, data_ptr, data_size, face_index, flags )))
         return 0;
 
     if (unix_face->family_name[0] == '.') /* Ignore fonts with names beginning with a dot */
     {
         TRACE("Ignoring %s since its family name begins with a dot\n", debugstr_a(unix_name));
+        if (indexed) font_index_add( unix_name, &st, face_index, flags, NULL );
         unix_face_destroy( unix_face );
         return 0;
     }
 
+    if (indexed) font_index_add( unix_name, &st, face_index, flags, unix_face );
+
     if (!HIWORD( flags )) flags |= ADDFONT_AA_FLAGS( default_aa_flags );
 
     ret = add_gdi_face( unix_face->family_name, unix_face->second_name, unix_face->style_name, unix_face->full_name,
@@ -1583,6 +2021,7 @@ static void freetype_load_fonts(void)
 #elif defined(__ANDROID__)
     ReadFontDir("/system/fonts", TRUE);
 #endif
+    font_index_close();
 }
 
 /* Some fonts have large usWinDescent values, as a result of storing signed short
@@ -3128,6 +3567,203 @@ static FT_Int get_load_flags( UINT format )
     return load_flags;
 }
 
+/*************************************************************
+ * Glyph bitmap cache
+ *
+ * Rendered glyph bitmaps are cached process-wide, keyed by font file, face,
+ * size, transformation and rendering format, so that different gdi fonts
+ * resolving to the same face don't render the same glyphs again.
+ */
+
+#define GLYPH_BITMAP_CACHE_SIZE    (4 * 1024 * 1024)
+#define GLYPH_BITMAP_CACHE_BUCKETS 1024
+
+struct glyph_bitmap_key
+{
+    dev_t    dev;
+    ino_t    ino;
+    FILETIME writetime;
+    UINT     face_index;
+    UINT     glyph;
+    UINT     format;
+    UINT     flags;
+    INT      scale_y;
+    INT      ave_width;
+    INT      ave_char_width;
+    INT      orientation;
+    INT      descent;
+    INT      max_ascent;
+    INT      max_descent;
+    FT_UShort x_ppem;
+    FT_UShort y_ppem;
+    FT_Fixed x_scale;
+    FT_Fixed y_scale;
+    FMAT2    matrix;
+};
+
+struct glyph_bitmap
+{
+    struct list             entry;
+    struct list             lru_entry;
+    struct glyph_bitmap_key key;
+    UINT                    hash;
+    GLYPHMETRICS            gm;
+    ABC                     abc;
+    DWORD                   size;
+    BYTE                    bits[1];
+};
+
+static struct list glyph_bitmap_buckets[GLYPH_BITMAP_CACHE_BUCKETS];
+static struct list glyph_bitmap_lru = LIST_INIT( glyph_bitmap_lru );
+static SIZE_T glyph_bitmap_cache_size;
+static UINT glyph_bitmap_hits, glyph_bitmap_misses;
+static pthread_mutex_t glyph_bitmap_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static BOOL is_bitmap_format( UINT format )
+{
+    switch (format & ~GGO_UNHINTED)
+    {
+    case GGO_BITMAP:
+    case GGO_GRAY2_BITMAP:
+    case GGO_GRAY4_BITMAP:
+    case GGO_GRAY8_BITMAP:
+    case WINE_GGO_GRAY16_BITMAP:
+    case WINE_GGO_HRGB_BITMAP:
+    case WINE_GGO_HBGR_BITMAP:
+    case WINE_GGO_VRGB_BITMAP:
+    case WINE_GGO_VBGR_BITMAP:
+        return TRUE;
+    }
+    return FALSE;
+}
+
+static BOOL get_glyph_bitmap_key( struct gdi_font *font, UINT glyph, UINT format, BOOL tategaki,
+                                  struct glyph_bitmap_key *key )
+{
+    struct font_private_data *data = font->private;
+    struct gdi_font *base_font = font->base_font ? font->base_font : font;
+    FT_Face ft_face = data->ft_face;
+
+    /* memory fonts may be freed and their data reused, only cache fonts mapped from files */
+    if (!data->mapping || !ft_face->size) return FALSE;
+
+    memset( key, 0, sizeof(*key) );
+    key->dev = data->mapping->dev;
+    key->ino = data->mapping->ino;
+    key->writetime = font->writetime;
+    key->face_index = font->face_index;
+    key->glyph = glyph;
+    key->format = format;
+    key->flags = tategaki | (font->fake_bold << 1) | (font->fake_italic << 2) | (font->scalable << 3);
+    key->scale_y = font->scale_y;
+    key->ave_width = font->aveWidth;
+    key->ave_char_width = font->otm.otmTextMetrics.tmAveCharWidth;
+    key->orientation = font->lf.lfOrientation;
+    key->descent = font->otm.otmDescent;
+    if (freetype_set_outline_text_metrics( base_font ) || freetype_set_bitmap_text_metrics( base_font ))
+    {
+        key->max_ascent = base_font->otm.otmTextMetrics.tmAscent;
+        key->max_descent = base_font->otm.otmTextMetrics.tmDescent;
+    }
+    key->x_ppem = ft_face->size->metrics.x_ppem;
+    key->y_ppem = ft_face->size->metrics.y_ppem;
+    key->x_scale = ft_face->size->metrics.x_scale;
+    key->y_scale = ft_face->size->metrics.y_scale;
+    key->matrix = font->matrix;
+    return TRUE;
+}
+
+static UINT hash_glyph_bitmap_key( const struct glyph_bitmap_key *key )
+{
+    const BYTE *ptr = (const BYTE *)key;
+    UINT i, hash = 2166136261u;
+
+    for (i = 0; i < sizeof(*key); i++) hash = (hash ^ ptr[i]) * 16777619;
+    return hash;
+}
+
+static BOOL get_cached_glyph_bitmap( const struct glyph_bitmap_key *key, GLYPHMETRICS *gm, ABC *abc,
+                                     DWORD buflen, void *buf, DWORD *ret )
+{
+    UINT hash = hash_glyph_bitmap_key( key );
+    struct list *bucket = &glyph_bitmap_buckets[hash % GLYPH_BITMAP_CACHE_BUCKETS];
+    struct glyph_bitmap *bitmap;
+    BOOL found = FALSE;
+
+    pthread_mutex_lock( &glyph_bitmap_lock );
+    if (bucket->next)
+    {
+        LIST_FOR_EACH_ENTRY( bitmap, bucket, struct glyph_bitmap, entry )
+        {
+            if (bitmap->hash != hash || memcmp( &bitmap->key, key, sizeof(*key) )) continue;
+
+            *gm = bitmap->gm;
+            *abc = bitmap->abc;
+            if (!buf || !buflen) *ret = bitmap->size;
+            else if (!bitmap->size || bitmap->size > buflen) *ret = GDI_ERROR;
+            else
+            {
+                memset( buf, 0, buflen );
+                memcpy( buf, bitmap->bits, bitmap->size );
+                *ret = bitmap->size;
+            }
+            list_remove( &bitmap->lru_entry );
+            list_add_head( &glyph_bitmap_lru, &bitmap->lru_entry );
+            found = TRUE;
+            break;
+        }
+    }
+    if (found) glyph_bitmap_hits++;
+    else glyph_bitmap_misses++;
+    if (!((glyph_bitmap_hits + glyph_bitmap_misses) & 0xfff))
+        TRACE( "glyph bitmap cache: %u hits, %u misses, %lu bytes\n",
+               glyph_bitmap_hits, glyph_bitmap_misses, (unsigned long)glyph_bitmap_cache_size );
+    pthread_mutex_unlock( &glyph_bitmap_lock );
+    return found;
+}
+
+static void add_cached_glyph_bitmap( const struct glyph_bitmap_key *key, const GLYPHMETRICS *gm,
+                                     const ABC *abc, const void *bits, DWORD size )
+{
+    UINT hash = hash_glyph_bitmap_key( key );
+    struct list *bucket = &glyph_bitmap_buckets[hash % GLYPH_BITMAP_CACHE_BUCKETS];
+    struct glyph_bitmap *bitmap, *old;
+
+    if (size > GLYPH_BITMAP_CACHE_SIZE / 16) return;
+    if (!(bitmap = malloc( offsetof( struct glyph_bitmap, bits[size] )))) return;
+    bitmap->key = *key;
+    bitmap->hash = hash;
+    bitmap->gm = *gm;
+    bitmap->abc = *abc;
+    bitmap->size = size;
+    memcpy( bitmap->bits, bits, size );
+
+    pthread_mutex_lock( &glyph_bitmap_lock );
+    if (!bucket->next) list_init( bucket );
+    LIST_FOR_EACH_ENTRY( old, bucket, struct glyph_bitmap, entry )
+    {
+        if (old->hash == hash && !memcmp( &old->key, key, sizeof(*key) ))
+        {
+            pthread_mutex_unlock( &glyph_bitmap_lock );
+            free( bitmap );
+            return;
+        }
+    }
+    list_add_head( bucket, &bitmap->entry );
+    list_add_head( &glyph_bitmap_lru, &bitmap->lru_entry );
+    glyph_bitmap_cache_size += offsetof( struct glyph_bitmap, bits[size] );
+
+    while (glyph_bitmap_cache_size > GLYPH_BITMAP_CACHE_SIZE)
+    {
+        old = LIST_ENTRY( list_tail( &glyph_bitmap_lru ), struct glyph_bitmap, lru_entry );
+        list_remove( &old->entry );
+        list_remove( &old->lru_entry );
+        glyph_bitmap_cache_size -= offsetof( struct glyph_bitmap, bits[old->size] );
+        free( old );
+    }
+    pthread_mutex_unlock( &glyph_bitmap_lock );
+}
+
 /*************************************************************
  * freetype_get_glyph_outline
  */
@@ -3142,10 +3778,18 @@ static UINT freetype_get_glyph_outline( struct gdi_font *font, UINT glyph, UINT
     FT_BBox bbox;
     FT_Int load_flags = get_load_flags(format);
     FT_Matrix transform_matrices[3], *matrices = NULL;
-    BOOL vertical_metrics;
+    struct glyph_bitmap_key key;
+    BOOL vertical_metrics, use_cache = FALSE;
+    DWORD ret;
 
     TRACE("%p, %04x, %08x, %p, %08x, %p, %p\n", font, glyph, format, lpgm, buflen, buf, lpmat);
 
+    if (!lpmat && is_bitmap_format( format ) && get_glyph_bitmap_key( font, glyph, format, tategaki, &key ))
+    {
+        if (get_cached_glyph_bitmap( &key, lpgm, abc, buflen, buf, &ret )) return ret;
+        use_cache = TRUE;
+    }
+
     TRACE("font transform %f %f %f %f\n",
           font->matrix.eM11, font->matrix.eM12,
           font->matrix.eM21, font->matrix.eM22);
@@ -3206,22 +3850,25 @@ static UINT freetype_get_glyph_outline( struct gdi_font *font, UINT glyph, UINT
         return 1;  /* FIXME */
 
     case GGO_BITMAP:
-        return get_mono_glyph_bitmap( ft_face->glyph, bbox, font->fake_bold,
-                                      matrices, buflen, buf );
+        ret = get_mono_glyph_bitmap( ft_face->glyph, bbox, font->fake_bold,
+                                     matrices, buflen, buf );
+        break;
 
     case GGO_GRAY2_BITMAP:
     case GGO_GRAY4_BITMAP:
     case GGO_GRAY8_BITMAP:
     case WINE_GGO_GRAY16_BITMAP:
-        return get_antialias_glyph_bitmap( ft_face->glyph, bbox, format, font->fake_bold,
-                                           matrices, buflen, buf );
+        ret = get_antialias_glyph_bitmap( ft_face->glyph, bbox, format, font->fake_bold,
+                                          matrices, buflen, buf );
+        break;
 
     case WINE_GGO_HRGB_BITMAP:
     case WINE_GGO_HBGR_BITMAP:
     case WINE_GGO_VRGB_BITMAP:
     case WINE_GGO_VBGR_BITMAP:
-        return get_subpixel_glyph_bitmap( ft_face->glyph, bbox, format, font->fake_bold,
-                                          matrices, lpgm, buflen, buf );
+        ret = get_subpixel_glyph_bitmap( ft_face->glyph, bbox, format, font->fake_bold,
+                                         matrices, lpgm, buflen, buf );
+        break;
 
     case GGO_NATIVE:
         if (ft_face->glyph->format == ft_glyph_format_outline)
@@ -3267,6 +3914,11 @@ static UINT freetype_get_glyph_outline( struct gdi_font *font, UINT glyph, UINT
         FIXME("Unsupported format %d\n", format);
 	return GDI_ERROR;
     }
+
+    /* empty glyphs are only reported by size queries */
+    if (use_cache && ret != GDI_ERROR && ((buf && buflen) || !ret))
+        add_cached_glyph_bitmap( &key, lpgm, abc, buf, ret );
+    return ret;
 }
 
 /*************************************************************
@@ -3938,6 +4590,7 @@ const struct font_backend_funcs *init_freetype_lib(void)
     init_fontconfig();
 #endif
     NtQueryDefaultLocale( FALSE, &system_lcid );
+    font_index_open();
     return &font_funcs;
 }
 
@@ -1042,6 +1042,8 @@ void gdi_init(void)
     init_gdi_shared();
     if (!gdi_shared) return;
 
+    init_dib_primitives();
+
     dpi = font_init();
     init_stock_objects( dpi );
 }
@@ -222,6 +222,9 @@ extern UINT set_dib_dc_color_table( HDC hdc, UINT startpos, UINT entries,
                                     const RGBQUAD *colors );
 extern void dibdrv_set_window_surface( DC *dc, struct window_surface *surface );
 
+/* dibdrv/primitives.c */
+extern void init_dib_primitives(void);
+
 /* driver.c */
 extern const struct gdi_dc_funcs null_driver;
 extern const struct gdi_dc_funcs dib_driver;
@@ -19,6 +19,9 @@
 
 #include <stdarg.h>
 #include <math.h>
+#if (defined(__x86_64__) || defined(_M_X64)) && !defined(__arm64ec__)
+#include <emmintrin.h>
+#endif
 
 #define COBJMACROS
 
@@ -96,22 +99,35 @@ typedef struct FormatConverter {
     CRITICAL_SECTION lock; /* must be held when initialized */
 } FormatConverter;
 
+static inline float uint_as_float(UINT bits)
+{
+    float f;
+    memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+static inline UINT float_as_uint(float f)
+{
+    UINT bits;
+    memcpy(&bits, &f, sizeof(bits));
+    return bits;
+}
+
 static float float_16_to_32(unsigned short in)
 {
-    const unsigned short s = (in & 0x8000);
-    const unsigned short e = (in & 0x7C00) >> 10;
-    const unsigned short m = in & 0x3FF;
-    const float sgn = (s ? -1.0f : 1.0f);
+    const UINT s = (in & 0x8000) << 16;
+    const UINT e = (in & 0x7C00) >> 10;
+    const UINT m = in & 0x3FF;
+    float f;
 
+    /* Denormals are m * 2^-24; everything else, including the all-ones
+     * exponent, is rebiased and mapped onto the matching float. */
     if (e == 0)
     {
-        if (m == 0) return sgn * 0.0f; /* +0.0 or -0.0 */
-        else return sgn * powf(2, -14.0f) * (m / 1024.0f);
-    }
-    else
-    {
-        return sgn * powf(2, e - 15.0f) * (1.0f + (m / 1024.0f));
+        f = m * (1.0f / 16777216.0f);
+        return s ? -f : f;
     }
+    return uint_as_float(s | (e + 112) << 23 | m << 13);
 }
 
 /* https://www.w3.org/Graphics/Color/srgb */
@@ -127,6 +143,267 @@ static inline float from_sRGB_component(float f)
     return powf((f + 0.055f) / 1.055f, 2.4f);
 }
 
+/* Lookup tables for the float <-> 8-bit sRGB conversions. The float -> byte
+ * direction stores, for every output value, the smallest linear input that
+ * rounds to it, so that a binary search gives exactly the same result as
+ * floorf(to_sRGB_component(f) * 255.0f + 0.51f) for 0.0 <= f <= 1.0. */
+static float sRGB_byte_thresholds[256];
+static float sRGB_byte_to_linear[256];
+static BYTE half_to_sRGB_byte[65536];
+
+static INIT_ONCE sRGB_tables_once = INIT_ONCE_STATIC_INIT;
+static INIT_ONCE half_table_once = INIT_ONCE_STATIC_INIT;
+
+static inline BYTE float_to_sRGB_byte_slow(float f)
+{
+    return (BYTE)floorf(to_sRGB_component(f) * 255.0f + 0.51f);
+}
+
+static BOOL WINAPI init_sRGB_tables(INIT_ONCE *once, void *param, void **context)
+{
+    UINT i, low, high, mid;
+
+    for (i = 0; i < 256; i++)
+        sRGB_byte_to_linear[i] = from_sRGB_component(i / 255.0f);
+
+    /* The conversion is monotonic in f, and so is the bit pattern of
+     * non-negative floats, so bisect on the bits. */
+    sRGB_byte_thresholds[0] = 0.0f;
+    for (i = 1; i < 256; i++)
+    {
+        low = float_as_uint(sRGB_byte_thresholds[i - 1]);
+        high = float_as_uint(1.0f);
+        while (low < high)
+        {
+            mid = low + (high - low) / 2;
+            if (float_to_sRGB_byte_slow(uint_as_float(mid)) >= i) high = mid;
+            else low = mid + 1;
+        }
+        sRGB_byte_thresholds[i] = uint_as_float(low);
+    }
+
+    return TRUE;
+}
+
+static inline BYTE float_to_sRGB_byte(float f)
+{
+    UINT idx = 0;
+
+    if (!(f >= 0.0f && f <= 1.0f))
+        return float_to_sRGB_byte_slow(f);
+
+    if (sRGB_byte_thresholds[idx + 128] <= f) idx += 128;
+    if (sRGB_byte_thresholds[idx + 64] <= f) idx += 64;
+    if (sRGB_byte_thresholds[idx + 32] <= f) idx += 32;
+    if (sRGB_byte_thresholds[idx + 16] <= f) idx += 16;
+    if (sRGB_byte_thresholds[idx + 8] <= f) idx += 8;
+    if (sRGB_byte_thresholds[idx + 4] <= f) idx += 4;
+    if (sRGB_byte_thresholds[idx + 2] <= f) idx += 2;
+    if (sRGB_byte_thresholds[idx + 1] <= f) idx += 1;
+    return idx;
+}
+
+static BOOL WINAPI init_half_table(INIT_ONCE *once, void *param, void **context)
+{
+    UINT i;
+
+    InitOnceExecuteOnce(&sRGB_tables_once, init_sRGB_tables, NULL, NULL);
+    for (i = 0; i < 65536; i++)
+        half_to_sRGB_byte[i] = float_to_sRGB_byte(float_16_to_32(i));
+
+    return TRUE;
+}
+
+static inline DWORD swap_red_blue(DWORD p)
+{
+    return (p & 0xff00ff00) | (p & 0xff) << 16 | (p >> 16 & 0xff);
+}
+
+/* Expands a row of 24bpp pixels to 32bpp with opaque alpha. src may be
+ * equal to dst, so the row is processed from the end, four pixels (three
+ * source DWORDs) at a time. */
+static void expand_row_24bpp_to_32bpp(BYTE *dst, const BYTE *src, UINT width, BOOL swap)
+{
+    DWORD a, b, c, p[4];
+    UINT x = width;
+
+    while (x % 4)
+    {
+        x--;
+        p[0] = 0xff000000 | src[3 * x] | src[3 * x + 1] << 8 | src[3 * x + 2] << 16;
+        if (swap) p[0] = swap_red_blue(p[0]);
+        memcpy(dst + 4 * x, p, 4);
+    }
+
+    while (x)
+    {
+        x -= 4;
+        memcpy(&a, src + 3 * x, 4);
+        memcpy(&b, src + 3 * x + 4, 4);
+        memcpy(&c, src + 3 * x + 8, 4);
+        p[0] = 0xff000000 | a;
+        p[1] = 0xff000000 | a >> 24 | b << 8;
+        p[2] = 0xff000000 | b >> 16 | c << 16;
+        p[3] = 0xff000000 | c >> 8;
+        if (swap)
+        {
+            p[0] = swap_red_blue(p[0]);
+            p[1] = swap_red_blue(p[1]);
+            p[2] = swap_red_blue(p[2]);
+            p[3] = swap_red_blue(p[3]);
+        }
+        memcpy(dst + 4 * x, p, 16);
+    }
+}
+
+/* Packs a row of 32bpp pixels to 24bpp, dropping alpha. */
+static void pack_row_32bpp_to_24bpp(BYTE *dst, const BYTE *src, UINT width, BOOL swap)
+{
+    DWORD p[4], packed[3];
+    UINT x;
+
+    for (x = 0; x + 4 <= width; x += 4)
+    {
+        memcpy(p, src + 4 * x, 16);
+        if (swap)
+        {
+            p[0] = swap_red_blue(p[0]);
+            p[1] = swap_red_blue(p[1]);
+            p[2] = swap_red_blue(p[2]);
+            p[3] = swap_red_blue(p[3]);
+        }
+        packed[0] = (p[0] & 0xffffff) | p[1] << 24;
+        packed[1] = (p[1] >> 8 & 0xffff) | p[2] << 16;
+        packed[2] = (p[2] >> 16 & 0xff) | p[3] << 8;
+        memcpy(dst + 3 * x, packed, 12);
+    }
+
+    for (; x < width; x++)
+    {
+        memcpy(p, src + 4 * x, 4);
+        if (swap) p[0] = swap_red_blue(p[0]);
+        dst[3 * x] = p[0];
+        dst[3 * x + 1] = p[0] >> 8;
+        dst[3 * x + 2] = p[0] >> 16;
+    }
+}
+
+static void set_row_alpha_opaque(BYTE *row, UINT width)
+{
+    DWORD *pixel = (DWORD *)row;
+    UINT x;
+
+    for (x = 0; x < width; x++)
+        pixel[x] |= 0xff000000;
+}
+
+/* Computes (c * alpha + 127) / 255 for the three color channels at once,
+ * red and blue sharing one multiply. */
+static inline DWORD premultiply_pixel(DWORD p)
+{
+    DWORD alpha = p >> 24, rb, g;
+
+    rb = (p & 0x00ff00ff) * alpha + 0x00800080;
+    rb = ((rb + (rb >> 8 & 0x00ff00ff)) >> 8) & 0x00ff00ff;
+    g = (p >> 8 & 0xff) * alpha + 0x80;
+    g = (g + (g >> 8)) >> 8 & 0xff;
+    return (p & 0xff000000) | rb | g << 8;
+}
+
+static void premultiply_row(BYTE *row, UINT width)
+{
+    DWORD *pixel = (DWORD *)row;
+    UINT x = 0;
+
+#if (defined(__x86_64__) || defined(_M_X64)) && !defined(__arm64ec__)
+    /* Same computation on four pixels at a time, one channel per 16-bit lane.
+     * The products fit in 16 bits, and alpha is restored from the source. */
+    const __m128i alpha_mask = _mm_set1_epi32(0xff000000), round = _mm_set1_epi16(0x80);
+    const __m128i zero = _mm_setzero_si128();
+    __m128i p, lo, hi;
+
+    for (; x + 4 <= width; x += 4)
+    {
+        p = _mm_loadu_si128((const __m128i *)(pixel + x));
+        lo = _mm_unpacklo_epi8(p, zero);
+        hi = _mm_unpackhi_epi8(p, zero);
+        lo = _mm_mullo_epi16(lo, _mm_shufflehi_epi16(_mm_shufflelo_epi16(lo, 0xff), 0xff));
+        hi = _mm_mullo_epi16(hi, _mm_shufflehi_epi16(_mm_shufflelo_epi16(hi, 0xff), 0xff));
+        lo = _mm_add_epi16(lo, round);
+        hi = _mm_add_epi16(hi, round);
+        lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+        hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+        lo = _mm_packus_epi16(lo, hi);
+        p = _mm_or_si128(_mm_and_si128(p, alpha_mask), _mm_andnot_si128(alpha_mask, lo));
+        _mm_storeu_si128((__m128i *)(pixel + x), p);
+    }
+#endif
+
+    for (; x < width; x++)
+    {
+        if ((pixel[x] >> 24) != 255)
+            pixel[x] = premultiply_pixel(pixel[x]);
+    }
+}
+
+/* 65536 * 255 / alpha rounded up, which makes (c * table[alpha]) >> 16 equal
+ * to c * 255 / alpha for all byte values. */
+static const DWORD unpremultiply_table[256] =
+{
+    0x000000, 0xff0000, 0x7f8000, 0x550000, 0x3fc000, 0x330000, 0x2a8000, 0x246db7,
+    0x1fe000, 0x1c5556, 0x198000, 0x172e8c, 0x154000, 0x139d8a, 0x1236dc, 0x110000,
+    0x0ff000, 0x0f0000, 0x0e2aab, 0x0d6bcb, 0x0cc000, 0x0c2493, 0x0b9746, 0x0b1643,
+    0x0aa000, 0x0a3334, 0x09cec5, 0x0971c8, 0x091b6e, 0x08cb09, 0x088000, 0x0839cf,
+    0x07f800, 0x07ba2f, 0x078000, 0x074925, 0x071556, 0x06e454, 0x06b5e6, 0x0689d9,
+    0x066000, 0x063832, 0x06124a, 0x05ee24, 0x05cba3, 0x05aaab, 0x058b22, 0x056cf0,
+    0x055000, 0x05343f, 0x05199a, 0x050000, 0x04e763, 0x04cfb3, 0x04b8e4, 0x04a2e9,
+    0x048db7, 0x047944, 0x046585, 0x045271, 0x044000, 0x042e2a, 0x041ce8, 0x040c31,
+    0x03fc00, 0x03ec4f, 0x03dd18, 0x03ce55, 0x03c000, 0x03b217, 0x03a493, 0x039770,
+    0x038aab, 0x037e40, 0x03722a, 0x036667, 0x035af3, 0x034fcb, 0x0344ed, 0x033a55,
+    0x033000, 0x0325ee, 0x031c19, 0x031282, 0x030925, 0x030000, 0x02f712, 0x02ee59,
+    0x02e5d2, 0x02dd7c, 0x02d556, 0x02cd5d, 0x02c591, 0x02bdf0, 0x02b678, 0x02af29,
+    0x02a800, 0x02a0fe, 0x029a20, 0x029365, 0x028ccd, 0x028657, 0x028000, 0x0279ca,
+    0x0273b2, 0x026db7, 0x0267da, 0x026218, 0x025c72, 0x0256e7, 0x025175, 0x024c1c,
+    0x0246dc, 0x0241b3, 0x023ca2, 0x0237a7, 0x0232c3, 0x022df3, 0x022939, 0x022493,
+    0x022000, 0x021b82, 0x021715, 0x0212bc, 0x020e74, 0x020a3e, 0x020619, 0x020205,
+    0x01fe00, 0x01fa0c, 0x01f628, 0x01f253, 0x01ee8c, 0x01ead4, 0x01e72b, 0x01e38f,
+    0x01e000, 0x01dc80, 0x01d90c, 0x01d5a4, 0x01d24a, 0x01cefb, 0x01cbb8, 0x01c881,
+    0x01c556, 0x01c235, 0x01bf20, 0x01bc15, 0x01b915, 0x01b61f, 0x01b334, 0x01b052,
+    0x01ad7a, 0x01aaab, 0x01a7e6, 0x01a52a, 0x01a277, 0x019fcc, 0x019d2b, 0x019a91,
+    0x019800, 0x019578, 0x0192f7, 0x01907e, 0x018e0d, 0x018ba3, 0x018941, 0x0186e6,
+    0x018493, 0x018246, 0x018000, 0x017dc2, 0x017b89, 0x017958, 0x01772d, 0x017508,
+    0x0172e9, 0x0170d1, 0x016ebe, 0x016cb2, 0x016aab, 0x0168aa, 0x0166af, 0x0164b9,
+    0x0162c9, 0x0160de, 0x015ef8, 0x015d18, 0x015b3c, 0x015966, 0x015795, 0x0155c8,
+    0x015400, 0x01523e, 0x01507f, 0x014ec5, 0x014d10, 0x014b5f, 0x0149b3, 0x01480b,
+    0x014667, 0x0144c7, 0x01432c, 0x014194, 0x014000, 0x013e71, 0x013ce5, 0x013b5d,
+    0x0139d9, 0x013859, 0x0136dc, 0x013563, 0x0133ed, 0x01327b, 0x01310c, 0x012fa1,
+    0x012e39, 0x012cd5, 0x012b74, 0x012a16, 0x0128bb, 0x012763, 0x01260e, 0x0124bd,
+    0x01236e, 0x012223, 0x0120da, 0x011f94, 0x011e51, 0x011d11, 0x011bd4, 0x011a99,
+    0x011962, 0x01182c, 0x0116fa, 0x0115ca, 0x01149d, 0x011372, 0x01124a, 0x011124,
+    0x011000, 0x010ee0, 0x010dc1, 0x010ca5, 0x010b8b, 0x010a73, 0x01095e, 0x01084b,
+    0x01073a, 0x01062c, 0x01051f, 0x010415, 0x01030d, 0x010207, 0x010103, 0x010000,
+};
+
+static void unpremultiply_row(BYTE *row, UINT width)
+{
+    DWORD *pixel = (DWORD *)row;
+    DWORD p, alpha, scale;
+    UINT x;
+
+    for (x = 0; x < width; x++)
+    {
+        p = pixel[x];
+        alpha = p >> 24;
+        if (alpha == 0 || alpha == 255) continue;
+
+        scale = unpremultiply_table[alpha];
+        pixel[x] = (p & 0xff000000)
+                 | (((p >> 16 & 0xff) * scale >> 16) & 0xff) << 16
+                 | (((p >> 8 & 0xff) * scale >> 16) & 0xff) << 8
+                 | (((p & 0xff) * scale >> 16) & 0xff);
+    }
+}
+
 #if 0 /* FIXME: enable once needed */
 
 static void from_sRGB(BYTE *bgr)
@@ -648,109 +925,36 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
         }
         return S_OK;
     case format_24bppBGR:
-        if (prc)
-        {
-            HRESULT res;
-            INT x, y;
-            BYTE *srcdata;
-            UINT srcstride, srcdatasize;
-            const BYTE *srcrow;
-            const BYTE *srcpixel;
-            BYTE *dstrow;
-            BYTE *dstpixel;
-
-            srcstride = 3 * prc->Width;
-            srcdatasize = srcstride * prc->Height;
-
-            srcdata = malloc(srcdatasize);
-            if (!srcdata) return E_OUTOFMEMORY;
-
-            res = IWICBitmapSource_CopyPixels(This->source, prc, srcstride, srcdatasize, srcdata);
-
-            if (SUCCEEDED(res))
-            {
-                srcrow = srcdata;
-                dstrow = pbBuffer;
-                for (y=0; y<prc->Height; y++) {
-                    srcpixel=srcrow;
-                    dstpixel=dstrow;
-                    for (x=0; x<prc->Width; x++) {
-                        *dstpixel++=*srcpixel++; /* blue */
-                        *dstpixel++=*srcpixel++; /* green */
-                        *dstpixel++=*srcpixel++; /* red */
-                        *dstpixel++=255; /* alpha */
-                    }
-                    srcrow += srcstride;
-                    dstrow += cbStride;
-                }
-            }
-
-            free(srcdata);
-
-            return res;
-        }
-        return S_OK;
     case format_24bppRGB:
         if (prc)
         {
             HRESULT res;
-            INT x, y;
-            BYTE *srcdata;
-            UINT srcstride, srcdatasize;
-            const BYTE *srcrow;
-            const BYTE *srcpixel;
-            BYTE *dstrow;
-            BYTE *dstpixel;
-            BYTE tmppixel[3];
-
-            srcstride = 3 * prc->Width;
-            srcdatasize = srcstride * prc->Height;
-
-            srcdata = malloc(srcdatasize);
-            if (!srcdata) return E_OUTOFMEMORY;
+            INT y;
 
-            res = IWICBitmapSource_CopyPixels(This->source, prc, srcstride, srcdatasize, srcdata);
+            /* Let the source fill the start of each destination row and
+             * expand the pixels in place, which avoids an intermediate copy. */
+            res = IWICBitmapSource_CopyPixels(This->source, prc, cbStride, cbBufferSize, pbBuffer);
+            if (FAILED(res)) return res;
 
-            if (SUCCEEDED(res))
+            for (y = 0; y < prc->Height; y++)
             {
-                srcrow = srcdata;
-                dstrow = pbBuffer;
-                for (y=0; y<prc->Height; y++) {
-                    srcpixel=srcrow;
-                    dstpixel=dstrow;
-                    for (x=0; x<prc->Width; x++) {
-                        tmppixel[0]=*srcpixel++; /* red */
-                        tmppixel[1]=*srcpixel++; /* green */
-                        tmppixel[2]=*srcpixel++; /* blue */
-
-                        *dstpixel++=tmppixel[2]; /* blue */
-                        *dstpixel++=tmppixel[1]; /* green */
-                        *dstpixel++=tmppixel[0]; /* red */
-                        *dstpixel++=255; /* alpha */
-                    }
-                    srcrow += srcstride;
-                    dstrow += cbStride;
-                }
+                BYTE *row = pbBuffer + cbStride * y;
+                expand_row_24bpp_to_32bpp(row, row, prc->Width, source_format == format_24bppRGB);
             }
-
-            free(srcdata);
-
-            return res;
         }
         return S_OK;
     case format_32bppBGR:
         if (prc)
         {
             HRESULT res;
-            INT x, y;
+            INT y;
 
             res = IWICBitmapSource_CopyPixels(This->source, prc, cbStride, cbBufferSize, pbBuffer);
             if (FAILED(res)) return res;
 
             /* set all alpha values to 255 */
             for (y=0; y<prc->Height; y++)
-                for (x=0; x<prc->Width; x++)
-                    pbBuffer[cbStride*y+4*x+3] = 0xff;
+                set_row_alpha_opaque(pbBuffer + cbStride * y, prc->Width);
         }
         return S_OK;
     case format_32bppRGBA:
@@ -770,22 +974,13 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
         if (prc)
         {
             HRESULT res;
-            INT x, y;
+            INT y;
 
             res = IWICBitmapSource_CopyPixels(This->source, prc, cbStride, cbBufferSize, pbBuffer);
             if (FAILED(res)) return res;
 
             for (y=0; y<prc->Height; y++)
-                for (x=0; x<prc->Width; x++)
-                {
-                    BYTE alpha = pbBuffer[cbStride*y+4*x+3];
-                    if (alpha != 0 && alpha != 255)
-                    {
-                        pbBuffer[cbStride*y+4*x] = pbBuffer[cbStride*y+4*x] * 255 / alpha;
-                        pbBuffer[cbStride*y+4*x+1] = pbBuffer[cbStride*y+4*x+1] * 255 / alpha;
-                        pbBuffer[cbStride*y+4*x+2] = pbBuffer[cbStride*y+4*x+2] * 255 / alpha;
-                    }
-                }
+                unpremultiply_row(pbBuffer + cbStride * y, prc->Width);
         }
         return S_OK;
     case format_48bppRGB:
@@ -930,9 +1125,9 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
                     {
                         BYTE red, green, blue;
 
-                        red   = (BYTE)floorf(to_sRGB_component(*srcpixel++) * 255.0f + 0.51f);
-                        green = (BYTE)floorf(to_sRGB_component(*srcpixel++) * 255.0f + 0.51f);
-                        blue  = (BYTE)floorf(to_sRGB_component(*srcpixel++) * 255.0f + 0.51f);
+                        red   = float_to_sRGB_byte(*srcpixel++);
+                        green = float_to_sRGB_byte(*srcpixel++);
+                        blue  = float_to_sRGB_byte(*srcpixel++);
 
                         *dstpixel++ = 0xff000000 | red << 16 | green << 8 | blue;
                     }
@@ -978,9 +1173,9 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
                     {
                         BYTE red, green, blue, alpha;
 
-                        red   = (BYTE)floorf(to_sRGB_component(*srcpixel++) * 255.0f + 0.51f);
-                        green = (BYTE)floorf(to_sRGB_component(*srcpixel++) * 255.0f + 0.51f);
-                        blue  = (BYTE)floorf(to_sRGB_component(*srcpixel++) * 255.0f + 0.51f);
+                        red   = float_to_sRGB_byte(*srcpixel++);
+                        green = float_to_sRGB_byte(*srcpixel++);
+                        blue  = float_to_sRGB_byte(*srcpixel++);
                         alpha = (BYTE)floorf(*srcpixel++ * 255.0f + 0.51f);
 
                         *dstpixel++ = alpha << 24 | red << 16 | green << 8 | blue;
@@ -1025,7 +1220,7 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
                     dstpixel = (DWORD *)dstrow;
                     for (x = 0; x < prc->Width; x++)
                     {
-                        BYTE comp = (BYTE)floorf(to_sRGB_component(float_16_to_32(*srcpixel++)) * 255.0f + 0.51f);
+                        BYTE comp = half_to_sRGB_byte[*srcpixel++];
                         *dstpixel++ = 0xff000000 | comp << 16 | comp << 8 | comp;
                     }
                     srcrow += srcstride;
@@ -1070,9 +1265,9 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
                     {
                         BYTE red, green, blue;
 
-                        red   = (BYTE)floorf(to_sRGB_component(float_16_to_32(*srcpixel++)) * 255.0f + 0.51f);
-                        green = (BYTE)floorf(to_sRGB_component(float_16_to_32(*srcpixel++)) * 255.0f + 0.51f);
-                        blue  = (BYTE)floorf(to_sRGB_component(float_16_to_32(*srcpixel++)) * 255.0f + 0.51f);
+                        red   = half_to_sRGB_byte[*srcpixel++];
+                        green = half_to_sRGB_byte[*srcpixel++];
+                        blue  = half_to_sRGB_byte[*srcpixel++];
 
                         *dstpixel++ = 0xff000000 | red << 16 | green << 8 | blue;
                     }
@@ -1102,15 +1297,14 @@ static HRESULT copypixels_to_32bppRGBA(struct FormatConverter *This, const WICRe
     case format_32bppRGB:
         if (prc)
         {
-            INT x, y;
+            INT y;
 
             hr = IWICBitmapSource_CopyPixels(This->source, prc, cbStride, cbBufferSize, pbBuffer);
             if (FAILED(hr)) return hr;
 
             /* set all alpha values to 255 */
             for (y=0; y<prc->Height; y++)
-                for (x=0; x<prc->Width; x++)
-                    pbBuffer[cbStride*y+4*x+3] = 0xff;
+                set_row_alpha_opaque(pbBuffer + cbStride * y, prc->Width);
         }
         return S_OK;
 
@@ -1122,22 +1316,13 @@ static HRESULT copypixels_to_32bppRGBA(struct FormatConverter *This, const WICRe
     case format_32bppPRGBA:
         if (prc)
         {
-            INT x, y;
+            INT y;
 
             hr = IWICBitmapSource_CopyPixels(This->source, prc, cbStride, cbBufferSize, pbBuffer);
             if (FAILED(hr)) return hr;
 
             for (y=0; y<prc->Height; y++)
-                for (x=0; x<prc->Width; x++)
-                {
-                    BYTE alpha = pbBuffer[cbStride*y+4*x+3];
-                    if (alpha != 0 && alpha != 255)
-                    {
-                        pbBuffer[cbStride*y+4*x] = pbBuffer[cbStride*y+4*x] * 255 / alpha;
-                        pbBuffer[cbStride*y+4*x+1] = pbBuffer[cbStride*y+4*x+1] * 255 / alpha;
-                        pbBuffer[cbStride*y+4*x+2] = pbBuffer[cbStride*y+4*x+2] * 255 / alpha;
-                    }
-                }
+                unpremultiply_row(pbBuffer + cbStride * y, prc->Width);
         }
         return S_OK;
 
@@ -1196,19 +1381,10 @@ static HRESULT copypixels_to_32bppPBGRA(struct FormatConverter *This, const WICR
         hr = copypixels_to_32bppBGRA(This, prc, cbStride, cbBufferSize, pbBuffer, source_format);
         if (SUCCEEDED(hr) && prc)
         {
-            INT x, y;
+            INT y;
 
             for (y=0; y<prc->Height; y++)
-                for (x=0; x<prc->Width; x++)
-                {
-                    BYTE alpha = pbBuffer[cbStride*y+4*x+3];
-                    if (alpha != 255)
-                    {
-                        pbBuffer[cbStride*y+4*x] = (pbBuffer[cbStride*y+4*x] * alpha + 127) / 255;
-                        pbBuffer[cbStride*y+4*x+1] = (pbBuffer[cbStride*y+4*x+1] * alpha + 127) / 255;
-                        pbBuffer[cbStride*y+4*x+2] = (pbBuffer[cbStride*y+4*x+2] * alpha + 127) / 255;
-                    }
-                }
+                premultiply_row(pbBuffer + cbStride * y, prc->Width);
         }
         return hr;
     }
@@ -1229,19 +1405,10 @@ static HRESULT copypixels_to_32bppPRGBA(struct FormatConverter *This, const WICR
         hr = copypixels_to_32bppRGBA(This, prc, cbStride, cbBufferSize, pbBuffer, source_format);
         if (SUCCEEDED(hr) && prc)
         {
-            INT x, y;
+            INT y;
 
             for (y=0; y<prc->Height; y++)
-                for (x=0; x<prc->Width; x++)
-                {
-                    BYTE alpha = pbBuffer[cbStride*y+4*x+3];
-                    if (alpha != 255)
-                    {
-                        pbBuffer[cbStride*y+4*x] = (pbBuffer[cbStride*y+4*x] * alpha + 127) / 255;
-                        pbBuffer[cbStride*y+4*x+1] = (pbBuffer[cbStride*y+4*x+1] * alpha + 127) / 255;
-                        pbBuffer[cbStride*y+4*x+2] = (pbBuffer[cbStride*y+4*x+2] * alpha + 127) / 255;
-                    }
-                }
+                premultiply_row(pbBuffer + cbStride * y, prc->Width);
         }
         return hr;
     }
@@ -1258,6 +1425,32 @@ static void set_24bppbgr_pixel(BYTE **dstpixel, WICColor color)
     *dstpixel += 3;
 }
 
+static HRESULT copy_32bpp_rows_to_24bpp(struct FormatConverter *This, const WICRect *prc,
+    UINT cbStride, UINT cbBufferSize, BYTE *pbBuffer, BOOL swap)
+{
+    UINT srcstride = 4 * prc->Width, srcdatasize;
+    BYTE *srcdata;
+    HRESULT res;
+    INT y;
+
+    srcdatasize = srcstride * prc->Height;
+
+    srcdata = malloc(srcdatasize);
+    if (!srcdata) return E_OUTOFMEMORY;
+
+    res = IWICBitmapSource_CopyPixels(This->source, prc, srcstride, srcdatasize, srcdata);
+
+    if (SUCCEEDED(res))
+    {
+        for (y = 0; y < prc->Height; y++)
+            pack_row_32bpp_to_24bpp(pbBuffer + cbStride * y, srcdata + srcstride * y, prc->Width, swap);
+    }
+
+    free(srcdata);
+
+    return res;
+}
+
 static HRESULT copypixels_to_24bppBGR(struct FormatConverter *This, const WICRect *prc,
     UINT cbStride, UINT cbBufferSize, BYTE *pbBuffer, enum pixelformat source_format)
 {
@@ -1329,67 +1522,8 @@ static HRESULT copypixels_to_24bppBGR(struct FormatConverter *This, const WICRec
     case format_32bppPBGRA:
     case format_32bppRGBA:
         if (prc)
-        {
-            HRESULT res;
-            INT x, y;
-            BYTE *srcdata;
-            UINT srcstride, srcdatasize;
-            const BYTE *srcrow;
-            const BYTE *srcpixel;
-            BYTE *dstrow;
-            BYTE *dstpixel;
-
-            srcstride = 4 * prc->Width;
-            srcdatasize = srcstride * prc->Height;
-
-            srcdata = malloc(srcdatasize);
-            if (!srcdata) return E_OUTOFMEMORY;
-
-            res = IWICBitmapSource_CopyPixels(This->source, prc, srcstride, srcdatasize, srcdata);
-
-            if (SUCCEEDED(res))
-            {
-                srcrow = srcdata;
-                dstrow = pbBuffer;
-
-                if (source_format == format_32bppRGBA)
-                {
-                    for (y = 0; y < prc->Height; y++)
-                    {
-                        srcpixel = srcrow;
-                        dstpixel = dstrow;
-                        for (x = 0; x < prc->Width; x++) {
-                            *dstpixel++ = srcpixel[2]; /* blue */
-                            *dstpixel++ = srcpixel[1]; /* green */
-                            *dstpixel++ = srcpixel[0]; /* red */
-                            srcpixel += 4;
-                        }
-                        srcrow += srcstride;
-                        dstrow += cbStride;
-                    }
-                }
-                else
-                {
-                    for (y = 0; y < prc->Height; y++)
-                    {
-                        srcpixel = srcrow;
-                        dstpixel = dstrow;
-                        for (x = 0; x < prc->Width; x++) {
-                            *dstpixel++ = *srcpixel++; /* blue */
-                            *dstpixel++ = *srcpixel++; /* green */
-                            *dstpixel++ = *srcpixel++; /* red */
-                            srcpixel++; /* alpha */
-                        }
-                        srcrow += srcstride;
-                        dstrow += cbStride;
-                    }
-                }
-            }
-
-            free(srcdata);
-
-            return res;
-        }
+            return copy_32bpp_rows_to_24bpp(This, prc, cbStride, cbBufferSize, pbBuffer,
+                                            source_format == format_32bppRGBA);
         return S_OK;
 
     case format_32bppGrayFloat:
@@ -1418,7 +1552,7 @@ static HRESULT copypixels_to_24bppBGR(struct FormatConverter *This, const WICRec
 
                     for (x = 0; x < prc->Width; x++)
                     {
-                        BYTE gray = (BYTE)floorf(to_sRGB_component(gray_float[x]) * 255.0f + 0.51f);
+                        BYTE gray = float_to_sRGB_byte(gray_float[x]);
                         *bgr++ = gray;
                         *bgr++ = gray;
                         *bgr++ = gray;
@@ -1503,51 +1637,7 @@ static HRESULT copypixels_to_24bppRGB(struct FormatConverter *This, const WICRec
     case format_32bppBGRA:
     case format_32bppPBGRA:
         if (prc)
-        {
-            HRESULT res;
-            INT x, y;
-            BYTE *srcdata;
-            UINT srcstride, srcdatasize;
-            const BYTE *srcrow;
-            const BYTE *srcpixel;
-            BYTE *dstrow;
-            BYTE *dstpixel;
-            BYTE tmppixel[3];
-
-            srcstride = 4 * prc->Width;
-            srcdatasize = srcstride * prc->Height;
-
-            srcdata = malloc(srcdatasize);
-            if (!srcdata) return E_OUTOFMEMORY;
-
-            res = IWICBitmapSource_CopyPixels(This->source, prc, srcstride, srcdatasize, srcdata);
-
-            if (SUCCEEDED(res))
-            {
-                srcrow = srcdata;
-                dstrow = pbBuffer;
-                for (y=0; y<prc->Height; y++) {
-                    srcpixel=srcrow;
-                    dstpixel=dstrow;
-                    for (x=0; x<prc->Width; x++) {
-                        tmppixel[0]=*srcpixel++; /* blue */
-                        tmppixel[1]=*srcpixel++; /* green */
-                        tmppixel[2]=*srcpixel++; /* red */
-                        srcpixel++; /* alpha */
-
-                        *dstpixel++=tmppixel[2]; /* red */
-                        *dstpixel++=tmppixel[1]; /* green */
-                        *dstpixel++=tmppixel[0]; /* blue */
-                    }
-                    srcrow += srcstride;
-                    dstrow += cbStride;
-                }
-            }
-
-            free(srcdata);
-
-            return res;
-        }
+            return copy_32bpp_rows_to_24bpp(This, prc, cbStride, cbBufferSize, pbBuffer, TRUE);
         return S_OK;
     default:
         FIXME("Unimplemented conversion path!\n");
@@ -1637,7 +1727,7 @@ static HRESULT copypixels_to_8bppGray(struct FormatConverter *This, const WICRec
                     BYTE *dstpixel = dst;
 
                     for (x=0; x < prc->Width; x++)
-                        *dstpixel++ = (BYTE)floorf(to_sRGB_component(*srcpixel++) * 255.0f + 0.51f);
+                        *dstpixel++ = float_to_sRGB_byte(*srcpixel++);
 
                     src += srcstride;
                     dst += cbStride;
@@ -1934,9 +2024,9 @@ static HRESULT copypixels_to_128bppRGBAFloat(struct FormatConverter *This, const
                 dstpixel= (float *)dstrow;
                 for (x = 0; x < prc->Width; x++)
                 {
-                    dstpixel[2] = from_sRGB_component(*srcpixel++ / 255.0f);
-                    dstpixel[1] = from_sRGB_component(*srcpixel++ / 255.0f);
-                    dstpixel[0] = from_sRGB_component(*srcpixel++ / 255.0f);
+                    dstpixel[2] = sRGB_byte_to_linear[*srcpixel++];
+                    dstpixel[1] = sRGB_byte_to_linear[*srcpixel++];
+                    dstpixel[0] = sRGB_byte_to_linear[*srcpixel++];
                     dstpixel[3] = 1.0f;
 
                     dstpixel += 4;
@@ -1979,9 +2069,9 @@ static HRESULT copypixels_to_128bppRGBAFloat(struct FormatConverter *This, const
                 dstpixel= (float *)dstrow;
                 for (x = 0; x < prc->Width; x++)
                 {
-                    dstpixel[2] = from_sRGB_component(*srcpixel++ / 255.0f);
-                    dstpixel[1] = from_sRGB_component(*srcpixel++ / 255.0f);
-                    dstpixel[0] = from_sRGB_component(*srcpixel++ / 255.0f);
+                    dstpixel[2] = sRGB_byte_to_linear[*srcpixel++];
+                    dstpixel[1] = sRGB_byte_to_linear[*srcpixel++];
+                    dstpixel[0] = sRGB_byte_to_linear[*srcpixel++];
                     dstpixel[3] = *srcpixel++ / 255.0f;
 
                     dstpixel += 4;
@@ -2464,6 +2554,10 @@ static HRESULT WINAPI FormatConverter_Initialize(IWICFormatConverter *iface,
 
     if (dstinfo->copy_function)
     {
+        InitOnceExecuteOnce(&sRGB_tables_once, init_sRGB_tables, NULL, NULL);
+        if (srcinfo->format == format_16bppGrayHalf || srcinfo->format == format_48bppRGBHalf)
+            InitOnceExecuteOnce(&half_table_once, init_half_table, NULL, NULL);
+
         IWICBitmapSource_AddRef(source);
         This->src_format = srcinfo;
         This->dst_format = dstinfo;
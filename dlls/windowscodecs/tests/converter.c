@@ -2103,6 +2103,228 @@ static const struct setting png_interlace_settings[] = {
     {NULL}
 };
 
+static void get_expected_pixel(const WICPixelFormatGUID *src_format, const WICPixelFormatGUID *dst_format,
+                               const BYTE *src, BYTE *dst)
+{
+    BYTE b, g, r, a = 0xff;
+    UINT i;
+
+    if (IsEqualGUID(src_format, &GUID_WICPixelFormat24bppBGR) || IsEqualGUID(src_format, &GUID_WICPixelFormat32bppBGRA)
+            || IsEqualGUID(src_format, &GUID_WICPixelFormat32bppPBGRA))
+    {
+        b = src[0];
+        g = src[1];
+        r = src[2];
+    }
+    else
+    {
+        r = src[0];
+        g = src[1];
+        b = src[2];
+    }
+    if (IsEqualGUID(src_format, &GUID_WICPixelFormat32bppBGRA) || IsEqualGUID(src_format, &GUID_WICPixelFormat32bppRGBA)
+            || IsEqualGUID(src_format, &GUID_WICPixelFormat32bppPBGRA))
+        a = src[3];
+
+    if (IsEqualGUID(src_format, &GUID_WICPixelFormat32bppPBGRA) && a && a != 255)
+    {
+        b = b * 255 / a;
+        g = g * 255 / a;
+        r = r * 255 / a;
+    }
+
+    dst[0] = b;
+    dst[1] = g;
+    dst[2] = r;
+    if (IsEqualGUID(dst_format, &GUID_WICPixelFormat24bppBGR)) return;
+    dst[3] = a;
+
+    if (IsEqualGUID(dst_format, &GUID_WICPixelFormat32bppPBGRA) && a != 255)
+    {
+        for (i = 0; i < 3; i++)
+            dst[i] = (dst[i] * a + 127) / 255;
+    }
+}
+
+static void test_converter_row_widths(void)
+{
+    static const struct
+    {
+        const WICPixelFormatGUID *src_format;
+        UINT src_bpp;
+        const WICPixelFormatGUID *dst_format;
+        UINT dst_bpp;
+        BOOL exact;
+    }
+    tests[] =
+    {
+        { &GUID_WICPixelFormat24bppBGR, 24, &GUID_WICPixelFormat32bppBGRA, 32, TRUE },
+        { &GUID_WICPixelFormat24bppRGB, 24, &GUID_WICPixelFormat32bppBGRA, 32, TRUE },
+        { &GUID_WICPixelFormat32bppBGRA, 32, &GUID_WICPixelFormat24bppBGR, 24, TRUE },
+        { &GUID_WICPixelFormat32bppRGBA, 32, &GUID_WICPixelFormat24bppBGR, 24, TRUE },
+        { &GUID_WICPixelFormat32bppBGRA, 32, &GUID_WICPixelFormat32bppPBGRA, 32, FALSE },
+        { &GUID_WICPixelFormat32bppPBGRA, 32, &GUID_WICPixelFormat32bppBGRA, 32, FALSE },
+    };
+    static const UINT height = 3;
+    BYTE src_bits[19 * 3 * 4], buf[(19 * 5 + 3) * 3], expected[4];
+    IWICFormatConverter *converter;
+    bitmap_data data = { 0 };
+    BitmapTestSrc *src_obj;
+    UINT i, j, width, x, y, stride, extra, pad;
+    HRESULT hr;
+
+    for (i = 0; i < ARRAY_SIZE(tests); i++)
+    {
+        for (width = 1; width <= 19; width++)
+        {
+            UINT src_stride = width * tests[i].src_bpp / 8;
+
+            for (j = 0; j < src_stride * height; j++)
+                src_bits[j] = (j * 37 + width * 11 + 5) & 0xff;
+
+            /* Keep premultiplied colors in range. */
+            if (IsEqualGUID(tests[i].src_format, &GUID_WICPixelFormat32bppPBGRA))
+            {
+                for (j = 0; j < width * height; j++)
+                {
+                    src_bits[4 * j + 3] |= 0x80;
+                    src_bits[4 * j] = min(src_bits[4 * j], src_bits[4 * j + 3]);
+                    src_bits[4 * j + 1] = min(src_bits[4 * j + 1], src_bits[4 * j + 3]);
+                    src_bits[4 * j + 2] = min(src_bits[4 * j + 2], src_bits[4 * j + 3]);
+                }
+            }
+
+            data.format = tests[i].src_format;
+            data.bpp = tests[i].src_bpp;
+            data.bits = src_bits;
+            data.width = width;
+            data.height = height;
+            CreateTestBitmap(&data, &src_obj);
+
+            /* A tight stride and one with room for the 32bpp source. */
+            for (extra = 0; extra < 2; extra++)
+            {
+                stride = width * tests[i].dst_bpp / 8 + extra * (width + 3);
+
+                hr = IWICImagingFactory_CreateFormatConverter(factory, &converter);
+                ok(hr == S_OK, "CreateFormatConverter error %#lx\n", hr);
+                hr = IWICFormatConverter_Initialize(converter, &src_obj->IWICBitmapSource_iface,
+                        tests[i].dst_format, WICBitmapDitherTypeNone, NULL, 0.0, WICBitmapPaletteTypeCustom);
+                ok(hr == S_OK, "%u: Initialize error %#lx\n", i, hr);
+
+                memset(buf, 0xcc, sizeof(buf));
+                hr = IWICFormatConverter_CopyPixels(converter, NULL, stride, stride * height, buf);
+                ok(hr == S_OK, "%u, width %u: CopyPixels error %#lx\n", i, width, hr);
+
+                for (y = 0; y < height; y++)
+                {
+                    const BYTE *row = buf + y * stride;
+                    const BYTE *dst = NULL;
+
+                    for (x = 0; x < width && !dst; x++)
+                    {
+                        const BYTE *src = src_bits + y * src_stride + x * tests[i].src_bpp / 8;
+
+                        get_expected_pixel(tests[i].src_format, tests[i].dst_format, src, expected);
+                        for (j = 0; j < tests[i].dst_bpp / 8; j++)
+                        {
+                            if (abs(row[x * tests[i].dst_bpp / 8 + j] - expected[j]) > (tests[i].exact ? 0 : 1))
+                            {
+                                dst = row + x * tests[i].dst_bpp / 8;
+                                break;
+                            }
+                        }
+                    }
+                    /* The caller owns the bytes between the end of the pixels and the stride. */
+                    for (pad = width * tests[i].dst_bpp / 8; pad < stride; pad++)
+                        if (row[pad] != 0xcc) break;
+
+                    ok(!dst && pad == stride, "%u, width %u, stride %u, row %u: got pixel %u %02x %02x %02x, "
+                       "expected %02x %02x %02x, padding byte %u %#x\n", i, width, stride, y, dst ? x - 1 : 0,
+                       dst ? dst[0] : 0, dst ? dst[1] : 0, dst ? dst[2] : 0, expected[0], expected[1], expected[2],
+                       pad, pad < stride ? row[pad] : 0xcc);
+                }
+
+                IWICFormatConverter_Release(converter);
+            }
+
+            DeleteTestBitmap(src_obj);
+        }
+    }
+}
+
+static void test_converter_performance(void)
+{
+    static const struct
+    {
+        const char *name;
+        const WICPixelFormatGUID *src_format;
+        UINT src_bpp;
+        const WICPixelFormatGUID *dst_format;
+        UINT dst_bpp;
+    }
+    tests[] =
+    {
+        { "24bppBGR -> 32bppBGRA", &GUID_WICPixelFormat24bppBGR, 24, &GUID_WICPixelFormat32bppBGRA, 32 },
+        { "32bppBGRA -> 24bppBGR", &GUID_WICPixelFormat32bppBGRA, 32, &GUID_WICPixelFormat24bppBGR, 24 },
+        { "32bppBGRA -> 32bppPBGRA", &GUID_WICPixelFormat32bppBGRA, 32, &GUID_WICPixelFormat32bppPBGRA, 32 },
+        { "32bppPBGRA -> 32bppBGRA", &GUID_WICPixelFormat32bppPBGRA, 32, &GUID_WICPixelFormat32bppBGRA, 32 },
+        { "128bppRGBAFloat -> 32bppBGRA", &GUID_WICPixelFormat128bppRGBAFloat, 128, &GUID_WICPixelFormat32bppBGRA, 32 },
+        { "48bppRGBHalf -> 32bppBGRA", &GUID_WICPixelFormat48bppRGBHalf, 48, &GUID_WICPixelFormat32bppBGRA, 32 },
+        { "24bppBGR -> 128bppRGBAFloat", &GUID_WICPixelFormat24bppBGR, 24, &GUID_WICPixelFormat128bppRGBAFloat, 128 },
+    };
+    static const UINT width = 512, height = 512;
+    LARGE_INTEGER freq, start, end;
+    IWICFormatConverter *converter;
+    bitmap_data data = { 0 };
+    BitmapTestSrc *src_obj;
+    BYTE *src_bits, *buf;
+    UINT i, j, stride;
+    HRESULT hr;
+
+    src_bits = malloc(width * height * 16);
+    buf = malloc(width * height * 16);
+    for (j = 0; j < width * height * 16; j++)
+        src_bits[j] = j * 7;
+    /* Use small positive floats for the float and half formats. */
+    for (j = 0; j < width * height * 4; j++)
+        ((float *)src_bits)[j] = (j % 256) / 255.0f;
+    QueryPerformanceFrequency(&freq);
+
+    for (i = 0; i < ARRAY_SIZE(tests); i++)
+    {
+        data.format = tests[i].src_format;
+        data.bpp = tests[i].src_bpp;
+        data.bits = src_bits;
+        data.width = width;
+        data.height = height;
+        CreateTestBitmap(&data, &src_obj);
+
+        hr = IWICImagingFactory_CreateFormatConverter(factory, &converter);
+        ok(hr == S_OK, "CreateFormatConverter error %#lx\n", hr);
+        hr = IWICFormatConverter_Initialize(converter, &src_obj->IWICBitmapSource_iface,
+                tests[i].dst_format, WICBitmapDitherTypeNone, NULL, 0.0, WICBitmapPaletteTypeCustom);
+        ok(hr == S_OK, "%s: Initialize error %#lx\n", tests[i].name, hr);
+
+        stride = width * tests[i].dst_bpp / 8;
+        QueryPerformanceCounter(&start);
+        for (j = 0; j < 4; j++)
+        {
+            hr = IWICFormatConverter_CopyPixels(converter, NULL, stride, stride * height, buf);
+            ok(hr == S_OK, "%s: CopyPixels error %#lx\n", tests[i].name, hr);
+        }
+        QueryPerformanceCounter(&end);
+        trace("%s: %.1f Mpixels/s\n", tests[i].name,
+              4.0 * width * height * freq.QuadPart / max(end.QuadPart - start.QuadPart, 1) / 1e6);
+
+        IWICFormatConverter_Release(converter);
+        DeleteTestBitmap(src_obj);
+    }
+
+    free(buf);
+    free(src_bits);
+}
+
 static void test_converter_8bppIndexed(void)
 {
     HRESULT hr;
@@ -2385,6 +2607,8 @@ START_TEST(converter)
     test_converter_4bppGray();
     test_converter_8bppGray();
     test_converter_8bppIndexed();
+    test_converter_row_widths();
+    test_converter_performance();
 
     test_encoder(&testdata_8bppIndexed, &CLSID_WICGifEncoder,
                  &testdata_8bppIndexed, &CLSID_WICGifDecoder, "GIF encoder 8bppIndexed");
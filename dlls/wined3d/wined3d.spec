@@ -381,6 +381,7 @@
 @ cdecl vkd3d_queue_signal_on_cpu(ptr ptr long)
 
 @ cdecl vkd3d_shader_compile(ptr ptr ptr)
+@ cdecl vkd3d_shader_compile_batch(ptr long long ptr ptr ptr)
 @ cdecl vkd3d_shader_convert_root_signature(ptr long ptr)
 @ cdecl vkd3d_shader_find_signature_element(ptr ptr long long)
 @ cdecl vkd3d_shader_free_dxbc(ptr)
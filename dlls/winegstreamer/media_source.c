@@ -24,6 +24,7 @@
 #include "mferror.h"
 
 #include "wine/list.h"
+#include "wine/mftrace.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(mfplat);
 
@@ -749,6 +750,7 @@ static HRESULT media_stream_send_sample(struct media_stream *stream, const struc
     if (token && FAILED(hr = IMFSample_SetUnknown(sample, &MFSampleExtension_Token, token)))
         goto out;
 
+    __wine_rtwq_trace(WINE_MF_TRACE_SAMPLE_READY, &stream->IMFMediaStream_iface, wg_buffer->pts);
     hr = IMFMediaEventQueue_QueueEventParamUnk(stream->event_queue, MEMediaSample,
             &GUID_NULL, S_OK, (IUnknown *)sample);
 
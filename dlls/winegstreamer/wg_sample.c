@@ -24,6 +24,7 @@
 
 #include "wine/debug.h"
 #include "wine/list.h"
+#include "wine/mftrace.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(mfplat);
 WINE_DECLARE_DEBUG_CHANNEL(quartz);
@@ -351,7 +352,11 @@ HRESULT wg_transform_read_mf(wg_transform_t transform, IMFSample *sample, DWORD
 
     wg_sample->size = 0;
 
-    if (FAILED(hr = wg_transform_read_data(transform, wg_sample)))
+    __wine_rtwq_trace(WINE_MF_TRACE_DECODE_BEGIN, (void *)(ULONG_PTR)transform, 0);
+    hr = wg_transform_read_data(transform, wg_sample);
+    __wine_rtwq_trace(WINE_MF_TRACE_DECODE_END, (void *)(ULONG_PTR)transform,
+            (wg_sample->flags & WG_SAMPLE_FLAG_HAS_PTS) ? wg_sample->pts : 0);
+    if (FAILED(hr))
     {
         wg_sample_release(wg_sample);
         return hr;
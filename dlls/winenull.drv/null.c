@@ -0,0 +1,1827 @@
+/*
+ * Null audio driver (unixlib)
+ *
+ * Renders into a virtual device driven by its own clock, optionally
+ * running faster than real time and dumping the rendered PCM to WAV
+ * files. Intended for benchmarking the audio stack on machines without
+ * a sound server.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#if 0
+#pragma makedep unix
+#endif
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <pthread.h>
+
+#include "ntstatus.h"
+#define WIN32_NO_STATUS
+#include "winternl.h"
+#include "initguid.h"
+#include "audioclient.h"
+#include "mmddk.h"
+
+#include "wine/debug.h"
+#include "wine/unixlib.h"
+
+#include "../mmdevapi/unixlib.h"
+
+struct period_stats
+{
+    UINT64 periods, underruns, silent_frames;
+    LONGLONG start_time, next_time, signal_time;
+    LONGLONG lateness_min, lateness_max, lateness_total;
+    LONGLONG response_min, response_max, response_total;
+    UINT64 responses;
+};
+
+struct null_stream
+{
+    WAVEFORMATEX *fmt;
+    EDataFlow flow;
+    UINT flags;
+    AUDCLNT_SHAREMODE share;
+    HANDLE event;
+
+    BOOL playing, mute, please_quit;
+    UINT64 written_frames, last_pos_frames;
+    UINT32 period_frames, bufsize_frames, held_frames, tmp_buffer_frames;
+    UINT32 lcl_offs_frames; /* offs into local_buffer where valid data starts */
+    REFERENCE_TIME period;
+
+    BYTE *local_buffer, *tmp_buffer, *silence;
+    INT32 getbuf_last; /* <0 when using tmp_buffer */
+
+    unsigned int id;
+    int wav_fd, stats_fd;
+    UINT64 wav_bytes;
+    struct period_stats stats;
+
+    pthread_mutex_t lock;
+};
+
+WINE_DEFAULT_DEBUG_CHANNEL(nullaudio);
+
+static const REFERENCE_TIME def_period = 100000;
+static const REFERENCE_TIME min_period = 30000;
+
+static const WCHAR drv_keyW[] = {'S','o','f','t','w','a','r','e','\\',
+    'W','i','n','e','\\','D','r','i','v','e','r','s','\\',
+    'w','i','n','e','n','u','l','l','.','d','r','v'};
+
+static ULONG_PTR zero_bits = 0;
+
+static struct
+{
+    DWORD clock_speed; /* multiple of real time, 0 means paced by the client */
+    DWORD sample_rate;
+    DWORD channels;
+    char output_file[PATH_MAX];
+    char stats_file[PATH_MAX];
+} config = { 1, 48000, 2 };
+
+static LONG next_stream_id;
+
+static NTSTATUS null_not_implemented(void *args)
+{
+    return STATUS_SUCCESS;
+}
+
+static inline void ascii_to_unicode( WCHAR *dst, const char *src, size_t len )
+{
+    while (len--) *dst++ = (unsigned char)*src++;
+}
+
+static HKEY reg_open_key( HKEY root, const WCHAR *name, ULONG name_len )
+{
+    UNICODE_STRING nameW = { name_len, name_len, (WCHAR *)name };
+    OBJECT_ATTRIBUTES attr;
+    HANDLE ret;
+
+    attr.Length = sizeof(attr);
+    attr.RootDirectory = root;
+    attr.ObjectName = &nameW;
+    attr.Attributes = 0;
+    attr.SecurityDescriptor = NULL;
+    attr.SecurityQualityOfService = NULL;
+
+    if (NtOpenKeyEx( &ret, MAXIMUM_ALLOWED, &attr, 0 )) return 0;
+    return ret;
+}
+
+static HKEY open_hkcu(void)
+{
+    char buffer[256];
+    WCHAR bufferW[256];
+    DWORD_PTR sid_data[(sizeof(TOKEN_USER) + SECURITY_MAX_SID_SIZE) / sizeof(DWORD_PTR)];
+    DWORD i, len = sizeof(sid_data);
+    SID *sid;
+
+    if (NtQueryInformationToken( GetCurrentThreadEffectiveToken(), TokenUser, sid_data, len, &len ))
+        return 0;
+
+    sid = ((TOKEN_USER *)sid_data)->User.Sid;
+    len = sprintf( buffer, "\\Registry\\User\\S-%u-%u", sid->Revision,
+                   (unsigned)MAKELONG( MAKEWORD( sid->IdentifierAuthority.Value[5], sid->IdentifierAuthority.Value[4] ),
+                                       MAKEWORD( sid->IdentifierAuthority.Value[3], sid->IdentifierAuthority.Value[2] )));
+    for (i = 0; i < sid->SubAuthorityCount; i++)
+        len += sprintf( buffer + len, "-%u", (unsigned)sid->SubAuthority[i] );
+    ascii_to_unicode( bufferW, buffer, len + 1 );
+
+    return reg_open_key( NULL, bufferW, len * sizeof(WCHAR) );
+}
+
+static HKEY reg_open_hkcu_key( const WCHAR *name, ULONG name_len )
+{
+    HKEY hkcu = open_hkcu(), key;
+
+    key = reg_open_key( hkcu, name, name_len );
+    NtClose( hkcu );
+
+    return key;
+}
+
+static ULONG reg_query_value( HKEY hkey, const WCHAR *name,
+                       KEY_VALUE_PARTIAL_INFORMATION *info, ULONG size )
+{
+    unsigned int name_size = name ? wcslen( name ) * sizeof(WCHAR) : 0;
+    UNICODE_STRING nameW = { name_size, name_size, (WCHAR *)name };
+
+    if (NtQueryValueKey( hkey, &nameW, KeyValuePartialInformation,
+                         info, size, &size ))
+        return 0;
+
+    return size - FIELD_OFFSET(KEY_VALUE_PARTIAL_INFORMATION, Data);
+}
+
+static void reg_query_dword(HKEY key, const WCHAR *name, DWORD *value)
+{
+    char buffer[sizeof(KEY_VALUE_PARTIAL_INFORMATION) + sizeof(DWORD)];
+    KEY_VALUE_PARTIAL_INFORMATION *info = (void *)buffer;
+
+    if(reg_query_value(key, name, info, sizeof(buffer)) == sizeof(DWORD) && info->Type == REG_DWORD)
+        *value = *(DWORD *)info->Data;
+}
+
+static void reg_query_path(HKEY key, const WCHAR *name, char *path)
+{
+    char buffer[sizeof(KEY_VALUE_PARTIAL_INFORMATION) + MAX_PATH * sizeof(WCHAR)];
+    KEY_VALUE_PARTIAL_INFORMATION *info = (void *)buffer;
+    ULONG size;
+
+    if(!(size = reg_query_value(key, name, info, sizeof(buffer) - sizeof(WCHAR))) || info->Type != REG_SZ)
+        return;
+
+    ((WCHAR *)info->Data)[size / sizeof(WCHAR)] = 0;
+    ntdll_wcstoumbs((WCHAR *)info->Data, wcslen((WCHAR *)info->Data) + 1, path, PATH_MAX, FALSE);
+}
+
+static void load_config(void)
+{
+    static const WCHAR ClockSpeedW[] = {'C','l','o','c','k','S','p','e','e','d',0};
+    static const WCHAR SampleRateW[] = {'S','a','m','p','l','e','R','a','t','e',0};
+    static const WCHAR ChannelsW[] = {'C','h','a','n','n','e','l','s',0};
+    static const WCHAR OutputFileW[] = {'O','u','t','p','u','t','F','i','l','e',0};
+    static const WCHAR StatsFileW[] = {'S','t','a','t','s','F','i','l','e',0};
+    HKEY key;
+
+    /* @@ Wine registry key: HKCU\Software\Wine\Drivers\winenull.drv
+     *
+     * ClockSpeed (DWORD): how many times faster than real time the device
+     *   consumes data; 0 consumes a period as soon as the client has queued it,
+     *   and captures one as soon as the client has read the previous one.
+     * SampleRate, Channels (DWORD): mix format of the endpoints.
+     * OutputFile (SZ): Unix path prefix, each render stream is dumped to
+     *   "<prefix>.<stream>.wav".
+     * StatsFile (SZ): Unix path to append per-period timing records to.
+     */
+    if(!(key = reg_open_hkcu_key(drv_keyW, sizeof(drv_keyW))))
+        return;
+
+    reg_query_dword(key, ClockSpeedW, &config.clock_speed);
+    reg_query_dword(key, SampleRateW, &config.sample_rate);
+    reg_query_dword(key, ChannelsW, &config.channels);
+    reg_query_path(key, OutputFileW, config.output_file);
+    reg_query_path(key, StatsFileW, config.stats_file);
+    NtClose(key);
+
+    if(config.sample_rate < 8000 || config.sample_rate > 384000)
+        config.sample_rate = 48000;
+    if(!config.channels || config.channels > 8)
+        config.channels = 2;
+
+    TRACE("clock speed %u, %u Hz, %u channels, output %s, stats %s\n",
+            (unsigned)config.clock_speed, (unsigned)config.sample_rate, (unsigned)config.channels,
+            debugstr_a(config.output_file), debugstr_a(config.stats_file));
+}
+
+/* copied from kernelbase */
+static int muldiv( int a, int b, int c )
+{
+    LONGLONG ret;
+
+    if (!c) return -1;
+
+    /* We want to deal with a positive divisor to simplify the logic. */
+    if (c < 0)
+    {
+        a = -a;
+        c = -c;
+    }
+
+    /* If the result is positive, we "add" to round. else, we subtract to round. */
+    if ((a < 0 && b < 0) || (a >= 0 && b >= 0))
+        ret = (((LONGLONG)a * b) + (c / 2)) / c;
+    else
+        ret = (((LONGLONG)a * b) - (c / 2)) / c;
+
+    if (ret > 2147483647 || ret < -2147483647) return -1;
+    return ret;
+}
+
+/* returns the current time in 100ns units */
+static LONGLONG get_time(void)
+{
+    LARGE_INTEGER stamp, freq;
+
+    NtQueryPerformanceCounter(&stamp, &freq);
+    return (stamp.QuadPart * (INT64)10000000) / freq.QuadPart;
+}
+
+static void null_lock(struct null_stream *stream)
+{
+    pthread_mutex_lock(&stream->lock);
+}
+
+static void null_unlock(struct null_stream *stream)
+{
+    pthread_mutex_unlock(&stream->lock);
+}
+
+static NTSTATUS null_unlock_result(struct null_stream *stream,
+                                   HRESULT *result, HRESULT value)
+{
+    *result = value;
+    null_unlock(stream);
+    return STATUS_SUCCESS;
+}
+
+static struct null_stream *handle_get_stream(stream_handle h)
+{
+    return (struct null_stream *)(UINT_PTR)h;
+}
+
+static NTSTATUS null_test_connect(void *args)
+{
+    struct test_connect_params *params = args;
+
+    /* Always works, but never better than a real device. */
+    params->priority = Priority_Neutral;
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS null_process_attach(void *args)
+{
+#ifdef _WIN64
+    if (NtCurrentTeb()->WowTebOffset)
+    {
+        SYSTEM_BASIC_INFORMATION info;
+
+        NtQuerySystemInformation(SystemEmulationBasicInformation, &info, sizeof(info), NULL);
+        zero_bits = (ULONG_PTR)info.HighestUserAddress | 0x7fffffff;
+    }
+#endif
+    load_config();
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS null_main_loop(void *args)
+{
+    struct main_loop_params *params = args;
+    NtSetEvent(params->event, NULL);
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS null_get_endpoint_ids(void *args)
+{
+    static const WCHAR outW[] = {'N','u','l','l',' ','O','u','t','p','u','t',0};
+    static const WCHAR inW[] = {'N','u','l','l',' ','I','n','p','u','t',0};
+    static const char device[] = "null";
+    struct get_endpoint_ids_params *params = args;
+    const WCHAR *name = (params->flow == eRender) ? outW : inW;
+    unsigned int name_len, device_len, needed;
+    struct endpoint *endpoint = params->endpoints;
+
+    name_len = wcslen(name) + 1;
+    device_len = strlen(device) + 1;
+    needed = sizeof(*endpoint) + name_len * sizeof(WCHAR) + ((device_len + 1) & ~1);
+
+    params->num = 1;
+    params->default_idx = 0;
+
+    if(needed > params->size){
+        params->size = needed;
+        params->result = HRESULT_FROM_WIN32(ERROR_INSUFFICIENT_BUFFER);
+        return STATUS_SUCCESS;
+    }
+
+    endpoint->name = sizeof(*endpoint);
+    memcpy((char *)params->endpoints + endpoint->name, name, name_len * sizeof(WCHAR));
+    endpoint->device = endpoint->name + name_len * sizeof(WCHAR);
+    memcpy((char *)params->endpoints + endpoint->device, device, device_len);
+
+    params->result = S_OK;
+    return STATUS_SUCCESS;
+}
+
+static UINT get_channel_mask(unsigned int channels)
+{
+    switch(channels){
+    case 0:
+        return 0;
+    case 1:
+        return KSAUDIO_SPEAKER_MONO;
+    case 2:
+        return KSAUDIO_SPEAKER_STEREO;
+    case 3:
+        return KSAUDIO_SPEAKER_STEREO | SPEAKER_LOW_FREQUENCY;
+    case 4:
+        return KSAUDIO_SPEAKER_QUAD;    /* not _SURROUND */
+    case 5:
+        return KSAUDIO_SPEAKER_QUAD | SPEAKER_LOW_FREQUENCY;
+    case 6:
+        return KSAUDIO_SPEAKER_5POINT1; /* not 5POINT1_SURROUND */
+    case 7:
+        return KSAUDIO_SPEAKER_5POINT1 | SPEAKER_BACK_CENTER;
+    case 8:
+        return KSAUDIO_SPEAKER_7POINT1_SURROUND; /* Vista deprecates 7POINT1 */
+    }
+    FIXME("Unknown speaker configuration: %u\n", channels);
+    return 0;
+}
+
+static BOOL is_supported_format(const WAVEFORMATEX *fmt)
+{
+    const WAVEFORMATEXTENSIBLE *fmtex = (const WAVEFORMATEXTENSIBLE *)fmt;
+
+    if(fmt->wFormatTag == WAVE_FORMAT_PCM ||
+            (fmt->wFormatTag == WAVE_FORMAT_EXTENSIBLE &&
+             IsEqualGUID(&fmtex->SubFormat, &KSDATAFORMAT_SUBTYPE_PCM)))
+        return fmt->wBitsPerSample == 8 || fmt->wBitsPerSample == 16 ||
+               fmt->wBitsPerSample == 24 || fmt->wBitsPerSample == 32;
+
+    if(fmt->wFormatTag == WAVE_FORMAT_IEEE_FLOAT ||
+            (fmt->wFormatTag == WAVE_FORMAT_EXTENSIBLE &&
+             IsEqualGUID(&fmtex->SubFormat, &KSDATAFORMAT_SUBTYPE_IEEE_FLOAT)))
+        return fmt->wBitsPerSample == 32;
+
+    return FALSE;
+}
+
+static WAVEFORMATEXTENSIBLE *clone_format(const WAVEFORMATEX *fmt)
+{
+    WAVEFORMATEXTENSIBLE *ret;
+    size_t size;
+
+    if(fmt->wFormatTag == WAVE_FORMAT_EXTENSIBLE)
+        size = sizeof(WAVEFORMATEXTENSIBLE);
+    else
+        size = sizeof(WAVEFORMATEX);
+
+    ret = malloc(size);
+    if(!ret)
+        return NULL;
+
+    memcpy(ret, fmt, size);
+
+    ret->Format.cbSize = size - sizeof(WAVEFORMATEX);
+
+    return ret;
+}
+
+/* The virtual device takes any sane PCM or float layout as-is, so this only
+ * has to reject malformed formats and suggest a consistent one. */
+static HRESULT check_format(AUDCLNT_SHAREMODE share, const WAVEFORMATEX *fmt,
+                            WAVEFORMATEXTENSIBLE *out)
+{
+    const WAVEFORMATEXTENSIBLE *fmtex = (const WAVEFORMATEXTENSIBLE *)fmt;
+    WAVEFORMATEXTENSIBLE *closest;
+    HRESULT ret = S_OK;
+
+    if(!is_supported_format(fmt))
+        return AUDCLNT_E_UNSUPPORTED_FORMAT;
+
+    if(fmt->wFormatTag == WAVE_FORMAT_EXTENSIBLE &&
+            (fmtex->Format.nAvgBytesPerSec == 0 ||
+             fmtex->Format.nBlockAlign == 0 ||
+             fmtex->Samples.wValidBitsPerSample > fmtex->Format.wBitsPerSample))
+        return E_INVALIDARG;
+
+    if(fmt->nChannels == 0 || fmt->nChannels > 8 ||
+            fmt->nSamplesPerSec < 8000 || fmt->nSamplesPerSec > 384000)
+        return AUDCLNT_E_UNSUPPORTED_FORMAT;
+
+    if(fmt->nBlockAlign != fmt->nChannels * fmt->wBitsPerSample / 8 ||
+            fmt->nAvgBytesPerSec != fmt->nBlockAlign * fmt->nSamplesPerSec ||
+            (fmt->wFormatTag == WAVE_FORMAT_EXTENSIBLE &&
+             fmtex->Samples.wValidBitsPerSample < fmtex->Format.wBitsPerSample))
+        ret = S_FALSE;
+
+    if(share == AUDCLNT_SHAREMODE_EXCLUSIVE &&
+            fmt->wFormatTag == WAVE_FORMAT_EXTENSIBLE){
+        if(fmtex->dwChannelMask == 0 || fmtex->dwChannelMask & SPEAKER_RESERVED)
+            ret = S_FALSE;
+    }
+
+    if(ret == S_FALSE && !out)
+        ret = AUDCLNT_E_UNSUPPORTED_FORMAT;
+
+    if(ret == S_FALSE){
+        if(!(closest = clone_format(fmt)))
+            return E_OUTOFMEMORY;
+        closest->Format.nBlockAlign =
+            closest->Format.nChannels * closest->Format.wBitsPerSample / 8;
+        closest->Format.nAvgBytesPerSec =
+            closest->Format.nBlockAlign * closest->Format.nSamplesPerSec;
+        if(closest->Format.wFormatTag == WAVE_FORMAT_EXTENSIBLE){
+            closest->Samples.wValidBitsPerSample = closest->Format.wBitsPerSample;
+            closest->dwChannelMask = get_channel_mask(closest->Format.nChannels);
+        }
+        memcpy(out, closest, closest->Format.cbSize + sizeof(WAVEFORMATEX));
+        free(closest);
+    }
+
+    TRACE("returning: %08x\n", (unsigned)ret);
+    return ret;
+}
+
+static void silence_buffer(struct null_stream *stream, BYTE *buffer, UINT32 frames)
+{
+    WAVEFORMATEXTENSIBLE *fmtex = (WAVEFORMATEXTENSIBLE*)stream->fmt;
+    if((stream->fmt->wFormatTag == WAVE_FORMAT_PCM ||
+            (stream->fmt->wFormatTag == WAVE_FORMAT_EXTENSIBLE &&
+             IsEqualGUID(&fmtex->SubFormat, &KSDATAFORMAT_SUBTYPE_PCM))) &&
+            stream->fmt->wBitsPerSample == 8)
+        memset(buffer, 128, frames * stream->fmt->nBlockAlign);
+    else
+        memset(buffer, 0, frames * stream->fmt->nBlockAlign);
+}
+
+static void wav_write_header(struct null_stream *stream)
+{
+    UINT32 fmt_size = sizeof(WAVEFORMATEX) + stream->fmt->cbSize;
+    UINT32 data_size = min(stream->wav_bytes, 0xffffffff - 36 - fmt_size);
+    UINT32 riff_size = 4 + 8 + fmt_size + 8 + data_size;
+    BYTE header[20 + sizeof(WAVEFORMATEXTENSIBLE) + 8], *p = header;
+
+    memcpy(p, "RIFF", 4); p += 4;
+    memcpy(p, &riff_size, 4); p += 4;
+    memcpy(p, "WAVEfmt ", 8); p += 8;
+    memcpy(p, &fmt_size, 4); p += 4;
+    memcpy(p, stream->fmt, fmt_size); p += fmt_size;
+    memcpy(p, "data", 4); p += 4;
+    memcpy(p, &data_size, 4); p += 4;
+
+    if(pwrite(stream->wav_fd, header, p - header, 0) != p - header)
+        WARN("Failed to write WAV header: %d (%s)\n", errno, strerror(errno));
+}
+
+static void wav_open(struct null_stream *stream)
+{
+    char path[PATH_MAX + 16];
+
+    stream->wav_fd = -1;
+    if(!config.output_file[0] || stream->flow != eRender)
+        return;
+
+    snprintf(path, sizeof(path), "%s.%u.wav", config.output_file, stream->id);
+    stream->wav_fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if(stream->wav_fd < 0){
+        WARN("Unable to open %s: %d (%s)\n", debugstr_a(path), errno, strerror(errno));
+        return;
+    }
+    wav_write_header(stream);
+    lseek(stream->wav_fd, 0, SEEK_END);
+}
+
+static void wav_write(struct null_stream *stream, const BYTE *data, UINT32 frames)
+{
+    size_t bytes = frames * stream->fmt->nBlockAlign;
+
+    if(stream->wav_fd < 0 || !frames)
+        return;
+
+    /* frames never exceed a period, which is what silence holds */
+    if(stream->mute)
+        data = stream->silence;
+
+    if(write(stream->wav_fd, data, bytes) != bytes){
+        WARN("Failed to write PCM data: %d (%s)\n", errno, strerror(errno));
+        close(stream->wav_fd);
+        stream->wav_fd = -1;
+        return;
+    }
+    stream->wav_bytes += bytes;
+}
+
+static void stats_write(struct null_stream *stream, const char *line, int len)
+{
+    if(write(stream->stats_fd, line, len) != len)
+        WARN("Failed to write stats: %d (%s)\n", errno, strerror(errno));
+}
+
+static void stats_open(struct null_stream *stream)
+{
+    char line[128];
+    int len;
+
+    stream->stats_fd = -1;
+    if(!config.stats_file[0])
+        return;
+
+    stream->stats_fd = open(config.stats_file, O_WRONLY | O_CREAT | O_APPEND, 0666);
+    if(stream->stats_fd < 0){
+        WARN("Unable to open %s: %d (%s)\n", debugstr_a(config.stats_file), errno, strerror(errno));
+        return;
+    }
+
+    len = snprintf(line, sizeof(line), "# stream %u: %s, %u Hz, %u channels, %u frames per period\n",
+            stream->id, stream->flow == eRender ? "render" : "capture",
+            (unsigned)stream->fmt->nSamplesPerSec, stream->fmt->nChannels, stream->period_frames);
+    stats_write(stream, line, len);
+    len = snprintf(line, sizeof(line), "# stream,period,device_us,wall_us,late_us,held,consumed,underrun\n");
+    stats_write(stream, line, len);
+}
+
+static void stats_record_period(struct null_stream *stream, LONGLONG now, LONGLONG lateness,
+                                UINT32 held, UINT32 consumed)
+{
+    struct period_stats *stats = &stream->stats;
+    BOOL underrun = stream->flow == eRender && consumed < stream->period_frames;
+    char line[160];
+    int len;
+
+    if(!stats->periods || lateness < stats->lateness_min)
+        stats->lateness_min = lateness;
+    if(!stats->periods || lateness > stats->lateness_max)
+        stats->lateness_max = lateness;
+    stats->lateness_total += lateness;
+    if(underrun){
+        ++stats->underruns;
+        stats->silent_frames += stream->period_frames - consumed;
+    }
+
+    if(stream->stats_fd >= 0){
+        len = snprintf(line, sizeof(line), "%u,%s,%s,%s,%s,%u,%u,%u\n", stream->id,
+                wine_dbgstr_longlong(stats->periods),
+                wine_dbgstr_longlong(stats->periods * stream->period_frames * 1000000 /
+                                     stream->fmt->nSamplesPerSec),
+                wine_dbgstr_longlong((now - stats->start_time) / 10),
+                wine_dbgstr_longlong(lateness / 10), held, consumed, underrun);
+        stats_write(stream, line, len);
+    }
+    ++stats->periods;
+}
+
+static void stats_close(struct null_stream *stream)
+{
+    struct period_stats *stats = &stream->stats;
+    char line[320];
+    int len;
+
+    len = snprintf(line, sizeof(line), "# stream %u: %s periods, %s underruns (%s frames), "
+            "late min/avg/max %s/%s/%s us, response min/avg/max %s/%s/%s us\n",
+            stream->id, wine_dbgstr_longlong(stats->periods), wine_dbgstr_longlong(stats->underruns),
+            wine_dbgstr_longlong(stats->silent_frames),
+            wine_dbgstr_longlong(stats->lateness_min / 10),
+            wine_dbgstr_longlong(stats->periods ? stats->lateness_total / stats->periods / 10 : 0),
+            wine_dbgstr_longlong(stats->lateness_max / 10),
+            wine_dbgstr_longlong(stats->response_min / 10),
+            wine_dbgstr_longlong(stats->responses ? stats->response_total / stats->responses / 10 : 0),
+            wine_dbgstr_longlong(stats->response_max / 10));
+    TRACE("%s", line + 2);
+
+    if(stream->stats_fd < 0)
+        return;
+    stats_write(stream, line, len);
+    close(stream->stats_fd);
+}
+
+static NTSTATUS null_create_stream(void *args)
+{
+    struct create_stream_params *params = args;
+    WAVEFORMATEXTENSIBLE *fmtex;
+    struct null_stream *stream;
+    SIZE_T size;
+
+    stream = calloc(1, sizeof(*stream));
+    if(!stream){
+        params->result = E_OUTOFMEMORY;
+        return STATUS_SUCCESS;
+    }
+
+    stream->flow = params->flow;
+    stream->wav_fd = stream->stats_fd = -1;
+    pthread_mutex_init(&stream->lock, NULL);
+
+    params->result = check_format(params->share, params->fmt, NULL);
+    if(FAILED(params->result))
+        goto exit;
+
+    fmtex = clone_format(params->fmt);
+    if(!fmtex){
+        params->result = E_OUTOFMEMORY;
+        goto exit;
+    }
+    stream->fmt = &fmtex->Format;
+
+    stream->period = params->period;
+    stream->period_frames = muldiv(params->fmt->nSamplesPerSec, params->period, 10000000);
+
+    stream->bufsize_frames = muldiv(params->duration, params->fmt->nSamplesPerSec, 10000000);
+    if(params->share == AUDCLNT_SHAREMODE_EXCLUSIVE)
+        stream->bufsize_frames -= stream->bufsize_frames % stream->period_frames;
+    size = stream->bufsize_frames * params->fmt->nBlockAlign;
+    if(NtAllocateVirtualMemory(GetCurrentProcess(), (void **)&stream->local_buffer, zero_bits,
+                               &size, MEM_COMMIT, PAGE_READWRITE)){
+        params->result = E_OUTOFMEMORY;
+        goto exit;
+    }
+
+    stream->silence = malloc(stream->period_frames * params->fmt->nBlockAlign);
+    if(!stream->silence){
+        params->result = E_OUTOFMEMORY;
+        goto exit;
+    }
+    silence_buffer(stream, stream->silence, stream->period_frames);
+
+    stream->share = params->share;
+    stream->flags = params->flags;
+    stream->id = InterlockedIncrement(&next_stream_id) - 1;
+
+    wav_open(stream);
+    stats_open(stream);
+
+exit:
+    if(FAILED(params->result)){
+        if(stream->local_buffer){
+            size = 0;
+            NtFreeVirtualMemory(GetCurrentProcess(), (void **)&stream->local_buffer, &size, MEM_RELEASE);
+        }
+        pthread_mutex_destroy(&stream->lock);
+        free(stream->silence);
+        free(stream->fmt);
+        free(stream);
+    }else{
+        *params->channel_count = params->fmt->nChannels;
+        *params->stream = (stream_handle)(UINT_PTR)stream;
+    }
+
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS null_release_stream(void *args)
+{
+    struct release_stream_params *params = args;
+    struct null_stream *stream = handle_get_stream(params->stream);
+    SIZE_T size;
+
+    if(params->timer_thread){
+        stream->please_quit = TRUE;
+        NtWaitForSingleObject(params->timer_thread, FALSE, NULL);
+        NtClose(params->timer_thread);
+    }
+
+    if(stream->wav_fd >= 0){
+        wav_write_header(stream);
+        close(stream->wav_fd);
+    }
+    stats_close(stream);
+
+    if(stream->local_buffer){
+        size = 0;
+        NtFreeVirtualMemory(GetCurrentProcess(), (void **)&stream->local_buffer, &size, MEM_RELEASE);
+    }
+    if(stream->tmp_buffer){
+        size = 0;
+        NtFreeVirtualMemory(GetCurrentProcess(), (void **)&stream->tmp_buffer, &size, MEM_RELEASE);
+    }
+    free(stream->silence);
+    free(stream->fmt);
+    pthread_mutex_destroy(&stream->lock);
+    free(stream);
+
+    params->result = S_OK;
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS null_start(void *args)
+{
+    struct start_params *params = args;
+    struct null_stream *stream = handle_get_stream(params->stream);
+
+    null_lock(stream);
+
+    if((stream->flags & AUDCLNT_STREAMFLAGS_EVENTCALLBACK) && !stream->event)
+        return null_unlock_result(stream, &params->result, AUDCLNT_E_EVENTHANDLE_NOT_SET);
+
+    if(stream->playing)
+        return null_unlock_result(stream, &params->result, AUDCLNT_E_NOT_STOPPED);
+
+    stream->playing = TRUE;
+
+    return null_unlock_result(stream, &params->result, S_OK);
+}
+
+static NTSTATUS null_stop(void *args)
+{
+    struct stop_params *params = args;
+    struct null_stream *stream = handle_get_stream(params->stream);
+
+    null_lock(stream);
+
+    if(!stream->playing)
+        return null_unlock_result(stream, &params->result, S_FALSE);
+
+    stream->playing = FALSE;
+
+    return null_unlock_result(stream, &params->result, S_OK);
+}
+
+static NTSTATUS null_reset(void *args)
+{
+    struct reset_params *params = args;
+    struct null_stream *stream = handle_get_stream(params->stream);
+
+    null_lock(stream);
+
+    if(stream->playing)
+        return null_unlock_result(stream, &params->result, AUDCLNT_E_NOT_STOPPED);
+
+    if(stream->getbuf_last)
+        return null_unlock_result(stream, &params->result, AUDCLNT_E_BUFFER_OPERATION_PENDING);
+
+    if(stream->flow == eRender){
+        stream->written_frames = 0;
+        stream->last_pos_frames = 0;
+    }else{
+        stream->written_frames += stream->held_frames;
+    }
+    stream->held_frames = 0;
+    stream->lcl_offs_frames = 0;
+
+    return null_unlock_result(stream, &params->result, S_OK);
+}
+
+/* Plays back one period worth of data; anything missing is an underrun and
+ * is rendered as silence, just like a real device would. */
+static UINT32 null_write_period(struct null_stream *stream)
+{
+    UINT32 frames = min(stream->held_frames, stream->period_frames), chunk;
+
+    chunk = min(frames, stream->bufsize_frames - stream->lcl_offs_frames);
+    wav_write(stream, stream->local_buffer + stream->lcl_offs_frames * stream->fmt->nBlockAlign, chunk);
+    wav_write(stream, stream->local_buffer, frames - chunk);
+    wav_write(stream, stream->silence, stream->period_frames - frames);
+
+    stream->lcl_offs_frames += frames;
+    stream->lcl_offs_frames %= stream->bufsize_frames;
+    stream->held_frames -= frames;
+    return frames;
+}
+
+static UINT32 null_read_period(struct null_stream *stream)
+{
+    UINT32 pos, chunk;
+
+    pos = (stream->held_frames + stream->lcl_offs_frames) % stream->bufsize_frames;
+    chunk = min(stream->period_frames, stream->bufsize_frames - pos);
+    silence_buffer(stream, stream->local_buffer + pos * stream->fmt->nBlockAlign, chunk);
+    silence_buffer(stream, stream->local_buffer, stream->period_frames - chunk);
+
+    stream->held_frames += stream->period_frames;
+    if(stream->held_frames > stream->bufsize_frames){
+        WARN("Overflow of unread data\n");
+        stream->lcl_offs_frames += stream->held_frames - stream->bufsize_frames;
+        stream->lcl_offs_frames %= stream->bufsize_frames;
+        stream->held_frames = stream->bufsize_frames;
+    }
+    return stream->period_frames;
+}
+
+static NTSTATUS null_timer_loop(void *args)
+{
+    struct timer_loop_params *params = args;
+    struct null_stream *stream = handle_get_stream(params->stream);
+    REFERENCE_TIME interval;
+    LARGE_INTEGER delay;
+    LONGLONG now, adjust;
+    UINT32 held, consumed;
+    BOOL ticked;
+
+    null_lock(stream);
+
+    /* In client paced mode the clock only advances once a full period has
+     * been queued for render, or the captured data has been read, we poll
+     * for that at a much finer granularity. */
+    interval = config.clock_speed ? stream->period / config.clock_speed : 1000;
+    stream->stats.start_time = now = get_time();
+    stream->stats.next_time = now + interval;
+    delay.QuadPart = -interval;
+
+    while(!stream->please_quit){
+        ticked = FALSE;
+        if(stream->playing &&
+                (config.clock_speed ||
+                 (stream->flow == eRender ? stream->held_frames >= stream->period_frames :
+                                            stream->held_frames < stream->period_frames))){
+            now = get_time();
+            held = stream->held_frames;
+            if(stream->flow == eRender)
+                consumed = null_write_period(stream);
+            else
+                consumed = null_read_period(stream);
+            /* the current tick was due one interval before next_time */
+            stats_record_period(stream, now, config.clock_speed ? now - stream->stats.next_time + interval : 0,
+                    held, consumed);
+            ticked = TRUE;
+        }
+        /* When paced by the client, only wake it up when it has something to
+         * do: after a period was consumed, or if it hasn't answered yet. */
+        if(stream->event && (config.clock_speed ||
+                (stream->playing && (ticked || !stream->stats.signal_time)))){
+            if(!stream->stats.signal_time)
+                stream->stats.signal_time = get_time();
+            NtSetEvent(stream->event, NULL);
+        }
+        null_unlock(stream);
+
+        NtDelayExecution(FALSE, &delay);
+
+        null_lock(stream);
+        if(config.clock_speed){
+            now = get_time();
+            adjust = stream->stats.next_time - now;
+            if(adjust > interval / 2)
+                adjust = interval / 2;
+            else if(adjust < -interval / 2)
+                adjust = -interval / 2;
+            delay.QuadPart = -(interval + adjust);
+            stream->stats.next_time += interval;
+        }
+    }
+
+    null_unlock(stream);
+
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS null_get_render_buffer(void *args)
+{
+    struct get_render_buffer_params *params = args;
+    struct null_stream *stream = handle_get_stream(params->stream);
+    UINT32 write_pos, frames = params->frames;
+    BYTE **data = params->data;
+    SIZE_T size;
+
+    null_lock(stream);
+
+    if(stream->getbuf_last)
+        return null_unlock_result(stream, &params->result, AUDCLNT_E_OUT_OF_ORDER);
+
+    if(!frames)
+        return null_unlock_result(stream, &params->result, S_OK);
+
+    if(stream->held_frames + frames > stream->bufsize_frames)
+        return null_unlock_result(stream, &params->result, AUDCLNT_E_BUFFER_TOO_LARGE);
+
+    write_pos =
+        (stream->lcl_offs_frames + stream->held_frames) % stream->bufsize_frames;
+    if(write_pos + frames > stream->bufsize_frames){
+        if(stream->tmp_buffer_frames < frames){
+            if(stream->tmp_buffer){
+                size = 0;
+                NtFreeVirtualMemory(GetCurrentProcess(), (void **)&stream->tmp_buffer, &size, MEM_RELEASE);
+                stream->tmp_buffer = NULL;
+            }
+            size = frames * stream->fmt->nBlockAlign;
+            if(NtAllocateVirtualMemory(GetCurrentProcess(), (void **)&stream->tmp_buffer, zero_bits,
+                                       &size, MEM_COMMIT, PAGE_READWRITE)){
+                stream->tmp_buffer_frames = 0;
+                return null_unlock_result(stream, &params->result, E_OUTOFMEMORY);
+            }
+            stream->tmp_buffer_frames = frames;
+        }
+        *data = stream->tmp_buffer;
+        stream->getbuf_last = -frames;
+    }else{
+        *data = stream->local_buffer + write_pos * stream->fmt->nBlockAlign;
+        stream->getbuf_last = frames;
+    }
+
+    silence_buffer(stream, *data, frames);
+
+    return null_unlock_result(stream, &params->result, S_OK);
+}
+
+static void null_wrap_buffer(struct null_stream *stream, BYTE *buffer, UINT32 written_frames)
+{
+    UINT32 write_offs_frames =
+        (stream->lcl_offs_frames + stream->held_frames) % stream->bufsize_frames;
+    UINT32 write_offs_bytes = write_offs_frames * stream->fmt->nBlockAlign;
+    UINT32 chunk_frames = stream->bufsize_frames - write_offs_frames;
+    UINT32 chunk_bytes = chunk_frames * stream->fmt->nBlockAlign;
+    UINT32 written_bytes = written_frames * stream->fmt->nBlockAlign;
+
+    if(written_bytes <= chunk_bytes){
+        memcpy(stream->local_buffer + write_offs_bytes, buffer, written_bytes);
+    }else{
+        memcpy(stream->local_buffer + write_offs_bytes, buffer, chunk_bytes);
+        memcpy(stream->local_buffer, buffer + chunk_bytes,
+                written_bytes - chunk_bytes);
+    }
+}
+
+static NTSTATUS null_release_render_buffer(void *args)
+{
+    struct release_render_buffer_params *params = args;
+    struct null_stream *stream = handle_get_stream(params->stream);
+    struct period_stats *stats = &stream->stats;
+    UINT32 written_frames = params->written_frames;
+    UINT flags = params->flags;
+    LONGLONG response;
+    BYTE *buffer;
+
+    null_lock(stream);
+
+    if(!written_frames){
+        stream->getbuf_last = 0;
+        return null_unlock_result(stream, &params->result, S_OK);
+    }
+
+    if(!stream->getbuf_last)
+        return null_unlock_result(stream, &params->result, AUDCLNT_E_OUT_OF_ORDER);
+
+    if(written_frames > (stream->getbuf_last >= 0 ? stream->getbuf_last : -stream->getbuf_last))
+        return null_unlock_result(stream, &params->result, AUDCLNT_E_INVALID_SIZE);
+
+    if(stream->getbuf_last >= 0)
+        buffer = stream->local_buffer + stream->fmt->nBlockAlign *
+          ((stream->lcl_offs_frames + stream->held_frames) % stream->bufsize_frames);
+    else
+        buffer = stream->tmp_buffer;
+
+    if(flags & AUDCLNT_BUFFERFLAGS_SILENT)
+        silence_buffer(stream, buffer, written_frames);
+
+    if(stream->getbuf_last < 0)
+        null_wrap_buffer(stream, buffer, written_frames);
+
+    stream->held_frames += written_frames;
+    stream->written_frames += written_frames;
+    stream->getbuf_last = 0;
+
+    /* Time from waking the client up to it handing data back, i.e. how long
+     * the application took to mix a period. */
+    if(stats->signal_time){
+        response = get_time() - stats->signal_time;
+        if(!stats->responses || response < stats->response_min)
+            stats->response_min = response;
+        if(!stats->responses || response > stats->response_max)
+            stats->response_max = response;
+        stats->response_total += response;
+        ++stats->responses;
+        stats->signal_time = 0;
+    }
+
+    return null_unlock_result(stream, &params->result, S_OK);
+}
+
+static NTSTATUS null_get_capture_buffer(void *args)
+{
+    struct get_capture_buffer_params *params = args;
+    struct null_stream *stream = handle_get_stream(params->stream);
+    UINT64 *devpos = params->devpos, *qpcpos = params->qpcpos;
+    UINT32 *frames = params->frames;
+    UINT *flags = params->flags;
+    BYTE **data = params->data;
+    SIZE_T size;
+
+    null_lock(stream);
+
+    if(stream->getbuf_last)
+        return null_unlock_result(stream, &params->result, AUDCLNT_E_OUT_OF_ORDER);
+
+    if(stream->held_frames < stream->period_frames){
+        *frames = 0;
+        return null_unlock_result(stream, &params->result, AUDCLNT_S_BUFFER_EMPTY);
+    }
+
+    *flags = AUDCLNT_BUFFERFLAGS_SILENT;
+
+    *frames = stream->period_frames;
+
+    if(stream->lcl_offs_frames + *frames > stream->bufsize_frames){
+        if(stream->tmp_buffer_frames < *frames){
+            if(stream->tmp_buffer){
+                size = 0;
+                NtFreeVirtualMemory(GetCurrentProcess(), (void **)&stream->tmp_buffer, &size, MEM_RELEASE);
+                stream->tmp_buffer = NULL;
+            }
+            size = *frames * stream->fmt->nBlockAlign;
+            if(NtAllocateVirtualMemory(GetCurrentProcess(), (void **)&stream->tmp_buffer, zero_bits,
+                                       &size, MEM_COMMIT, PAGE_READWRITE)){
+                stream->tmp_buffer_frames = 0;
+                return null_unlock_result(stream, &params->result, E_OUTOFMEMORY);
+            }
+            stream->tmp_buffer_frames = *frames;
+        }
+
+        /* capture data is always silence, no need to copy it */
+        *data = stream->tmp_buffer;
+        silence_buffer(stream, *data, *frames);
+    }else
+        *data = stream->local_buffer +
+            stream->lcl_offs_frames * stream->fmt->nBlockAlign;
+
+    stream->getbuf_last = *frames;
+
+    if(devpos)
+       *devpos = stream->written_frames;
+    if(qpcpos)
+        *qpcpos = get_time();
+
+    return null_unlock_result(stream, &params->result, *frames ? S_OK : AUDCLNT_S_BUFFER_EMPTY);
+}
+
+static NTSTATUS null_release_capture_buffer(void *args)
+{
+    struct release_capture_buffer_params *params = args;
+    struct null_stream *stream = handle_get_stream(params->stream);
+    UINT32 done = params->done;
+
+    null_lock(stream);
+
+    if(!done){
+        stream->getbuf_last = 0;
+        return null_unlock_result(stream, &params->result, S_OK);
+    }
+
+    if(!stream->getbuf_last)
+        return null_unlock_result(stream, &params->result, AUDCLNT_E_OUT_OF_ORDER);
+
+    if(stream->getbuf_last != done)
+        return null_unlock_result(stream, &params->result, AUDCLNT_E_INVALID_SIZE);
+
+    stream->written_frames += done;
+    stream->held_frames -= done;
+    stream->lcl_offs_frames += done;
+    stream->lcl_offs_frames %= stream->bufsize_frames;
+    stream->getbuf_last = 0;
+
+    return null_unlock_result(stream, &params->result, S_OK);
+}
+
+static NTSTATUS null_is_format_supported(void *args)
+{
+    struct is_format_supported_params *params = args;
+
+    params->result = S_OK;
+
+    if(!params->fmt_in || (params->share == AUDCLNT_SHAREMODE_SHARED && !params->fmt_out))
+        params->result = E_POINTER;
+    else if(params->share != AUDCLNT_SHAREMODE_SHARED && params->share != AUDCLNT_SHAREMODE_EXCLUSIVE)
+        params->result = E_INVALIDARG;
+    else if(params->fmt_in->wFormatTag == WAVE_FORMAT_EXTENSIBLE &&
+            params->fmt_in->cbSize < sizeof(WAVEFORMATEXTENSIBLE) - sizeof(WAVEFORMATEX))
+        params->result = E_INVALIDARG;
+    if(FAILED(params->result))
+        return STATUS_SUCCESS;
+
+    params->result = check_format(params->share, params->fmt_in, params->fmt_out);
+
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS null_get_mix_format(void *args)
+{
+    struct get_mix_format_params *params = args;
+    WAVEFORMATEXTENSIBLE *fmt = params->fmt;
+
+    if(params->flow != eRender && params->flow != eCapture){
+        params->result = E_UNEXPECTED;
+        return STATUS_SUCCESS;
+    }
+
+    fmt->Format.wFormatTag = WAVE_FORMAT_EXTENSIBLE;
+    fmt->Format.wBitsPerSample = 32;
+    fmt->SubFormat = KSDATAFORMAT_SUBTYPE_IEEE_FLOAT;
+    fmt->Format.nChannels = config.channels;
+    fmt->Format.nSamplesPerSec = config.sample_rate;
+    fmt->dwChannelMask = get_channel_mask(fmt->Format.nChannels);
+
+    fmt->Format.nBlockAlign = (fmt->Format.wBitsPerSample *
+            fmt->Format.nChannels) / 8;
+    fmt->Format.nAvgBytesPerSec = fmt->Format.nSamplesPerSec *
+        fmt->Format.nBlockAlign;
+
+    fmt->Samples.wValidBitsPerSample = fmt->Format.wBitsPerSample;
+    fmt->Format.cbSize = sizeof(WAVEFORMATEXTENSIBLE) - sizeof(WAVEFORMATEX);
+
+    params->result = S_OK;
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS null_get_device_period(void *args)
+{
+    struct get_device_period_params *params = args;
+
+    if (params->def_period)
+        *params->def_period = def_period;
+    if (params->min_period)
+        *params->min_period = min_period;
+
+    params->result = S_OK;
+
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS null_get_buffer_size(void *args)
+{
+    struct get_buffer_size_params *params = args;
+    struct null_stream *stream = handle_get_stream(params->stream);
+
+    null_lock(stream);
+
+    *params->frames = stream->bufsize_frames;
+
+    return null_unlock_result(stream, &params->result, S_OK);
+}
+
+static NTSTATUS null_get_latency(void *args)
+{
+    struct get_latency_params *params = args;
+    struct null_stream *stream = handle_get_stream(params->stream);
+
+    null_lock(stream);
+
+    /* there is no hardware behind us, data is consumed a period at a time */
+    *params->latency = stream->period;
+
+    return null_unlock_result(stream, &params->result, S_OK);
+}
+
+static NTSTATUS null_get_current_padding(void *args)
+{
+    struct get_current_padding_params *params = args;
+    struct null_stream *stream = handle_get_stream(params->stream);
+
+    null_lock(stream);
+
+    *params->padding = stream->held_frames;
+
+    return null_unlock_result(stream, &params->result, S_OK);
+}
+
+static NTSTATUS null_get_next_packet_size(void *args)
+{
+    struct get_next_packet_size_params *params = args;
+    struct null_stream *stream = handle_get_stream(params->stream);
+    UINT32 *frames = params->frames;
+
+    null_lock(stream);
+
+    *frames = stream->held_frames < stream->period_frames ? 0 : stream->period_frames;
+
+    return null_unlock_result(stream, &params->result, S_OK);
+}
+
+static NTSTATUS null_get_frequency(void *args)
+{
+    struct get_frequency_params *params = args;
+    struct null_stream *stream = handle_get_stream(params->stream);
+    UINT64 *freq = params->freq;
+
+    null_lock(stream);
+
+    if(stream->share == AUDCLNT_SHAREMODE_SHARED)
+        *freq = (UINT64)stream->fmt->nSamplesPerSec * stream->fmt->nBlockAlign;
+    else
+        *freq = stream->fmt->nSamplesPerSec;
+
+    return null_unlock_result(stream, &params->result, S_OK);
+}
+
+static NTSTATUS null_get_position(void *args)
+{
+    struct get_position_params *params = args;
+    struct null_stream *stream = handle_get_stream(params->stream);
+    UINT64 *pos = params->pos, *qpctime = params->qpctime;
+
+    null_lock(stream);
+
+    /* The device position follows the virtual clock, not the wall clock. */
+    if(params->device)
+        *pos = stream->stats.periods * stream->period_frames;
+    else if(stream->flow == eRender){
+        *pos = stream->written_frames - stream->held_frames;
+        if(*pos < stream->last_pos_frames)
+            *pos = stream->last_pos_frames;
+        stream->last_pos_frames = *pos;
+    }else
+        *pos = stream->written_frames + stream->held_frames;
+
+    TRACE("returning: %s\n", wine_dbgstr_longlong(*pos));
+    if(stream->share == AUDCLNT_SHAREMODE_SHARED)
+        *pos *= stream->fmt->nBlockAlign;
+
+    if(qpctime)
+        *qpctime = get_time();
+
+    return null_unlock_result(stream, &params->result, S_OK);
+}
+
+static NTSTATUS null_set_volumes(void *args)
+{
+    struct set_volumes_params *params = args;
+    struct null_stream *stream = handle_get_stream(params->stream);
+    UINT16 i;
+
+    if (params->master_volume) {
+        for (i = 0; i < stream->fmt->nChannels; ++i) {
+            if (params->master_volume * params->volumes[i] * params->session_volumes[i] != 1.0f) {
+                FIXME("Volume control is not implemented\n");
+                break;
+            }
+        }
+    }
+
+    null_lock(stream);
+    stream->mute = !params->master_volume;
+    null_unlock(stream);
+
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS null_set_event_handle(void *args)
+{
+    struct set_event_handle_params *params = args;
+    struct null_stream *stream = handle_get_stream(params->stream);
+
+    null_lock(stream);
+
+    if(!(stream->flags & AUDCLNT_STREAMFLAGS_EVENTCALLBACK))
+        return null_unlock_result(stream, &params->result, AUDCLNT_E_EVENTHANDLE_NOT_EXPECTED);
+
+    if (stream->event){
+        FIXME("called twice\n");
+        return null_unlock_result(stream, &params->result, HRESULT_FROM_WIN32(ERROR_INVALID_NAME));
+    }
+
+    stream->event = params->event;
+
+    return null_unlock_result(stream, &params->result, S_OK);
+}
+
+static NTSTATUS null_is_started(void *args)
+{
+    struct is_started_params *params = args;
+    struct null_stream *stream = handle_get_stream(params->stream);
+
+    null_lock(stream);
+
+    return null_unlock_result(stream, &params->result, stream->playing ? S_OK : S_FALSE);
+}
+
+static NTSTATUS null_get_prop_value(void *args)
+{
+    struct get_prop_value_params *params = args;
+
+    params->result = E_NOTIMPL;
+
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS null_midi_init(void *args)
+{
+    struct midi_init_params *params = args;
+
+    /* no MIDI devices */
+    *params->err = DRV_FAILURE;
+    return STATUS_SUCCESS;
+}
+
+const unixlib_entry_t __wine_unix_call_funcs[] =
+{
+    null_process_attach,
+    null_not_implemented,
+    null_main_loop,
+    null_get_endpoint_ids,
+    null_create_stream,
+    null_release_stream,
+    null_start,
+    null_stop,
+    null_reset,
+    null_timer_loop,
+    null_get_render_buffer,
+    null_release_render_buffer,
+    null_get_capture_buffer,
+    null_release_capture_buffer,
+    null_is_format_supported,
+    null_not_implemented,
+    null_get_mix_format,
+    null_get_device_period,
+    null_get_buffer_size,
+    null_get_latency,
+    null_get_current_padding,
+    null_get_next_packet_size,
+    null_get_frequency,
+    null_get_position,
+    null_set_volumes,
+    null_set_event_handle,
+    null_not_implemented,
+    null_test_connect,
+    null_is_started,
+    null_get_prop_value,
+    null_not_implemented,
+    null_midi_init,
+    null_not_implemented,
+    null_not_implemented,
+    null_not_implemented,
+    null_not_implemented,
+    null_not_implemented,
+};
+
+C_ASSERT(ARRAYSIZE(__wine_unix_call_funcs) == funcs_count);
+
+#ifdef _WIN64
+
+typedef UINT PTR32;
+
+static NTSTATUS null_wow64_test_connect(void *args)
+{
+    struct
+    {
+        PTR32 name;
+        enum driver_priority priority;
+    } *params32 = args;
+    struct test_connect_params params =
+    {
+        .name = ULongToPtr(params32->name),
+    };
+    null_test_connect(&params);
+    params32->priority = params.priority;
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS null_wow64_main_loop(void *args)
+{
+    struct
+    {
+        PTR32 event;
+    } *params32 = args;
+    struct main_loop_params params =
+    {
+        .event = ULongToHandle(params32->event)
+    };
+    return null_main_loop(&params);
+}
+
+static NTSTATUS null_wow64_get_endpoint_ids(void *args)
+{
+    struct
+    {
+        EDataFlow flow;
+        PTR32 endpoints;
+        unsigned int size;
+        HRESULT result;
+        unsigned int num;
+        unsigned int default_idx;
+    } *params32 = args;
+    struct get_endpoint_ids_params params =
+    {
+        .flow = params32->flow,
+        .endpoints = ULongToPtr(params32->endpoints),
+        .size = params32->size
+    };
+    null_get_endpoint_ids(&params);
+    params32->size = params.size;
+    params32->result = params.result;
+    params32->num = params.num;
+    params32->default_idx = params.default_idx;
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS null_wow64_create_stream(void *args)
+{
+    struct
+    {
+        PTR32 name;
+        PTR32 device;
+        EDataFlow flow;
+        AUDCLNT_SHAREMODE share;
+        UINT flags;
+        REFERENCE_TIME duration;
+        REFERENCE_TIME period;
+        PTR32 fmt;
+        HRESULT result;
+        PTR32 channel_count;
+        PTR32 stream;
+    } *params32 = args;
+    struct create_stream_params params =
+    {
+        .name = ULongToPtr(params32->name),
+        .device = ULongToPtr(params32->device),
+        .flow = params32->flow,
+        .share = params32->share,
+        .flags = params32->flags,
+        .duration = params32->duration,
+        .period = params32->period,
+        .fmt = ULongToPtr(params32->fmt),
+        .channel_count = ULongToPtr(params32->channel_count),
+        .stream = ULongToPtr(params32->stream)
+    };
+    null_create_stream(&params);
+    params32->result = params.result;
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS null_wow64_release_stream(void *args)
+{
+    struct
+    {
+        stream_handle stream;
+        PTR32 timer_thread;
+        HRESULT result;
+    } *params32 = args;
+    struct release_stream_params params =
+    {
+        .stream = params32->stream,
+        .timer_thread = ULongToHandle(params32->timer_thread)
+    };
+    null_release_stream(&params);
+    params32->result = params.result;
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS null_wow64_get_render_buffer(void *args)
+{
+    struct
+    {
+        stream_handle stream;
+        UINT32 frames;
+        HRESULT result;
+        PTR32 data;
+    } *params32 = args;
+    BYTE *data = NULL;
+    struct get_render_buffer_params params =
+    {
+        .stream = params32->stream,
+        .frames = params32->frames,
+        .data = &data
+    };
+    null_get_render_buffer(&params);
+    params32->result = params.result;
+    *(unsigned int *)ULongToPtr(params32->data) = PtrToUlong(data);
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS null_wow64_get_capture_buffer(void *args)
+{
+    struct
+    {
+        stream_handle stream;
+        HRESULT result;
+        PTR32 data;
+        PTR32 frames;
+        PTR32 flags;
+        PTR32 devpos;
+        PTR32 qpcpos;
+    } *params32 = args;
+    BYTE *data = NULL;
+    struct get_capture_buffer_params params =
+    {
+        .stream = params32->stream,
+        .data = &data,
+        .frames = ULongToPtr(params32->frames),
+        .flags = ULongToPtr(params32->flags),
+        .devpos = ULongToPtr(params32->devpos),
+        .qpcpos = ULongToPtr(params32->qpcpos)
+    };
+    null_get_capture_buffer(&params);
+    params32->result = params.result;
+    *(unsigned int *)ULongToPtr(params32->data) = PtrToUlong(data);
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS null_wow64_is_format_supported(void *args)
+{
+    struct
+    {
+        PTR32 device;
+        EDataFlow flow;
+        AUDCLNT_SHAREMODE share;
+        PTR32 fmt_in;
+        PTR32 fmt_out;
+        HRESULT result;
+    } *params32 = args;
+    struct is_format_supported_params params =
+    {
+        .device = ULongToPtr(params32->device),
+        .flow = params32->flow,
+        .share = params32->share,
+        .fmt_in = ULongToPtr(params32->fmt_in),
+        .fmt_out = ULongToPtr(params32->fmt_out)
+    };
+    null_is_format_supported(&params);
+    params32->result = params.result;
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS null_wow64_get_mix_format(void *args)
+{
+    struct
+    {
+        PTR32 device;
+        EDataFlow flow;
+        PTR32 fmt;
+        HRESULT result;
+    } *params32 = args;
+    struct get_mix_format_params params =
+    {
+        .device = ULongToPtr(params32->device),
+        .flow = params32->flow,
+        .fmt = ULongToPtr(params32->fmt)
+    };
+    null_get_mix_format(&params);
+    params32->result = params.result;
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS null_wow64_get_device_period(void *args)
+{
+    struct
+    {
+        PTR32 device;
+        EDataFlow flow;
+        HRESULT result;
+        PTR32 def_period;
+        PTR32 min_period;
+    } *params32 = args;
+    struct get_device_period_params params =
+    {
+        .device = ULongToPtr(params32->device),
+        .flow = params32->flow,
+        .def_period = ULongToPtr(params32->def_period),
+        .min_period = ULongToPtr(params32->min_period),
+    };
+    null_get_device_period(&params);
+    params32->result = params.result;
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS null_wow64_get_buffer_size(void *args)
+{
+    struct
+    {
+        stream_handle stream;
+        HRESULT result;
+        PTR32 frames;
+    } *params32 = args;
+    struct get_buffer_size_params params =
+    {
+        .stream = params32->stream,
+        .frames = ULongToPtr(params32->frames)
+    };
+    null_get_buffer_size(&params);
+    params32->result = params.result;
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS null_wow64_get_latency(void *args)
+{
+    struct
+    {
+        stream_handle stream;
+        HRESULT result;
+        PTR32 latency;
+    } *params32 = args;
+    struct get_latency_params params =
+    {
+        .stream = params32->stream,
+        .latency = ULongToPtr(params32->latency)
+    };
+    null_get_latency(&params);
+    params32->result = params.result;
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS null_wow64_get_current_padding(void *args)
+{
+    struct
+    {
+        stream_handle stream;
+        HRESULT result;
+        PTR32 padding;
+    } *params32 = args;
+    struct get_current_padding_params params =
+    {
+        .stream = params32->stream,
+        .padding = ULongToPtr(params32->padding)
+    };
+    null_get_current_padding(&params);
+    params32->result = params.result;
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS null_wow64_get_next_packet_size(void *args)
+{
+    struct
+    {
+        stream_handle stream;
+        HRESULT result;
+        PTR32 frames;
+    } *params32 = args;
+    struct get_next_packet_size_params params =
+    {
+        .stream = params32->stream,
+        .frames = ULongToPtr(params32->frames)
+    };
+    null_get_next_packet_size(&params);
+    params32->result = params.result;
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS null_wow64_get_frequency(void *args)
+{
+    struct
+    {
+        stream_handle stream;
+        HRESULT result;
+        PTR32 freq;
+    } *params32 = args;
+    struct get_frequency_params params =
+    {
+        .stream = params32->stream,
+        .freq = ULongToPtr(params32->freq)
+    };
+    null_get_frequency(&params);
+    params32->result = params.result;
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS null_wow64_get_position(void *args)
+{
+    struct
+    {
+        stream_handle stream;
+        BOOL device;
+        HRESULT result;
+        PTR32 pos;
+        PTR32 qpctime;
+    } *params32 = args;
+    struct get_position_params params =
+    {
+        .stream = params32->stream,
+        .device = params32->device,
+        .pos = ULongToPtr(params32->pos),
+        .qpctime = ULongToPtr(params32->qpctime)
+    };
+    null_get_position(&params);
+    params32->result = params.result;
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS null_wow64_set_volumes(void *args)
+{
+    struct
+    {
+        stream_handle stream;
+        float master_volume;
+        PTR32 volumes;
+        PTR32 session_volumes;
+    } *params32 = args;
+    struct set_volumes_params params =
+    {
+        .stream = params32->stream,
+        .master_volume = params32->master_volume,
+        .volumes = ULongToPtr(params32->volumes),
+        .session_volumes = ULongToPtr(params32->session_volumes),
+    };
+    return null_set_volumes(&params);
+}
+
+static NTSTATUS null_wow64_set_event_handle(void *args)
+{
+    struct
+    {
+        stream_handle stream;
+        PTR32 event;
+        HRESULT result;
+    } *params32 = args;
+    struct set_event_handle_params params =
+    {
+        .stream = params32->stream,
+        .event = ULongToHandle(params32->event)
+    };
+    null_set_event_handle(&params);
+    params32->result = params.result;
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS null_wow64_get_prop_value(void *args)
+{
+    struct
+    {
+        PTR32 device;
+        EDataFlow flow;
+        PTR32 guid;
+        PTR32 prop;
+        HRESULT result;
+        PTR32 value;
+        PTR32 buffer; /* caller allocated buffer to hold value's strings */
+        PTR32 buffer_size;
+    } *params32 = args;
+
+    params32->result = E_NOTIMPL;
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS null_wow64_midi_init(void *args)
+{
+    struct
+    {
+        PTR32 err;
+    } *params32 = args;
+    struct midi_init_params params =
+    {
+        .err = ULongToPtr(params32->err)
+    };
+    return null_midi_init(&params);
+}
+
+const unixlib_entry_t __wine_unix_call_wow64_funcs[] =
+{
+    null_process_attach,
+    null_not_implemented,
+    null_wow64_main_loop,
+    null_wow64_get_endpoint_ids,
+    null_wow64_create_stream,
+    null_wow64_release_stream,
+    null_start,
+    null_stop,
+    null_reset,
+    null_timer_loop,
+    null_wow64_get_render_buffer,
+    null_release_render_buffer,
+    null_wow64_get_capture_buffer,
+    null_release_capture_buffer,
+    null_wow64_is_format_supported,
+    null_not_implemented,
+    null_wow64_get_mix_format,
+    null_wow64_get_device_period,
+    null_wow64_get_buffer_size,
+    null_wow64_get_latency,
+    null_wow64_get_current_padding,
+    null_wow64_get_next_packet_size,
+    null_wow64_get_frequency,
+    null_wow64_get_position,
+    null_wow64_set_volumes,
+    null_wow64_set_event_handle,
+    null_not_implemented,
+    null_wow64_test_connect,
+    null_is_started,
+    null_wow64_get_prop_value,
+    null_not_implemented,
+    null_wow64_midi_init,
+    null_not_implemented,
+    null_not_implemented,
+    null_not_implemented,
+    null_not_implemented,
+    null_not_implemented,
+};
+
+C_ASSERT(ARRAYSIZE(__wine_unix_call_wow64_funcs) == funcs_count);
+
+#endif /* _WIN64 */
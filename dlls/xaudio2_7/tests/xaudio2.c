@@ -16,6 +16,7 @@
  * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
  */
 
+#include <stdio.h>
 #include <windows.h>
 #include <math.h>
 #include <stdbool.h>
@@ -34,8 +35,12 @@
 #include "xapo.h"
 #include "xapofx.h"
 #include "mmsystem.h"
+#include "mmreg.h"
 #include "ks.h"
 #include "ksmedia.h"
+#if XAUDIO2_VER >= 8
+#include "x3daudio.h"
+#endif
 
 static const GUID IID_IXAudio27 =            {0x8bcf1f58, 0x9fe7, 0x4583, {0x8a, 0xc6, 0xe2, 0xad, 0xc4, 0x65, 0xc8, 0xbb}};
 static const GUID IID_IXAudio28 =            {0x60d8dac8, 0x5aa1, 0x4e8e, {0xb5, 0x97, 0x2f, 0x5e, 0x28, 0x83, 0xd4, 0x84}};
@@ -1279,6 +1284,305 @@ static void test_setchannelvolumes(IXAudio2 *xa)
     IXAudio2MasteringVoice_DestroyVoice(master);
 }
 
+#define MIX_VOICES 64
+#define MIX_FRAMES 4410
+
+/* records the first frames of non-silent input of the voice it's attached to */
+struct capture_xapo
+{
+    IXAPO IXAPO_iface;
+    LONG ref;
+    UINT32 channels;
+    UINT32 frames;
+    float data[MIX_FRAMES * 2];
+    HANDLE done;
+};
+
+static inline struct capture_xapo *impl_from_IXAPO(IXAPO *iface)
+{
+    return CONTAINING_RECORD(iface, struct capture_xapo, IXAPO_iface);
+}
+
+static HRESULT WINAPI capture_QueryInterface(IXAPO *iface, REFIID riid, void **out)
+{
+    if (IsEqualGUID(riid, &IID_IUnknown) || IsEqualGUID(riid, &IID_IXAPO) || IsEqualGUID(riid, &IID_IXAPO27))
+    {
+        *out = iface;
+        IXAPO_AddRef(iface);
+        return S_OK;
+    }
+    *out = NULL;
+    return E_NOINTERFACE;
+}
+
+static ULONG WINAPI capture_AddRef(IXAPO *iface)
+{
+    struct capture_xapo *capture = impl_from_IXAPO(iface);
+    return InterlockedIncrement(&capture->ref);
+}
+
+static ULONG WINAPI capture_Release(IXAPO *iface)
+{
+    struct capture_xapo *capture = impl_from_IXAPO(iface);
+    return InterlockedDecrement(&capture->ref);
+}
+
+static HRESULT WINAPI capture_GetRegistrationProperties(IXAPO *iface, XAPO_REGISTRATION_PROPERTIES **props)
+{
+    if (!(*props = CoTaskMemAlloc(sizeof(**props)))) return E_OUTOFMEMORY;
+    memset(*props, 0, sizeof(**props));
+    wcscpy((*props)->FriendlyName, L"capture");
+    (*props)->MajorVersion = 1;
+    (*props)->Flags = XAPO_FLAG_CHANNELS_MUST_MATCH | XAPO_FLAG_FRAMERATE_MUST_MATCH
+            | XAPO_FLAG_BITSPERSAMPLE_MUST_MATCH | XAPO_FLAG_BUFFERCOUNT_MUST_MATCH
+            | XAPO_FLAG_INPLACE_SUPPORTED | XAPO_FLAG_INPLACE_REQUIRED;
+    (*props)->MinInputBufferCount = (*props)->MaxInputBufferCount = 1;
+    (*props)->MinOutputBufferCount = (*props)->MaxOutputBufferCount = 1;
+    return S_OK;
+}
+
+static HRESULT WINAPI capture_IsInputFormatSupported(IXAPO *iface, const WAVEFORMATEX *output_fmt,
+        const WAVEFORMATEX *input_fmt, WAVEFORMATEX **supported_fmt)
+{
+    return S_OK;
+}
+
+static HRESULT WINAPI capture_IsOutputFormatSupported(IXAPO *iface, const WAVEFORMATEX *input_fmt,
+        const WAVEFORMATEX *output_fmt, WAVEFORMATEX **supported_fmt)
+{
+    return S_OK;
+}
+
+static HRESULT WINAPI capture_Initialize(IXAPO *iface, const void *data, UINT32 data_len)
+{
+    return S_OK;
+}
+
+static void WINAPI capture_Reset(IXAPO *iface)
+{
+}
+
+static HRESULT WINAPI capture_LockForProcess(IXAPO *iface, UINT32 in_params_count,
+        const XAPO_LOCKFORPROCESS_BUFFER_PARAMETERS *in_params, UINT32 out_params_count,
+        const XAPO_LOCKFORPROCESS_BUFFER_PARAMETERS *out_params)
+{
+    struct capture_xapo *capture = impl_from_IXAPO(iface);
+
+    ok(in_params_count == 1, "Got %u input buffers.\n", in_params_count);
+    ok(in_params[0].pFormat->nChannels == 2, "Got %u channels.\n", in_params[0].pFormat->nChannels);
+    capture->channels = in_params[0].pFormat->nChannels;
+    return S_OK;
+}
+
+static void WINAPI capture_UnlockForProcess(IXAPO *iface)
+{
+}
+
+static void WINAPI capture_Process(IXAPO *iface, UINT32 in_params_count,
+        const XAPO_PROCESS_BUFFER_PARAMETERS *in_params, UINT32 out_params_count,
+        XAPO_PROCESS_BUFFER_PARAMETERS *out_params, BOOL enabled)
+{
+    struct capture_xapo *capture = impl_from_IXAPO(iface);
+    const float *data = in_params[0].pBuffer;
+    UINT32 i, count;
+
+    if (out_params_count)
+    {
+        out_params[0].BufferFlags = in_params[0].BufferFlags;
+        out_params[0].ValidFrameCount = in_params[0].ValidFrameCount;
+    }
+    if (capture->channels != 2 || capture->frames == MIX_FRAMES) return;
+
+    count = in_params[0].ValidFrameCount * capture->channels;
+    if (!capture->frames)
+    {
+        /* all the voices are started in the same pass, start recording there */
+        if (in_params[0].BufferFlags != XAPO_BUFFER_VALID) return;
+        for (i = 0; i < count; ++i) if (data[i]) break;
+        if (i == count) return;
+    }
+
+    count = min(in_params[0].ValidFrameCount, MIX_FRAMES - capture->frames);
+    if (in_params[0].BufferFlags == XAPO_BUFFER_VALID)
+        memcpy(capture->data + capture->frames * 2, data, count * 2 * sizeof(float));
+    else
+        memset(capture->data + capture->frames * 2, 0, count * 2 * sizeof(float));
+    if ((capture->frames += count) == MIX_FRAMES) SetEvent(capture->done);
+}
+
+static UINT32 WINAPI capture_CalcInputFrames(IXAPO *iface, UINT32 output_frames)
+{
+    return output_frames;
+}
+
+static UINT32 WINAPI capture_CalcOutputFrames(IXAPO *iface, UINT32 input_frames)
+{
+    return input_frames;
+}
+
+static const IXAPOVtbl capture_vtbl =
+{
+    capture_QueryInterface,
+    capture_AddRef,
+    capture_Release,
+    capture_GetRegistrationProperties,
+    capture_IsInputFormatSupported,
+    capture_IsOutputFormatSupported,
+    capture_Initialize,
+    capture_Reset,
+    capture_LockForProcess,
+    capture_UnlockForProcess,
+    capture_Process,
+    capture_CalcInputFrames,
+    capture_CalcOutputFrames,
+};
+
+/* Mixes enough source voices for the FAudio mixing thread pool to be used,
+ * at different rates, volumes and formats, through two submix stages, and
+ * records the result. The 8 channel group submix makes the sources go
+ * through the 1in_8out and 2in_8out kernels, and itself through the
+ * generic one. The MSADPCM buffers are end of stream buffers shared by
+ * several voices, as one-shot sounds would be. */
+static void render_mix(IXAudio2 *xa, struct capture_xapo *capture)
+{
+    static const ADPCMCOEFSET coefs[] =
+        {{256, 0}, {512, -256}, {0, 0}, {192, 64}, {240, 0}, {460, -208}, {392, -232}};
+    static const UINT32 rates[] = {22050, 44100, 48000};
+    IXAudio2SourceVoice *voices[MIX_VOICES];
+    XAUDIO2_SEND_DESCRIPTOR send_desc = {0};
+    XAUDIO2_VOICE_SENDS sends = {1, &send_desc};
+    XAUDIO2_EFFECT_DESCRIPTOR effect = {0};
+    XAUDIO2_EFFECT_CHAIN chain = {1, &effect};
+    IXAudio2SubmixVoice *final, *group;
+    IXAudio2MasteringVoice *master;
+    XAUDIO2_BUFFER buffers[3][ARRAY_SIZE(rates)];
+    WAVEFORMATEX float_fmt, pcm_fmt, *fmt[3];
+    struct
+    {
+        ADPCMWAVEFORMAT fmt;
+        ADPCMCOEFSET coefs[ARRAY_SIZE(coefs) - 1];
+    } adpcm_fmt;
+    unsigned int i, j, k, seed = 1;
+    float *samples;
+    BYTE *adpcm;
+    short *pcm;
+    HRESULT hr;
+    DWORD ret;
+
+    capture->IXAPO_iface.lpVtbl = &capture_vtbl;
+    capture->ref = 1;
+    capture->done = CreateEventW(NULL, TRUE, FALSE, NULL);
+
+    hr = create_mastering_voice(xa, 2, &master);
+    ok(hr == S_OK, "CreateMasteringVoice failed: %08lx\n", hr);
+
+    effect.pEffect = (IUnknown *)&capture->IXAPO_iface;
+    effect.InitialState = TRUE;
+    effect.OutputChannels = 2;
+    hr = IXAudio2_CreateSubmixVoice(xa, &final, 2, 44100, 0, 1, NULL, &chain);
+    ok(hr == S_OK, "CreateSubmixVoice failed: %08lx\n", hr);
+    send_desc.pOutputVoice = (IXAudio2Voice *)final;
+    hr = IXAudio2_CreateSubmixVoice(xa, &group, 8, 44100, 0, 0, &sends, NULL);
+    ok(hr == S_OK, "CreateSubmixVoice failed: %08lx\n", hr);
+
+    fmt[0] = &float_fmt;
+    fmt[0]->wFormatTag = WAVE_FORMAT_IEEE_FLOAT;
+    fmt[0]->nChannels = 2;
+    fmt[0]->wBitsPerSample = 32;
+    fmt[0]->nBlockAlign = fmt[0]->nChannels * fmt[0]->wBitsPerSample / 8;
+    fmt[0]->cbSize = 0;
+    fmt[1] = &pcm_fmt;
+    fmt[1]->wFormatTag = WAVE_FORMAT_PCM;
+    fmt[1]->nChannels = 1;
+    fmt[1]->wBitsPerSample = 16;
+    fmt[1]->nBlockAlign = fmt[1]->nChannels * fmt[1]->wBitsPerSample / 8;
+    fmt[1]->cbSize = 0;
+    fmt[2] = &adpcm_fmt.fmt.wfx;
+    fmt[2]->wFormatTag = WAVE_FORMAT_ADPCM;
+    fmt[2]->nChannels = 1;
+    fmt[2]->wBitsPerSample = 4;
+    fmt[2]->nBlockAlign = 262;
+    fmt[2]->cbSize = sizeof(adpcm_fmt) - sizeof(WAVEFORMATEX);
+    adpcm_fmt.fmt.wSamplesPerBlock = 512;
+    adpcm_fmt.fmt.wNumCoef = ARRAY_SIZE(coefs);
+    memcpy(adpcm_fmt.fmt.aCoef, coefs, sizeof(coefs));
+
+    for (i = 0; i < ARRAY_SIZE(rates); ++i)
+    {
+        memset(&buffers[0][i], 0, sizeof(buffers[0][i]));
+        buffers[0][i].AudioBytes = rates[i] / 10 * fmt[0]->nBlockAlign;
+        buffers[0][i].LoopCount = XAUDIO2_LOOP_INFINITE;
+        samples = HeapAlloc(GetProcessHeap(), 0, buffers[0][i].AudioBytes);
+        for (j = 0; j < rates[i] / 10; ++j)
+        {
+            samples[2 * j] = sinf(j * (200 + 30 * i) * 2 * M_PI / rates[i]);
+            samples[2 * j + 1] = cosf(j * (310 + 20 * i) * 2 * M_PI / rates[i]);
+        }
+        buffers[0][i].pAudioData = (BYTE *)samples;
+
+        buffers[1][i] = buffers[0][i];
+        buffers[1][i].AudioBytes = rates[i] / 10 * fmt[1]->nBlockAlign;
+        pcm = HeapAlloc(GetProcessHeap(), 0, buffers[1][i].AudioBytes);
+        for (j = 0; j < rates[i] / 10; ++j)
+            pcm[j] = 32767 * sinf(j * (450 + 40 * i) * 2 * M_PI / rates[i]);
+        buffers[1][i].pAudioData = (BYTE *)pcm;
+
+        /* Any nibbles decode to something, this doesn't need to be a real encoding. */
+        buffers[2][i] = buffers[0][i];
+        buffers[2][i].Flags = XAUDIO2_END_OF_STREAM;
+        buffers[2][i].AudioBytes = (rates[i] / 10 / 512 + 1) * fmt[2]->nBlockAlign;
+        adpcm = HeapAlloc(GetProcessHeap(), 0, buffers[2][i].AudioBytes);
+        for (j = 0; j < buffers[2][i].AudioBytes; j += fmt[2]->nBlockAlign)
+        {
+            /* predictor index, 16-bit delta, then two 16-bit samples */
+            memset(&adpcm[j], 0, 7);
+            adpcm[j] = j / fmt[2]->nBlockAlign % ARRAY_SIZE(coefs);
+            adpcm[j + 1] = 64;
+            for (k = 7; k < fmt[2]->nBlockAlign; ++k)
+                adpcm[j + k] = (seed = seed * 1103515245 + 12345) >> 16;
+        }
+        buffers[2][i].pAudioData = adpcm;
+    }
+
+    for (i = 0; i < MIX_VOICES; ++i)
+    {
+        j = i / 2 % ARRAY_SIZE(fmt);
+        fmt[j]->nSamplesPerSec = rates[i % ARRAY_SIZE(rates)];
+        if (fmt[j]->wFormatTag == WAVE_FORMAT_ADPCM)
+            fmt[j]->nAvgBytesPerSec = fmt[j]->nSamplesPerSec * fmt[j]->nBlockAlign / adpcm_fmt.fmt.wSamplesPerBlock;
+        else
+            fmt[j]->nAvgBytesPerSec = fmt[j]->nSamplesPerSec * fmt[j]->nBlockAlign;
+        send_desc.pOutputVoice = (IXAudio2Voice *)(i % 2 ? group : final);
+        hr = IXAudio2_CreateSourceVoice(xa, &voices[i], fmt[j], 0, 2.f, NULL, &sends, NULL);
+        ok(hr == S_OK, "CreateSourceVoice failed: %08lx\n", hr);
+        hr = IXAudio2SourceVoice_SetVolume(voices[i], 1.f / (i + 1), XAUDIO2_COMMIT_NOW);
+        ok(hr == S_OK, "SetVolume failed: %08lx\n", hr);
+        hr = IXAudio2SourceVoice_SetFrequencyRatio(voices[i], 1.f + i / 256.f, XAUDIO2_COMMIT_NOW);
+        ok(hr == S_OK, "SetFrequencyRatio failed: %08lx\n", hr);
+        hr = IXAudio2SourceVoice_SubmitSourceBuffer(voices[i], &buffers[j][i % ARRAY_SIZE(rates)], NULL);
+        ok(hr == S_OK, "SubmitSourceBuffer failed: %08lx\n", hr);
+        hr = IXAudio2SourceVoice_Start(voices[i], 0, 1);
+        ok(hr == S_OK, "Start failed: %08lx\n", hr);
+    }
+    hr = IXAudio2_CommitChanges(xa, 1);
+    ok(hr == S_OK, "CommitChanges failed: %08lx\n", hr);
+
+    ret = WaitForSingleObject(capture->done, 5000);
+    ok(!ret, "Got %lu recorded frames.\n", capture->frames);
+
+    for (i = 0; i < MIX_VOICES; ++i)
+        IXAudio2SourceVoice_DestroyVoice(voices[i]);
+    IXAudio2SubmixVoice_DestroyVoice(group);
+    IXAudio2SubmixVoice_DestroyVoice(final);
+    IXAudio2MasteringVoice_DestroyVoice(master);
+    for (i = 0; i < ARRAY_SIZE(rates); ++i)
+    {
+        for (j = 0; j < ARRAY_SIZE(buffers); ++j)
+            HeapFree(GetProcessHeap(), 0, (void *)buffers[j][i].pAudioData);
+    }
+    CloseHandle(capture->done);
+}
+
 static UINT32 check_has_devices(IXAudio2 *xa)
 {
     HRESULT hr;
@@ -1293,14 +1597,777 @@ static UINT32 check_has_devices(IXAudio2 *xa)
     return 1;
 }
 
+static void test_mix_child(const char *file)
+{
+    struct capture_xapo *capture;
+    IXAudio2 *xa;
+    HANDLE out;
+    DWORD size;
+
+    if (!(xa = create_xaudio2()))
+        return;
+
+    if (check_has_devices(xa))
+    {
+        capture = calloc(1, sizeof(*capture));
+        render_mix(xa, capture);
+        out = CreateFileA(file, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, 0, NULL);
+        ok(out != INVALID_HANDLE_VALUE, "CreateFile failed, error %lu.\n", GetLastError());
+        WriteFile(out, capture->data, capture->frames * 2 * sizeof(float), &size, NULL);
+        CloseHandle(out);
+        free(capture);
+    }
+
+    IXAudio2_Release(xa);
+}
+
+static BOOL run_child(const char *var, const char *value, const char *args)
+{
+    PROCESS_INFORMATION pi;
+    STARTUPINFOA si = {0};
+    char cmdline[MAX_PATH * 3];
+    char **argv;
+    BOOL ret;
+
+    /* FAudio reads its settings when the engine is created, and from the CRT
+     * environment, which is only set up from the process environment */
+    winetest_get_mainargs(&argv);
+    sprintf(cmdline, "\"%s\" %s %s", argv[0], argv[1], args);
+    si.cb = sizeof(si);
+    SetEnvironmentVariableA(var, value);
+    ret = CreateProcessA(NULL, cmdline, NULL, NULL, FALSE, 0, NULL, NULL, &si, &pi);
+    SetEnvironmentVariableA(var, NULL);
+    ok(ret, "CreateProcess failed, error %lu.\n", GetLastError());
+    if (!ret) return FALSE;
+    wait_child_process(&pi);
+    CloseHandle(pi.hProcess);
+    CloseHandle(pi.hThread);
+    return TRUE;
+}
+
+static DWORD run_mix_child(const char *var, const char *value, const char *file, float *data)
+{
+    char args[MAX_PATH + 8];
+    DWORD size = 0;
+    HANDLE in;
+
+    sprintf(args, "mix \"%s\"", file);
+    if (!run_child(var, value, args)) return 0;
+
+    in = CreateFileA(file, GENERIC_READ, 0, NULL, OPEN_EXISTING, FILE_FLAG_DELETE_ON_CLOSE, NULL);
+    if (in == INVALID_HANDLE_VALUE) return 0;
+    ReadFile(in, data, MIX_FRAMES * 2 * sizeof(float), &size, NULL);
+    CloseHandle(in);
+    return size / (2 * sizeof(float));
+}
+
+static void test_mix_threads(void)
+{
+    char path[MAX_PATH], file[MAX_PATH];
+    float *serial, *parallel;
+    DWORD serial_frames, parallel_frames, i;
+
+    serial = calloc(MIX_FRAMES * 2, sizeof(float));
+    parallel = calloc(MIX_FRAMES * 2, sizeof(float));
+
+    GetTempPathA(ARRAY_SIZE(path), path);
+    GetTempFileNameA(path, "mix", 0, file);
+    serial_frames = run_mix_child("FAUDIO_MIX_THREADS", "0", file, serial);
+    GetTempFileNameA(path, "mix", 0, file);
+    parallel_frames = run_mix_child("FAUDIO_MIX_THREADS", "4", file, parallel);
+
+    ok(serial_frames == MIX_FRAMES, "Got %lu serial frames.\n", serial_frames);
+    ok(parallel_frames == MIX_FRAMES, "Got %lu parallel frames.\n", parallel_frames);
+    for (i = 0; i < MIX_FRAMES * 2; ++i) if (serial[i]) break;
+    ok(i < MIX_FRAMES * 2, "Got silent output.\n");
+
+    /* the parallel mixer mixes every destination in the serial order */
+    for (i = 0; i < MIX_FRAMES * 2; ++i) if (serial[i] != parallel[i]) break;
+    ok(i == MIX_FRAMES * 2, "Output differs at sample %lu, %.8e vs %.8e.\n", i,
+            i < MIX_FRAMES * 2 ? serial[i] : 0.f, i < MIX_FRAMES * 2 ? parallel[i] : 0.f);
+
+    free(serial);
+    free(parallel);
+}
+
+static void test_mix_simd(void)
+{
+    char path[MAX_PATH], file[MAX_PATH];
+    DWORD simd_frames, scalar_frames, i;
+    float *simd, *scalar;
+
+    simd = calloc(MIX_FRAMES * 2, sizeof(float));
+    scalar = calloc(MIX_FRAMES * 2, sizeof(float));
+
+    GetTempPathA(ARRAY_SIZE(path), path);
+    GetTempFileNameA(path, "mix", 0, file);
+    simd_frames = run_mix_child("FAUDIO_SIMD", NULL, file, simd);
+    GetTempFileNameA(path, "mix", 0, file);
+    scalar_frames = run_mix_child("FAUDIO_SIMD", "none", file, scalar);
+
+    ok(simd_frames == MIX_FRAMES, "Got %lu SIMD frames.\n", simd_frames);
+    ok(scalar_frames == MIX_FRAMES, "Got %lu scalar frames.\n", scalar_frames);
+
+    /* The SIMD resamplers step in single precision and the SIMD generic
+     * mixer sums its inputs in a different order, everything else matches
+     * the scalar code exactly. */
+    for (i = 0; i < MIX_FRAMES * 2; ++i) if (fabsf(simd[i] - scalar[i]) > 1e-4f) break;
+    ok(i == MIX_FRAMES * 2, "Output differs at sample %lu, %.8e vs %.8e.\n", i,
+            i < MIX_FRAMES * 2 ? simd[i] : 0.f, i < MIX_FRAMES * 2 ? scalar[i] : 0.f);
+
+    free(simd);
+    free(scalar);
+}
+
+static void test_mix_cache(void)
+{
+    char path[MAX_PATH], file[MAX_PATH];
+    DWORD cached_frames, decoded_frames, i;
+    float *cached, *decoded;
+
+    cached = calloc(MIX_FRAMES * 2, sizeof(float));
+    decoded = calloc(MIX_FRAMES * 2, sizeof(float));
+
+    GetTempPathA(ARRAY_SIZE(path), path);
+    GetTempFileNameA(path, "mix", 0, file);
+    decoded_frames = run_mix_child("FAUDIO_DECODE_CACHE", NULL, file, decoded);
+    GetTempFileNameA(path, "mix", 0, file);
+    cached_frames = run_mix_child("FAUDIO_DECODE_CACHE", "16", file, cached);
+
+    ok(decoded_frames == MIX_FRAMES, "Got %lu decoded frames.\n", decoded_frames);
+    ok(cached_frames == MIX_FRAMES, "Got %lu cached frames.\n", cached_frames);
+
+    /* FAudio mixes buffers from its PCM cache once they are decoded ahead,
+     * which must not make any difference. */
+    for (i = 0; i < MIX_FRAMES * 2; ++i) if (decoded[i] != cached[i]) break;
+    ok(i == MIX_FRAMES * 2, "Output differs at sample %lu, %.8e vs %.8e.\n", i,
+            i < MIX_FRAMES * 2 ? decoded[i] : 0.f, i < MIX_FRAMES * 2 ? cached[i] : 0.f);
+
+    free(cached);
+    free(decoded);
+}
+
+#define BENCH_VOICES 32
+#define BENCH_WARMUP_PASSES 2
+#define BENCH_PASSES 10
+/* XAudio2 processes 10 ms per pass, this is the engine rate of
+ * create_mastering_voice(). */
+#define BENCH_PASS_FRAMES 441
+
+/* times the processing passes once a workload's voices are playing */
+struct bench_callback
+{
+    IXAudio2EngineCallback IXAudio2EngineCallback_iface;
+    LONG active, passes;
+    LARGE_INTEGER start;
+    LONGLONG ticks;
+    HANDLE done;
+};
+
+static inline struct bench_callback *impl_from_IXAudio2EngineCallback(IXAudio2EngineCallback *iface)
+{
+    return CONTAINING_RECORD(iface, struct bench_callback, IXAudio2EngineCallback_iface);
+}
+
+static void WINAPI bench_OnProcessingPassStart(IXAudio2EngineCallback *iface)
+{
+    struct bench_callback *cb = impl_from_IXAudio2EngineCallback(iface);
+
+    QueryPerformanceCounter(&cb->start);
+}
+
+static void WINAPI bench_OnProcessingPassEnd(IXAudio2EngineCallback *iface)
+{
+    struct bench_callback *cb = impl_from_IXAudio2EngineCallback(iface);
+    LARGE_INTEGER end;
+
+    QueryPerformanceCounter(&end);
+    if (!cb->active || cb->passes == BENCH_WARMUP_PASSES + BENCH_PASSES) return;
+    if (++cb->passes > BENCH_WARMUP_PASSES) cb->ticks += end.QuadPart - cb->start.QuadPart;
+    if (cb->passes == BENCH_WARMUP_PASSES + BENCH_PASSES) SetEvent(cb->done);
+}
+
+static void WINAPI bench_OnCriticalError(IXAudio2EngineCallback *iface, HRESULT error)
+{
+    ok(0, "Unexpected OnCriticalError %#lx.\n", error);
+}
+
+static const IXAudio2EngineCallbackVtbl bench_vtbl =
+{
+    bench_OnProcessingPassStart,
+    bench_OnProcessingPassEnd,
+    bench_OnCriticalError,
+};
+
+/* Each workload spends most of its processing pass in the FAudio kernel it
+ * is named after. Sources at the engine rate aren't resampled. */
+struct bench_workload
+{
+    const char *kernel;
+    WORD format, channels, bits;
+    UINT32 rate, submix_channels;
+};
+
+static const struct bench_workload bench_workloads[] =
+{
+    {"ResampleMono",   WAVE_FORMAT_IEEE_FLOAT, 1, 32, 48000, 1},
+    {"ResampleStereo", WAVE_FORMAT_IEEE_FLOAT, 2, 32, 48000, 2},
+    {"Convert_U8",     WAVE_FORMAT_PCM,        2,  8, 44100, 2},
+    {"Convert_S16",    WAVE_FORMAT_PCM,        2, 16, 44100, 2},
+    {"Convert_S32",    WAVE_FORMAT_PCM,        2, 32, 44100, 2},
+    {"Mix_1in_8out",   WAVE_FORMAT_IEEE_FLOAT, 1, 32, 44100, 8},
+    {"Mix_2in_8out",   WAVE_FORMAT_IEEE_FLOAT, 2, 32, 44100, 8},
+    {"Mix_Generic",    WAVE_FORMAT_IEEE_FLOAT, 8, 32, 44100, 8},
+    /* unconnected submix voices with a volume, and no sources */
+    {"Amplify",        0,                      0,  0,     0, 8},
+};
+
+static void run_bench_workload(IXAudio2 *xa, struct bench_callback *cb, const struct bench_workload *workload)
+{
+    IXAudio2SubmixVoice *submixes[BENCH_VOICES] = {0};
+    IXAudio2SourceVoice *sources[BENCH_VOICES] = {0};
+    XAUDIO2_SEND_DESCRIPTOR send_desc = {0};
+    XAUDIO2_VOICE_SENDS sends = {1, &send_desc}, no_sends = {0};
+    XAUDIO2_BUFFER buffer = {0};
+    unsigned int i, channels;
+    LARGE_INTEGER freq;
+    WAVEFORMATEX fmt;
+    BYTE *data = NULL;
+    float value;
+    HRESULT hr;
+    DWORD ret;
+
+    winetest_push_context("%s", workload->kernel);
+
+    if (!workload->channels)
+    {
+        channels = workload->submix_channels;
+        for (i = 0; i < BENCH_VOICES; ++i)
+        {
+            hr = IXAudio2_CreateSubmixVoice(xa, &submixes[i], channels, 44100, 0, 0, &no_sends, NULL);
+            ok(hr == S_OK, "CreateSubmixVoice failed: %08lx\n", hr);
+            if (FAILED(hr)) goto done;
+            hr = IXAudio2SubmixVoice_SetVolume(submixes[i], 0.5f, XAUDIO2_COMMIT_NOW);
+            ok(hr == S_OK, "SetVolume failed: %08lx\n", hr);
+        }
+    }
+    else
+    {
+        channels = workload->channels;
+        hr = IXAudio2_CreateSubmixVoice(xa, &submixes[0], workload->submix_channels, 44100, 0, 0, NULL, NULL);
+        ok(hr == S_OK, "CreateSubmixVoice failed: %08lx\n", hr);
+        if (FAILED(hr)) goto done;
+        send_desc.pOutputVoice = (IXAudio2Voice *)submixes[0];
+
+        fmt.wFormatTag = workload->format;
+        fmt.nChannels = channels;
+        fmt.nSamplesPerSec = workload->rate;
+        fmt.wBitsPerSample = workload->bits;
+        fmt.nBlockAlign = fmt.nChannels * fmt.wBitsPerSample / 8;
+        fmt.nAvgBytesPerSec = fmt.nSamplesPerSec * fmt.nBlockAlign;
+        fmt.cbSize = 0;
+
+        /* a looped tone, silence could take shortcuts */
+        data = malloc(MIX_FRAMES * fmt.nBlockAlign);
+        for (i = 0; i < MIX_FRAMES * channels; ++i)
+        {
+            value = 0.5f * sinf((i / channels) * 440 * 2 * M_PI / fmt.nSamplesPerSec);
+            if (fmt.wFormatTag == WAVE_FORMAT_IEEE_FLOAT)
+                ((float *)data)[i] = value;
+            else if (fmt.wBitsPerSample == 8)
+                data[i] = 128 + 127 * value;
+            else if (fmt.wBitsPerSample == 16)
+                ((short *)data)[i] = 32767 * value;
+            else
+                ((int *)data)[i] = 2147483647.0 * value;
+        }
+        buffer.AudioBytes = MIX_FRAMES * fmt.nBlockAlign;
+        buffer.pAudioData = data;
+        buffer.LoopCount = XAUDIO2_LOOP_INFINITE;
+
+        for (i = 0; i < BENCH_VOICES; ++i)
+        {
+            hr = IXAudio2_CreateSourceVoice(xa, &sources[i], &fmt, 0, 2.f, NULL, &sends, NULL);
+            if (FAILED(hr))
+            {
+                skip("Failed to create source voice, hr %#lx.\n", hr);
+                goto done;
+            }
+            hr = IXAudio2SourceVoice_SubmitSourceBuffer(sources[i], &buffer, NULL);
+            ok(hr == S_OK, "SubmitSourceBuffer failed: %08lx\n", hr);
+            hr = IXAudio2SourceVoice_Start(sources[i], 0, XAUDIO2_COMMIT_NOW);
+            ok(hr == S_OK, "Start failed: %08lx\n", hr);
+        }
+    }
+
+    cb->passes = 0;
+    cb->ticks = 0;
+    ResetEvent(cb->done);
+    InterlockedExchange(&cb->active, 1);
+    ret = WaitForSingleObject(cb->done, 5000);
+    InterlockedExchange(&cb->active, 0);
+    ok(!ret, "Got %ld processing passes.\n", cb->passes);
+    if (!ret)
+    {
+        QueryPerformanceFrequency(&freq);
+        trace("%.1f million samples/s.\n", (double)BENCH_VOICES * channels * BENCH_PASS_FRAMES * BENCH_PASSES
+                * freq.QuadPart / max(cb->ticks, 1) / 1e6);
+    }
+
+done:
+    for (i = 0; i < BENCH_VOICES; ++i)
+    {
+        if (sources[i]) IXAudio2SourceVoice_DestroyVoice(sources[i]);
+    }
+    for (i = 0; i < BENCH_VOICES; ++i)
+    {
+        if (submixes[i]) IXAudio2SubmixVoice_DestroyVoice(submixes[i]);
+    }
+    free(data);
+    winetest_pop_context();
+}
+
+static void test_kernel_benchmark_child(void)
+{
+    struct bench_callback cb = {{&bench_vtbl}};
+    IXAudio2MasteringVoice *master;
+    const char *simd;
+    unsigned int i;
+    IXAudio2 *xa;
+    HRESULT hr;
+
+    if (!(xa = create_xaudio2()))
+        return;
+
+    hr = create_mastering_voice(xa, 2, &master);
+    if (FAILED(hr))
+    {
+        skip("Failed to create mastering voice, hr %#lx.\n", hr);
+        IXAudio2_Release(xa);
+        return;
+    }
+    cb.done = CreateEventW(NULL, TRUE, FALSE, NULL);
+    hr = IXAudio2_RegisterForCallbacks(xa, &cb.IXAudio2EngineCallback_iface);
+    ok(hr == S_OK, "RegisterForCallbacks failed: %08lx\n", hr);
+
+    simd = getenv("FAUDIO_SIMD");
+    winetest_push_context("FAUDIO_SIMD=%s", simd ? simd : "default");
+    for (i = 0; i < ARRAY_SIZE(bench_workloads); ++i)
+        run_bench_workload(xa, &cb, &bench_workloads[i]);
+    winetest_pop_context();
+
+    IXAudio2_UnregisterForCallbacks(xa, &cb.IXAudio2EngineCallback_iface);
+    IXAudio2MasteringVoice_DestroyVoice(master);
+    IXAudio2_Release(xa);
+    CloseHandle(cb.done);
+}
+
+/* Traces the throughput of each FAudio mixing kernel, with the scalar, SSE2
+ * and default kernels, so that regressions in any of them show up. */
+static void test_kernel_benchmark(void)
+{
+    if (!strcmp(winetest_platform, "wine"))
+    {
+        run_child("FAUDIO_SIMD", "none", "bench");
+        run_child("FAUDIO_SIMD", "sse2", "bench");
+    }
+    run_child("FAUDIO_SIMD", NULL, "bench");
+}
+
+struct submit_callback
+{
+    IXAudio2VoiceCallback IXAudio2VoiceCallback_iface;
+    LONG buffer_ends;
+};
+
+static inline struct submit_callback *impl_from_IXAudio2VoiceCallback(IXAudio2VoiceCallback *iface)
+{
+    return CONTAINING_RECORD(iface, struct submit_callback, IXAudio2VoiceCallback_iface);
+}
+
+static void WINAPI submit_cb_OnVoiceProcessingPassStart(IXAudio2VoiceCallback *iface, UINT32 bytes)
+{
+}
+
+static void WINAPI submit_cb_OnVoiceProcessingPassEnd(IXAudio2VoiceCallback *iface)
+{
+}
+
+static void WINAPI submit_cb_OnStreamEnd(IXAudio2VoiceCallback *iface)
+{
+}
+
+static void WINAPI submit_cb_OnBufferStart(IXAudio2VoiceCallback *iface, void *context)
+{
+}
+
+static void WINAPI submit_cb_OnBufferEnd(IXAudio2VoiceCallback *iface, void *context)
+{
+    struct submit_callback *cb = impl_from_IXAudio2VoiceCallback(iface);
+
+    InterlockedIncrement(&cb->buffer_ends);
+}
+
+static void WINAPI submit_cb_OnLoopEnd(IXAudio2VoiceCallback *iface, void *context)
+{
+}
+
+static void WINAPI submit_cb_OnVoiceError(IXAudio2VoiceCallback *iface, void *context, HRESULT error)
+{
+    ok(0, "Unexpected OnVoiceError %#lx.\n", error);
+}
+
+static const IXAudio2VoiceCallbackVtbl submit_cb_vtbl =
+{
+    submit_cb_OnVoiceProcessingPassStart,
+    submit_cb_OnVoiceProcessingPassEnd,
+    submit_cb_OnStreamEnd,
+    submit_cb_OnBufferStart,
+    submit_cb_OnBufferEnd,
+    submit_cb_OnLoopEnd,
+    submit_cb_OnVoiceError,
+};
+
+#define SUBMIT_THREADS 4
+#define SUBMIT_SHARED_BUFFERS 16
+#define SUBMIT_OWN_BUFFERS 48
+
+struct submit_thread_data
+{
+    IXAudio2SourceVoice *own, *shared;
+    const XAUDIO2_BUFFER *buf;
+    LONG *failures;
+};
+
+static DWORD WINAPI submit_thread(void *arg)
+{
+    struct submit_thread_data *data = arg;
+    unsigned int i;
+    HRESULT hr;
+
+    for (i = 0; i < SUBMIT_OWN_BUFFERS; ++i)
+    {
+        hr = IXAudio2SourceVoice_SubmitSourceBuffer(data->own, data->buf, NULL);
+        if (FAILED(hr)) InterlockedIncrement(data->failures);
+        if (i < SUBMIT_SHARED_BUFFERS)
+        {
+            hr = IXAudio2SourceVoice_SubmitSourceBuffer(data->shared, data->buf, NULL);
+            if (FAILED(hr)) InterlockedIncrement(data->failures);
+        }
+        if (!(i % 8)) Sleep(1);
+    }
+    return 0;
+}
+
+struct churn_thread_data
+{
+    IXAudio2 *xa;
+    const WAVEFORMATEX *fmt;
+    const XAUDIO2_BUFFER *buf;
+    LONG *failures;
+};
+
+static DWORD WINAPI churn_thread(void *arg)
+{
+    struct churn_thread_data *data = arg;
+    IXAudio2SourceVoice *voice;
+    unsigned int i;
+    HRESULT hr;
+
+    for (i = 0; i < 32; ++i)
+    {
+        hr = IXAudio2_CreateSourceVoice(data->xa, &voice, data->fmt, 0, 1.f, NULL, NULL, NULL);
+        if (FAILED(hr))
+        {
+            InterlockedIncrement(data->failures);
+            continue;
+        }
+        hr = IXAudio2SourceVoice_SubmitSourceBuffer(voice, data->buf, NULL);
+        if (FAILED(hr)) InterlockedIncrement(data->failures);
+        hr = IXAudio2SourceVoice_Start(voice, 0, XAUDIO2_COMMIT_NOW);
+        if (FAILED(hr)) InterlockedIncrement(data->failures);
+        Sleep(i % 3);
+        IXAudio2SourceVoice_DestroyVoice(voice);
+    }
+    return 0;
+}
+
+static void test_concurrent_submit(IXAudio2 *xa)
+{
+    struct submit_callback callbacks[SUBMIT_THREADS + 1];
+    struct submit_thread_data thread_data[SUBMIT_THREADS];
+    IXAudio2SourceVoice *voices[SUBMIT_THREADS + 1];
+    HANDLE threads[SUBMIT_THREADS + 1];
+    struct churn_thread_data churn;
+    IXAudio2MasteringVoice *master;
+    XAUDIO2_VOICE_STATE state;
+    LONG failures = 0;
+    WAVEFORMATEX fmt;
+    XAUDIO2_BUFFER buf;
+    unsigned int i, queued;
+    DWORD start;
+    HRESULT hr;
+
+    hr = create_mastering_voice(xa, 2, &master);
+    ok(hr == S_OK, "CreateMasteringVoice failed: %08lx\n", hr);
+
+    fmt.wFormatTag = WAVE_FORMAT_IEEE_FLOAT;
+    fmt.nChannels = 2;
+    fmt.nSamplesPerSec = 44100;
+    fmt.wBitsPerSample = 32;
+    fmt.nBlockAlign = fmt.nChannels * fmt.wBitsPerSample / 8;
+    fmt.nAvgBytesPerSec = fmt.nSamplesPerSec * fmt.nBlockAlign;
+    fmt.cbSize = 0;
+
+    memset(&buf, 0, sizeof(buf));
+    buf.AudioBytes = 441 * fmt.nBlockAlign;
+    buf.pAudioData = HeapAlloc(GetProcessHeap(), 0, buf.AudioBytes);
+    fill_buf((float*)buf.pAudioData, &fmt, 440, 441);
+
+    /* The last voice is shared between all submitting threads. */
+    for (i = 0; i < ARRAY_SIZE(voices); ++i)
+    {
+        callbacks[i].IXAudio2VoiceCallback_iface.lpVtbl = &submit_cb_vtbl;
+        callbacks[i].buffer_ends = 0;
+        hr = IXAudio2_CreateSourceVoice(xa, &voices[i], &fmt, 0, 1.f,
+                &callbacks[i].IXAudio2VoiceCallback_iface, NULL, NULL);
+        ok(hr == S_OK, "CreateSourceVoice failed: %08lx\n", hr);
+        hr = IXAudio2SourceVoice_Start(voices[i], 0, XAUDIO2_COMMIT_NOW);
+        ok(hr == S_OK, "Start failed: %08lx\n", hr);
+    }
+
+    for (i = 0; i < SUBMIT_THREADS; ++i)
+    {
+        thread_data[i].own = voices[i];
+        thread_data[i].shared = voices[SUBMIT_THREADS];
+        thread_data[i].buf = &buf;
+        thread_data[i].failures = &failures;
+        threads[i] = CreateThread(NULL, 0, submit_thread, &thread_data[i], 0, NULL);
+        ok(!!threads[i], "CreateThread failed, error %lu.\n", GetLastError());
+    }
+    churn.xa = xa;
+    churn.fmt = &fmt;
+    churn.buf = &buf;
+    churn.failures = &failures;
+    threads[SUBMIT_THREADS] = CreateThread(NULL, 0, churn_thread, &churn, 0, NULL);
+    ok(!!threads[SUBMIT_THREADS], "CreateThread failed, error %lu.\n", GetLastError());
+
+    WaitForMultipleObjects(ARRAY_SIZE(threads), threads, TRUE, INFINITE);
+    for (i = 0; i < ARRAY_SIZE(threads); ++i)
+        CloseHandle(threads[i]);
+    ok(!failures, "Got %ld failed calls.\n", failures);
+
+    /* Everything submitted must eventually be played out. */
+    start = GetTickCount();
+    do
+    {
+        queued = 0;
+        for (i = 0; i < ARRAY_SIZE(voices); ++i)
+        {
+            get_voice_state(voices[i], &state);
+            queued += state.BuffersQueued;
+        }
+        if (!queued) break;
+        Sleep(10);
+    } while (GetTickCount() - start < 5000);
+    ok(!queued, "Got %u buffers still queued.\n", queued);
+
+    for (i = 0; i < SUBMIT_THREADS; ++i)
+        ok(callbacks[i].buffer_ends == SUBMIT_OWN_BUFFERS, "Voice %u: got %ld OnBufferEnd calls.\n",
+                i, callbacks[i].buffer_ends);
+    ok(callbacks[SUBMIT_THREADS].buffer_ends == SUBMIT_THREADS * SUBMIT_SHARED_BUFFERS,
+            "Shared voice: got %ld OnBufferEnd calls.\n", callbacks[SUBMIT_THREADS].buffer_ends);
+
+    for (i = 0; i < ARRAY_SIZE(voices); ++i)
+        IXAudio2SourceVoice_DestroyVoice(voices[i]);
+    IXAudio2MasteringVoice_DestroyVoice(master);
+    HeapFree(GetProcessHeap(), 0, (void*)buf.pAudioData);
+}
+
+#if XAUDIO2_VER >= 8
+static void test_x3daudio_calculate(void)
+{
+    static const unsigned int emitter_count = 256, frame_count = 200;
+    X3DAUDIO_LISTENER listener = {{0.0f, 0.0f, 1.0f}, {0.0f, 1.0f, 0.0f}, {1.0f, 2.0f, 3.0f}, {3.0f, 0.0f, -1.0f}};
+    X3DAUDIO_DSP_SETTINGS *settings;
+    LARGE_INTEGER freq, start, end;
+    X3DAUDIO_EMITTER *emitters;
+    float *matrix;
+    X3DAUDIO_HANDLE handle;
+    unsigned int i, j;
+    double elapsed;
+    HRESULT hr;
+    UINT32 flags = X3DAUDIO_CALCULATE_MATRIX | X3DAUDIO_CALCULATE_LPF_DIRECT | X3DAUDIO_CALCULATE_REVERB
+            | X3DAUDIO_CALCULATE_DOPPLER;
+
+    hr = X3DAudioInitialize(SPEAKER_STEREO, X3DAUDIO_SPEED_OF_SOUND, handle);
+    ok(hr == S_OK, "X3DAudioInitialize failed: %08lx\n", hr);
+
+    emitters = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, emitter_count * sizeof(*emitters));
+    settings = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, emitter_count * sizeof(*settings));
+    matrix = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, emitter_count * 2 * sizeof(*matrix));
+
+    for (i = 0; i < emitter_count; ++i)
+    {
+        emitters[i].OrientFront.z = 1.0f;
+        emitters[i].OrientTop.y = 1.0f;
+        emitters[i].Position.x = (float)(i % 16) * 5.0f - 40.0f;
+        emitters[i].Position.z = (float)(i / 16) * 5.0f - 40.0f;
+        emitters[i].Velocity.x = (float)(i % 7) - 3.0f;
+        emitters[i].ChannelCount = 1;
+        emitters[i].CurveDistanceScaler = 10.0f;
+        emitters[i].DopplerScaler = 1.0f;
+        settings[i].pMatrixCoefficients = matrix + i * 2;
+        settings[i].SrcChannelCount = 1;
+        settings[i].DstChannelCount = 2;
+    }
+
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&start);
+    for (j = 0; j < frame_count; ++j)
+    {
+        for (i = 0; i < emitter_count; ++i)
+            X3DAudioCalculate(handle, &listener, &emitters[i], flags, &settings[i]);
+    }
+    QueryPerformanceCounter(&end);
+
+    for (i = 0; i < emitter_count; ++i)
+    {
+        ok(settings[i].DopplerFactor >= 0.5f && settings[i].DopplerFactor <= 4.0f,
+                "Emitter %u: got doppler factor %f.\n", i, settings[i].DopplerFactor);
+        ok(settings[i].EmitterToListenerDistance > 0.0f, "Emitter %u: got distance %f.\n",
+                i, settings[i].EmitterToListenerDistance);
+    }
+
+    elapsed = (double)(end.QuadPart - start.QuadPart) * 1000.0 / freq.QuadPart;
+    if (elapsed > 0.0)
+        trace("X3DAudioCalculate: %.1f emitters/ms.\n", emitter_count * frame_count / elapsed);
+
+    HeapFree(GetProcessHeap(), 0, matrix);
+    HeapFree(GetProcessHeap(), 0, settings);
+    HeapFree(GetProcessHeap(), 0, emitters);
+}
+
+static void test_x3daudio_calculate_batch(void)
+{
+    /* Not a multiple of 4, so both the vector and the scalar tail are used. */
+    static const unsigned int emitter_count = 67;
+    X3DAUDIO_LISTENER listener = {{0.0f, 0.0f, 1.0f}, {0.0f, 1.0f, 0.0f}, {1.0f, 2.0f, 3.0f}, {3.0f, 0.0f, -1.0f}};
+    void (CDECL *pX3DAudioCalculateBatch)(const X3DAUDIO_HANDLE, const X3DAUDIO_LISTENER *,
+            const X3DAUDIO_EMITTER *, UINT32, UINT32, X3DAUDIO_DSP_SETTINGS *);
+    X3DAUDIO_DSP_SETTINGS *settings, *batch_settings;
+    float *matrix, *batch_matrix;
+    X3DAUDIO_EMITTER *emitters;
+    X3DAUDIO_HANDLE handle;
+    unsigned int i, j;
+    HRESULT hr;
+    UINT32 flags = X3DAUDIO_CALCULATE_MATRIX | X3DAUDIO_CALCULATE_LPF_DIRECT | X3DAUDIO_CALCULATE_REVERB
+            | X3DAUDIO_CALCULATE_DOPPLER | X3DAUDIO_CALCULATE_EMITTER_ANGLE;
+
+    pX3DAudioCalculateBatch = (void *)GetProcAddress(GetModuleHandleA("xaudio2_8.dll"),
+            "__wine_X3DAudioCalculateBatch");
+    if (!pX3DAudioCalculateBatch)
+    {
+        win_skip("__wine_X3DAudioCalculateBatch is not available.\n");
+        return;
+    }
+
+    hr = X3DAudioInitialize(SPEAKER_5POINT1, X3DAUDIO_SPEED_OF_SOUND, handle);
+    ok(hr == S_OK, "X3DAudioInitialize failed: %08lx\n", hr);
+
+    emitters = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, emitter_count * sizeof(*emitters));
+    settings = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, 2 * emitter_count * sizeof(*settings));
+    matrix = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, 2 * emitter_count * 6 * sizeof(*matrix));
+    batch_settings = settings + emitter_count;
+    batch_matrix = matrix + emitter_count * 6;
+
+    for (i = 0; i < emitter_count; ++i)
+    {
+        emitters[i].OrientFront.z = 1.0f;
+        emitters[i].OrientTop.y = 1.0f;
+        emitters[i].Position.x = (float)(i % 9) * 7.5f - 30.0f;
+        emitters[i].Position.y = (float)(i % 5) * 1.25f - 2.0f;
+        emitters[i].Position.z = (float)(i / 9) * 6.0f - 21.0f;
+        emitters[i].Velocity.x = (float)(i % 7) - 3.0f;
+        emitters[i].Velocity.y = (float)(i % 3) * 0.5f;
+        emitters[i].Velocity.z = 2.0f - (float)(i % 11) * 0.4f;
+        emitters[i].ChannelCount = 1;
+        emitters[i].CurveDistanceScaler = 1.0f + (float)(i % 4) * 3.0f;
+        emitters[i].DopplerScaler = (i % 6) ? 1.0f : 2.5f;
+        settings[i].pMatrixCoefficients = matrix + i * 6;
+        settings[i].SrcChannelCount = 1;
+        settings[i].DstChannelCount = 6;
+        batch_settings[i] = settings[i];
+        batch_settings[i].pMatrixCoefficients = batch_matrix + i * 6;
+    }
+
+    for (i = 0; i < emitter_count; ++i)
+        X3DAudioCalculate(handle, &listener, &emitters[i], flags, &settings[i]);
+    pX3DAudioCalculateBatch(handle, &listener, emitters, emitter_count, flags, batch_settings);
+
+    for (i = 0; i < emitter_count; ++i)
+    {
+        winetest_push_context("Emitter %u", i);
+        ok(batch_settings[i].DopplerFactor == settings[i].DopplerFactor,
+                "Got doppler factor %.8e, expected %.8e.\n",
+                batch_settings[i].DopplerFactor, settings[i].DopplerFactor);
+        ok(batch_settings[i].EmitterToListenerDistance == settings[i].EmitterToListenerDistance,
+                "Got distance %.8e, expected %.8e.\n",
+                batch_settings[i].EmitterToListenerDistance, settings[i].EmitterToListenerDistance);
+        ok(batch_settings[i].EmitterToListenerAngle == settings[i].EmitterToListenerAngle,
+                "Got angle %.8e, expected %.8e.\n",
+                batch_settings[i].EmitterToListenerAngle, settings[i].EmitterToListenerAngle);
+        ok(batch_settings[i].EmitterVelocityComponent == settings[i].EmitterVelocityComponent
+                && batch_settings[i].ListenerVelocityComponent == settings[i].ListenerVelocityComponent,
+                "Got velocity components %.8e/%.8e, expected %.8e/%.8e.\n",
+                batch_settings[i].EmitterVelocityComponent, batch_settings[i].ListenerVelocityComponent,
+                settings[i].EmitterVelocityComponent, settings[i].ListenerVelocityComponent);
+        ok(batch_settings[i].LPFDirectCoefficient == settings[i].LPFDirectCoefficient,
+                "Got LPF coefficient %.8e, expected %.8e.\n",
+                batch_settings[i].LPFDirectCoefficient, settings[i].LPFDirectCoefficient);
+        ok(batch_settings[i].ReverbLevel == settings[i].ReverbLevel,
+                "Got reverb level %.8e, expected %.8e.\n",
+                batch_settings[i].ReverbLevel, settings[i].ReverbLevel);
+        for (j = 0; j < 6; ++j)
+            ok(batch_matrix[i * 6 + j] == matrix[i * 6 + j], "Got matrix coefficient %u %.8e, expected %.8e.\n",
+                    j, batch_matrix[i * 6 + j], matrix[i * 6 + j]);
+        winetest_pop_context();
+    }
+
+    HeapFree(GetProcessHeap(), 0, matrix);
+    HeapFree(GetProcessHeap(), 0, settings);
+    HeapFree(GetProcessHeap(), 0, emitters);
+}
+#endif
+
 START_TEST(xaudio2)
 {
     IXAudio2 *audio;
+    char **argv;
     ULONG ref;
+    int argc;
 
     CoInitialize(NULL);
 
+    argc = winetest_get_mainargs(&argv);
+    if (argc >= 4 && !strcmp(argv[2], "mix"))
+    {
+        test_mix_child(argv[3]);
+        CoUninitialize();
+        return;
+    }
+    if (argc >= 3 && !strcmp(argv[2], "bench"))
+    {
+        test_kernel_benchmark_child();
+        CoUninitialize();
+        return;
+    }
+
     test_xapo_creation();
+#if XAUDIO2_VER >= 8
+    test_x3daudio_calculate();
+    test_x3daudio_calculate_batch();
+#endif
 
     if (!(audio = create_xaudio2()))
         return;
@@ -1316,6 +2383,11 @@ START_TEST(xaudio2)
         test_submix(audio);
         test_flush(audio);
         test_setchannelvolumes(audio);
+        test_mix_threads();
+        test_mix_simd();
+        test_mix_cache();
+        test_kernel_benchmark();
+        test_concurrent_submit(audio);
     }
 
     ref = IXAudio2_Release(audio);
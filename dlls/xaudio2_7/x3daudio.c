@@ -75,3 +75,21 @@ void CDECL X3DAudioCalculate(const X3DAUDIO_HANDLE handle,
     );
 }
 #endif /* XAUDIO2_VER >= 8 || defined X3DAUDIO1_VER */
+
+#if XAUDIO2_VER >= 8
+/* Wine extension: X3DAudioCalculate for an array of emitters. */
+void CDECL __wine_X3DAudioCalculateBatch(const X3DAUDIO_HANDLE handle,
+        const X3DAUDIO_LISTENER *listener, const X3DAUDIO_EMITTER *emitters,
+        UINT32 count, UINT32 flags, X3DAUDIO_DSP_SETTINGS *out)
+{
+    TRACE("%p, %p, %p, %u, 0x%x, %p\n", handle, listener, emitters, count, flags, out);
+    F3DAudioCalculateBatchEXT(
+        handle,
+        (const F3DAUDIO_LISTENER*) listener,
+        (const F3DAUDIO_EMITTER*) emitters,
+        count,
+        flags,
+        (F3DAUDIO_DSP_SETTINGS*) out
+    );
+}
+#endif /* XAUDIO2_VER >= 8 */
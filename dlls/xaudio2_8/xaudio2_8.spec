@@ -4,3 +4,7 @@
 4 cdecl -ordinal CreateFX(ptr ptr ptr long)
 5 cdecl -ordinal X3DAudioCalculate(ptr ptr ptr long ptr)
 6 cdecl -ordinal X3DAudioInitialize(long float ptr)
+
+################################################################
+# Wine internal extensions
+@ cdecl __wine_X3DAudioCalculateBatch(ptr ptr ptr long long ptr)
@@ -0,0 +1,60 @@
+/*
+ * Wine-specific heap information classes
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef __WINE_WINE_HEAPINFO_H
+#define __WINE_WINE_HEAPINFO_H
+
+#include "winternl.h"
+
+/* Extra RtlQueryHeapInformation / RtlSetHeapInformation classes, not part of
+ * the Windows HEAP_INFORMATION_CLASS enumeration. */
+
+#define HeapWineSummaryInformation      ((HEAP_INFORMATION_CLASS)1000)
+#define HeapWineBinInformation          ((HEAP_INFORMATION_CLASS)1001)
+#define HeapWineThreadCacheInformation  ((HEAP_INFORMATION_CLASS)1002)  /* ULONG, process heap only */
+#define HeapWineStatisticsInformation   ((HEAP_INFORMATION_CLASS)1003)  /* ULONG, enables the LFH counters */
+
+typedef struct _HEAP_WINE_SUMMARY_INFORMATION
+{
+    SIZE_T AllocatedSize;     /* user size of busy blocks */
+    SIZE_T CommittedSize;
+    SIZE_T ReservedSize;
+    SIZE_T FreeSize;
+    ULONG  SubheapCount;
+    ULONG  LargeBlockCount;
+    ULONG  BusyBlockCount;
+    ULONG  FreeBlockCount;
+} HEAP_WINE_SUMMARY_INFORMATION, *PHEAP_WINE_SUMMARY_INFORMATION;
+
+/* the LFH counters are only updated once enabled with HeapWineStatisticsInformation,
+ * or with WINEDEBUG=+heapstats, and are approximate with concurrent use of the heap */
+typedef struct _HEAP_WINE_BIN_INFORMATION
+{
+    SIZE_T BlockSize;
+    ULONG  Enabled;           /* whether the LFH is active for this size class */
+    ULONG  BackendAllocCount; /* allocations going through the backend, before LFH activation */
+    ULONG  BackendFreeCount;
+    ULONG  AllocCount;        /* LFH allocations */
+    ULONG  FreeCount;         /* LFH frees */
+    ULONG  AffinityHitCount;  /* allocations served from the thread affinity group */
+    ULONG  GroupCount;
+    ULONG  UsedBlockCount;
+    ULONG  CacheHitCount;     /* allocations served from the thread local caches, other threads are counted in batches */
+} HEAP_WINE_BIN_INFORMATION, *PHEAP_WINE_BIN_INFORMATION;
+
+#endif  /* __WINE_WINE_HEAPINFO_H */
@@ -0,0 +1,47 @@
+/*
+ * Media Foundation pipeline event tracing
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef __WINE_MFTRACE_H
+#define __WINE_MFTRACE_H
+
+#include "windef.h"
+
+/* Media pipeline events, recorded by rtworkq into a per-process ring when the
+ * WINE_MF_TRACE environment variable is set to an output file name. The ring
+ * is written out in Chrome trace JSON format on platform shutdown, to that
+ * name with the process id appended. */
+
+enum wine_mf_trace_event
+{
+    WINE_MF_TRACE_SAMPLE_REQUEST,   /* session requests a sample from a source stream */
+    WINE_MF_TRACE_SAMPLE_READY,     /* source stream queues a sample */
+    WINE_MF_TRACE_SAMPLE_DELIVER,   /* session receives a sample from a source stream */
+    WINE_MF_TRACE_DECODE_BEGIN,     /* transform starts producing an output sample */
+    WINE_MF_TRACE_DECODE_END,
+    WINE_MF_TRACE_SAMPLE_PRESENT,   /* session passes a sample to a stream sink */
+    WINE_MF_TRACE_WORK_ITEM_BEGIN,  /* work queue invokes a callback */
+    WINE_MF_TRACE_WORK_ITEM_END,
+    WINE_MF_TRACE_COPY_BEGIN,       /* image copy */
+    WINE_MF_TRACE_COPY_END,
+};
+
+BOOL WINAPI __wine_rtwq_trace_enabled(void);
+void WINAPI __wine_rtwq_trace(enum wine_mf_trace_event event, const void *object, LONGLONG value);
+BOOL WINAPI __wine_rtwq_trace_dump(const WCHAR *path);
+
+#endif /* __WINE_MFTRACE_H */
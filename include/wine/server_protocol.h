@@ -2232,6 +2232,36 @@ struct get_image_map_address_reply
 
 
 
+struct get_image_reloc_file_request
+{
+    struct request_header __header;
+    obj_handle_t handle;
+    client_ptr_t base;
+};
+struct get_image_reloc_file_reply
+{
+    struct reply_header __header;
+    obj_handle_t file;
+    int          ready;
+};
+
+
+
+struct set_image_reloc_file_ready_request
+{
+    struct request_header __header;
+    obj_handle_t handle;
+    client_ptr_t base;
+    int          success;
+    char __pad_28[4];
+};
+struct set_image_reloc_file_ready_reply
+{
+    struct reply_header __header;
+};
+
+
+
 struct map_view_request
 {
     struct request_header __header;
@@ -6223,6 +6253,8 @@ enum request
     REQ_open_mapping,
     REQ_get_mapping_info,
     REQ_get_image_map_address,
+    REQ_get_image_reloc_file,
+    REQ_set_image_reloc_file_ready,
     REQ_map_view,
     REQ_map_image_view,
     REQ_map_builtin_view,
@@ -6536,6 +6568,8 @@ union generic_request
     struct open_mapping_request open_mapping_request;
     struct get_mapping_info_request get_mapping_info_request;
     struct get_image_map_address_request get_image_map_address_request;
+    struct get_image_reloc_file_request get_image_reloc_file_request;
+    struct set_image_reloc_file_ready_request set_image_reloc_file_ready_request;
     struct map_view_request map_view_request;
     struct map_image_view_request map_image_view_request;
     struct map_builtin_view_request map_builtin_view_request;
@@ -6847,6 +6881,8 @@ union generic_reply
     struct open_mapping_reply open_mapping_reply;
     struct get_mapping_info_reply get_mapping_info_reply;
     struct get_image_map_address_reply get_image_map_address_reply;
+    struct get_image_reloc_file_reply get_image_reloc_file_reply;
+    struct set_image_reloc_file_ready_reply set_image_reloc_file_ready_reply;
     struct map_view_reply map_view_reply;
     struct map_image_view_reply map_image_view_reply;
     struct map_builtin_view_reply map_builtin_view_reply;
@@ -7088,6 +7124,6 @@ union generic_reply
     struct d3dkmt_mutex_release_reply d3dkmt_mutex_release_reply;
 };
 
-#define SERVER_PROTOCOL_VERSION 927
+#define SERVER_PROTOCOL_VERSION 928
 
 #endif /* __WINE_WINE_SERVER_PROTOCOL_H */
@@ -253,6 +253,19 @@ F3DAUDIOAPI void F3DAudioCalculate(
 	F3DAUDIO_DSP_SETTINGS *pDSPSettings
 );
 
+/* Equivalent to calling F3DAudioCalculate for each of the EmitterCount
+ * emitters, with one DSP settings struct per emitter, but the position and
+ * velocity math is done for several emitters at a time.
+ */
+F3DAUDIOAPI void F3DAudioCalculateBatchEXT(
+	const F3DAUDIO_HANDLE Instance,
+	const F3DAUDIO_LISTENER *pListener,
+	const F3DAUDIO_EMITTER *pEmitters,
+	uint32_t EmitterCount,
+	uint32_t Flags,
+	F3DAUDIO_DSP_SETTINGS *pDSPSettings
+);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
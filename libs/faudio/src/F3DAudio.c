@@ -30,6 +30,14 @@
 #include <math.h> /* ONLY USE THIS FOR isnan! */
 #include <float.h> /* ONLY USE THIS FOR FLT_MIN/FLT_MAX! */
 
+/* x86_64 guarantees SSE2, the batched path falls back to scalar elsewhere */
+#if defined(__SSE2__) || defined(__x86_64__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define F3DAUDIO_HAVE_SSE2 1
+#else
+#define F3DAUDIO_HAVE_SSE2 0
+#endif
+
 /* VS2010 doesn't define isnan (which is C99), so here it is. */
 #if defined(_MSC_VER) && !defined(isnan)
 #define isnan(x) _isnan(x)
@@ -1434,12 +1442,146 @@ static inline void CalculateDoppler(
 	}
 }
 
-void F3DAudioCalculate(
+/* Per-emitter values that only depend on positions and velocities, computed
+ * for several emitters at once when SIMD is available.
+ */
+typedef struct F3DAUDIO_EMITTER_PRECALC
+{
+	F3DAUDIO_VECTOR emitterToListener;
+	float eToLDistance;
+	float listenerVelocityComponent;
+	float emitterVelocityComponent;
+	float dopplerFactor;
+} F3DAUDIO_EMITTER_PRECALC;
+
+static inline void PrecalcEmitter(
+	float SpeedOfSound,
+	const F3DAUDIO_LISTENER *pListener,
+	const F3DAUDIO_EMITTER *pEmitter,
+	uint32_t Flags,
+	F3DAUDIO_EMITTER_PRECALC *pre
+) {
+	pre->emitterToListener = VectorSub(pListener->Position, pEmitter->Position);
+	pre->eToLDistance = VectorLength(pre->emitterToListener);
+
+	if (Flags & F3DAUDIO_CALCULATE_DOPPLER)
+	{
+		CalculateDoppler(
+			SpeedOfSound,
+			pListener,
+			pEmitter,
+			pre->emitterToListener,
+			pre->eToLDistance,
+			&pre->listenerVelocityComponent,
+			&pre->emitterVelocityComponent,
+			&pre->dopplerFactor
+		);
+	}
+}
+
+#if F3DAUDIO_HAVE_SSE2
+/* Same as PrecalcEmitter, for four emitters at a time. The operations are
+ * done in the same order as the scalar code, so the results are identical.
+ */
+static void PrecalcEmitters_SSE2(
+	float SpeedOfSound,
+	const F3DAUDIO_LISTENER *pListener,
+	const F3DAUDIO_EMITTER *pEmitters,
+	uint32_t Flags,
+	F3DAUDIO_EMITTER_PRECALC *pre
+) {
+	const F3DAUDIO_EMITTER *e0 = &pEmitters[0];
+	const F3DAUDIO_EMITTER *e1 = &pEmitters[1];
+	const F3DAUDIO_EMITTER *e2 = &pEmitters[2];
+	const F3DAUDIO_EMITTER *e3 = &pEmitters[3];
+	__m128 ex, ey, ez, dist, lvc, evc, scaler, sos, scaled, doppler;
+	__m128 hasDist, hasScaler, isNan;
+	float out[4];
+	uint32_t i;
+
+	#define GATHER(field) _mm_setr_ps(e0->field, e1->field, e2->field, e3->field)
+	#define STORE(vec, field) \
+		_mm_storeu_ps(out, vec); \
+		for (i = 0; i < 4; i += 1) pre[i].field = out[i];
+
+	/* emitterToListener = listener - emitter */
+	ex = _mm_sub_ps(_mm_set1_ps(pListener->Position.x), GATHER(Position.x));
+	ey = _mm_sub_ps(_mm_set1_ps(pListener->Position.y), GATHER(Position.y));
+	ez = _mm_sub_ps(_mm_set1_ps(pListener->Position.z), GATHER(Position.z));
+	dist = _mm_sqrt_ps(_mm_add_ps(
+		_mm_add_ps(_mm_mul_ps(ex, ex), _mm_mul_ps(ey, ey)),
+		_mm_mul_ps(ez, ez)
+	));
+
+	STORE(ex, emitterToListener.x)
+	STORE(ey, emitterToListener.y)
+	STORE(ez, emitterToListener.z)
+	STORE(dist, eToLDistance)
+
+	if (Flags & F3DAUDIO_CALCULATE_DOPPLER)
+	{
+		/* Project... */
+		hasDist = _mm_cmpneq_ps(dist, _mm_setzero_ps());
+		lvc = _mm_div_ps(_mm_add_ps(_mm_add_ps(
+			_mm_mul_ps(ex, _mm_set1_ps(pListener->Velocity.x)),
+			_mm_mul_ps(ey, _mm_set1_ps(pListener->Velocity.y))),
+			_mm_mul_ps(ez, _mm_set1_ps(pListener->Velocity.z))
+		), dist);
+		evc = _mm_div_ps(_mm_add_ps(_mm_add_ps(
+			_mm_mul_ps(ex, GATHER(Velocity.x)),
+			_mm_mul_ps(ey, GATHER(Velocity.y))),
+			_mm_mul_ps(ez, GATHER(Velocity.z))
+		), dist);
+		lvc = _mm_and_ps(hasDist, lvc);
+		evc = _mm_and_ps(hasDist, evc);
+
+		/* Clamp... */
+		scaler = GATHER(DopplerScaler);
+		hasScaler = _mm_cmpgt_ps(scaler, _mm_setzero_ps());
+		sos = _mm_set1_ps(SpeedOfSound);
+		scaled = _mm_div_ps(sos, scaler);
+		lvc = _mm_or_ps(
+			_mm_and_ps(hasScaler, _mm_min_ps(lvc, scaled)),
+			_mm_andnot_ps(hasScaler, lvc)
+		);
+		evc = _mm_or_ps(
+			_mm_and_ps(hasScaler, _mm_min_ps(evc, scaled)),
+			_mm_andnot_ps(hasScaler, evc)
+		);
+
+		/* ... then Multiply. */
+		doppler = _mm_div_ps(
+			_mm_sub_ps(sos, _mm_mul_ps(scaler, lvc)),
+			_mm_sub_ps(sos, _mm_mul_ps(scaler, evc))
+		);
+		isNan = _mm_cmpunord_ps(doppler, doppler);
+		doppler = _mm_or_ps(
+			_mm_andnot_ps(isNan, doppler),
+			_mm_and_ps(isNan, _mm_set1_ps(1.0f))
+		);
+		doppler = _mm_min_ps(_mm_max_ps(doppler, _mm_set1_ps(0.5f)), _mm_set1_ps(4.0f));
+		doppler = _mm_or_ps(
+			_mm_and_ps(hasScaler, doppler),
+			_mm_andnot_ps(hasScaler, _mm_set1_ps(1.0f))
+		);
+
+		STORE(lvc, listenerVelocityComponent)
+		STORE(evc, emitterVelocityComponent)
+		STORE(doppler, dopplerFactor)
+	}
+
+	#undef GATHER
+	#undef STORE
+}
+#endif /* F3DAUDIO_HAVE_SSE2 */
+
+static void CalculateEmitter(
 	const F3DAUDIO_HANDLE Instance,
 	const F3DAUDIO_LISTENER *pListener,
 	const F3DAUDIO_EMITTER *pEmitter,
 	uint32_t Flags,
-	F3DAUDIO_DSP_SETTINGS *pDSPSettings
+	F3DAUDIO_DSP_SETTINGS *pDSPSettings,
+	const F3DAUDIO_EMITTER_PRECALC *pre
 ) {
 	uint32_t i;
 	F3DAUDIO_VECTOR emitterToListener;
@@ -1461,8 +1603,8 @@ void F3DAudioCalculate(
 	#undef DEFAULT_POINTS
 
 	/* For XACT, this calculates "Distance" */
-	emitterToListener = VectorSub(pListener->Position, pEmitter->Position);
-	eToLDistance = VectorLength(emitterToListener);
+	emitterToListener = pre->emitterToListener;
+	eToLDistance = pre->eToLDistance;
 	pDSPSettings->EmitterToListenerDistance = eToLDistance;
 
 	F3DAudioCheckCalculateParams(Instance, pListener, pEmitter, Flags, pDSPSettings);
@@ -1519,16 +1661,9 @@ void F3DAudioCalculate(
 	/* For XACT, this calculates "DopplerPitchScalar" */
 	if (Flags & F3DAUDIO_CALCULATE_DOPPLER)
 	{
-		CalculateDoppler(
-			SPEEDOFSOUND(Instance),
-			pListener,
-			pEmitter,
-			emitterToListener,
-			eToLDistance,
-			&pDSPSettings->ListenerVelocityComponent,
-			&pDSPSettings->EmitterVelocityComponent,
-			&pDSPSettings->DopplerFactor
-		);
+		pDSPSettings->ListenerVelocityComponent = pre->listenerVelocityComponent;
+		pDSPSettings->EmitterVelocityComponent = pre->emitterVelocityComponent;
+		pDSPSettings->DopplerFactor = pre->dopplerFactor;
 	}
 
 	/* For XACT, this calculates "OrientationAngle" */
@@ -1562,4 +1697,79 @@ void F3DAudioCalculate(
 	}
 }
 
+void F3DAudioCalculateBatchEXT(
+	const F3DAUDIO_HANDLE Instance,
+	const F3DAUDIO_LISTENER *pListener,
+	const F3DAUDIO_EMITTER *pEmitters,
+	uint32_t EmitterCount,
+	uint32_t Flags,
+	F3DAUDIO_DSP_SETTINGS *pDSPSettings
+) {
+	F3DAUDIO_EMITTER_PRECALC pre[4];
+	uint32_t i = 0;
+#if F3DAUDIO_HAVE_SSE2
+	uint32_t j;
+#endif /* F3DAUDIO_HAVE_SSE2 */
+
+#if F3DAUDIO_HAVE_SSE2
+	for (; i + 4 <= EmitterCount; i += 4)
+	{
+		PrecalcEmitters_SSE2(
+			SPEEDOFSOUND(Instance),
+			pListener,
+			&pEmitters[i],
+			Flags,
+			pre
+		);
+		for (j = 0; j < 4; j += 1)
+		{
+			CalculateEmitter(
+				Instance,
+				pListener,
+				&pEmitters[i + j],
+				Flags,
+				&pDSPSettings[i + j],
+				&pre[j]
+			);
+		}
+	}
+#endif /* F3DAUDIO_HAVE_SSE2 */
+
+	for (; i < EmitterCount; i += 1)
+	{
+		PrecalcEmitter(
+			SPEEDOFSOUND(Instance),
+			pListener,
+			&pEmitters[i],
+			Flags,
+			&pre[0]
+		);
+		CalculateEmitter(
+			Instance,
+			pListener,
+			&pEmitters[i],
+			Flags,
+			&pDSPSettings[i],
+			&pre[0]
+		);
+	}
+}
+
+void F3DAudioCalculate(
+	const F3DAUDIO_HANDLE Instance,
+	const F3DAUDIO_LISTENER *pListener,
+	const F3DAUDIO_EMITTER *pEmitter,
+	uint32_t Flags,
+	F3DAUDIO_DSP_SETTINGS *pDSPSettings
+) {
+	F3DAudioCalculateBatchEXT(
+		Instance,
+		pListener,
+		pEmitter,
+		1,
+		Flags,
+		pDSPSettings
+	);
+}
+
 /* vim: set noexpandtab shiftwidth=8 tabstop=8: */
@@ -165,6 +165,11 @@ uint32_t FAudio_Release(FAudio *audio)
 	refcount = audio->refcount;
 	if (audio->refcount == 0)
 	{
+		FAudio_PlatformLockMutex(audio->sourceLock);
+		LOG_MUTEX_LOCK(audio, audio->sourceLock)
+		FAudio_INTERNAL_AddNewSources(audio);
+		FAudio_PlatformUnlockMutex(audio->sourceLock);
+		LOG_MUTEX_UNLOCK(audio, audio->sourceLock)
 		while (audio->sources)
 		{
 			voice = (FAudioSourceVoice*) audio->sources->entry;
@@ -179,6 +184,8 @@ uint32_t FAudio_Release(FAudio *audio)
 			destroy_voice(audio->master);
 		FAudio_OPERATIONSET_ClearAll(audio);
 		FAudio_StopEngine(audio);
+		FAudio_INTERNAL_DestroyMixPool(audio);
+		FAudio_INTERNAL_DestroyPCMCache(audio);
 		audio->pFree(audio->decodeCache);
 		audio->pFree(audio->resampleCache);
 		audio->pFree(audio->effectChainCache);
@@ -237,6 +244,10 @@ uint32_t FAudio_Initialize(
 	audio->decodeSamples = 1;
 	audio->resampleSamples = 1;
 
+	FAudio_INTERNAL_CreateMixPool(audio);
+	FAudio_INTERNAL_CreatePCMCache(audio);
+	audio->perfLastQuery = FAudio_PlatformGetPerformanceCounter();
+
 	FAudio_StartEngine(audio);
 	LOG_API_EXIT(audio)
 	return 0;
@@ -416,6 +427,7 @@ uint32_t FAudio_CreateSourceVoice(
 	(*ppSourceVoice)->src.totalSamples = 0;
 	(*ppSourceVoice)->src.bufferList = NULL;
 	(*ppSourceVoice)->src.flushList = NULL;
+	(*ppSourceVoice)->src.submitQueue = NULL;
 	(*ppSourceVoice)->src.bufferLock = FAudio_PlatformCreateMutex();
 	LOG_MUTEX_CREATE(audio, (*ppSourceVoice)->src.bufferLock)
 
@@ -569,11 +581,10 @@ uint32_t FAudio_CreateSourceVoice(
 
 	LOG_INFO(audio, "-> %p", (void*) (*ppSourceVoice))
 
-	/* Add to list, finally. */
-	LinkedList_PrependEntry(
-		&audio->sources,
+	/* Add to list, finally. The mixer picks this up on its next pass. */
+	LinkedList_PushEntryAtomic(
+		&audio->newSources,
 		*ppSourceVoice,
-		audio->sourceLock,
 		audio->pMalloc
 	);
 
@@ -907,6 +918,7 @@ void FAudio_GetPerformanceData(
 ) {
 	LinkedList *list;
 	FAudioSourceVoice *source;
+	uint64_t now;
 
 	LOG_API_ENTER(audio)
 
@@ -914,6 +926,7 @@ void FAudio_GetPerformanceData(
 
 	FAudio_PlatformLockMutex(audio->sourceLock);
 	LOG_MUTEX_LOCK(audio, audio->sourceLock)
+	FAudio_INTERNAL_AddNewSources(audio);
 	list = audio->sources;
 	while (list != NULL)
 	{
@@ -945,6 +958,21 @@ void FAudio_GetPerformanceData(
 		pPerfData->CurrentLatencyInSamples = 2 * audio->updateSize;
 	}
 
+	/* Counted by FAudio_INTERNAL_GenerateOutput */
+	now = FAudio_PlatformGetPerformanceCounter();
+	FAudio_PlatformLockMutex(audio->operationLock);
+	LOG_MUTEX_LOCK(audio, audio->operationLock)
+	pPerfData->AudioCyclesSinceLastQuery = audio->perfAudioTicks;
+	pPerfData->TotalCyclesSinceLastQuery = now - audio->perfLastQuery;
+	pPerfData->MinimumCyclesPerQuantum = audio->perfMinTicks;
+	pPerfData->MaximumCyclesPerQuantum = audio->perfMaxTicks;
+	audio->perfAudioTicks = 0;
+	audio->perfLastQuery = now;
+	audio->perfMinTicks = 0;
+	audio->perfMaxTicks = 0;
+	FAudio_PlatformUnlockMutex(audio->operationLock);
+	LOG_MUTEX_UNLOCK(audio, audio->operationLock)
+
 	LOG_API_EXIT(audio)
 }
 
@@ -1276,7 +1304,7 @@ uint32_t FAudioVoice_SetOutputVoices(
 			}
 			else if (outChannels == 8)
 			{
-				voice->sendMix[i] = FAudio_INTERNAL_Mix_1in_8out_Scalar;
+				voice->sendMix[i] = FAudio_INTERNAL_Mix_1in_8out;
 			}
 			else
 			{
@@ -1299,7 +1327,7 @@ uint32_t FAudioVoice_SetOutputVoices(
 			}
 			else if (outChannels == 8)
 			{
-				voice->sendMix[i] = FAudio_INTERNAL_Mix_2in_8out_Scalar;
+				voice->sendMix[i] = FAudio_INTERNAL_Mix_2in_8out;
 			}
 			else
 			{
@@ -2288,6 +2316,7 @@ static uint32_t check_for_sends_to_voice(FAudioVoice *voice)
 	uint32_t i;
 
 	FAudio_PlatformLockMutex(audio->sourceLock);
+	FAudio_INTERNAL_AddNewSources(audio);
 	list = audio->sources;
 	while (list != NULL)
 	{
@@ -2351,12 +2380,14 @@ static void destroy_voice(FAudioVoice *voice)
 			FAudio_PlatformLockMutex(voice->audio->sourceLock);
 			LOG_MUTEX_LOCK(voice->audio, voice->audio->sourceLock)
 		}
+		FAudio_INTERNAL_AddNewSources(voice->audio);
 		LinkedList_RemoveEntry(
 			&voice->audio->sources,
 			voice,
 			voice->audio->sourceLock,
 			voice->audio->pFree
 		);
+		FAudio_INTERNAL_CancelVoiceMix(voice);
 		FAudio_PlatformUnlockMutex(voice->audio->sourceLock);
 		LOG_MUTEX_UNLOCK(voice->audio, voice->audio->sourceLock)
 
@@ -2364,6 +2395,7 @@ static void destroy_voice(FAudioVoice *voice)
 		while (entry != NULL)
 		{
 			next = entry->next;
+			FAudio_INTERNAL_ReleaseBufferEntry(voice->audio, entry);
 			voice->audio->pFree(entry);
 			entry = next;
 		}
@@ -2372,6 +2404,16 @@ static void destroy_voice(FAudioVoice *voice)
 		while (entry != NULL)
 		{
 			next = entry->next;
+			FAudio_INTERNAL_ReleaseBufferEntry(voice->audio, entry);
+			voice->audio->pFree(entry);
+			entry = next;
+		}
+
+		entry = voice->src.submitQueue;
+		while (entry != NULL)
+		{
+			next = entry->next;
+			FAudio_INTERNAL_ReleaseBufferEntry(voice->audio, entry);
 			voice->audio->pFree(entry);
 			entry = next;
 		}
@@ -2473,6 +2515,20 @@ static void destroy_voice(FAudioVoice *voice)
 		FAudio_PlatformDestroyMutex(voice->effectLock);
 	}
 
+	/* Parallel mixing caches */
+	if (voice->scratch.decodeCache != NULL)
+	{
+		voice->audio->pFree(voice->scratch.decodeCache);
+	}
+	if (voice->scratch.resampleCache != NULL)
+	{
+		voice->audio->pFree(voice->scratch.resampleCache);
+	}
+	if (voice->scratch.effectChainCache != NULL)
+	{
+		voice->audio->pFree(voice->scratch.effectChainCache);
+	}
+
 	if (voice->filterLock != NULL)
 	{
 		FAudio_PlatformLockMutex(voice->filterLock);
@@ -2738,6 +2794,7 @@ uint32_t FAudioSourceVoice_SubmitSourceBuffer(
 		FAudio_memcpy(&entry->bufferWMA, pBufferWMA, sizeof(FAudioBufferWMA));
 	}
 	entry->next = NULL;
+	FAudio_INTERNAL_PrefetchBuffer(voice, entry);
 
 	if (	voice->audio->version <= 7 && (
 		entry->buffer.LoopCount > 0 &&
@@ -2754,38 +2811,25 @@ uint32_t FAudioSourceVoice_SubmitSourceBuffer(
 	}
 #endif /* FAUDIO_DUMP_VOICES */
 
-	/* Submit! */
-	FAudio_PlatformLockMutex(voice->src.bufferLock);
-	LOG_MUTEX_LOCK(voice->audio, voice->src.bufferLock)
-	if (voice->src.bufferList == NULL)
-	{
-		voice->src.bufferList = entry;
-		voice->src.curBufferOffset = entry->buffer.PlayBegin;
-		voice->src.newBuffer = 1;
-	}
-	else
-	{
-		list = voice->src.bufferList;
-		while (list->next != NULL)
-		{
-			list = list->next;
-		}
-		list->next = entry;
-
-		/* For some bizarre reason we get scenarios where a buffer is freed, only to
-		 * have the allocator give us the exact same address and somehow get a single
-		 * buffer referencing itself. I don't even know.
-		 */
-		FAudio_assert(list != entry);
-	}
+	/* Submit! The entry is pushed onto a lock-free stack which the mixer
+	 * (or any other bufferLock holder) drains into bufferList, so game
+	 * threads never have to wait for a mix pass to finish.
+	 */
+	do
+	{
+		list = voice->src.submitQueue;
+		entry->next = list;
+	} while (FAudio_PlatformAtomicCompareExchangePointer(
+		(void**) &voice->src.submitQueue,
+		entry,
+		list
+	) != list);
 	LOG_INFO(
 		voice->audio,
 		"%p: appended buffer %p",
 		(void*) voice,
 		(void*) &entry->buffer
 	)
-	FAudio_PlatformUnlockMutex(voice->src.bufferLock);
-	LOG_MUTEX_UNLOCK(voice->audio, voice->src.bufferLock)
 	LOG_API_EXIT(voice->audio)
 	return 0;
 }
@@ -2801,6 +2845,7 @@ uint32_t FAudioSourceVoice_FlushSourceBuffers(
 	FAudio_PlatformLockMutex(voice->src.bufferLock);
 	LOG_MUTEX_LOCK(voice->audio, voice->src.bufferLock)
 
+	FAudio_INTERNAL_DrainSubmitQueue(voice);
 	/* If the source is playing, don't flush the active buffer */
 	entry = voice->src.bufferList;
 	if ((voice->src.active == 1) && entry != NULL && !voice->src.newBuffer)
@@ -2850,6 +2895,7 @@ uint32_t FAudioSourceVoice_Discontinuity(
 	FAudio_PlatformLockMutex(voice->src.bufferLock);
 	LOG_MUTEX_LOCK(voice->audio, voice->src.bufferLock)
 
+	FAudio_INTERNAL_DrainSubmitQueue(voice);
 	if (voice->src.bufferList != NULL)
 	{
 		for (buf = voice->src.bufferList; buf->next != NULL; buf = buf->next);
@@ -2883,6 +2929,7 @@ uint32_t FAudioSourceVoice_ExitLoop(
 	FAudio_PlatformLockMutex(voice->src.bufferLock);
 	LOG_MUTEX_LOCK(voice->audio, voice->src.bufferLock)
 
+	FAudio_INTERNAL_DrainSubmitQueue(voice);
 	if (voice->src.bufferList != NULL)
 	{
 		voice->src.bufferList->buffer.LoopCount = 0;
@@ -2907,6 +2954,7 @@ void FAudioSourceVoice_GetState(
 	FAudio_PlatformLockMutex(voice->src.bufferLock);
 	LOG_MUTEX_LOCK(voice->audio, voice->src.bufferLock)
 
+	FAudio_INTERNAL_DrainSubmitQueue(voice);
 	if (!(Flags & FAUDIO_VOICE_NOSAMPLESPLAYED))
 	{
 		pVoiceState->SamplesPlayed = voice->src.totalSamples;
@@ -3007,6 +3055,7 @@ uint32_t FAudioSourceVoice_SetSourceSampleRate(
 
 	FAudio_PlatformLockMutex(voice->src.bufferLock);
 	LOG_MUTEX_LOCK(voice->audio, voice->src.bufferLock)
+	FAudio_INTERNAL_DrainSubmitQueue(voice);
 	if (	voice->audio->version > 7 &&
 		voice->src.bufferList != NULL	)
 	{
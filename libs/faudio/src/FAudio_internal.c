@@ -205,6 +205,25 @@ void LinkedList_PrependEntry(
 	FAudio_PlatformUnlockMutex(lock);
 }
 
+void LinkedList_PushEntryAtomic(
+	LinkedList **start,
+	void* toAdd,
+	FAudioMallocFunc pMalloc
+) {
+	LinkedList *newEntry, *head;
+	newEntry = (LinkedList*) pMalloc(sizeof(LinkedList));
+	newEntry->entry = toAdd;
+	do
+	{
+		head = *start;
+		newEntry->next = head;
+	} while (FAudio_PlatformAtomicCompareExchangePointer(
+		(void**) start,
+		newEntry,
+		head
+	) != head);
+}
+
 void LinkedList_RemoveEntry(
 	LinkedList **start,
 	void* toRemove,
@@ -359,6 +378,86 @@ static uint32_t FAudio_INTERNAL_GetBytesRequested(
 	return result;
 }
 
+/* Must be called with the voice's bufferLock held! */
+void FAudio_INTERNAL_DrainSubmitQueue(FAudioSourceVoice *voice)
+{
+	FAudioBufferEntry *queue, *entry, *next, *list;
+
+	if (voice->src.submitQueue == NULL)
+	{
+		return;
+	}
+
+	/* Take the whole stack at once, so there's no ABA to worry about */
+	queue = (FAudioBufferEntry*) FAudio_PlatformAtomicExchangePointer(
+		(void**) &voice->src.submitQueue,
+		NULL
+	);
+
+	/* The stack is newest-first, flip it back to submission order */
+	entry = NULL;
+	while (queue != NULL)
+	{
+		next = queue->next;
+		queue->next = entry;
+		entry = queue;
+		queue = next;
+	}
+	if (entry == NULL)
+	{
+		return;
+	}
+
+	if (voice->src.bufferList == NULL)
+	{
+		voice->src.bufferList = entry;
+		voice->src.curBufferOffset = entry->buffer.PlayBegin;
+		voice->src.newBuffer = 1;
+	}
+	else
+	{
+		list = voice->src.bufferList;
+		while (list->next != NULL)
+		{
+			list = list->next;
+		}
+		list->next = entry;
+
+		/* For some bizarre reason we get scenarios where a buffer is freed, only to
+		 * have the allocator give us the exact same address and somehow get a single
+		 * buffer referencing itself. I don't even know.
+		 */
+		FAudio_assert(list != entry);
+	}
+}
+
+/* Must be called with the engine's sourceLock held! */
+void FAudio_INTERNAL_AddNewSources(FAudio *audio)
+{
+	LinkedList *added, *last;
+
+	if (audio->newSources == NULL)
+	{
+		return;
+	}
+
+	added = (LinkedList*) FAudio_PlatformAtomicExchangePointer(
+		(void**) &audio->newSources,
+		NULL
+	);
+	if (added == NULL)
+	{
+		return;
+	}
+
+	/* The stack is already newest-first, which is exactly what prepending
+	 * each voice to the source list would have given us.
+	 */
+	for (last = added; last->next != NULL; last = last->next);
+	last->next = audio->sources;
+	audio->sources = added;
+}
+
 static void FAudio_INTERNAL_DecodeBuffers(
 	FAudioSourceVoice *voice,
 	uint64_t *toDecode
@@ -418,7 +517,7 @@ static void FAudio_INTERNAL_DecodeBuffers(
 		);
 
 		/* Decode... */
-		voice->src.decode(
+		FAudio_INTERNAL_DecodeSourceBuffer(
 			voice,
 			buffer,
 			voice->audio->decodeCache + (
@@ -501,8 +600,10 @@ static void FAudio_INTERNAL_DecodeBuffers(
 				)
 
 				/* Change active buffer, delete finished buffer */
+				FAudio_INTERNAL_DrainSubmitQueue(voice);
 				toDelete = voice->src.bufferList;
 				voice->src.bufferList = voice->src.bufferList->next;
+				FAudio_INTERNAL_ReleaseBufferEntry(voice->audio, toDelete);
 				if (voice->src.bufferList != NULL)
 				{
 					buffer = &voice->src.bufferList->buffer;
@@ -562,6 +663,7 @@ static void FAudio_INTERNAL_DecodeBuffers(
 					LOG_MUTEX_LOCK(voice->audio, voice->src.bufferLock)
 
 					/* One last chance at redemption */
+					FAudio_INTERNAL_DrainSubmitQueue(voice);
 					if (buffer == NULL && voice->src.bufferList != NULL)
 					{
 						buffer = &voice->src.bufferList->buffer;
@@ -611,7 +713,7 @@ static void FAudio_INTERNAL_DecodeBuffers(
 			EXTRA_DECODE_PADDING
 		);
 
-		voice->src.decode(
+		FAudio_INTERNAL_DecodeSourceBuffer(
 			voice,
 			buffer,
 			voice->audio->decodeCache + (
@@ -691,15 +793,19 @@ static inline void FAudio_INTERNAL_FilterVoice(
 	LOG_FUNC_EXIT(audio)
 }
 
-static void FAudio_INTERNAL_ResizeEffectChainCache(FAudio *audio, uint32_t samples)
-{
+static void FAudio_INTERNAL_ResizeCache(
+	FAudio *audio,
+	float **cache,
+	uint32_t *cacheSamples,
+	uint32_t samples
+) {
 	LOG_FUNC_ENTER(audio)
-	if (samples > audio->effectChainSamples)
+	if (samples > *cacheSamples)
 	{
-		audio->effectChainSamples = samples;
-		audio->effectChainCache = (float*) audio->pRealloc(
-			audio->effectChainCache,
-			sizeof(float) * audio->effectChainSamples
+		*cacheSamples = samples;
+		*cache = (float*) audio->pRealloc(
+			*cache,
+			sizeof(float) * samples
 		);
 	}
 	LOG_FUNC_EXIT(audio)
@@ -708,7 +814,9 @@ static void FAudio_INTERNAL_ResizeEffectChainCache(FAudio *audio, uint32_t sampl
 static inline float *FAudio_INTERNAL_ProcessEffectChain(
 	FAudioVoice *voice,
 	float *buffer,
-	uint32_t *samples
+	uint32_t *samples,
+	float **effectChainCache,
+	uint32_t *effectChainSamples
 ) {
 	uint32_t i;
 	FAPO *fapo;
@@ -743,11 +851,13 @@ static inline float *FAudio_INTERNAL_ProcessEffectChain(
 		{
 			if (dstParams.pBuffer == buffer)
 			{
-				FAudio_INTERNAL_ResizeEffectChainCache(
+				FAudio_INTERNAL_ResizeCache(
 					voice->audio,
+					effectChainCache,
+					effectChainSamples,
 					voice->effects.desc[i].OutputChannels * srcParams.ValidFrameCount
 				);
-				dstParams.pBuffer = voice->audio->effectChainCache;
+				dstParams.pBuffer = *effectChainCache;
 			}
 			else
 			{
@@ -796,39 +906,85 @@ static inline float *FAudio_INTERNAL_ProcessEffectChain(
 
 static void FAudio_INTERNAL_ResizeResampleCache(FAudio *audio, uint32_t samples)
 {
-       LOG_FUNC_ENTER(audio)
-       if (samples > audio->resampleSamples)
-       {
-               audio->resampleSamples = samples;
-               audio->resampleCache = (float*) audio->pRealloc(
-                       audio->resampleCache,
-                       sizeof(float) * audio->resampleSamples
-               );
-       }
-       LOG_FUNC_EXIT(audio)
+	FAudio_INTERNAL_ResizeCache(
+		audio,
+		&audio->resampleCache,
+		&audio->resampleSamples,
+		samples
+	);
 }
 
-static void FAudio_INTERNAL_MixSource(FAudioSourceVoice *voice)
-{
-	/* Iterators */
-	uint32_t i;
+/* Mixes the final samples of a voice into the stream of one of its sends.
+ * The caller must hold the voice's sendLock and volumeLock.
+ */
+static void FAudio_INTERNAL_MixSend(
+	FAudioVoice *voice,
+	uint32_t send,
+	float *samples,
+	uint32_t mixed
+) {
+	float *stream;
+	uint32_t oChan;
+	FAudioVoice *out;
+
+	out = voice->sends.pSends[send].pOutputVoice;
+	if (out->type == FAUDIO_VOICE_MASTER)
+	{
+		stream = out->master.output;
+		oChan = out->master.inputChannels;
+	}
+	else
+	{
+		stream = out->mix.inputCache;
+		oChan = out->mix.inputChannels;
+	}
+
+	voice->sendMix[send](
+		mixed,
+		voice->outputChannels,
+		oChan,
+		samples,
+		stream,
+		voice->mixCoefficients[send]
+	);
+
+	if (voice->sends.pSends[send].Flags & FAUDIO_SEND_USEFILTER)
+	{
+		FAudio_INTERNAL_FilterVoice(
+			voice->audio,
+			&voice->sendFilter[send],
+			voice->sendFilterState[send],
+			stream,
+			mixed,
+			oChan
+		);
+	}
+}
+
+/* Runs the buffer queue and the client callbacks of a source voice for one
+ * update. Called with the sendLock held; if there is nothing to mix the
+ * sendLock is released and 0 is returned. Otherwise *samples points to
+ * *decoded frames of decoded (or silent) data, *mixed is the number of
+ * output frames and *resample tells whether *samples still has to be
+ * resampled to get them.
+ */
+static uint8_t FAudio_INTERNAL_DecodeSource(
+	FAudioSourceVoice *voice,
+	float **samples,
+	uint32_t *decoded,
+	uint32_t *mixed,
+	uint8_t *resample
+) {
 	/* Decode/Resample variables */
 	uint64_t toDecode;
 	uint64_t toResample;
-	/* Output mix variables */
-	float *stream;
-	uint32_t mixed;
-	uint32_t oChan;
+	/* Output variables */
 	FAudioVoice *out;
 	uint32_t outputRate;
 	double stepd;
-	float *finalSamples;
 
 	LOG_FUNC_ENTER(voice->audio)
 
-	FAudio_PlatformLockMutex(voice->sendLock);
-	LOG_MUTEX_LOCK(voice->audio, voice->sendLock)
-
 	/* Calculate the resample stepping value */
 	if (voice->src.resampleFreq != voice->src.freqRatio * voice->src.format->nSamplesPerSec)
 	{
@@ -850,17 +1006,7 @@ static void FAudio_INTERNAL_MixSource(FAudioSourceVoice *voice)
 	if (voice->src.active == 2)
 	{
 		/* We're just playing tails, skip all buffer stuff */
-		FAudio_INTERNAL_ResizeResampleCache(
-				voice->audio,
-				voice->src.resampleSamples * voice->src.format->nChannels
-		);
-		mixed = voice->src.resampleSamples;
-		FAudio_zero(
-			voice->audio->resampleCache,
-			mixed * voice->src.format->nChannels * sizeof(float)
-		);
-		finalSamples = voice->audio->resampleCache;
-		goto sendwork;
+		goto silence;
 	}
 
 	/* Base decode size, int to fixed... */
@@ -896,6 +1042,7 @@ static void FAudio_INTERNAL_MixSource(FAudioSourceVoice *voice)
 	LOG_MUTEX_LOCK(voice->audio, voice->src.bufferLock)
 
 	/* Nothing to do? */
+	FAudio_INTERNAL_DrainSubmitQueue(voice);
 	if (voice->src.bufferList == NULL)
 	{
 		FAudio_PlatformUnlockMutex(voice->src.bufferLock);
@@ -904,17 +1051,7 @@ static void FAudio_INTERNAL_MixSource(FAudioSourceVoice *voice)
 		if (voice->effects.count > 0 && voice->effects.state != FAPO_BUFFER_SILENT)
 		{
 			/* do not stop while the effect chain generates a non-silent buffer */
-			FAudio_INTERNAL_ResizeResampleCache(
-					voice->audio,
-					voice->src.resampleSamples * voice->src.format->nChannels
-			);
-			mixed = voice->src.resampleSamples;
-			FAudio_zero(
-				voice->audio->resampleCache,
-				mixed * voice->src.format->nChannels * sizeof(float)
-			);
-			finalSamples = voice->audio->resampleCache;
-			goto sendwork;
+			goto silence;
 		}
 
 		FAudio_PlatformUnlockMutex(voice->sendLock);
@@ -935,7 +1072,7 @@ static void FAudio_INTERNAL_MixSource(FAudioSourceVoice *voice)
 		LOG_MUTEX_LOCK(voice->audio, voice->audio->sourceLock)
 
 		LOG_FUNC_EXIT(voice->audio)
-		return;
+		return 0;
 	}
 
 	/* Decode... */
@@ -985,7 +1122,7 @@ static void FAudio_INTERNAL_MixSource(FAudioSourceVoice *voice)
 		LOG_MUTEX_UNLOCK(voice->audio, voice->sendLock)
 
 		LOG_FUNC_EXIT(voice->audio)
-		return;
+		return 0;
 	}
 
 	/* int to fixed... */
@@ -1001,29 +1138,6 @@ static void FAudio_INTERNAL_MixSource(FAudioSourceVoice *voice)
 	/* FIXME: I feel like this should be an assert but I suck */
 	toResample = FAudio_min(toResample, voice->src.resampleSamples);
 
-	/* Resample... */
-	if (voice->src.resampleStep == FIXED_ONE)
-	{
-		/* Actually, just use the existing buffer... */
-		finalSamples = voice->audio->decodeCache;
-	}
-	else
-	{
-		FAudio_INTERNAL_ResizeResampleCache(
-				voice->audio,
-				voice->src.resampleSamples * voice->src.format->nChannels
-		);
-		voice->src.resample(
-			voice->audio->decodeCache,
-			voice->audio->resampleCache,
-			&voice->src.resampleOffset,
-			voice->src.resampleStep,
-			toResample,
-			(uint8_t) voice->src.format->nChannels
-		);
-		finalSamples = voice->audio->resampleCache;
-	}
-
 	/* Update buffer offsets */
 	if (voice->src.bufferList != NULL)
 	{
@@ -1050,9 +1164,44 @@ static void FAudio_INTERNAL_MixSource(FAudioSourceVoice *voice)
 	/* Done with buffers, finally. */
 	FAudio_PlatformUnlockMutex(voice->src.bufferLock);
 	LOG_MUTEX_UNLOCK(voice->audio, voice->src.bufferLock)
-	mixed = (uint32_t) toResample;
 
-sendwork:
+	/* Resampling is left to the caller, it may happen off this thread */
+	*samples = voice->audio->decodeCache;
+	*decoded = (uint32_t) toDecode + EXTRA_DECODE_PADDING;
+	*mixed = (uint32_t) toResample;
+	*resample = (voice->src.resampleStep != FIXED_ONE);
+	LOG_FUNC_EXIT(voice->audio)
+	return 1;
+
+silence:
+	FAudio_INTERNAL_ResizeResampleCache(
+			voice->audio,
+			voice->src.resampleSamples * voice->src.format->nChannels
+	);
+	FAudio_zero(
+		voice->audio->resampleCache,
+		voice->src.resampleSamples * voice->src.format->nChannels * sizeof(float)
+	);
+	*samples = voice->audio->resampleCache;
+	*decoded = voice->src.resampleSamples;
+	*mixed = voice->src.resampleSamples;
+	*resample = 0;
+	LOG_FUNC_EXIT(voice->audio)
+	return 1;
+}
+
+/* Applies the voice filter and the effect chain to the resampled output of a
+ * source voice. Returns the final samples, *mixed is updated to the number of
+ * frames they contain.
+ */
+static float *FAudio_INTERNAL_RenderSource(
+	FAudioSourceVoice *voice,
+	float *finalSamples,
+	uint32_t *mixed,
+	float **effectChainCache,
+	uint32_t *effectChainSamples
+) {
+	LOG_FUNC_ENTER(voice->audio)
 
 	/* Filters */
 	if (voice->flags & FAUDIO_VOICE_USEFILTER)
@@ -1064,7 +1213,7 @@ sendwork:
 			&voice->filter,
 			voice->filterState,
 			finalSamples,
-			mixed,
+			*mixed,
 			voice->src.format->nChannels
 		);
 		FAudio_PlatformUnlockMutex(voice->filterLock);
@@ -1079,91 +1228,116 @@ sendwork:
 		/* If we didn't get the full size of the update, we have to fill
 		 * it with silence so the effect can process a whole update
 		 */
-		if (mixed < voice->src.resampleSamples)
+		if (*mixed < voice->src.resampleSamples)
 		{
 			FAudio_zero(
-				finalSamples + (mixed * voice->src.format->nChannels),
-				(voice->src.resampleSamples - mixed) * voice->src.format->nChannels * sizeof(float)
+				finalSamples + (*mixed * voice->src.format->nChannels),
+				(voice->src.resampleSamples - *mixed) * voice->src.format->nChannels * sizeof(float)
 			);
-			mixed = voice->src.resampleSamples;
+			*mixed = voice->src.resampleSamples;
 		}
 		finalSamples = FAudio_INTERNAL_ProcessEffectChain(
 			voice,
 			finalSamples,
-			&mixed
+			mixed,
+			effectChainCache,
+			effectChainSamples
 		);
 	}
+	voice->scratch.outputChannels = voice->outputChannels;
 	FAudio_PlatformUnlockMutex(voice->effectLock);
 	LOG_MUTEX_UNLOCK(voice->audio, voice->effectLock)
 
-	/* Nowhere to send it? Just skip the rest...*/
-	if (voice->sends.SendCount == 0)
-	{
-		FAudio_PlatformUnlockMutex(voice->sendLock);
-		LOG_MUTEX_UNLOCK(voice->audio, voice->sendLock)
+	LOG_FUNC_EXIT(voice->audio)
+	return finalSamples;
+}
+
+static void FAudio_INTERNAL_MixSource(FAudioSourceVoice *voice)
+{
+	/* Iterators */
+	uint32_t i;
+	/* Output mix variables */
+	uint32_t decoded;
+	uint32_t mixed;
+	uint8_t resample;
+	float *finalSamples;
+
+	LOG_FUNC_ENTER(voice->audio)
+
+	FAudio_PlatformLockMutex(voice->sendLock);
+	LOG_MUTEX_LOCK(voice->audio, voice->sendLock)
+
+	if (!FAudio_INTERNAL_DecodeSource(
+		voice,
+		&finalSamples,
+		&decoded,
+		&mixed,
+		&resample
+	)) {
 		LOG_FUNC_EXIT(voice->audio)
 		return;
 	}
 
-	/* Send float cache to sends */
-	FAudio_PlatformLockMutex(voice->volumeLock);
-	LOG_MUTEX_LOCK(voice->audio, voice->volumeLock)
-	for (i = 0; i < voice->sends.SendCount; i += 1)
+	/* Resample... */
+	if (resample)
 	{
-		out = voice->sends.pSends[i].pOutputVoice;
-		if (out->type == FAUDIO_VOICE_MASTER)
-		{
-			stream = out->master.output;
-			oChan = out->master.inputChannels;
-		}
-		else
-		{
-			stream = out->mix.inputCache;
-			oChan = out->mix.inputChannels;
-		}
-
-		voice->sendMix[i](
+		FAudio_INTERNAL_ResizeResampleCache(
+				voice->audio,
+				voice->src.resampleSamples * voice->src.format->nChannels
+		);
+		voice->src.resample(
+			voice->audio->decodeCache,
+			voice->audio->resampleCache,
+			&voice->src.resampleOffset,
+			voice->src.resampleStep,
 			mixed,
-			voice->outputChannels,
-			oChan,
-			finalSamples,
-			stream,
-			voice->mixCoefficients[i]
+			(uint8_t) voice->src.format->nChannels
 		);
+		finalSamples = voice->audio->resampleCache;
+	}
+
+	finalSamples = FAudio_INTERNAL_RenderSource(
+		voice,
+		finalSamples,
+		&mixed,
+		&voice->audio->effectChainCache,
+		&voice->audio->effectChainSamples
+	);
 
-		if (voice->sends.pSends[i].Flags & FAUDIO_SEND_USEFILTER)
+	/* Send float cache to sends */
+	if (voice->sends.SendCount > 0)
+	{
+		FAudio_PlatformLockMutex(voice->volumeLock);
+		LOG_MUTEX_LOCK(voice->audio, voice->volumeLock)
+		for (i = 0; i < voice->sends.SendCount; i += 1)
 		{
-			FAudio_INTERNAL_FilterVoice(
-				voice->audio,
-				&voice->sendFilter[i],
-				voice->sendFilterState[i],
-				stream,
-				mixed,
-				oChan
-			);
+			FAudio_INTERNAL_MixSend(voice, i, finalSamples, mixed);
 		}
+		FAudio_PlatformUnlockMutex(voice->volumeLock);
+		LOG_MUTEX_UNLOCK(voice->audio, voice->volumeLock)
 	}
-	FAudio_PlatformUnlockMutex(voice->volumeLock);
-	LOG_MUTEX_UNLOCK(voice->audio, voice->volumeLock)
 
 	FAudio_PlatformUnlockMutex(voice->sendLock);
 	LOG_MUTEX_UNLOCK(voice->audio, voice->sendLock)
 	LOG_FUNC_EXIT(voice->audio)
 }
 
-static void FAudio_INTERNAL_MixSubmix(FAudioSubmixVoice *voice)
-{
-	uint32_t i;
-	float *stream;
-	uint32_t oChan;
-	FAudioVoice *out;
-	uint32_t resampled;
+/* Resamples, amplifies, filters and runs the effect chain on the input of a
+ * submix voice. Returns the final samples, *resampled is set to the number
+ * of frames they contain.
+ */
+static float *FAudio_INTERNAL_RenderSubmix(
+	FAudioSubmixVoice *voice,
+	uint32_t *resampled,
+	float **resampleCache,
+	uint32_t *resampleSamples,
+	float **effectChainCache,
+	uint32_t *effectChainSamples
+) {
 	uint64_t resampleOffset = 0;
 	float *finalSamples;
 
 	LOG_FUNC_ENTER(voice->audio)
-	FAudio_PlatformLockMutex(voice->sendLock);
-	LOG_MUTEX_LOCK(voice->audio, voice->sendLock)
 
 	/* Resample */
 	if (voice->mix.resampleStep == FIXED_ONE)
@@ -1173,32 +1347,34 @@ static void FAudio_INTERNAL_MixSubmix(FAudioSubmixVoice *voice)
 	}
 	else
 	{
-		FAudio_INTERNAL_ResizeResampleCache(
+		FAudio_INTERNAL_ResizeCache(
 				voice->audio,
+				resampleCache,
+				resampleSamples,
 				voice->mix.outputSamples * voice->mix.inputChannels
 		);
 		voice->mix.resample(
 			voice->mix.inputCache,
-			voice->audio->resampleCache,
+			*resampleCache,
 			&resampleOffset,
 			voice->mix.resampleStep,
 			voice->mix.outputSamples,
 			(uint8_t) voice->mix.inputChannels
 		);
-		finalSamples = voice->audio->resampleCache;
+		finalSamples = *resampleCache;
 	}
-	resampled = voice->mix.outputSamples * voice->mix.inputChannels;
+	*resampled = voice->mix.outputSamples * voice->mix.inputChannels;
 
 	/* Submix overall volume is applied _before_ effects/filters, blech! */
 	if (voice->volume != 1.0f)
 	{
 		FAudio_INTERNAL_Amplify(
 			finalSamples,
-			resampled,
+			*resampled,
 			voice->volume
 		);
 	}
-	resampled /= voice->mix.inputChannels;
+	*resampled /= voice->mix.inputChannels;
 
 	/* Filters */
 	if (voice->flags & FAUDIO_VOICE_USEFILTER)
@@ -1210,7 +1386,7 @@ static void FAudio_INTERNAL_MixSubmix(FAudioSubmixVoice *voice)
 			&voice->filter,
 			voice->filterState,
 			finalSamples,
-			resampled,
+			*resampled,
 			voice->mix.inputChannels
 		);
 		FAudio_PlatformUnlockMutex(voice->filterLock);
@@ -1225,12 +1401,38 @@ static void FAudio_INTERNAL_MixSubmix(FAudioSubmixVoice *voice)
 		finalSamples = FAudio_INTERNAL_ProcessEffectChain(
 			voice,
 			finalSamples,
-			&resampled
+			resampled,
+			effectChainCache,
+			effectChainSamples
 		);
 	}
+	voice->scratch.outputChannels = voice->outputChannels;
 	FAudio_PlatformUnlockMutex(voice->effectLock);
 	LOG_MUTEX_UNLOCK(voice->audio, voice->effectLock)
 
+	LOG_FUNC_EXIT(voice->audio)
+	return finalSamples;
+}
+
+static void FAudio_INTERNAL_MixSubmix(FAudioSubmixVoice *voice)
+{
+	uint32_t i;
+	uint32_t resampled;
+	float *finalSamples;
+
+	LOG_FUNC_ENTER(voice->audio)
+	FAudio_PlatformLockMutex(voice->sendLock);
+	LOG_MUTEX_LOCK(voice->audio, voice->sendLock)
+
+	finalSamples = FAudio_INTERNAL_RenderSubmix(
+		voice,
+		&resampled,
+		&voice->audio->resampleCache,
+		&voice->audio->resampleSamples,
+		&voice->audio->effectChainCache,
+		&voice->audio->effectChainSamples
+	);
+
 	/* Nothing more to do? */
 	if (voice->sends.SendCount == 0)
 	{
@@ -1242,38 +1444,7 @@ static void FAudio_INTERNAL_MixSubmix(FAudioSubmixVoice *voice)
 	LOG_MUTEX_LOCK(voice->audio, voice->volumeLock)
 	for (i = 0; i < voice->sends.SendCount; i += 1)
 	{
-		out = voice->sends.pSends[i].pOutputVoice;
-		if (out->type == FAUDIO_VOICE_MASTER)
-		{
-			stream = out->master.output;
-			oChan = out->master.inputChannels;
-		}
-		else
-		{
-			stream = out->mix.inputCache;
-			oChan = out->mix.inputChannels;
-		}
-
-		voice->sendMix[i](
-			resampled,
-			voice->outputChannels,
-			oChan,
-			finalSamples,
-			stream,
-			voice->mixCoefficients[i]
-		);
-
-		if (voice->sends.pSends[i].Flags & FAUDIO_SEND_USEFILTER)
-		{
-			FAudio_INTERNAL_FilterVoice(
-				voice->audio,
-				&voice->sendFilter[i],
-				voice->sendFilterState[i],
-				stream,
-				resampled,
-				oChan
-			);
-		}
+		FAudio_INTERNAL_MixSend(voice, i, finalSamples, resampled);
 	}
 	FAudio_PlatformUnlockMutex(voice->volumeLock);
 	LOG_MUTEX_UNLOCK(voice->audio, voice->volumeLock)
@@ -1301,6 +1472,7 @@ static void FAudio_INTERNAL_FlushPendingBuffers(FAudioSourceVoice *voice)
 	{
 		entry = voice->src.flushList;
 		voice->src.flushList = voice->src.flushList->next;
+		FAudio_INTERNAL_ReleaseBufferEntry(voice->audio, entry);
 
 		if (voice->src.callback != NULL && voice->src.callback->OnBufferEnd != NULL)
 		{
@@ -1328,19 +1500,558 @@ static void FAudio_INTERNAL_FlushPendingBuffers(FAudioSourceVoice *voice)
 	LOG_MUTEX_UNLOCK(voice->audio, voice->src.bufferLock)
 }
 
-static void FAUDIOCALL FAudio_INTERNAL_GenerateOutput(FAudio *audio, float *output)
+/* Parallel Mixing */
+
+/* Below this many active sources the pool is not worth waking up */
+#define FAUDIO_MIX_MIN_VOICES 8
+
+typedef void (*FAudioMixJob)(FAudioMixPool *pool, uint32_t index);
+
+struct FAudioMixPool
 {
-	uint32_t totalSamples;
-	LinkedList *list;
-	float *effectOut;
-	FAudioEngineCallback *callback;
+	FAudio *audio;
+
+	uint32_t threadCount;
+	FAudioThread *threads;
+	FAudioSemaphore start;
+	FAudioSemaphore done;
+	FAudioMutex jobLock;
+	uint8_t quit;
+
+	/* Current job batch, index claimed under jobLock */
+	FAudioMixJob job;
+	uint32_t jobCount;
+	uint32_t nextJob;
+
+	/* Voices rendered by the current pass, in mixing order */
+	FAudioVoice **voices;
+	uint32_t voiceCount;
+	uint32_t voiceCapacity;
+
+	/* Destinations of those voices, in order of first use */
+	FAudioVoice **outputs;
+	uint32_t outputCount;
+	uint32_t outputCapacity;
+};
 
-	LOG_FUNC_ENTER(audio)
-	if (!audio->active)
+static void FAudio_INTERNAL_MixPoolWork(FAudioMixPool *pool)
+{
+	uint32_t index;
+
+	while (1)
+	{
+		FAudio_PlatformLockMutex(pool->jobLock);
+		index = pool->nextJob;
+		if (index < pool->jobCount)
+		{
+			pool->nextJob += 1;
+		}
+		FAudio_PlatformUnlockMutex(pool->jobLock);
+
+		if (index >= pool->jobCount)
+		{
+			break;
+		}
+		pool->job(pool, index);
+	}
+}
+
+static int32_t FAUDIOCALL FAudio_INTERNAL_MixThread(void *user)
+{
+	FAudioMixPool *pool = (FAudioMixPool*) user;
+
+	FAudio_PlatformThreadPriority(FAUDIO_THREAD_PRIORITY_HIGH);
+
+	while (1)
+	{
+		FAudio_PlatformWaitSemaphore(pool->start);
+		if (pool->quit)
+		{
+			break;
+		}
+		FAudio_INTERNAL_MixPoolWork(pool);
+		FAudio_PlatformSignalSemaphore(pool->done, 1);
+	}
+	return 0;
+}
+
+/* Runs job(0) ... job(count - 1) on the pool and the calling thread, and
+ * returns once all of them are done.
+ */
+static void FAudio_INTERNAL_MixPoolRun(
+	FAudioMixPool *pool,
+	FAudioMixJob job,
+	uint32_t count
+) {
+	uint32_t i, workers;
+
+	if (count == 0)
+	{
+		return;
+	}
+
+	pool->job = job;
+	pool->jobCount = count;
+	pool->nextJob = 0;
+
+	workers = FAudio_min(pool->threadCount, count - 1);
+	FAudio_PlatformSignalSemaphore(pool->start, workers);
+	FAudio_INTERNAL_MixPoolWork(pool);
+	for (i = 0; i < workers; i += 1)
+	{
+		FAudio_PlatformWaitSemaphore(pool->done);
+	}
+}
+
+static void FAudio_INTERNAL_MixPoolGrow(
+	FAudio *audio,
+	FAudioVoice ***array,
+	uint32_t *capacity,
+	uint32_t count
+) {
+	if (count >= *capacity)
+	{
+		*capacity = FAudio_max(*capacity * 2, 16);
+		*array = (FAudioVoice**) audio->pRealloc(
+			*array,
+			sizeof(FAudioVoice*) * *capacity
+		);
+	}
+}
+
+static void FAudio_INTERNAL_MixPoolAddVoice(
+	FAudioMixPool *pool,
+	FAudioVoice *voice
+) {
+	FAudio_INTERNAL_MixPoolGrow(
+		pool->audio,
+		&pool->voices,
+		&pool->voiceCapacity,
+		pool->voiceCount
+	);
+	pool->voices[pool->voiceCount++] = voice;
+}
+
+static void FAudio_INTERNAL_MixPoolAddOutput(
+	FAudioMixPool *pool,
+	FAudioVoice *voice
+) {
+	uint32_t i;
+
+	for (i = 0; i < pool->outputCount; i += 1)
+	{
+		if (pool->outputs[i] == voice)
+		{
+			return;
+		}
+	}
+	FAudio_INTERNAL_MixPoolGrow(
+		pool->audio,
+		&pool->outputs,
+		&pool->outputCapacity,
+		pool->outputCount
+	);
+	pool->outputs[pool->outputCount++] = voice;
+}
+
+void FAudio_INTERNAL_CreateMixPool(FAudio *audio)
+{
+	FAudioMixPool *pool;
+	const char *env;
+	uint32_t i, threads;
+
+	env = FAudio_getenv("FAUDIO_MIX_THREADS");
+	if (env == NULL || FAudio_atoi(env) <= 0)
+	{
+		return;
+	}
+	/* The mixing thread helps with the jobs, but keep at least one worker
+	 * when explicitly requested so that the pool is also used, and can be
+	 * tested, on single CPU machines.
+	 */
+	threads = (uint32_t) FAudio_atoi(env);
+	threads = FAudio_min(threads, FAudio_max(FAudio_PlatformGetCPUCount() - 1, 1));
+	threads = FAudio_min(threads, 16);
+
+	pool = (FAudioMixPool*) audio->pMalloc(sizeof(FAudioMixPool));
+	FAudio_zero(pool, sizeof(FAudioMixPool));
+	pool->audio = audio;
+	pool->start = FAudio_PlatformCreateSemaphore(0);
+	pool->done = FAudio_PlatformCreateSemaphore(0);
+	pool->jobLock = FAudio_PlatformCreateMutex();
+	pool->threads = (FAudioThread*) audio->pMalloc(
+		sizeof(FAudioThread) * threads
+	);
+	for (i = 0; i < threads; i += 1)
+	{
+		pool->threads[i] = FAudio_PlatformCreateThread(
+			FAudio_INTERNAL_MixThread,
+			"FAudioMixThread",
+			pool
+		);
+		if (pool->threads[i] == NULL)
+		{
+			break;
+		}
+	}
+	pool->threadCount = i;
+	audio->mixPool = pool;
+
+	if (pool->threadCount == 0)
+	{
+		FAudio_INTERNAL_DestroyMixPool(audio);
+	}
+}
+
+void FAudio_INTERNAL_DestroyMixPool(FAudio *audio)
+{
+	FAudioMixPool *pool = audio->mixPool;
+	uint32_t i;
+
+	if (pool == NULL)
+	{
+		return;
+	}
+
+	pool->quit = 1;
+	FAudio_PlatformSignalSemaphore(pool->start, pool->threadCount);
+	for (i = 0; i < pool->threadCount; i += 1)
+	{
+		FAudio_PlatformWaitThread(pool->threads[i], NULL);
+	}
+
+	FAudio_PlatformDestroySemaphore(pool->start);
+	FAudio_PlatformDestroySemaphore(pool->done);
+	FAudio_PlatformDestroyMutex(pool->jobLock);
+	audio->pFree(pool->threads);
+	audio->pFree(pool->voices);
+	audio->pFree(pool->outputs);
+	audio->pFree(pool);
+	audio->mixPool = NULL;
+}
+
+void FAudio_INTERNAL_CancelVoiceMix(FAudioSourceVoice *voice)
+{
+	FAudioMixPool *pool = voice->audio->mixPool;
+	uint32_t i;
+
+	/* Called with the sourceLock held, so no pass is running right now,
+	 * but the voice may still be queued for the rest of this one.
+	 */
+	if (pool == NULL)
+	{
+		return;
+	}
+	for (i = 0; i < pool->voiceCount; i += 1)
+	{
+		if (pool->voices[i] == voice)
+		{
+			pool->voices[i] = NULL;
+		}
+	}
+}
+
+static void FAudio_INTERNAL_RenderSourceJob(FAudioMixPool *pool, uint32_t index)
+{
+	FAudioSourceVoice *voice = pool->voices[index];
+	float *finalSamples;
+	uint32_t mixed;
+
+	if (voice == NULL)
+	{
+		return;
+	}
+
+	finalSamples = voice->scratch.decodeCache;
+	mixed = voice->scratch.outputSamples;
+	if (voice->scratch.toResample > 0)
+	{
+		FAudio_INTERNAL_ResizeCache(
+			voice->audio,
+			&voice->scratch.resampleCache,
+			&voice->scratch.resampleSamples,
+			voice->src.resampleSamples * voice->src.format->nChannels
+		);
+		voice->src.resample(
+			voice->scratch.decodeCache,
+			voice->scratch.resampleCache,
+			&voice->src.resampleOffset,
+			voice->src.resampleStep,
+			voice->scratch.toResample,
+			(uint8_t) voice->src.format->nChannels
+		);
+		finalSamples = voice->scratch.resampleCache;
+	}
+
+	voice->scratch.output = FAudio_INTERNAL_RenderSource(
+		voice,
+		finalSamples,
+		&mixed,
+		&voice->scratch.effectChainCache,
+		&voice->scratch.effectChainSamples
+	);
+	voice->scratch.outputSamples = mixed;
+}
+
+static void FAudio_INTERNAL_RenderSubmixJob(FAudioMixPool *pool, uint32_t index)
+{
+	FAudioSubmixVoice *voice = pool->voices[index];
+	uint32_t resampled;
+
+	voice->scratch.output = FAudio_INTERNAL_RenderSubmix(
+		voice,
+		&resampled,
+		&voice->scratch.resampleCache,
+		&voice->scratch.resampleSamples,
+		&voice->scratch.effectChainCache,
+		&voice->scratch.effectChainSamples
+	);
+	voice->scratch.outputSamples = resampled;
+}
+
+/* Every destination is owned by exactly one job, which mixes the voices in
+ * the same order the serial mixer would, so the output does not change.
+ */
+static void FAudio_INTERNAL_MixSendsJob(FAudioMixPool *pool, uint32_t index)
+{
+	FAudioVoice *out = pool->outputs[index];
+	FAudioVoice *voice;
+	uint32_t i, j;
+
+	for (i = 0; i < pool->voiceCount; i += 1)
+	{
+		voice = pool->voices[i];
+		if (voice == NULL || voice->scratch.outputChannels != voice->outputChannels)
+		{
+			continue;
+		}
+
+		FAudio_PlatformLockMutex(voice->volumeLock);
+		LOG_MUTEX_LOCK(voice->audio, voice->volumeLock)
+		for (j = 0; j < voice->sends.SendCount; j += 1)
+		{
+			if (voice->sends.pSends[j].pOutputVoice == out)
+			{
+				FAudio_INTERNAL_MixSend(
+					voice,
+					j,
+					voice->scratch.output,
+					voice->scratch.outputSamples
+				);
+			}
+		}
+		FAudio_PlatformUnlockMutex(voice->volumeLock);
+		LOG_MUTEX_UNLOCK(voice->audio, voice->volumeLock)
+	}
+}
+
+/* Sends the rendered voices of the pool to their destinations */
+static void FAudio_INTERNAL_MixPoolSends(FAudioMixPool *pool)
+{
+	FAudioVoice *voice;
+	uint32_t i, j;
+
+	pool->outputCount = 0;
+	for (i = 0; i < pool->voiceCount; i += 1)
+	{
+		voice = pool->voices[i];
+		if (voice == NULL)
+		{
+			continue;
+		}
+		FAudio_PlatformLockMutex(voice->sendLock);
+		LOG_MUTEX_LOCK(voice->audio, voice->sendLock)
+		for (j = 0; j < voice->sends.SendCount; j += 1)
+		{
+			FAudio_INTERNAL_MixPoolAddOutput(
+				pool,
+				voice->sends.pSends[j].pOutputVoice
+			);
+		}
+	}
+
+	FAudio_INTERNAL_MixPoolRun(
+		pool,
+		FAudio_INTERNAL_MixSendsJob,
+		pool->outputCount
+	);
+
+	for (i = 0; i < pool->voiceCount; i += 1)
+	{
+		voice = pool->voices[i];
+		if (voice != NULL)
+		{
+			FAudio_PlatformUnlockMutex(voice->sendLock);
+			LOG_MUTEX_UNLOCK(voice->audio, voice->sendLock)
+		}
+	}
+}
+
+/* Decoding and all client callbacks stay on the engine thread and happen in
+ * list order, only resampling, filters, effects and sends are spread over
+ * the pool. Called with the sourceLock held.
+ */
+static void FAudio_INTERNAL_MixSourcesParallel(FAudio *audio)
+{
+	FAudioMixPool *pool = audio->mixPool;
+	FAudioSourceVoice *voice;
+	LinkedList *list;
+	float *samples;
+	uint32_t decoded, mixed;
+	uint8_t resample;
+
+	LOG_FUNC_ENTER(audio)
+
+	pool->voiceCount = 0;
+	list = audio->sources;
+	while (list != NULL)
+	{
+		voice = (FAudioSourceVoice*) list->entry;
+		audio->processingSource = voice;
+
+		FAudio_INTERNAL_FlushPendingBuffers(voice);
+		if (voice->src.active)
+		{
+			FAudio_PlatformLockMutex(voice->sendLock);
+			LOG_MUTEX_LOCK(audio, voice->sendLock)
+			if (FAudio_INTERNAL_DecodeSource(
+				voice,
+				&samples,
+				&decoded,
+				&mixed,
+				&resample
+			)) {
+				FAudio_PlatformUnlockMutex(voice->sendLock);
+				LOG_MUTEX_UNLOCK(audio, voice->sendLock)
+
+				/* The decode cache is shared, keep a copy for the pool */
+				FAudio_INTERNAL_ResizeCache(
+					audio,
+					&voice->scratch.decodeCache,
+					&voice->scratch.decodeSamples,
+					FAudio_max(decoded, voice->src.resampleSamples) * voice->src.format->nChannels
+				);
+				FAudio_memcpy(
+					voice->scratch.decodeCache,
+					samples,
+					decoded * voice->src.format->nChannels * sizeof(float)
+				);
+				voice->scratch.toResample = resample ? mixed : 0;
+				voice->scratch.outputSamples = mixed;
+				FAudio_INTERNAL_MixPoolAddVoice(pool, voice);
+			}
+			FAudio_INTERNAL_FlushPendingBuffers(voice);
+		}
+
+		list = list->next;
+	}
+	audio->processingSource = NULL;
+
+	FAudio_INTERNAL_MixPoolRun(
+		pool,
+		FAudio_INTERNAL_RenderSourceJob,
+		pool->voiceCount
+	);
+	FAudio_INTERNAL_MixPoolSends(pool);
+	pool->voiceCount = 0;
+
+	LOG_FUNC_EXIT(audio)
+}
+
+/* Submixes of the same processing stage are independent of each other as long
+ * as none of them sends to a submix of the same or an earlier stage, in which
+ * case the serial order is kept. Called with the submixLock held.
+ */
+static uint8_t FAudio_INTERNAL_MixSubmixesParallel(FAudio *audio)
+{
+	FAudioMixPool *pool = audio->mixPool;
+	FAudioSubmixVoice *voice;
+	FAudioVoice *out;
+	LinkedList *list, *group;
+	uint32_t i;
+	uint8_t parallel = 1;
+
+	LOG_FUNC_ENTER(audio)
+
+	for (list = audio->submixes; list != NULL; list = list->next)
+	{
+		voice = (FAudioSubmixVoice*) list->entry;
+		FAudio_PlatformLockMutex(voice->sendLock);
+		LOG_MUTEX_LOCK(audio, voice->sendLock)
+		for (i = 0; i < voice->sends.SendCount; i += 1)
+		{
+			out = voice->sends.pSends[i].pOutputVoice;
+			if (	out->type == FAUDIO_VOICE_SUBMIX &&
+				out->mix.processingStage <= voice->mix.processingStage	)
+			{
+				parallel = 0;
+			}
+		}
+	}
+	if (!parallel)
+	{
+		goto end;
+	}
+
+	list = audio->submixes;
+	while (list != NULL)
+	{
+		pool->voiceCount = 0;
+		group = list;
+		while (	list != NULL &&
+			((FAudioSubmixVoice*) list->entry)->mix.processingStage ==
+			((FAudioSubmixVoice*) group->entry)->mix.processingStage	)
+		{
+			FAudio_INTERNAL_MixPoolAddVoice(pool, list->entry);
+			list = list->next;
+		}
+
+		FAudio_INTERNAL_MixPoolRun(
+			pool,
+			FAudio_INTERNAL_RenderSubmixJob,
+			pool->voiceCount
+		);
+		FAudio_INTERNAL_MixPoolSends(pool);
+
+		/* Zero these at the end, for the next update */
+		for (i = 0; i < pool->voiceCount; i += 1)
+		{
+			voice = pool->voices[i];
+			FAudio_zero(
+				voice->mix.inputCache,
+				sizeof(float) * voice->mix.inputSamples
+			);
+		}
+	}
+	pool->voiceCount = 0;
+
+end:
+	for (list = audio->submixes; list != NULL; list = list->next)
+	{
+		voice = (FAudioSubmixVoice*) list->entry;
+		FAudio_PlatformUnlockMutex(voice->sendLock);
+		LOG_MUTEX_UNLOCK(audio, voice->sendLock)
+	}
+	LOG_FUNC_EXIT(audio)
+	return parallel;
+}
+
+static void FAUDIOCALL FAudio_INTERNAL_GenerateOutput(FAudio *audio, float *output)
+{
+	uint32_t totalSamples;
+	uint32_t voiceCount;
+	LinkedList *list;
+	float *effectOut;
+	FAudioEngineCallback *callback;
+	uint64_t startTicks, ticks;
+
+	LOG_FUNC_ENTER(audio)
+	if (!audio->active)
 	{
 		LOG_FUNC_EXIT(audio)
 		return;
 	}
+	startTicks = FAudio_PlatformGetPerformanceCounter();
 
 	/* Apply any committed changes */
 	FAudio_OPERATIONSET_Execute(audio);
@@ -1386,32 +2097,54 @@ static void FAUDIOCALL FAudio_INTERNAL_GenerateOutput(FAudio *audio, float *outp
 	/* Mix sources */
 	FAudio_PlatformLockMutex(audio->sourceLock);
 	LOG_MUTEX_LOCK(audio, audio->sourceLock)
-	list = audio->sources;
-	while (list != NULL)
+	FAudio_INTERNAL_AddNewSources(audio);
+	voiceCount = 0;
+	if (audio->mixPool != NULL)
 	{
-		audio->processingSource = (FAudioSourceVoice*) list->entry;
-
-		FAudio_INTERNAL_FlushPendingBuffers(audio->processingSource);
-		if (audio->processingSource->src.active)
+		for (list = audio->sources; list != NULL; list = list->next)
 		{
-			FAudio_INTERNAL_MixSource(audio->processingSource);
-			FAudio_INTERNAL_FlushPendingBuffers(audio->processingSource);
+			voiceCount += 1;
 		}
+	}
+	if (voiceCount >= FAUDIO_MIX_MIN_VOICES)
+	{
+		FAudio_INTERNAL_MixSourcesParallel(audio);
+	}
+	else
+	{
+		list = audio->sources;
+		while (list != NULL)
+		{
+			audio->processingSource = (FAudioSourceVoice*) list->entry;
 
-		list = list->next;
+			FAudio_INTERNAL_FlushPendingBuffers(audio->processingSource);
+			if (audio->processingSource->src.active)
+			{
+				FAudio_INTERNAL_MixSource(audio->processingSource);
+				FAudio_INTERNAL_FlushPendingBuffers(audio->processingSource);
+			}
+
+			list = list->next;
+		}
+		audio->processingSource = NULL;
 	}
-	audio->processingSource = NULL;
 	FAudio_PlatformUnlockMutex(audio->sourceLock);
 	LOG_MUTEX_UNLOCK(audio, audio->sourceLock)
 
 	/* Mix submixes, ordered by processing stage */
 	FAudio_PlatformLockMutex(audio->submixLock);
 	LOG_MUTEX_LOCK(audio, audio->submixLock)
-	list = audio->submixes;
-	while (list != NULL)
+	if (	audio->mixPool == NULL ||
+		audio->submixes == NULL ||
+		audio->submixes->next == NULL ||
+		!FAudio_INTERNAL_MixSubmixesParallel(audio)	)
 	{
-		FAudio_INTERNAL_MixSubmix((FAudioSubmixVoice*) list->entry);
-		list = list->next;
+		list = audio->submixes;
+		while (list != NULL)
+		{
+			FAudio_INTERNAL_MixSubmix((FAudioSubmixVoice*) list->entry);
+			list = list->next;
+		}
 	}
 	FAudio_PlatformUnlockMutex(audio->submixLock);
 	LOG_MUTEX_UNLOCK(audio, audio->submixLock)
@@ -1435,7 +2168,9 @@ static void FAUDIOCALL FAudio_INTERNAL_GenerateOutput(FAudio *audio, float *outp
 		effectOut = FAudio_INTERNAL_ProcessEffectChain(
 			audio->master,
 			audio->master->master.output,
-			&totalSamples
+			&totalSamples,
+			&audio->effectChainCache,
+			&audio->effectChainSamples
 		);
 
 		if (effectOut != output)
@@ -1475,6 +2210,22 @@ static void FAUDIOCALL FAudio_INTERNAL_GenerateOutput(FAudio *audio, float *outp
 	FAudio_PlatformUnlockMutex(audio->callbackLock);
 	LOG_MUTEX_UNLOCK(audio, audio->callbackLock)
 
+	/* Update the performance counters, see FAudio_GetPerformanceData */
+	ticks = FAudio_PlatformGetPerformanceCounter() - startTicks;
+	FAudio_PlatformLockMutex(audio->operationLock);
+	LOG_MUTEX_LOCK(audio, audio->operationLock)
+	audio->perfAudioTicks += ticks;
+	if (audio->perfMinTicks == 0 || ticks < audio->perfMinTicks)
+	{
+		audio->perfMinTicks = (uint32_t) ticks;
+	}
+	if (ticks > audio->perfMaxTicks)
+	{
+		audio->perfMaxTicks = (uint32_t) ticks;
+	}
+	FAudio_PlatformUnlockMutex(audio->operationLock);
+	LOG_MUTEX_UNLOCK(audio, audio->operationLock)
+
 	LOG_FUNC_EXIT(audio)
 }
 
@@ -2015,6 +2766,640 @@ void FAudio_INTERNAL_DecodeStereoMSADPCM(
 	LOG_FUNC_EXIT(voice->audio)
 }
 
+/* Decoded PCM cache
+ *
+ * Set FAUDIO_DECODE_CACHE to a budget in MiB to enable it. Submitted buffers
+ * are then decoded into float PCM on a worker thread, ahead of the mixer.
+ * End of stream buffers, which are typically one-shot sounds played again
+ * and again, are shared by every buffer submitted with the same data and
+ * format. Lookups hash the source data, so buffers whose memory is reused
+ * for different audio never hit a stale entry. Shared entries are kept in
+ * LRU order and evicted past the byte budget, but stay alive until the last
+ * buffer using them is released.
+ *
+ * The mixer never decodes into the cache nor waits for the worker: until a
+ * buffer's PCM is ready it decodes the buffer as usual.
+ */
+
+struct FAudioPCMCacheEntry
+{
+	FAudioPCMCacheEntry *prev;
+	FAudioPCMCacheEntry *next;
+	uint8_t shared;		/* In the LRU list, accounted in the budget */
+	uint32_t refcount;
+
+	/* Key */
+	const void *data;
+	uint32_t bytes;
+	uint64_t hash;
+	uint16_t channels;
+	uint16_t blockAlign;
+	uint16_t samplesPerBlock;
+
+	uint32_t samples;
+	float *pcm;
+};
+
+typedef struct FAudioPCMPrefetchJob FAudioPCMPrefetchJob;
+struct FAudioPCMPrefetchJob
+{
+	FAudioPCMPrefetchJob *next;
+	FAudioBufferEntry *owner;
+	uint8_t shared;
+	uint8_t cancelled;	/* owner is gone, drop the result */
+	const void *data;
+	uint32_t bytes;
+	uint16_t channels;
+	uint16_t blockAlign;
+	uint16_t samplesPerBlock;
+};
+
+struct FAudioPCMCache
+{
+	FAudio *audio;
+
+	/* Most recently used first */
+	FAudioMutex lock;
+	FAudioPCMCacheEntry *head;
+	FAudioPCMCacheEntry *tail;
+	uint64_t size;
+	uint64_t budget;
+
+	/* Prefetch worker, jobLock protects the queue, the current job and
+	 * the pcm pointer of buffers with a pending job. It is never held
+	 * while decoding.
+	 */
+	FAudioThread thread;
+	FAudioSemaphore wake;
+	FAudioMutex jobLock;
+	FAudioPCMPrefetchJob *jobs;
+	FAudioPCMPrefetchJob *lastJob;
+	FAudioPCMPrefetchJob *current;
+	uint8_t quit;
+};
+
+static uint64_t FAudio_INTERNAL_PCMCacheHash(const uint8_t *data, uint32_t bytes)
+{
+	uint64_t hash = 0xcbf29ce484222325ULL;
+	uint64_t word;
+	uint32_t i;
+
+	/* FNV-1a, a word at a time */
+	for (i = 0; i + 8 <= bytes; i += 8)
+	{
+		FAudio_memcpy(&word, data + i, sizeof(word));
+		hash = (hash ^ word) * 0x100000001b3ULL;
+	}
+	for (; i < bytes; i += 1)
+	{
+		hash = (hash ^ data[i]) * 0x100000001b3ULL;
+	}
+	return hash;
+}
+
+static void FAudio_INTERNAL_PCMCacheUnlink(
+	FAudioPCMCache *cache,
+	FAudioPCMCacheEntry *entry
+) {
+	if (entry->prev != NULL)
+	{
+		entry->prev->next = entry->next;
+	}
+	else
+	{
+		cache->head = entry->next;
+	}
+	if (entry->next != NULL)
+	{
+		entry->next->prev = entry->prev;
+	}
+	else
+	{
+		cache->tail = entry->prev;
+	}
+	entry->prev = NULL;
+	entry->next = NULL;
+}
+
+/* Must be called with the cache lock held! */
+static void FAudio_INTERNAL_PCMCacheUnref(
+	FAudioPCMCache *cache,
+	FAudioPCMCacheEntry *entry
+) {
+	entry->refcount -= 1;
+	if (entry->refcount == 0)
+	{
+		cache->audio->pFree(entry->pcm);
+		cache->audio->pFree(entry);
+	}
+}
+
+/* Must be called with the cache lock held! */
+static void FAudio_INTERNAL_PCMCacheEvict(FAudioPCMCache *cache)
+{
+	FAudioPCMCacheEntry *entry;
+
+	while (cache->size > cache->budget && cache->tail != NULL)
+	{
+		entry = cache->tail;
+		FAudio_INTERNAL_PCMCacheUnlink(cache, entry);
+		cache->size -= (uint64_t) entry->samples * entry->channels * sizeof(float);
+		entry->shared = 0;
+		FAudio_INTERNAL_PCMCacheUnref(cache, entry);
+	}
+}
+
+/* Returns a new reference to a matching entry, or NULL. Must be called with
+ * the cache lock held!
+ */
+static FAudioPCMCacheEntry* FAudio_INTERNAL_PCMCacheFind(
+	FAudioPCMCache *cache,
+	const void *data,
+	uint32_t bytes,
+	uint64_t hash,
+	uint16_t channels,
+	uint16_t blockAlign,
+	uint16_t samplesPerBlock
+) {
+	FAudioPCMCacheEntry *entry;
+
+	for (entry = cache->head; entry != NULL; entry = entry->next)
+	{
+		if (	entry->data == data &&
+			entry->bytes == bytes &&
+			entry->hash == hash &&
+			entry->channels == channels &&
+			entry->blockAlign == blockAlign &&
+			entry->samplesPerBlock == samplesPerBlock	)
+		{
+			/* Move to the front */
+			FAudio_INTERNAL_PCMCacheUnlink(cache, entry);
+			entry->next = cache->head;
+			if (cache->head != NULL)
+			{
+				cache->head->prev = entry;
+			}
+			cache->head = entry;
+			if (cache->tail == NULL)
+			{
+				cache->tail = entry;
+			}
+
+			entry->refcount += 1;
+			return entry;
+		}
+	}
+	return NULL;
+}
+
+/* Decodes a whole MSADPCM buffer, returns a new entry with one reference.
+ * The entry is inserted in the LRU list if shared is set.
+ */
+static FAudioPCMCacheEntry* FAudio_INTERNAL_PCMCacheDecode(
+	FAudioPCMCache *cache,
+	const void *data,
+	uint32_t bytes,
+	uint64_t hash,
+	uint16_t channels,
+	uint16_t blockAlign,
+	uint16_t samplesPerBlock,
+	uint8_t shared
+) {
+	FAudio *audio = cache->audio;
+	FAudioPCMCacheEntry *entry;
+	uint32_t blocks, i;
+	int16_t *blockCache;
+	uint64_t size;
+	uint8_t *buf;
+	float *out;
+
+	blocks = bytes / blockAlign;
+	size = (uint64_t) blocks * samplesPerBlock * channels * sizeof(float);
+
+	entry = (FAudioPCMCacheEntry*) audio->pMalloc(sizeof(FAudioPCMCacheEntry));
+	entry->prev = NULL;
+	entry->next = NULL;
+	entry->shared = shared;
+	entry->refcount = shared ? 2 : 1;
+	entry->data = data;
+	entry->bytes = bytes;
+	entry->hash = hash;
+	entry->channels = channels;
+	entry->blockAlign = blockAlign;
+	entry->samplesPerBlock = samplesPerBlock;
+	entry->samples = blocks * samplesPerBlock;
+	entry->pcm = (float*) audio->pMalloc((size_t) size);
+
+	buf = (uint8_t*) data;
+	out = entry->pcm;
+	blockCache = (int16_t*) FAudio_alloca(samplesPerBlock * channels * sizeof(int16_t));
+	for (i = 0; i < blocks; i += 1)
+	{
+		if (channels == 2)
+		{
+			FAudio_INTERNAL_DecodeStereoMSADPCMBlock(
+				&buf,
+				blockCache,
+				blockAlign
+			);
+		}
+		else
+		{
+			FAudio_INTERNAL_DecodeMonoMSADPCMBlock(
+				&buf,
+				blockCache,
+				blockAlign
+			);
+		}
+		FAudio_INTERNAL_Convert_S16_To_F32(
+			blockCache,
+			out,
+			samplesPerBlock * channels
+		);
+		out += samplesPerBlock * channels;
+	}
+	FAudio_dealloca(blockCache);
+
+	if (shared)
+	{
+		FAudio_PlatformLockMutex(cache->lock);
+		entry->next = cache->head;
+		if (cache->head != NULL)
+		{
+			cache->head->prev = entry;
+		}
+		cache->head = entry;
+		if (cache->tail == NULL)
+		{
+			cache->tail = entry;
+		}
+		cache->size += size;
+		FAudio_INTERNAL_PCMCacheEvict(cache);
+		FAudio_PlatformUnlockMutex(cache->lock);
+	}
+
+	LOG_INFO(
+		audio,
+		"Decoded %u samples from %p into PCM cache entry %p",
+		entry->samples,
+		data,
+		(void*) entry
+	)
+	return entry;
+}
+
+/* Finds or decodes the PCM for a buffer */
+static FAudioPCMCacheEntry* FAudio_INTERNAL_PCMCacheGet(
+	FAudioPCMCache *cache,
+	const void *data,
+	uint32_t bytes,
+	uint16_t channels,
+	uint16_t blockAlign,
+	uint16_t samplesPerBlock,
+	uint8_t shared
+) {
+	FAudioPCMCacheEntry *entry = NULL;
+	uint64_t hash = 0, size;
+
+	/* Don't bother decoding what we wouldn't keep */
+	size = (uint64_t) (bytes / blockAlign) * samplesPerBlock * channels * sizeof(float);
+	if (size == 0 || size > cache->budget / 4)
+	{
+		return NULL;
+	}
+
+	if (shared)
+	{
+		hash = FAudio_INTERNAL_PCMCacheHash((const uint8_t*) data, bytes);
+		FAudio_PlatformLockMutex(cache->lock);
+		entry = FAudio_INTERNAL_PCMCacheFind(
+			cache,
+			data,
+			bytes,
+			hash,
+			channels,
+			blockAlign,
+			samplesPerBlock
+		);
+		FAudio_PlatformUnlockMutex(cache->lock);
+	}
+	if (entry == NULL)
+	{
+		entry = FAudio_INTERNAL_PCMCacheDecode(
+			cache,
+			data,
+			bytes,
+			hash,
+			channels,
+			blockAlign,
+			samplesPerBlock,
+			shared
+		);
+	}
+	return entry;
+}
+
+static int32_t FAUDIOCALL FAudio_INTERNAL_PCMPrefetchThread(void *user)
+{
+	FAudioPCMCache *cache = (FAudioPCMCache*) user;
+	FAudioPCMPrefetchJob *job;
+	FAudioPCMCacheEntry *pcm;
+	uint8_t cancelled;
+
+	FAudio_PlatformThreadPriority(FAUDIO_THREAD_PRIORITY_LOW);
+
+	while (1)
+	{
+		FAudio_PlatformWaitSemaphore(cache->wake);
+		if (cache->quit)
+		{
+			break;
+		}
+
+		FAudio_PlatformLockMutex(cache->jobLock);
+		job = cache->jobs;
+		if (job == NULL)
+		{
+			/* Cancelled */
+			FAudio_PlatformUnlockMutex(cache->jobLock);
+			continue;
+		}
+		cache->jobs = job->next;
+		if (cache->jobs == NULL)
+		{
+			cache->lastJob = NULL;
+		}
+		cache->current = job;
+		FAudio_PlatformUnlockMutex(cache->jobLock);
+
+		pcm = FAudio_INTERNAL_PCMCacheGet(
+			cache,
+			job->data,
+			job->bytes,
+			job->channels,
+			job->blockAlign,
+			job->samplesPerBlock,
+			job->shared
+		);
+
+		FAudio_PlatformLockMutex(cache->jobLock);
+		cancelled = job->cancelled;
+		if (!cancelled)
+		{
+			job->owner->pcm = pcm;
+			job->owner->pcmDone = 1;
+		}
+		cache->current = NULL;
+		FAudio_PlatformUnlockMutex(cache->jobLock);
+
+		if (cancelled && pcm != NULL)
+		{
+			FAudio_PlatformLockMutex(cache->lock);
+			FAudio_INTERNAL_PCMCacheUnref(cache, pcm);
+			FAudio_PlatformUnlockMutex(cache->lock);
+		}
+		cache->audio->pFree(job);
+	}
+	return 0;
+}
+
+/* Removes the buffer's prefetch job, or tells the worker to drop the result
+ * if it is already decoding it. This never waits for the worker, so it's
+ * safe to call from the mixer. Afterwards entry->pcm doesn't change anymore.
+ */
+static void FAudio_INTERNAL_PCMPrefetchCancel(
+	FAudioPCMCache *cache,
+	FAudioBufferEntry *entry
+) {
+	FAudioPCMPrefetchJob *job, *prev = NULL;
+
+	if (!entry->pcmPrefetch)
+	{
+		return;
+	}
+	entry->pcmPrefetch = 0;
+
+	FAudio_PlatformLockMutex(cache->jobLock);
+	for (job = cache->jobs; job != NULL; prev = job, job = job->next)
+	{
+		if (job->owner == entry)
+		{
+			if (prev != NULL)
+			{
+				prev->next = job->next;
+			}
+			else
+			{
+				cache->jobs = job->next;
+			}
+			if (cache->lastJob == job)
+			{
+				cache->lastJob = prev;
+			}
+			cache->audio->pFree(job);
+			break;
+		}
+	}
+	if (cache->current != NULL && cache->current->owner == entry)
+	{
+		cache->current->cancelled = 1;
+	}
+	FAudio_PlatformUnlockMutex(cache->jobLock);
+}
+
+void FAudio_INTERNAL_CreatePCMCache(FAudio *audio)
+{
+	FAudioPCMCache *cache;
+	const char *env;
+	int budget = 0;
+
+	env = FAudio_getenv("FAUDIO_DECODE_CACHE");
+	if (env != NULL)
+	{
+		budget = FAudio_atoi(env);
+	}
+	if (budget <= 0)
+	{
+		return;
+	}
+
+	cache = (FAudioPCMCache*) audio->pMalloc(sizeof(FAudioPCMCache));
+	FAudio_zero(cache, sizeof(FAudioPCMCache));
+	cache->audio = audio;
+	cache->budget = (uint64_t) budget * 1024 * 1024;
+	cache->lock = FAudio_PlatformCreateMutex();
+	cache->wake = FAudio_PlatformCreateSemaphore(0);
+	cache->jobLock = FAudio_PlatformCreateMutex();
+	cache->thread = FAudio_PlatformCreateThread(
+		FAudio_INTERNAL_PCMPrefetchThread,
+		"FAudioPrefetchThread",
+		cache
+	);
+	if (cache->thread == NULL)
+	{
+		LOG_ERROR(audio, "%s", "Failed to create the prefetch thread, PCM cache disabled")
+		FAudio_PlatformDestroySemaphore(cache->wake);
+		FAudio_PlatformDestroyMutex(cache->jobLock);
+		FAudio_PlatformDestroyMutex(cache->lock);
+		audio->pFree(cache);
+		return;
+	}
+
+	audio->pcmCache = cache;
+}
+
+void FAudio_INTERNAL_DestroyPCMCache(FAudio *audio)
+{
+	FAudioPCMCache *cache = audio->pcmCache;
+	FAudioPCMPrefetchJob *job;
+
+	if (cache == NULL)
+	{
+		return;
+	}
+
+	/* All voices are gone by now, so there are no jobs left either */
+	cache->quit = 1;
+	FAudio_PlatformSignalSemaphore(cache->wake, 1);
+	FAudio_PlatformWaitThread(cache->thread, NULL);
+	while ((job = cache->jobs) != NULL)
+	{
+		cache->jobs = job->next;
+		audio->pFree(job);
+	}
+	FAudio_PlatformDestroySemaphore(cache->wake);
+	FAudio_PlatformDestroyMutex(cache->jobLock);
+
+	FAudio_PlatformLockMutex(cache->lock);
+	cache->budget = 0;
+	FAudio_INTERNAL_PCMCacheEvict(cache);
+	FAudio_PlatformUnlockMutex(cache->lock);
+	FAudio_PlatformDestroyMutex(cache->lock);
+	audio->pFree(cache);
+	audio->pcmCache = NULL;
+}
+
+static uint8_t FAudio_INTERNAL_PCMCacheSupported(FAudioSourceVoice *voice)
+{
+	return (	voice->audio->pcmCache != NULL &&
+			voice->src.format->wFormatTag == FAUDIO_FORMAT_MSADPCM &&
+			voice->src.format->nChannels <= 2	);
+}
+
+/* Called on submission, before the buffer is visible to the mixer */
+void FAudio_INTERNAL_PrefetchBuffer(
+	FAudioSourceVoice *voice,
+	FAudioBufferEntry *entry
+) {
+	FAudioPCMCache *cache = voice->audio->pcmCache;
+	FAudioPCMPrefetchJob *job;
+
+	entry->pcm = NULL;
+	entry->pcmPrefetch = 0;
+	entry->pcmDone = 0;
+
+	if (	!FAudio_INTERNAL_PCMCacheSupported(voice) ||
+		entry->buffer.pAudioData == NULL	)
+	{
+		return;
+	}
+
+	job = (FAudioPCMPrefetchJob*) voice->audio->pMalloc(sizeof(FAudioPCMPrefetchJob));
+	job->next = NULL;
+	job->owner = entry;
+	job->shared = !!(entry->buffer.Flags & FAUDIO_END_OF_STREAM);
+	job->cancelled = 0;
+	job->data = entry->buffer.pAudioData;
+	job->bytes = entry->buffer.AudioBytes;
+	job->channels = voice->src.format->nChannels;
+	job->blockAlign = voice->src.format->nBlockAlign;
+	job->samplesPerBlock = ((FAudioADPCMWaveFormat*) voice->src.format)->wSamplesPerBlock;
+	entry->pcmPrefetch = 1;
+
+	FAudio_PlatformLockMutex(cache->jobLock);
+	if (cache->lastJob != NULL)
+	{
+		cache->lastJob->next = job;
+	}
+	else
+	{
+		cache->jobs = job;
+	}
+	cache->lastJob = job;
+	FAudio_PlatformUnlockMutex(cache->jobLock);
+
+	FAudio_PlatformSignalSemaphore(cache->wake, 1);
+}
+
+/* Called before a buffer is handed back to the application */
+void FAudio_INTERNAL_ReleaseBufferEntry(
+	FAudio *audio,
+	FAudioBufferEntry *entry
+) {
+	FAudioPCMCache *cache = audio->pcmCache;
+
+	if (cache == NULL)
+	{
+		return;
+	}
+
+	FAudio_INTERNAL_PCMPrefetchCancel(cache, entry);
+	if (entry->pcm != NULL)
+	{
+		FAudio_PlatformLockMutex(cache->lock);
+		FAudio_INTERNAL_PCMCacheUnref(cache, entry->pcm);
+		FAudio_PlatformUnlockMutex(cache->lock);
+		entry->pcm = NULL;
+	}
+}
+
+/* Decodes from the current buffer, using its cached PCM if there is any */
+void FAudio_INTERNAL_DecodeSourceBuffer(
+	FAudioSourceVoice *voice,
+	FAudioBuffer *buffer,
+	float *decodeCache,
+	uint32_t samples
+) {
+	FAudioPCMCache *cache = voice->audio->pcmCache;
+	FAudioBufferEntry *entry = voice->src.bufferList;
+	FAudioPCMCacheEntry *pcm;
+
+	if (cache != NULL)
+	{
+		FAudio_assert(buffer == &entry->buffer);
+
+		if (entry->pcmPrefetch)
+		{
+			/* Only a pointer check, the worker doesn't hold the lock
+			 * while decoding.
+			 */
+			FAudio_PlatformLockMutex(cache->jobLock);
+			pcm = entry->pcm;
+			if (entry->pcmDone)
+			{
+				entry->pcmPrefetch = 0;
+			}
+			FAudio_PlatformUnlockMutex(cache->jobLock);
+		}
+		else
+		{
+			pcm = entry->pcm;
+		}
+
+		if (pcm != NULL && voice->src.curBufferOffset + samples <= pcm->samples)
+		{
+			FAudio_memcpy(
+				decodeCache,
+				pcm->pcm + (uint64_t) voice->src.curBufferOffset * pcm->channels,
+				sizeof(float) * samples * pcm->channels
+			);
+			return;
+		}
+	}
+
+	voice->src.decode(voice, buffer, decodeCache, samples);
+}
+
 /* Fallback WMA decoder, get ready for spam! */
 
 void FAudio_INTERNAL_DecodeWMAERROR(
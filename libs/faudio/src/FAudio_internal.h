@@ -84,6 +84,7 @@
 #define FAudio_snprintf snprintf
 #define FAudio_vsnprintf vsnprintf
 #define FAudio_getenv getenv
+#define FAudio_atoi atoi
 #define FAudio_PRIu64 PRIu64
 #define FAudio_PRIx64 PRIx64
 
@@ -205,6 +206,7 @@ extern void FAudio_Log(char const *msg);
 #define FAudio_vsnprintf SDL_vsnprintf
 #define FAudio_Log(msg) SDL_Log("%s", msg)
 #define FAudio_getenv SDL_getenv
+#define FAudio_atoi SDL_atoi
 #define FAudio_PRIu64 SDL_PRIu64
 #define FAudio_PRIx64 SDL_PRIx64
 #endif
@@ -254,6 +256,7 @@ extern void FAudio_Log(char const *msg);
 
 typedef void* FAudioThread;
 typedef void* FAudioMutex;
+typedef void* FAudioSemaphore;
 typedef int32_t (FAUDIOCALL * FAudioThreadFunc)(void* data);
 typedef enum FAudioThreadPriority
 {
@@ -282,6 +285,11 @@ void LinkedList_PrependEntry(
 	FAudioMutex lock,
 	FAudioMallocFunc pMalloc
 );
+void LinkedList_PushEntryAtomic(
+	LinkedList **start,
+	void* toAdd,
+	FAudioMallocFunc pMalloc
+);
 void LinkedList_RemoveEntry(
 	LinkedList **start,
 	void* toRemove,
@@ -291,6 +299,10 @@ void LinkedList_RemoveEntry(
 
 /* Internal FAudio Types */
 
+typedef struct FAudioMixPool FAudioMixPool;
+typedef struct FAudioPCMCache FAudioPCMCache;
+typedef struct FAudioPCMCacheEntry FAudioPCMCacheEntry;
+
 typedef enum FAudioVoiceType
 {
 	FAUDIO_VOICE_SOURCE,
@@ -304,6 +316,11 @@ struct FAudioBufferEntry
 	FAudioBuffer buffer;
 	FAudioBufferWMA bufferWMA;
 	FAudioBufferEntry *next;
+
+	/* Decoded PCM, see FAudio_INTERNAL_DecodeSourceBuffer */
+	FAudioPCMCacheEntry *pcm;
+	uint8_t pcmPrefetch;	/* Job queued, pcm is protected by the job lock */
+	uint8_t pcmDone;	/* Job finished, set by the prefetch thread */
 };
 
 typedef void (FAUDIOCALL * FAudioDecodeCallback)(
@@ -422,6 +439,7 @@ struct FAudio
 	uint32_t updateSize;
 	FAudioMasteringVoice *master;
 	LinkedList *sources;
+	LinkedList *newSources; /* Lock-free stack, merged into sources */
 	LinkedList *submixes;
 	LinkedList *callbacks;
 	FAudioMutex sourceLock;
@@ -445,6 +463,18 @@ struct FAudio
 	float *resampleCache;
 	float *effectChainCache;
 
+	/* Optional worker pool for parallel voice mixing, see FAUDIO_MIX_THREADS */
+	FAudioMixPool *mixPool;
+
+	/* Decoded PCM cache for compressed buffers, see FAUDIO_DECODE_CACHE */
+	FAudioPCMCache *pcmCache;
+
+	/* Performance counters, in platform performance counter ticks */
+	uint64_t perfAudioTicks;
+	uint64_t perfLastQuery;
+	uint32_t perfMinTicks;
+	uint32_t perfMaxTicks;
+
 	/* Allocator callbacks */
 	FAudioMallocFunc pMalloc;
 	FAudioFreeFunc pFree;
@@ -496,6 +526,23 @@ struct FAudioVoice
 	uint32_t outputChannels;
 	FAudioMutex volumeLock;
 
+	/* Per-voice storage for the current mixing pass */
+	struct
+	{
+		uint32_t decodeSamples;
+		uint32_t resampleSamples;
+		uint32_t effectChainSamples;
+		float *decodeCache;
+		float *resampleCache;
+		float *effectChainCache;
+
+		/* Result of the current pass, interleaved PCM32F */
+		float *output;
+		uint32_t outputSamples;
+		uint32_t outputChannels;
+		uint32_t toResample;
+	} scratch;
+
 	FAUDIONAMELESS union
 	{
 		struct
@@ -530,6 +577,7 @@ struct FAudioVoice
 			uint64_t totalSamples;
 			FAudioBufferEntry *bufferList;
 			FAudioBufferEntry *flushList;
+			FAudioBufferEntry *submitQueue; /* Lock-free stack, newest first */
 			FAudioMutex bufferLock;
 		} src;
 		struct
@@ -570,6 +618,27 @@ void FAudio_INTERNAL_InsertSubmixSorted(
 );
 void FAudio_INTERNAL_UpdateEngine(FAudio *audio, float *output);
 void FAudio_INTERNAL_ResizeDecodeCache(FAudio *audio, uint32_t size);
+void FAudio_INTERNAL_CreateMixPool(FAudio *audio);
+void FAudio_INTERNAL_DestroyMixPool(FAudio *audio);
+void FAudio_INTERNAL_CancelVoiceMix(FAudioSourceVoice *voice);
+void FAudio_INTERNAL_CreatePCMCache(FAudio *audio);
+void FAudio_INTERNAL_DestroyPCMCache(FAudio *audio);
+void FAudio_INTERNAL_PrefetchBuffer(
+	FAudioSourceVoice *voice,
+	FAudioBufferEntry *entry
+);
+void FAudio_INTERNAL_ReleaseBufferEntry(
+	FAudio *audio,
+	FAudioBufferEntry *entry
+);
+void FAudio_INTERNAL_DecodeSourceBuffer(
+	FAudioSourceVoice *voice,
+	FAudioBuffer *buffer,
+	float *decodeCache,
+	uint32_t samples
+);
+void FAudio_INTERNAL_DrainSubmitQueue(FAudioSourceVoice *voice);
+void FAudio_INTERNAL_AddNewSources(FAudio *audio);
 void FAudio_INTERNAL_AllocEffectChain(
 	FAudioVoice *voice,
 	const FAudioEffectChain *pEffectChain
@@ -737,6 +806,8 @@ extern void (*FAudio_INTERNAL_Amplify)(
 );
 
 extern FAudioMixCallback FAudio_INTERNAL_Mix_Generic;
+extern FAudioMixCallback FAudio_INTERNAL_Mix_1in_8out;
+extern FAudioMixCallback FAudio_INTERNAL_Mix_2in_8out;
 
 #define MIX_FUNC(type) \
 	extern void FAudio_INTERNAL_Mix_##type##_Scalar( \
@@ -821,11 +892,23 @@ FAudioMutex FAudio_PlatformCreateMutex(void);
 void FAudio_PlatformDestroyMutex(FAudioMutex mutex);
 void FAudio_PlatformLockMutex(FAudioMutex mutex);
 void FAudio_PlatformUnlockMutex(FAudioMutex mutex);
+FAudioSemaphore FAudio_PlatformCreateSemaphore(uint32_t initialValue);
+void FAudio_PlatformDestroySemaphore(FAudioSemaphore sem);
+void FAudio_PlatformWaitSemaphore(FAudioSemaphore sem);
+void FAudio_PlatformSignalSemaphore(FAudioSemaphore sem, uint32_t count);
+uint32_t FAudio_PlatformGetCPUCount(void);
+void* FAudio_PlatformAtomicExchangePointer(void **dst, void *value);
+void* FAudio_PlatformAtomicCompareExchangePointer(
+	void **dst,
+	void *exchange,
+	void *comparand
+);
 void FAudio_sleep(uint32_t ms);
 
 /* Time */
 
 uint32_t FAudio_timems(void);
+uint64_t FAudio_PlatformGetPerformanceCounter(void);
 
 /* WaveFormatExtensible Helpers */
 
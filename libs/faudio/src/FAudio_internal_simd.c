@@ -37,30 +37,22 @@
 	#ifndef __ARM_NEON__
 	#define __ARM_NEON__ 1
 	#endif
-
-	/* AArch64 guarantees NEON. */
-	#define NEED_SCALAR_CONVERTER_FALLBACKS 0
 #elif defined(__x86_64__) || defined(_M_X64)
 	/* Some platforms fail to define this... */
 	#ifndef __SSE2__
 	#define __SSE2__ 1
 	#endif
-
-	/* x86_64 guarantees SSE2. */
-	#define NEED_SCALAR_CONVERTER_FALLBACKS 0
 #elif __MACOSX__ && !defined(__POWERPC__)
 	/* Some build systems may need to specify this. */
 	#if !defined(__SSE2__) && !defined(__ARM_NEON__)
 	#error macOS does not have SSE2/NEON? Bad compiler?
 	#endif
-
-	/* Mac OS X/Intel guarantees SSE2. */
-	#define NEED_SCALAR_CONVERTER_FALLBACKS 0
-#else
-	/* Need plain C implementations to support all other hardware */
-	#define NEED_SCALAR_CONVERTER_FALLBACKS 1
 #endif
 
+/* The scalar code is always built: it is the fallback on other hardware,
+ * and FAUDIO_SIMD=none selects it for comparison with the SIMD paths.
+ */
+
 /* Our NEON paths require AArch64, don't check __ARM_NEON__ here */
 #if defined(__aarch64__) || defined(_M_ARM64) || defined(__arm64ec__) || defined(_M_ARM64EC)
 #include <arm_neon.h>
@@ -73,6 +65,27 @@
 #define HAVE_SSE2_INTRINSICS 1
 #endif
 
+/* The AVX2 paths are compiled with per-function target attributes and only
+ * used if CPUID says so. mingw GCC cannot align ymm spills on Win64 (GCC bug
+ * 54412), so they are left out for that compiler.
+ *
+ * They don't use FMA: every lane does the same separately rounded multiply
+ * and add as the scalar code, so the output doesn't depend on the machine.
+ */
+#if HAVE_SSE2_INTRINSICS && (defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86))
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#include <immintrin.h>
+#define HAVE_AVX2_INTRINSICS 1
+#define FAUDIO_TARGET_AVX2
+#elif defined(__clang__) || (defined(__GNUC__) && !defined(_WIN64))
+#include <cpuid.h>
+#include <immintrin.h>
+#define HAVE_AVX2_INTRINSICS 1
+#define FAUDIO_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
 /* SECTION 1: Type Converters */
 
 /* The SSE/NEON converters are based on SDL_audiotypecvt:
@@ -83,7 +96,7 @@
 #define DIVBY32768 0.000030517578125f
 #define DIVBY8388607 0.00000011920930376163766f
 
-#if NEED_SCALAR_CONVERTER_FALLBACKS
+/* The scalar versions are always built, FAUDIO_SIMD=none selects them */
 void FAudio_INTERNAL_Convert_U8_To_F32_Scalar(
 	const uint8_t *restrict src,
 	float *restrict dst,
@@ -119,7 +132,6 @@ void FAudio_INTERNAL_Convert_S32_To_F32_Scalar(
 		*dst++ = (*src++ >> 8) * DIVBY8388607;
 	}
 }
-#endif /* NEED_SCALAR_CONVERTER_FALLBACKS */
 
 #if HAVE_SSE2_INTRINSICS
 void FAudio_INTERNAL_Convert_U8_To_F32_SSE2(
@@ -256,6 +268,84 @@ void FAudio_INTERNAL_Convert_S32_To_F32_SSE2(
 }
 #endif /* HAVE_SSE2_INTRINSICS */
 
+#if HAVE_AVX2_INTRINSICS
+FAUDIO_TARGET_AVX2 void FAudio_INTERNAL_Convert_U8_To_F32_AVX2(
+	const uint8_t *restrict src,
+	float *restrict dst,
+	uint32_t len
+) {
+	uint32_t i;
+	const __m256 divby128 = _mm256_set1_ps(DIVBY128);
+	const __m256 one = _mm256_set1_ps(1.0f);
+	__m256i ints;
+
+	for (i = 0; i + 8 <= len; i += 8)
+	{
+		ints = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*) (src + i)));
+		_mm256_storeu_ps(
+			dst + i,
+			_mm256_sub_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(ints), divby128), one)
+		);
+	}
+
+	/* Finish off any leftovers with scalar operations. */
+	for (; i < len; i += 1)
+	{
+		dst[i] = (src[i] * DIVBY128) - 1.0f;
+	}
+}
+
+FAUDIO_TARGET_AVX2 void FAudio_INTERNAL_Convert_S16_To_F32_AVX2(
+	const int16_t *restrict src,
+	float *restrict dst,
+	uint32_t len
+) {
+	uint32_t i;
+	const __m256 divby32768 = _mm256_set1_ps(DIVBY32768);
+	__m256i ints;
+
+	for (i = 0; i + 8 <= len; i += 8)
+	{
+		ints = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*) (src + i)));
+		_mm256_storeu_ps(
+			dst + i,
+			_mm256_mul_ps(_mm256_cvtepi32_ps(ints), divby32768)
+		);
+	}
+
+	/* Finish off any leftovers with scalar operations. */
+	for (; i < len; i += 1)
+	{
+		dst[i] = src[i] * DIVBY32768;
+	}
+}
+
+FAUDIO_TARGET_AVX2 void FAudio_INTERNAL_Convert_S32_To_F32_AVX2(
+	const int32_t *restrict src,
+	float *restrict dst,
+	uint32_t len
+) {
+	uint32_t i;
+	const __m256 divby8388607 = _mm256_set1_ps(DIVBY8388607);
+	__m256i ints;
+
+	for (i = 0; i + 8 <= len; i += 8)
+	{
+		ints = _mm256_srai_epi32(_mm256_loadu_si256((const __m256i*) (src + i)), 8);
+		_mm256_storeu_ps(
+			dst + i,
+			_mm256_mul_ps(_mm256_cvtepi32_ps(ints), divby8388607)
+		);
+	}
+
+	/* Finish off any leftovers with scalar operations. */
+	for (; i < len; i += 1)
+	{
+		dst[i] = (src[i] >> 8) * DIVBY8388607;
+	}
+}
+#endif /* HAVE_AVX2_INTRINSICS */
+
 #if HAVE_NEON_INTRINSICS
 void FAudio_INTERNAL_Convert_U8_To_F32_NEON(
 	const uint8_t *restrict src,
@@ -419,7 +509,6 @@ void FAudio_INTERNAL_ResampleGeneric(
 	}
 }
 
-#if NEED_SCALAR_CONVERTER_FALLBACKS
 void FAudio_INTERNAL_ResampleMono_Scalar(
 	float *restrict dCache,
 	float *restrict resampleCache,
@@ -496,7 +585,6 @@ void FAudio_INTERNAL_ResampleStereo_Scalar(
 		cur &= FIXED_FRACTION_MASK;
 	}
 }
-#endif /* NEED_SCALAR_CONVERTER_FALLBACKS */
 
 /* The SSE2 versions of the resamplers come from @8thMage! */
 
@@ -843,6 +931,195 @@ void FAudio_INTERNAL_ResampleStereo_SSE2(
 }
 #endif /* HAVE_SSE2_INTRINSICS */
 
+/* The AVX2 resamplers keep the fixed point position of every output sample
+ * in 64-bit lanes. The integer part is used as gather index into dCache and
+ * the fraction as lerp weight, so there is no per-sample pointer juggling.
+ */
+
+#if HAVE_AVX2_INTRINSICS
+FAUDIO_TARGET_AVX2 void FAudio_INTERNAL_ResampleMono_AVX2(
+	float *restrict dCache,
+	float *restrict resampleCache,
+	uint64_t *resampleOffset,
+	uint64_t resampleStep,
+	uint64_t toResample,
+	uint8_t UNUSED
+) {
+	uint32_t i, tail;
+	uint64_t cur_scalar = *resampleOffset & FIXED_FRACTION_MASK;
+	__m256i pos_0_3, pos_4_7, adder, high_sel, low_sel, half_fixed,
+		index, frac;
+	__m256 one_over_fixed_one, half, current, next, cur_fixed;
+
+	pos_0_3 = _mm256_setr_epi64x(
+		cur_scalar,
+		cur_scalar + resampleStep,
+		cur_scalar + resampleStep * 2,
+		cur_scalar + resampleStep * 3
+	);
+	pos_4_7 = _mm256_add_epi64(
+		pos_0_3,
+		_mm256_set1_epi64x(resampleStep * 4)
+	);
+	adder = _mm256_set1_epi64x(resampleStep * 8);
+
+	/* Constants */
+	high_sel = _mm256_setr_epi32(1, 3, 5, 7, 1, 3, 5, 7);
+	low_sel = _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6);
+	half_fixed = _mm256_set1_epi32((int32_t) DOUBLE_TO_FIXED(0.5));
+	one_over_fixed_one = _mm256_set1_ps(1.0f / FIXED_ONE);
+	half = _mm256_set1_ps(0.5f);
+
+	tail = toResample % 8;
+	for (i = 0; i < toResample - tail; i += 8, resampleCache += 8)
+	{
+		index = _mm256_blend_epi32(
+			_mm256_permutevar8x32_epi32(pos_0_3, high_sel),
+			_mm256_permutevar8x32_epi32(pos_4_7, high_sel),
+			0xF0
+		);
+		frac = _mm256_blend_epi32(
+			_mm256_permutevar8x32_epi32(pos_0_3, low_sel),
+			_mm256_permutevar8x32_epi32(pos_4_7, low_sel),
+			0xF0
+		);
+
+		current = _mm256_i32gather_ps(dCache, index, 4);
+		next = _mm256_i32gather_ps(dCache + 1, index, 4);
+
+		/* Same signed conversion trick as the SSE2 version */
+		cur_fixed = _mm256_add_ps(
+			_mm256_mul_ps(
+				_mm256_cvtepi32_ps(_mm256_sub_epi32(frac, half_fixed)),
+				one_over_fixed_one
+			),
+			half
+		);
+		_mm256_storeu_ps(
+			resampleCache,
+			_mm256_add_ps(_mm256_mul_ps(_mm256_sub_ps(next, current), cur_fixed), current)
+		);
+
+		pos_0_3 = _mm256_add_epi64(pos_0_3, adder);
+		pos_4_7 = _mm256_add_epi64(pos_4_7, adder);
+	}
+	*resampleOffset += resampleStep * (toResample - tail);
+	cur_scalar += resampleStep * (toResample - tail);
+	dCache += (cur_scalar >> FIXED_PRECISION);
+	cur_scalar &= FIXED_FRACTION_MASK;
+
+	/* This is the tail. */
+	for (i = 0; i < tail; i += 1)
+	{
+		/* lerp, then convert to float value */
+		*resampleCache++ = (float) (
+			dCache[0] +
+			(dCache[1] - dCache[0]) *
+			FIXED_TO_FLOAT(cur_scalar)
+		);
+
+		/* Increment fraction offset by the stepping value */
+		*resampleOffset += resampleStep;
+		cur_scalar += resampleStep;
+
+		/* Only increment the sample offset by integer values. */
+		dCache += (cur_scalar >> FIXED_PRECISION);
+
+		/* Now that any integer has been added, drop it. */
+		cur_scalar &= FIXED_FRACTION_MASK;
+	}
+}
+
+FAUDIO_TARGET_AVX2 void FAudio_INTERNAL_ResampleStereo_AVX2(
+	float *restrict dCache,
+	float *restrict resampleCache,
+	uint64_t *resampleOffset,
+	uint64_t resampleStep,
+	uint64_t toResample,
+	uint8_t UNUSED
+) {
+	uint32_t i, tail;
+	uint64_t cur_scalar = *resampleOffset & FIXED_FRACTION_MASK;
+	__m256i pos, adder, high_sel, low_sel, channel, half_fixed,
+		index, frac;
+	__m256 one_over_fixed_one, half, current, next, cur_fixed;
+
+	/* Four frames per iteration, each lane pair is one L/R frame */
+	pos = _mm256_setr_epi64x(
+		cur_scalar,
+		cur_scalar + resampleStep,
+		cur_scalar + resampleStep * 2,
+		cur_scalar + resampleStep * 3
+	);
+	adder = _mm256_set1_epi64x(resampleStep * 4);
+
+	/* Constants */
+	high_sel = _mm256_setr_epi32(1, 1, 3, 3, 5, 5, 7, 7);
+	low_sel = _mm256_setr_epi32(0, 0, 2, 2, 4, 4, 6, 6);
+	channel = _mm256_setr_epi32(0, 1, 0, 1, 0, 1, 0, 1);
+	half_fixed = _mm256_set1_epi32((int32_t) DOUBLE_TO_FIXED(0.5));
+	one_over_fixed_one = _mm256_set1_ps(1.0f / FIXED_ONE);
+	half = _mm256_set1_ps(0.5f);
+
+	tail = toResample % 4;
+	for (i = 0; i < toResample - tail; i += 4, resampleCache += 8)
+	{
+		index = _mm256_add_epi32(
+			_mm256_slli_epi32(_mm256_permutevar8x32_epi32(pos, high_sel), 1),
+			channel
+		);
+		frac = _mm256_permutevar8x32_epi32(pos, low_sel);
+
+		current = _mm256_i32gather_ps(dCache, index, 4);
+		next = _mm256_i32gather_ps(dCache + 2, index, 4);
+
+		cur_fixed = _mm256_add_ps(
+			_mm256_mul_ps(
+				_mm256_cvtepi32_ps(_mm256_sub_epi32(frac, half_fixed)),
+				one_over_fixed_one
+			),
+			half
+		);
+		_mm256_storeu_ps(
+			resampleCache,
+			_mm256_add_ps(_mm256_mul_ps(_mm256_sub_ps(next, current), cur_fixed), current)
+		);
+
+		pos = _mm256_add_epi64(pos, adder);
+	}
+	*resampleOffset += resampleStep * (toResample - tail);
+	cur_scalar += resampleStep * (toResample - tail);
+	dCache += (cur_scalar >> FIXED_PRECISION) * 2;
+	cur_scalar &= FIXED_FRACTION_MASK;
+
+	/* This is the tail. */
+	for (i = 0; i < tail; i += 1)
+	{
+		/* lerp, then convert to float value */
+		*resampleCache++ = (float) (
+			dCache[0] +
+			(dCache[2] - dCache[0]) *
+			FIXED_TO_FLOAT(cur_scalar)
+		);
+		*resampleCache++ = (float) (
+			dCache[1] +
+			(dCache[3] - dCache[1]) *
+			FIXED_TO_FLOAT(cur_scalar)
+		);
+
+		/* Increment fraction offset by the stepping value */
+		*resampleOffset += resampleStep;
+		cur_scalar += resampleStep;
+
+		/* Only increment the sample offset by integer values. */
+		dCache += (cur_scalar >> FIXED_PRECISION) * 2;
+
+		/* Now that any integer has been added, drop it. */
+		cur_scalar &= FIXED_FRACTION_MASK;
+	}
+}
+#endif /* HAVE_AVX2_INTRINSICS */
+
 #if HAVE_NEON_INTRINSICS
 void FAudio_INTERNAL_ResampleMono_NEON(
 	float *restrict dCache,
@@ -1182,7 +1459,6 @@ void FAudio_INTERNAL_ResampleStereo_NEON(
 
 /* SECTION 3: Amplifiers */
 
-#if NEED_SCALAR_CONVERTER_FALLBACKS
 void FAudio_INTERNAL_Amplify_Scalar(
 	float* output,
 	uint32_t totalSamples,
@@ -1194,7 +1470,6 @@ void FAudio_INTERNAL_Amplify_Scalar(
 		output[i] *= volume;
 	}
 }
-#endif /* NEED_SCALAR_CONVERTER_FALLBACKS */
 
 /* The SSE2 version of the amplifier comes from @8thMage! */
 
@@ -1237,6 +1512,30 @@ void FAudio_INTERNAL_Amplify_SSE2(
 }
 #endif /* HAVE_SSE2_INTRINSICS */
 
+#if HAVE_AVX2_INTRINSICS
+FAUDIO_TARGET_AVX2 void FAudio_INTERNAL_Amplify_AVX2(
+	float* output,
+	uint32_t totalSamples,
+	float volume
+) {
+	uint32_t i;
+	const __m256 volumeVec = _mm256_set1_ps(volume);
+
+	for (i = 0; i + 8 <= totalSamples; i += 8)
+	{
+		_mm256_storeu_ps(
+			output + i,
+			_mm256_mul_ps(_mm256_loadu_ps(output + i), volumeVec)
+		);
+	}
+
+	for (; i < totalSamples; i += 1)
+	{
+		output[i] *= volume;
+	}
+}
+#endif /* HAVE_AVX2_INTRINSICS */
+
 #if HAVE_NEON_INTRINSICS
 void FAudio_INTERNAL_Amplify_NEON(
 	float* output,
@@ -1344,6 +1643,165 @@ void FAudio_INTERNAL_Mix_Generic_SSE2(
 }
 #endif /* HAVE_SSE2_INTRINSICS */
 
+#if HAVE_AVX2_INTRINSICS
+FAUDIO_TARGET_AVX2 void FAudio_INTERNAL_Mix_Generic_AVX2(
+	uint32_t toMix,
+	uint32_t srcChans,
+	uint32_t dstChans,
+	float *restrict src,
+	float *restrict dst,
+	float *restrict coefficients
+) {
+	uint32_t i, co, ci;
+	__m256 sum8, out;
+	__m128 sum4;
+	__m256i mask;
+	float columns[32][8];
+
+	/* Surround outputs fit in one register: transpose the matrix once, then
+	 * every input sample is a broadcast multiply-add into the output frame,
+	 * in the same order as the scalar mixer. For
+	 * fewer outputs the overlapping masked stores of adjacent frames stall
+	 * store forwarding, so use per-channel dot products there instead.
+	 */
+	if (dstChans >= 6 && dstChans <= 8 && srcChans <= 32)
+	{
+		for (ci = 0; ci < srcChans; ci += 1)
+		for (co = 0; co < 8; co += 1)
+		{
+			columns[ci][co] = (co < dstChans) ?
+				coefficients[co * srcChans + ci] :
+				0.0f;
+		}
+		mask = _mm256_cmpgt_epi32(
+			_mm256_set1_epi32(dstChans),
+			_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)
+		);
+		for (i = 0; i < toMix; i += 1, src += srcChans, dst += dstChans)
+		{
+			out = _mm256_maskload_ps(dst, mask);
+			for (ci = 0; ci < srcChans; ci += 1)
+			{
+				out = _mm256_add_ps(
+					_mm256_mul_ps(_mm256_set1_ps(src[ci]), _mm256_loadu_ps(columns[ci])),
+					out
+				);
+			}
+			_mm256_maskstore_ps(dst, mask, out);
+		}
+		return;
+	}
+
+	/* Not enough inputs to fill a ymm register */
+	if (srcChans < 8)
+	{
+		FAudio_INTERNAL_Mix_Generic_SSE2(
+			toMix,
+			srcChans,
+			dstChans,
+			src,
+			dst,
+			coefficients
+		);
+		return;
+	}
+
+	for (i = 0; i < toMix; i += 1, src += srcChans, dst += dstChans)
+	for (co = 0; co < dstChans; co += 1)
+	{
+		sum8 = _mm256_setzero_ps();
+		for (ci = 0; srcChans - ci >= 8; ci += 8)
+		{
+			sum8 = _mm256_add_ps(
+				_mm256_mul_ps(
+					_mm256_loadu_ps(&src[ci]),
+					_mm256_loadu_ps(&coefficients[co * srcChans + ci])
+				),
+				sum8
+			);
+		}
+		sum4 = _mm_add_ps(
+			_mm256_castps256_ps128(sum8),
+			_mm256_extractf128_ps(sum8, 1)
+		);
+		if (srcChans - ci >= 4)
+		{
+			sum4 = _mm_add_ps(
+				_mm_mul_ps(
+					_mm_loadu_ps(&src[ci]),
+					_mm_loadu_ps(&coefficients[co * srcChans + ci])
+				),
+				sum4
+			);
+			ci += 4;
+		}
+		if (ci > 0)
+		{
+			dst[co] += FAudio_simd_hadd(sum4);
+		}
+
+		for (; ci < srcChans; ci += 1)
+		{
+			/* do scalar */
+			dst[co] += (
+				src[ci] *
+				coefficients[co * srcChans + ci]
+			);
+		}
+	}
+}
+
+/* 7.1 output is common enough to get its own kernels: all eight output
+ * channels of a frame fit in one register, so the coefficient columns are
+ * loaded once and every input sample becomes a broadcast multiply-add.
+ */
+
+FAUDIO_TARGET_AVX2 void FAudio_INTERNAL_Mix_1in_8out_AVX2(
+	uint32_t toMix,
+	uint32_t UNUSED1,
+	uint32_t UNUSED2,
+	float *restrict src,
+	float *restrict dst,
+	float *restrict coefficients
+) {
+	uint32_t i;
+	const __m256 column = _mm256_loadu_ps(coefficients);
+	for (i = 0; i < toMix; i += 1, src += 1, dst += 8)
+	{
+		_mm256_storeu_ps(dst, _mm256_add_ps(
+			_mm256_mul_ps(_mm256_set1_ps(src[0]), column),
+			_mm256_loadu_ps(dst)
+		));
+	}
+}
+
+FAUDIO_TARGET_AVX2 void FAudio_INTERNAL_Mix_2in_8out_AVX2(
+	uint32_t toMix,
+	uint32_t UNUSED1,
+	uint32_t UNUSED2,
+	float *restrict src,
+	float *restrict dst,
+	float *restrict coefficients
+) {
+	uint32_t i;
+	const __m256 left = _mm256_setr_ps(
+		coefficients[0], coefficients[2], coefficients[4], coefficients[6],
+		coefficients[8], coefficients[10], coefficients[12], coefficients[14]
+	);
+	const __m256 right = _mm256_setr_ps(
+		coefficients[1], coefficients[3], coefficients[5], coefficients[7],
+		coefficients[9], coefficients[11], coefficients[13], coefficients[15]
+	);
+	__m256 out;
+	for (i = 0; i < toMix; i += 1, src += 2, dst += 8)
+	{
+		out = _mm256_mul_ps(_mm256_set1_ps(src[0]), left);
+		out = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(src[1]), right), out);
+		_mm256_storeu_ps(dst, _mm256_add_ps(_mm256_loadu_ps(dst), out));
+	}
+}
+#endif /* HAVE_AVX2_INTRINSICS */
+
 void FAudio_INTERNAL_Mix_1in_1out_Scalar(
 	uint32_t toMix,
 	uint32_t UNUSED1,
@@ -1543,7 +2001,7 @@ void FAudio_INTERNAL_Mix_2in_8out_Scalar(
 	}
 }
 
-/* SECTION 5: InitSIMDFunctions. Assigns based on SSE2/NEON support. */
+/* SECTION 5: InitSIMDFunctions. Assigns based on SSE2/AVX2/NEON support. */
 
 void (*FAudio_INTERNAL_Convert_U8_To_F32)(
 	const uint8_t *restrict src,
@@ -1571,9 +2029,104 @@ void (*FAudio_INTERNAL_Amplify)(
 );
 
 FAudioMixCallback FAudio_INTERNAL_Mix_Generic;
+FAudioMixCallback FAudio_INTERNAL_Mix_1in_8out;
+FAudioMixCallback FAudio_INTERNAL_Mix_2in_8out;
+
+#if HAVE_AVX2_INTRINSICS
+static uint8_t FAudio_INTERNAL_HasAVX2(void)
+{
+	uint32_t regs[4];
+	uint64_t xcr0;
+
+#if defined(_MSC_VER) && !defined(__clang__)
+	__cpuid((int*) regs, 0);
+	if (regs[0] < 7)
+	{
+		return 0;
+	}
+	__cpuid((int*) regs, 1);
+#else
+	if (__get_cpuid_max(0, NULL) < 7)
+	{
+		return 0;
+	}
+	__cpuid(1, regs[0], regs[1], regs[2], regs[3]);
+#endif
+
+	/* OSXSAVE (bit 27) and AVX (bit 28) */
+	if ((regs[2] & 0x18000000) != 0x18000000)
+	{
+		return 0;
+	}
+
+	/* The OS has to save the ymm registers for us */
+#if defined(_MSC_VER) && !defined(__clang__)
+	xcr0 = _xgetbv(0);
+#else
+	{
+		uint32_t lo, hi;
+		__asm__ __volatile__ ("xgetbv" : "=a" (lo), "=d" (hi) : "c" (0));
+		xcr0 = ((uint64_t) hi << 32) | lo;
+	}
+#endif
+	if ((xcr0 & 0x6) != 0x6)
+	{
+		return 0;
+	}
 
+#if defined(_MSC_VER) && !defined(__clang__)
+	__cpuidex((int*) regs, 7, 0);
+#else
+	__cpuid_count(7, 0, regs[0], regs[1], regs[2], regs[3]);
+#endif
+	return (regs[1] & (1 << 5)) != 0;
+}
+#endif /* HAVE_AVX2_INTRINSICS */
+
+/* FAUDIO_SIMD=sse2 disables the AVX2 paths, FAUDIO_SIMD=none disables all
+ * the SIMD paths, so that they can be compared with the scalar code.
+ */
 void FAudio_INTERNAL_InitSIMDFunctions(uint8_t hasSSE2, uint8_t hasNEON)
 {
+	const char *env = FAudio_getenv("FAUDIO_SIMD");
+#if HAVE_AVX2_INTRINSICS
+	uint8_t allowAVX2 = 1;
+#endif
+
+	if (env != NULL && FAudio_strcmp(env, "none") == 0)
+	{
+#if HAVE_SSE2_INTRINSICS
+		hasSSE2 = 0;
+#endif
+#if HAVE_NEON_INTRINSICS
+		hasNEON = 0;
+#endif
+	}
+#if HAVE_AVX2_INTRINSICS
+	else if (env != NULL && FAudio_strcmp(env, "sse2") == 0)
+	{
+		allowAVX2 = 0;
+	}
+#endif
+
+	FAudio_INTERNAL_Mix_1in_8out = FAudio_INTERNAL_Mix_1in_8out_Scalar;
+	FAudio_INTERNAL_Mix_2in_8out = FAudio_INTERNAL_Mix_2in_8out_Scalar;
+
+#if HAVE_AVX2_INTRINSICS
+	if (allowAVX2 && hasSSE2 && FAudio_INTERNAL_HasAVX2())
+	{
+		FAudio_INTERNAL_Convert_U8_To_F32 = FAudio_INTERNAL_Convert_U8_To_F32_AVX2;
+		FAudio_INTERNAL_Convert_S16_To_F32 = FAudio_INTERNAL_Convert_S16_To_F32_AVX2;
+		FAudio_INTERNAL_Convert_S32_To_F32 = FAudio_INTERNAL_Convert_S32_To_F32_AVX2;
+		FAudio_INTERNAL_ResampleMono = FAudio_INTERNAL_ResampleMono_AVX2;
+		FAudio_INTERNAL_ResampleStereo = FAudio_INTERNAL_ResampleStereo_AVX2;
+		FAudio_INTERNAL_Amplify = FAudio_INTERNAL_Amplify_AVX2;
+		FAudio_INTERNAL_Mix_Generic = FAudio_INTERNAL_Mix_Generic_AVX2;
+		FAudio_INTERNAL_Mix_1in_8out = FAudio_INTERNAL_Mix_1in_8out_AVX2;
+		FAudio_INTERNAL_Mix_2in_8out = FAudio_INTERNAL_Mix_2in_8out_AVX2;
+		return;
+	}
+#endif
 #if HAVE_SSE2_INTRINSICS
 	if (hasSSE2)
 	{
@@ -1600,7 +2153,6 @@ void FAudio_INTERNAL_InitSIMDFunctions(uint8_t hasSSE2, uint8_t hasNEON)
 		return;
 	}
 #endif
-#if NEED_SCALAR_CONVERTER_FALLBACKS
 	FAudio_INTERNAL_Convert_U8_To_F32 = FAudio_INTERNAL_Convert_U8_To_F32_Scalar;
 	FAudio_INTERNAL_Convert_S16_To_F32 = FAudio_INTERNAL_Convert_S16_To_F32_Scalar;
 	FAudio_INTERNAL_Convert_S32_To_F32 = FAudio_INTERNAL_Convert_S32_To_F32_Scalar;
@@ -1608,9 +2160,4 @@ void FAudio_INTERNAL_InitSIMDFunctions(uint8_t hasSSE2, uint8_t hasNEON)
 	FAudio_INTERNAL_ResampleStereo = FAudio_INTERNAL_ResampleStereo_Scalar;
 	FAudio_INTERNAL_Amplify = FAudio_INTERNAL_Amplify_Scalar;
 	FAudio_INTERNAL_Mix_Generic = FAudio_INTERNAL_Mix_Generic_Scalar;
-#else
-	FAudio_assert(0 && "Need converter functions!");
-#endif
 }
-
-/* vim: set noexpandtab shiftwidth=8 tabstop=8: */
@@ -702,12 +702,52 @@ void FAudio_PlatformUnlockMutex(FAudioMutex mutex)
 	if (mutex) LeaveCriticalSection(mutex);
 }
 
+void* FAudio_PlatformAtomicExchangePointer(void **dst, void *value)
+{
+	return InterlockedExchangePointer(dst, value);
+}
+
+void* FAudio_PlatformAtomicCompareExchangePointer(
+	void **dst,
+	void *exchange,
+	void *comparand
+) {
+	return InterlockedCompareExchangePointer(dst, exchange, comparand);
+}
+
 void FAudio_PlatformDestroyMutex(FAudioMutex mutex)
 {
 	if (mutex) DeleteCriticalSection(mutex);
 	FAudio_free(mutex);
 }
 
+FAudioSemaphore FAudio_PlatformCreateSemaphore(uint32_t initialValue)
+{
+	return CreateSemaphoreW(NULL, initialValue, MAXLONG, NULL);
+}
+
+void FAudio_PlatformDestroySemaphore(FAudioSemaphore sem)
+{
+	if (sem) CloseHandle(sem);
+}
+
+void FAudio_PlatformWaitSemaphore(FAudioSemaphore sem)
+{
+	WaitForSingleObject(sem, INFINITE);
+}
+
+void FAudio_PlatformSignalSemaphore(FAudioSemaphore sem, uint32_t count)
+{
+	if (count) ReleaseSemaphore(sem, count, NULL);
+}
+
+uint32_t FAudio_PlatformGetCPUCount(void)
+{
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return info.dwNumberOfProcessors;
+}
+
 struct FAudioThreadArgs
 {
 	FAudioThreadFunc func;
@@ -768,6 +808,13 @@ uint32_t FAudio_timems()
 	return GetTickCount();
 }
 
+uint64_t FAudio_PlatformGetPerformanceCounter(void)
+{
+	LARGE_INTEGER counter;
+	QueryPerformanceCounter(&counter);
+	return counter.QuadPart;
+}
+
 /* FAudio I/O */
 
 static size_t FAUDIOCALL FAudio_FILE_read(
@@ -171,8 +171,11 @@ const char *debugstr_w(const WCHAR *wstr, size_t wchar_size);
         vkd3d_dbg_next_time = true; \
         VKD3D_DBG_PRINTF_##level
 
+/* Check the level first, so that arguments such as debugstr_a(), which write
+ * to buffers shared by all threads, are only evaluated when needed. */
 #define VKD3D_DBG_PRINTF(...) \
-        vkd3d_dbg_printf(vkd3d_dbg_level, __FUNCTION__, __VA_ARGS__); } while (0)
+        if (vkd3d_dbg_level <= vkd3d_dbg_get_level()) \
+            vkd3d_dbg_printf(vkd3d_dbg_level, __FUNCTION__, __VA_ARGS__); } while (0)
 
 #define VKD3D_DBG_PRINTF_TRACE(...) VKD3D_DBG_PRINTF(__VA_ARGS__)
 #define VKD3D_DBG_PRINTF_WARN(...) VKD3D_DBG_PRINTF(__VA_ARGS__)
@@ -391,6 +394,101 @@ static inline int vkd3d_u64_compare(uint64_t x, uint64_t y)
     return (x > y) - (x < y);
 }
 
+#define VKD3D_HASH_PRIME1 0x9e3779b185ebca87ull
+#define VKD3D_HASH_PRIME2 0xc2b2ae3d27d4eb4full
+#define VKD3D_HASH_PRIME3 0x165667b19e3779f9ull
+#define VKD3D_HASH_PRIME4 0x85ebca77c2b2ae63ull
+#define VKD3D_HASH_PRIME5 0x27d4eb2f165667c5ull
+
+static inline uint64_t vkd3d_hash_rotl64(uint64_t x, unsigned int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t vkd3d_hash_read_u64(const uint8_t *p)
+{
+    return (uint64_t)p[0] | (uint64_t)p[1] << 8 | (uint64_t)p[2] << 16 | (uint64_t)p[3] << 24
+            | (uint64_t)p[4] << 32 | (uint64_t)p[5] << 40 | (uint64_t)p[6] << 48 | (uint64_t)p[7] << 56;
+}
+
+static inline uint64_t vkd3d_hash_round(uint64_t acc, uint64_t input)
+{
+    acc += input * VKD3D_HASH_PRIME2;
+    return vkd3d_hash_rotl64(acc, 31) * VKD3D_HASH_PRIME1;
+}
+
+static inline uint64_t vkd3d_hash_merge(uint64_t hash, uint64_t acc)
+{
+    hash ^= vkd3d_hash_round(0, acc);
+    return hash * VKD3D_HASH_PRIME1 + VKD3D_HASH_PRIME4;
+}
+
+/* A seeded 64-bit hash, computing the same values as XXH64. It consumes
+ * 32 bytes per iteration, which makes it considerably faster than FNV-1a for
+ * the large keys used by the shader caches. */
+static inline uint64_t vkd3d_hash_bytes(const void *data, size_t size, uint64_t seed)
+{
+    const uint8_t *p = data, *end = p + size;
+    uint64_t hash;
+
+    if (size >= 32)
+    {
+        uint64_t v1 = seed + VKD3D_HASH_PRIME1 + VKD3D_HASH_PRIME2;
+        uint64_t v2 = seed + VKD3D_HASH_PRIME2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - VKD3D_HASH_PRIME1;
+
+        do
+        {
+            v1 = vkd3d_hash_round(v1, vkd3d_hash_read_u64(p));
+            v2 = vkd3d_hash_round(v2, vkd3d_hash_read_u64(p + 8));
+            v3 = vkd3d_hash_round(v3, vkd3d_hash_read_u64(p + 16));
+            v4 = vkd3d_hash_round(v4, vkd3d_hash_read_u64(p + 24));
+            p += 32;
+        } while (end - p >= 32);
+
+        hash = vkd3d_hash_rotl64(v1, 1) + vkd3d_hash_rotl64(v2, 7)
+                + vkd3d_hash_rotl64(v3, 12) + vkd3d_hash_rotl64(v4, 18);
+        hash = vkd3d_hash_merge(hash, v1);
+        hash = vkd3d_hash_merge(hash, v2);
+        hash = vkd3d_hash_merge(hash, v3);
+        hash = vkd3d_hash_merge(hash, v4);
+    }
+    else
+    {
+        hash = seed + VKD3D_HASH_PRIME5;
+    }
+
+    hash += size;
+
+    for (; end - p >= 8; p += 8)
+    {
+        hash ^= vkd3d_hash_round(0, vkd3d_hash_read_u64(p));
+        hash = vkd3d_hash_rotl64(hash, 27) * VKD3D_HASH_PRIME1 + VKD3D_HASH_PRIME4;
+    }
+    if (end - p >= 4)
+    {
+        uint32_t v = (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+
+        hash ^= v * VKD3D_HASH_PRIME1;
+        hash = vkd3d_hash_rotl64(hash, 23) * VKD3D_HASH_PRIME2 + VKD3D_HASH_PRIME3;
+        p += 4;
+    }
+    for (; p < end; ++p)
+    {
+        hash ^= *p * VKD3D_HASH_PRIME5;
+        hash = vkd3d_hash_rotl64(hash, 11) * VKD3D_HASH_PRIME1;
+    }
+
+    hash ^= hash >> 33;
+    hash *= VKD3D_HASH_PRIME2;
+    hash ^= hash >> 29;
+    hash *= VKD3D_HASH_PRIME3;
+    hash ^= hash >> 32;
+
+    return hash;
+}
+
 #define VKD3D_BITMAP_SIZE(x) (((x) + 0x1f) >> 5)
 
 static inline bool bitmap_clear(uint32_t *map, unsigned int idx)
@@ -2816,6 +2816,44 @@ VKD3D_SHADER_API const enum vkd3d_shader_target_type *vkd3d_shader_get_supported
  */
 VKD3D_SHADER_API int vkd3d_shader_compile(const struct vkd3d_shader_compile_info *compile_info,
         struct vkd3d_shader_code *out, char **messages);
+/**
+ * Compile several shaders, distributing the compilations over multiple
+ * threads.
+ *
+ * Each element of \a compile_infos is compiled exactly as if it had been
+ * passed to vkd3d_shader_compile(); the results are the same, and are
+ * independent of the number of threads used. The order in which the
+ * compilations are performed is unspecified.
+ *
+ * Callbacks supplied through the chained structures, such as the include
+ * callbacks of struct vkd3d_shader_preprocess_info, may be called
+ * concurrently from several threads, and must be thread-safe.
+ *
+ * \param compile_infos An array of \a count chained structures containing
+ * compilation parameters.
+ *
+ * \param count The number of shaders to compile.
+ *
+ * \param thread_count The maximum number of threads to use, including the
+ * calling thread. If zero, one thread per processor is used.
+ *
+ * \param out An array of \a count vkd3d_shader_code structures in which the
+ * compiled code will be stored. Elements for which compilation failed are
+ * left in an unspecified state. The compiled shaders should be freed with
+ * vkd3d_shader_free_shader_code() when no longer needed.
+ *
+ * \param messages Optional array of \a count output locations for the
+ * messages produced by each compilation, as for vkd3d_shader_compile().
+ *
+ * \param results Optional array of \a count output locations for the
+ * result of each compilation, as returned by vkd3d_shader_compile().
+ *
+ * \return VKD3D_OK if all compilations succeeded. Otherwise, the result of the
+ * first failed compilation in array order, or VKD3D_ERROR_OUT_OF_MEMORY.
+ * If \a count is zero, nothing is compiled and VKD3D_OK is returned.
+ */
+VKD3D_SHADER_API int vkd3d_shader_compile_batch(const struct vkd3d_shader_compile_info *compile_infos,
+        unsigned int count, unsigned int thread_count, struct vkd3d_shader_code *out, char **messages, int *results);
 /**
  * Free shader messages allocated by another vkd3d-shader function, such as
  * vkd3d_shader_compile().
@@ -3283,6 +3321,9 @@ typedef const enum vkd3d_shader_target_type *(*PFN_vkd3d_shader_get_supported_ta
 /** Type of vkd3d_shader_compile(). */
 typedef int (*PFN_vkd3d_shader_compile)(const struct vkd3d_shader_compile_info *compile_info,
         struct vkd3d_shader_code *out, char **messages);
+/** Type of vkd3d_shader_compile_batch(). */
+typedef int (*PFN_vkd3d_shader_compile_batch)(const struct vkd3d_shader_compile_info *compile_infos,
+        unsigned int count, unsigned int thread_count, struct vkd3d_shader_code *out, char **messages, int *results);
 /** Type of vkd3d_shader_free_messages(). */
 typedef void (*PFN_vkd3d_shader_free_messages)(char *messages);
 /** Type of vkd3d_shader_free_shader_code(). */
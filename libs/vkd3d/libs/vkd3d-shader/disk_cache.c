@@ -0,0 +1,1005 @@
+/*
+ * Persistent on-disk cache for shader translations
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+/* The cache is a single file shared by all processes using the same
+ * VKD3D_SHADER_CACHE_PATH. It is mapped into memory and consists of a
+ * header, an open addressing index, and a data region holding the keys and
+ * values. All accesses are serialised by a lock on the file. Entries are
+ * only ever appended; when either the index or the data region fills up,
+ * the least recently used half of the entries is dropped and the remaining
+ * ones are compacted.
+ *
+ * The key of an entry is a serialised form of everything that can influence
+ * the output of vkd3d_shader_compile(), except for the source itself, which
+ * is represented by its size and two independent 64-bit hashes. The value
+ * holds the size of the compiled code, the code, and the messages the
+ * compilation produced. */
+
+#include "vkd3d_shader_private.h"
+
+#ifndef _WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define VKD3D_SHADER_DISK_CACHE_MAGIC VKD3D_MAKE_TAG('V', 'K', 'S', 'C')
+/* Bump this whenever a change to the compiler alters its output for the same
+ * input, since released versions are the only thing the build id tracks. */
+#define VKD3D_SHADER_DISK_CACHE_VERSION 1
+#define VKD3D_SHADER_DISK_CACHE_FILE_NAME "vkd3d-shader-cache.bin"
+
+#define VKD3D_SHADER_DISK_CACHE_DEFAULT_SIZE_MB 64
+#define VKD3D_SHADER_DISK_CACHE_MAX_SIZE_MB 1024
+#define VKD3D_SHADER_DISK_CACHE_INITIAL_DATA_SIZE (1024 * 1024)
+/* Used to size the index; SPIR-V for a typical D3D12 shader is a few KiB. */
+#define VKD3D_SHADER_DISK_CACHE_AVERAGE_ENTRY_SIZE 4096
+#define VKD3D_SHADER_DISK_CACHE_ALIGNMENT 4096
+
+#define VKD3D_SHADER_DISK_CACHE_SOURCE_SEED1 0x6b766433645f7331ull
+#define VKD3D_SHADER_DISK_CACHE_SOURCE_SEED2 0x6b766433645f7332ull
+
+struct vkd3d_shader_disk_cache_header
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t build_id;
+    uint64_t max_size;
+    uint64_t file_size;
+    uint64_t data_offset;
+    uint64_t data_size;
+    uint32_t bucket_count;
+    uint32_t entry_count;
+    uint64_t use_counter;
+    uint32_t dirty;
+    uint32_t reserved;
+};
+
+struct vkd3d_shader_disk_cache_bucket
+{
+    /* Zero for unused buckets. */
+    uint64_t hash;
+    /* Relative to the start of the data region. */
+    uint64_t offset;
+    uint32_t key_size;
+    uint32_t value_size;
+    uint64_t value_hash;
+    uint64_t last_use;
+};
+
+struct vkd3d_shader_disk_cache
+{
+    bool initialised;
+    bool enabled;
+
+#ifdef _WIN32
+    HANDLE file;
+    HANDLE mapping;
+#else
+    int fd;
+#endif
+    uint8_t *map;
+    uint64_t map_size;
+
+    uint64_t build_id;
+    /* Layout used when (re)initialising the file. */
+    uint64_t max_size;
+    uint32_t bucket_count;
+    uint64_t data_offset;
+};
+
+static struct vkd3d_mutex disk_cache_mutex = VKD3D_MUTEX_INITIALIZER;
+static struct vkd3d_shader_disk_cache disk_cache;
+
+#ifdef _WIN32
+
+static bool disk_cache_open_file(struct vkd3d_shader_disk_cache *cache, const char *path)
+{
+    cache->file = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE,
+            NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (cache->file == INVALID_HANDLE_VALUE)
+    {
+        WARN("Failed to open \"%s\", error %lu.\n", path, GetLastError());
+        return false;
+    }
+    cache->mapping = NULL;
+    return true;
+}
+
+/* Byte range locks on Windows are mandatory for reads and writes, so lock a
+ * single byte far beyond the end of the file instead of the file itself. */
+static void disk_cache_lock_file(struct vkd3d_shader_disk_cache *cache)
+{
+    OVERLAPPED overlapped = {0};
+
+    overlapped.Offset = 0xffffffff;
+    overlapped.OffsetHigh = 0x7fffffff;
+    if (!LockFileEx(cache->file, LOCKFILE_EXCLUSIVE_LOCK, 0, 1, 0, &overlapped))
+        ERR("Failed to lock the cache file, error %lu.\n", GetLastError());
+}
+
+static void disk_cache_unlock_file(struct vkd3d_shader_disk_cache *cache)
+{
+    OVERLAPPED overlapped = {0};
+
+    overlapped.Offset = 0xffffffff;
+    overlapped.OffsetHigh = 0x7fffffff;
+    UnlockFileEx(cache->file, 0, 1, 0, &overlapped);
+}
+
+static uint64_t disk_cache_get_file_size(struct vkd3d_shader_disk_cache *cache)
+{
+    LARGE_INTEGER size;
+
+    if (!GetFileSizeEx(cache->file, &size))
+        return 0;
+    return size.QuadPart;
+}
+
+static void disk_cache_unmap(struct vkd3d_shader_disk_cache *cache)
+{
+    if (cache->map)
+        UnmapViewOfFile(cache->map);
+    if (cache->mapping)
+        CloseHandle(cache->mapping);
+    cache->map = NULL;
+    cache->mapping = NULL;
+    cache->map_size = 0;
+}
+
+/* Maps the first "size" bytes of the file, extending it if needed. */
+static bool disk_cache_map(struct vkd3d_shader_disk_cache *cache, uint64_t size)
+{
+    disk_cache_unmap(cache);
+
+    if (!(cache->mapping = CreateFileMappingA(cache->file, NULL, PAGE_READWRITE, size >> 32, (DWORD)size, NULL)))
+    {
+        WARN("Failed to create a file mapping, error %lu.\n", GetLastError());
+        return false;
+    }
+    if (!(cache->map = MapViewOfFile(cache->mapping, FILE_MAP_READ | FILE_MAP_WRITE, 0, 0, size)))
+    {
+        WARN("Failed to map the cache file, error %lu.\n", GetLastError());
+        CloseHandle(cache->mapping);
+        cache->mapping = NULL;
+        return false;
+    }
+    cache->map_size = size;
+    return true;
+}
+
+static void disk_cache_close_file(struct vkd3d_shader_disk_cache *cache)
+{
+    disk_cache_unmap(cache);
+    CloseHandle(cache->file);
+}
+
+#else
+
+static bool disk_cache_open_file(struct vkd3d_shader_disk_cache *cache, const char *path)
+{
+    if ((cache->fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644)) < 0)
+    {
+        WARN("Failed to open \"%s\", errno %d.\n", path, errno);
+        return false;
+    }
+    return true;
+}
+
+/* fcntl() locks are owned by the process, threads are serialised by
+ * disk_cache_mutex. */
+static void disk_cache_lock_file(struct vkd3d_shader_disk_cache *cache)
+{
+    struct flock lock = {.l_type = F_WRLCK, .l_whence = SEEK_SET};
+
+    while (fcntl(cache->fd, F_SETLKW, &lock) < 0)
+    {
+        if (errno != EINTR)
+        {
+            ERR("Failed to lock the cache file, errno %d.\n", errno);
+            break;
+        }
+    }
+}
+
+static void disk_cache_unlock_file(struct vkd3d_shader_disk_cache *cache)
+{
+    struct flock lock = {.l_type = F_UNLCK, .l_whence = SEEK_SET};
+
+    fcntl(cache->fd, F_SETLK, &lock);
+}
+
+static uint64_t disk_cache_get_file_size(struct vkd3d_shader_disk_cache *cache)
+{
+    struct stat st;
+
+    if (fstat(cache->fd, &st) < 0)
+        return 0;
+    return st.st_size;
+}
+
+static void disk_cache_unmap(struct vkd3d_shader_disk_cache *cache)
+{
+    if (cache->map)
+        munmap(cache->map, cache->map_size);
+    cache->map = NULL;
+    cache->map_size = 0;
+}
+
+/* Maps the first "size" bytes of the file, extending it if needed. */
+static bool disk_cache_map(struct vkd3d_shader_disk_cache *cache, uint64_t size)
+{
+    void *map;
+
+    disk_cache_unmap(cache);
+
+    if (disk_cache_get_file_size(cache) < size && ftruncate(cache->fd, size) < 0)
+    {
+        WARN("Failed to resize the cache file, errno %d.\n", errno);
+        return false;
+    }
+    if ((map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, cache->fd, 0)) == MAP_FAILED)
+    {
+        WARN("Failed to map the cache file, errno %d.\n", errno);
+        return false;
+    }
+    cache->map = map;
+    cache->map_size = size;
+    return true;
+}
+
+static void disk_cache_close_file(struct vkd3d_shader_disk_cache *cache)
+{
+    disk_cache_unmap(cache);
+    close(cache->fd);
+}
+
+#endif
+
+static struct vkd3d_shader_disk_cache_header *disk_cache_header(struct vkd3d_shader_disk_cache *cache)
+{
+    return (struct vkd3d_shader_disk_cache_header *)cache->map;
+}
+
+static struct vkd3d_shader_disk_cache_bucket *disk_cache_buckets(struct vkd3d_shader_disk_cache *cache)
+{
+    return (struct vkd3d_shader_disk_cache_bucket *)(cache->map + sizeof(struct vkd3d_shader_disk_cache_header));
+}
+
+static uint8_t *disk_cache_data(struct vkd3d_shader_disk_cache *cache)
+{
+    return cache->map + disk_cache_header(cache)->data_offset;
+}
+
+static bool disk_cache_header_is_valid(const struct vkd3d_shader_disk_cache *cache,
+        const struct vkd3d_shader_disk_cache_header *header, uint64_t file_size)
+{
+    uint64_t index_end;
+
+    if (header->magic != VKD3D_SHADER_DISK_CACHE_MAGIC || header->version != VKD3D_SHADER_DISK_CACHE_VERSION
+            || header->build_id != cache->build_id || header->dirty)
+        return false;
+
+    if (!header->bucket_count || (header->bucket_count & (header->bucket_count - 1))
+            || header->entry_count >= header->bucket_count)
+        return false;
+
+    index_end = sizeof(*header) + (uint64_t)header->bucket_count * sizeof(struct vkd3d_shader_disk_cache_bucket);
+    if (header->data_offset < index_end || header->data_offset > header->max_size
+            || header->file_size > file_size || header->file_size < header->data_offset
+            || header->file_size > SIZE_MAX)
+        return false;
+
+    return header->data_size <= header->file_size - header->data_offset;
+}
+
+/* Called with the file lock held. Throws away any existing contents. */
+static bool disk_cache_reset(struct vkd3d_shader_disk_cache *cache, uint64_t file_size)
+{
+    struct vkd3d_shader_disk_cache_header *header;
+    uint64_t size;
+
+    size = max(file_size, cache->data_offset + VKD3D_SHADER_DISK_CACHE_INITIAL_DATA_SIZE);
+    size = min(size, max(file_size, cache->max_size));
+    if (!disk_cache_map(cache, size))
+        return false;
+
+    TRACE("Initialising the cache file, size %#"PRIx64".\n", size);
+
+    header = disk_cache_header(cache);
+    memset(cache->map, 0, cache->data_offset);
+    header->magic = VKD3D_SHADER_DISK_CACHE_MAGIC;
+    header->version = VKD3D_SHADER_DISK_CACHE_VERSION;
+    header->build_id = cache->build_id;
+    header->max_size = cache->max_size;
+    header->file_size = size;
+    header->data_offset = cache->data_offset;
+    header->bucket_count = cache->bucket_count;
+    return true;
+}
+
+static bool disk_cache_init(struct vkd3d_shader_disk_cache *cache)
+{
+    const char *version, *dir;
+    unsigned int size_mb;
+    uint64_t index_size;
+    char *path;
+    bool ret;
+
+    if (!(dir = getenv("VKD3D_SHADER_CACHE_PATH")) || !*dir)
+        return false;
+
+    if (!(size_mb = vkd3d_env_var_as_uint("VKD3D_SHADER_CACHE_SIZE", VKD3D_SHADER_DISK_CACHE_DEFAULT_SIZE_MB)))
+        return false;
+    size_mb = min(size_mb, VKD3D_SHADER_DISK_CACHE_MAX_SIZE_MB);
+    if (sizeof(size_t) < sizeof(uint64_t))
+        size_mb = min(size_mb, VKD3D_SHADER_DISK_CACHE_MAX_SIZE_MB / 4);
+
+    version = vkd3d_shader_get_version(NULL, NULL);
+    cache->build_id = vkd3d_hash_bytes(version, strlen(version), VKD3D_SHADER_DISK_CACHE_VERSION);
+    cache->max_size = (uint64_t)size_mb << 20;
+    cache->bucket_count = 1u << vkd3d_log2i(max(cache->max_size / VKD3D_SHADER_DISK_CACHE_AVERAGE_ENTRY_SIZE, 256));
+    index_size = sizeof(struct vkd3d_shader_disk_cache_header)
+            + (uint64_t)cache->bucket_count * sizeof(struct vkd3d_shader_disk_cache_bucket);
+    cache->data_offset = align(index_size, VKD3D_SHADER_DISK_CACHE_ALIGNMENT);
+    cache->map = NULL;
+    cache->map_size = 0;
+
+    if (!(path = vkd3d_malloc(strlen(dir) + strlen(VKD3D_SHADER_DISK_CACHE_FILE_NAME) + 2)))
+        return false;
+    sprintf(path, "%s/%s", dir, VKD3D_SHADER_DISK_CACHE_FILE_NAME);
+    ret = disk_cache_open_file(cache, path);
+    if (ret)
+        TRACE("Using shader cache \"%s\", max size %u MiB.\n", path, size_mb);
+    vkd3d_free(path);
+
+    return ret;
+}
+
+static bool disk_cache_is_enabled(struct vkd3d_shader_disk_cache *cache)
+{
+    bool enabled;
+
+    vkd3d_mutex_lock(&disk_cache_mutex);
+    if (!cache->initialised)
+    {
+        cache->enabled = disk_cache_init(cache);
+        cache->initialised = true;
+    }
+    enabled = cache->enabled;
+    vkd3d_mutex_unlock(&disk_cache_mutex);
+
+    return enabled;
+}
+
+/* Called with the locks held, and releases them. */
+static void disk_cache_disable(struct vkd3d_shader_disk_cache *cache)
+{
+    WARN("Disabling the shader cache.\n");
+    disk_cache_unlock_file(cache);
+    disk_cache_close_file(cache);
+    cache->enabled = false;
+    vkd3d_mutex_unlock(&disk_cache_mutex);
+}
+
+/* Takes the locks and makes sure the mapping is valid and up to date. */
+static bool disk_cache_begin(struct vkd3d_shader_disk_cache *cache)
+{
+    const struct vkd3d_shader_disk_cache_header *header;
+    uint64_t file_size;
+
+    vkd3d_mutex_lock(&disk_cache_mutex);
+
+    if (!cache->enabled)
+    {
+        vkd3d_mutex_unlock(&disk_cache_mutex);
+        return false;
+    }
+
+    disk_cache_lock_file(cache);
+
+    /* The file never shrinks, unless something outside vkd3d-shader truncated it. */
+    file_size = disk_cache_get_file_size(cache);
+    if (cache->map_size > file_size)
+        disk_cache_unmap(cache);
+
+    if (file_size < sizeof(*header) || (!cache->map && !disk_cache_map(cache, file_size))
+            || !disk_cache_header_is_valid(cache, disk_cache_header(cache), file_size))
+    {
+        if (!disk_cache_reset(cache, file_size))
+            goto fail;
+    }
+    else if ((header = disk_cache_header(cache))->file_size != cache->map_size)
+    {
+        /* Another process grew the file. */
+        if (!disk_cache_map(cache, header->file_size))
+            goto fail;
+    }
+
+    return true;
+
+fail:
+    disk_cache_disable(cache);
+    return false;
+}
+
+static void disk_cache_end(struct vkd3d_shader_disk_cache *cache)
+{
+    disk_cache_unlock_file(cache);
+    vkd3d_mutex_unlock(&disk_cache_mutex);
+}
+
+static uint64_t disk_cache_hash_key(const void *key, size_t key_size)
+{
+    uint64_t hash = vkd3d_hash_bytes(key, key_size, 0);
+
+    return hash ? hash : 1;
+}
+
+static bool disk_cache_entry_is_valid(struct vkd3d_shader_disk_cache *cache,
+        const struct vkd3d_shader_disk_cache_bucket *bucket)
+{
+    const struct vkd3d_shader_disk_cache_header *header = disk_cache_header(cache);
+
+    return bucket->offset <= header->data_size
+            && (uint64_t)bucket->key_size + bucket->value_size <= header->data_size - bucket->offset;
+}
+
+/* Returns the bucket holding "key", or the empty bucket where it would be
+ * inserted. Returns NULL if neither exists, which can only happen if the
+ * index was corrupted. */
+static struct vkd3d_shader_disk_cache_bucket *disk_cache_find_bucket(struct vkd3d_shader_disk_cache *cache,
+        const void *key, size_t key_size, uint64_t hash)
+{
+    struct vkd3d_shader_disk_cache_bucket *buckets = disk_cache_buckets(cache), *bucket;
+    uint32_t mask = disk_cache_header(cache)->bucket_count - 1;
+    const uint8_t *data = disk_cache_data(cache);
+    uint32_t i, count;
+
+    for (i = hash & mask, count = 0; count <= mask; i = (i + 1) & mask, ++count)
+    {
+        bucket = &buckets[i];
+
+        if (!bucket->hash)
+            return bucket;
+        if (bucket->hash == hash && bucket->key_size == key_size && disk_cache_entry_is_valid(cache, bucket)
+                && !memcmp(data + bucket->offset, key, key_size))
+            return bucket;
+    }
+
+    return NULL;
+}
+
+static int disk_cache_bucket_compare_use(const void *a, const void *b)
+{
+    const struct vkd3d_shader_disk_cache_bucket *x = a, *y = b;
+
+    /* Most recently used first. */
+    return vkd3d_u64_compare(y->last_use, x->last_use);
+}
+
+/* Drops the least recently used entries until at most half of the index and
+ * of the maximum data size are in use, and compacts the data region. */
+static void disk_cache_evict(struct vkd3d_shader_disk_cache *cache)
+{
+    struct vkd3d_shader_disk_cache_header *header = disk_cache_header(cache);
+    struct vkd3d_shader_disk_cache_bucket *buckets = disk_cache_buckets(cache), *entries, *bucket;
+    uint64_t budget, data_size = 0, entry_size;
+    uint32_t i, entry_count = 0, kept = 0;
+    uint8_t *data, *saved = NULL;
+
+    TRACE("Evicting entries, %u entries, data size %#"PRIx64".\n", header->entry_count, header->data_size);
+
+    header->dirty = 1;
+    budget = (header->max_size - header->data_offset) / 2;
+    data = disk_cache_data(cache);
+
+    if ((entries = vkd3d_calloc(header->bucket_count, sizeof(*entries))))
+    {
+        for (i = 0; i < header->bucket_count; ++i)
+        {
+            if (buckets[i].hash && disk_cache_entry_is_valid(cache, &buckets[i]))
+                entries[entry_count++] = buckets[i];
+        }
+        qsort(entries, entry_count, sizeof(*entries), disk_cache_bucket_compare_use);
+
+        for (kept = 0; kept < entry_count && kept < header->bucket_count / 2; ++kept)
+        {
+            entry_size = align((uint64_t)entries[kept].key_size + entries[kept].value_size, 8);
+            if (data_size + entry_size > budget)
+                break;
+            data_size += entry_size;
+        }
+
+        if (!(saved = vkd3d_malloc(data_size)))
+            kept = 0;
+    }
+
+    data_size = 0;
+    for (i = 0; i < kept; ++i)
+    {
+        entry_size = align((uint64_t)entries[i].key_size + entries[i].value_size, 8);
+        memcpy(saved + data_size, data + entries[i].offset, entry_size);
+        entries[i].offset = data_size;
+        data_size += entry_size;
+    }
+
+    memset(buckets, 0, header->bucket_count * sizeof(*buckets));
+    if (kept)
+        memcpy(data, saved, data_size);
+    header->data_size = data_size;
+    header->entry_count = kept;
+
+    for (i = 0; i < kept; ++i)
+    {
+        bucket = disk_cache_find_bucket(cache, data + entries[i].offset, entries[i].key_size, entries[i].hash);
+        *bucket = entries[i];
+    }
+
+    vkd3d_free(saved);
+    vkd3d_free(entries);
+    header->dirty = 0;
+}
+
+static bool disk_cache_get(struct vkd3d_shader_disk_cache *cache, const void *key, size_t key_size,
+        struct vkd3d_shader_code *out, struct vkd3d_shader_message_context *message_context)
+{
+    struct vkd3d_shader_disk_cache_header *header;
+    struct vkd3d_shader_disk_cache_bucket *bucket;
+    uint64_t hash = disk_cache_hash_key(key, key_size);
+    uint32_t code_size, messages_size;
+    const uint8_t *value;
+    void *code;
+
+    bucket = disk_cache_find_bucket(cache, key, key_size, hash);
+    if (!bucket || !bucket->hash)
+        return false;
+
+    value = disk_cache_data(cache) + bucket->offset + key_size;
+    if (vkd3d_hash_bytes(value, bucket->value_size, 0) != bucket->value_hash)
+    {
+        WARN("Cache entry %#"PRIx64" is corrupted.\n", hash);
+        return false;
+    }
+
+    if (bucket->value_size < sizeof(code_size))
+        return false;
+    memcpy(&code_size, value, sizeof(code_size));
+    if (code_size > bucket->value_size - sizeof(code_size))
+        return false;
+    messages_size = bucket->value_size - sizeof(code_size) - code_size;
+
+    if (!(code = vkd3d_malloc(code_size)))
+        return false;
+    memcpy(code, value + sizeof(code_size), code_size);
+    if (messages_size && vkd3d_string_buffer_printf(&message_context->messages, "%.*s",
+            (int)messages_size, (const char *)value + sizeof(code_size) + code_size) < 0)
+    {
+        vkd3d_free(code);
+        return false;
+    }
+    out->code = code;
+    out->size = code_size;
+
+    header = disk_cache_header(cache);
+    bucket->last_use = ++header->use_counter;
+
+    TRACE("Returning cached entry %#"PRIx64", size %u.\n", hash, bucket->value_size);
+    return true;
+}
+
+/* Returns false if the file could no longer be mapped. */
+static bool disk_cache_put(struct vkd3d_shader_disk_cache *cache,
+        const void *key, size_t key_size, const void *value, size_t value_size)
+{
+    struct vkd3d_shader_disk_cache_header *header = disk_cache_header(cache);
+    uint64_t hash = disk_cache_hash_key(key, key_size);
+    uint64_t entry_size, capacity, needed, size;
+    struct vkd3d_shader_disk_cache_bucket *bucket;
+    uint8_t *entry;
+
+    entry_size = align((uint64_t)key_size + value_size, 8);
+    capacity = header->max_size - header->data_offset;
+    if (key_size > UINT32_MAX || value_size > UINT32_MAX || entry_size > capacity / 4)
+    {
+        TRACE("Not caching entry %#"PRIx64", size %#"PRIx64".\n", hash, entry_size);
+        return true;
+    }
+
+    if (header->data_size + entry_size > capacity
+            || header->entry_count + 1 > header->bucket_count / 4 * 3)
+        disk_cache_evict(cache);
+
+    needed = header->data_offset + header->data_size + entry_size;
+    if (needed > header->file_size)
+    {
+        size = min(max(needed, header->file_size * 2), max(header->max_size, needed));
+        size = align(size, VKD3D_SHADER_DISK_CACHE_ALIGNMENT);
+        /* This unmaps the file, and "header" along with it. */
+        if (!disk_cache_map(cache, size))
+            return false;
+        header = disk_cache_header(cache);
+        header->file_size = size;
+    }
+
+    if (!(bucket = disk_cache_find_bucket(cache, key, key_size, hash)))
+    {
+        WARN("The cache index is corrupted, evicting all entries.\n");
+        disk_cache_evict(cache);
+        bucket = disk_cache_find_bucket(cache, key, key_size, hash);
+    }
+    if (!bucket->hash)
+        ++header->entry_count;
+
+    entry = disk_cache_data(cache) + header->data_size;
+    memcpy(entry, key, key_size);
+    memcpy(entry + key_size, value, value_size);
+
+    bucket->hash = hash;
+    bucket->offset = header->data_size;
+    bucket->key_size = key_size;
+    bucket->value_size = value_size;
+    bucket->value_hash = vkd3d_hash_bytes(value, value_size, 0);
+    bucket->last_use = ++header->use_counter;
+    header->data_size += entry_size;
+
+    TRACE("Stored entry %#"PRIx64", size %#zx.\n", hash, value_size);
+    return true;
+}
+
+static void put_u64(struct vkd3d_bytecode_buffer *buffer, uint64_t value)
+{
+    bytecode_put_bytes(buffer, &value, sizeof(value));
+}
+
+static void put_optional_string(struct vkd3d_bytecode_buffer *buffer, const char *string)
+{
+    size_t length = string ? strlen(string) + 1 : 0;
+
+    put_u32(buffer, length);
+    bytecode_put_bytes(buffer, string, length);
+}
+
+static void put_descriptor_binding(struct vkd3d_bytecode_buffer *buffer,
+        const struct vkd3d_shader_descriptor_binding *binding)
+{
+    put_u32(buffer, binding->set);
+    put_u32(buffer, binding->binding);
+    put_u32(buffer, binding->count);
+}
+
+static void put_interface_info(struct vkd3d_bytecode_buffer *buffer,
+        const struct vkd3d_shader_interface_info *info)
+{
+    unsigned int i;
+
+    put_u32(buffer, info->binding_count);
+    for (i = 0; i < info->binding_count; ++i)
+    {
+        const struct vkd3d_shader_resource_binding *b = &info->bindings[i];
+
+        put_u32(buffer, b->type);
+        put_u32(buffer, b->register_space);
+        put_u32(buffer, b->register_index);
+        put_u32(buffer, b->shader_visibility);
+        put_u32(buffer, b->flags);
+        put_descriptor_binding(buffer, &b->binding);
+    }
+
+    put_u32(buffer, info->push_constant_buffer_count);
+    for (i = 0; i < info->push_constant_buffer_count; ++i)
+    {
+        const struct vkd3d_shader_push_constant_buffer *b = &info->push_constant_buffers[i];
+
+        put_u32(buffer, b->register_space);
+        put_u32(buffer, b->register_index);
+        put_u32(buffer, b->shader_visibility);
+        put_u32(buffer, b->offset);
+        put_u32(buffer, b->size);
+    }
+
+    put_u32(buffer, info->combined_sampler_count);
+    for (i = 0; i < info->combined_sampler_count; ++i)
+    {
+        const struct vkd3d_shader_combined_resource_sampler *s = &info->combined_samplers[i];
+
+        put_u32(buffer, s->resource_space);
+        put_u32(buffer, s->resource_index);
+        put_u32(buffer, s->sampler_space);
+        put_u32(buffer, s->sampler_index);
+        put_u32(buffer, s->shader_visibility);
+        put_u32(buffer, s->flags);
+        put_descriptor_binding(buffer, &s->binding);
+    }
+
+    put_u32(buffer, info->uav_counter_count);
+    for (i = 0; i < info->uav_counter_count; ++i)
+    {
+        const struct vkd3d_shader_uav_counter_binding *c = &info->uav_counters[i];
+
+        put_u32(buffer, c->register_space);
+        put_u32(buffer, c->register_index);
+        put_u32(buffer, c->shader_visibility);
+        put_descriptor_binding(buffer, &c->binding);
+        put_u32(buffer, c->offset);
+    }
+}
+
+static void put_descriptor_offsets(struct vkd3d_bytecode_buffer *buffer,
+        const struct vkd3d_shader_descriptor_offset *offsets, unsigned int count)
+{
+    unsigned int i;
+
+    put_u32(buffer, offsets ? count : 0);
+    for (i = 0; offsets && i < count; ++i)
+    {
+        put_u32(buffer, offsets[i].static_offset);
+        put_u32(buffer, offsets[i].dynamic_offset_index);
+    }
+}
+
+static void put_spirv_target_info(struct vkd3d_bytecode_buffer *buffer,
+        const struct vkd3d_shader_spirv_target_info *info)
+{
+    unsigned int i;
+
+    put_optional_string(buffer, info->entry_point);
+    put_u32(buffer, info->environment);
+
+    put_u32(buffer, info->extension_count);
+    for (i = 0; i < info->extension_count; ++i)
+        put_u32(buffer, info->extensions[i]);
+
+    put_u32(buffer, info->parameter_count);
+    for (i = 0; i < info->parameter_count; ++i)
+    {
+        const struct vkd3d_shader_parameter *p = &info->parameters[i];
+
+        put_u32(buffer, p->name);
+        put_u32(buffer, p->type);
+        put_u32(buffer, p->data_type);
+        if (p->type == VKD3D_SHADER_PARAMETER_TYPE_SPECIALIZATION_CONSTANT)
+            put_u32(buffer, p->u.specialization_constant.id);
+        else
+            put_u32(buffer, p->u.immediate_constant.u.u32);
+    }
+
+    put_u32(buffer, info->dual_source_blending);
+    put_u32(buffer, info->output_swizzle_count);
+    for (i = 0; i < info->output_swizzle_count; ++i)
+        put_u32(buffer, info->output_swizzles[i]);
+}
+
+static bool put_parameter1(struct vkd3d_bytecode_buffer *buffer, const struct vkd3d_shader_parameter1 *p)
+{
+    put_u32(buffer, p->name);
+    put_u32(buffer, p->type);
+    put_u32(buffer, p->data_type);
+
+    switch (p->type)
+    {
+        case VKD3D_SHADER_PARAMETER_TYPE_IMMEDIATE_CONSTANT:
+            if (p->data_type == VKD3D_SHADER_PARAMETER_DATA_TYPE_FLOAT32_VEC4)
+                bytecode_put_bytes(buffer, p->u.immediate_constant.u.f32_vec4,
+                        sizeof(p->u.immediate_constant.u.f32_vec4));
+            else
+                put_u32(buffer, p->u.immediate_constant.u.u32);
+            return true;
+
+        case VKD3D_SHADER_PARAMETER_TYPE_SPECIALIZATION_CONSTANT:
+            put_u32(buffer, p->u.specialization_constant.id);
+            return true;
+
+        case VKD3D_SHADER_PARAMETER_TYPE_BUFFER:
+            put_u32(buffer, p->u.buffer.set);
+            put_u32(buffer, p->u.buffer.binding);
+            put_u32(buffer, p->u.buffer.offset);
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+/* Serialises everything affecting the output of the compilation. Returns
+ * false if the compile info contains anything we don't know how to key on,
+ * or structures the compiler writes output to. */
+static bool disk_cache_build_key(struct vkd3d_bytecode_buffer *buffer,
+        const struct vkd3d_shader_compile_info *compile_info, uint64_t config_flags)
+{
+    const struct vkd3d_shader_interface_info *interface_info;
+    const struct vkd3d_struct *s;
+    unsigned int i;
+
+    interface_info = vkd3d_find_struct(compile_info->next, INTERFACE_INFO);
+
+    put_u32(buffer, compile_info->source_type);
+    put_u32(buffer, compile_info->target_type);
+    put_u32(buffer, compile_info->log_level);
+    put_u64(buffer, config_flags);
+    put_optional_string(buffer, compile_info->source_name);
+    put_u32(buffer, compile_info->option_count);
+    for (i = 0; i < compile_info->option_count; ++i)
+    {
+        put_u32(buffer, compile_info->options[i].name);
+        put_u32(buffer, compile_info->options[i].value);
+    }
+
+    for (s = compile_info->next; s; s = s->next)
+    {
+        put_u32(buffer, s->type);
+
+        switch (s->type)
+        {
+            case VKD3D_SHADER_STRUCTURE_TYPE_INTERFACE_INFO:
+                put_interface_info(buffer, (const struct vkd3d_shader_interface_info *)s);
+                break;
+
+            case VKD3D_SHADER_STRUCTURE_TYPE_TRANSFORM_FEEDBACK_INFO:
+            {
+                const struct vkd3d_shader_transform_feedback_info *info = (const void *)s;
+
+                put_u32(buffer, info->element_count);
+                for (i = 0; i < info->element_count; ++i)
+                {
+                    const struct vkd3d_shader_transform_feedback_element *e = &info->elements[i];
+
+                    put_u32(buffer, e->stream_index);
+                    put_optional_string(buffer, e->semantic_name);
+                    put_u32(buffer, e->semantic_index);
+                    put_u32(buffer, e->component_index | e->component_count << 8 | e->output_slot << 16);
+                }
+                put_u32(buffer, info->buffer_stride_count);
+                for (i = 0; i < info->buffer_stride_count; ++i)
+                    put_u32(buffer, info->buffer_strides[i]);
+                break;
+            }
+
+            case VKD3D_SHADER_STRUCTURE_TYPE_DESCRIPTOR_OFFSET_INFO:
+            {
+                const struct vkd3d_shader_descriptor_offset_info *info = (const void *)s;
+
+                put_u32(buffer, info->descriptor_table_offset);
+                put_u32(buffer, info->descriptor_table_count);
+                put_descriptor_offsets(buffer, info->binding_offsets,
+                        interface_info ? interface_info->binding_count : 0);
+                put_descriptor_offsets(buffer, info->uav_counter_offsets,
+                        interface_info ? interface_info->uav_counter_count : 0);
+                break;
+            }
+
+            case VKD3D_SHADER_STRUCTURE_TYPE_SPIRV_TARGET_INFO:
+                put_spirv_target_info(buffer, (const struct vkd3d_shader_spirv_target_info *)s);
+                break;
+
+            case VKD3D_SHADER_STRUCTURE_TYPE_SPIRV_DOMAIN_SHADER_TARGET_INFO:
+            {
+                const struct vkd3d_shader_spirv_domain_shader_target_info *info = (const void *)s;
+
+                put_u32(buffer, info->output_primitive);
+                put_u32(buffer, info->partitioning);
+                break;
+            }
+
+            case VKD3D_SHADER_STRUCTURE_TYPE_VARYING_MAP_INFO:
+            {
+                const struct vkd3d_shader_varying_map_info *info = (const void *)s;
+
+                put_u32(buffer, info->varying_count);
+                for (i = 0; i < info->varying_count; ++i)
+                {
+                    put_u32(buffer, info->varying_map[i].output_signature_index);
+                    put_u32(buffer, info->varying_map[i].input_register_index);
+                    put_u32(buffer, info->varying_map[i].input_mask);
+                }
+                break;
+            }
+
+            case VKD3D_SHADER_STRUCTURE_TYPE_PARAMETER_INFO:
+            {
+                const struct vkd3d_shader_parameter_info *info = (const void *)s;
+
+                put_u32(buffer, info->parameter_count);
+                for (i = 0; i < info->parameter_count; ++i)
+                {
+                    if (!put_parameter1(buffer, &info->parameters[i]))
+                        return false;
+                }
+                break;
+            }
+
+            default:
+                TRACE("Not caching compilation with structure type %#x.\n", s->type);
+                return false;
+        }
+    }
+
+    put_u64(buffer, compile_info->source.size);
+    put_u64(buffer, vkd3d_hash_bytes(compile_info->source.code,
+            compile_info->source.size, VKD3D_SHADER_DISK_CACHE_SOURCE_SEED1));
+    put_u64(buffer, vkd3d_hash_bytes(compile_info->source.code,
+            compile_info->source.size, VKD3D_SHADER_DISK_CACHE_SOURCE_SEED2));
+
+    return !buffer->status;
+}
+
+/* Looks up the translation of compile_info in the disk cache, and appends the
+ * messages of the original compilation to "message_context" if found. On a
+ * miss, "key" is filled in if the result can be stored with
+ * vkd3d_shader_disk_cache_store(), and left empty otherwise. */
+bool vkd3d_shader_disk_cache_lookup(const struct vkd3d_shader_compile_info *compile_info, uint64_t config_flags,
+        struct vkd3d_bytecode_buffer *key, struct vkd3d_shader_code *out,
+        struct vkd3d_shader_message_context *message_context)
+{
+    bool found;
+
+    memset(key, 0, sizeof(*key));
+
+    if (compile_info->source_type != VKD3D_SHADER_SOURCE_DXBC_TPF
+            && compile_info->source_type != VKD3D_SHADER_SOURCE_DXBC_DXIL)
+        return false;
+    if (compile_info->target_type != VKD3D_SHADER_TARGET_SPIRV_BINARY)
+        return false;
+
+    if (!disk_cache_is_enabled(&disk_cache))
+        return false;
+
+    if (!disk_cache_build_key(key, compile_info, config_flags))
+    {
+        vkd3d_free(key->data);
+        memset(key, 0, sizeof(*key));
+        return false;
+    }
+
+    if (!disk_cache_begin(&disk_cache))
+        return false;
+    found = disk_cache_get(&disk_cache, key->data, key->size, out, message_context);
+    disk_cache_end(&disk_cache);
+
+    return found;
+}
+
+/* Stores "code" and the messages in "message_context" under "key". */
+void vkd3d_shader_disk_cache_store(const struct vkd3d_bytecode_buffer *key, const struct vkd3d_shader_code *code,
+        const struct vkd3d_shader_message_context *message_context)
+{
+    struct vkd3d_bytecode_buffer value = {0};
+
+    if (!key->size || code->size > UINT32_MAX)
+        return;
+
+    put_u32(&value, code->size);
+    bytecode_put_bytes_unaligned(&value, code->code, code->size);
+    bytecode_put_bytes_unaligned(&value, message_context->messages.buffer, message_context->messages.content_size);
+    if (value.status)
+    {
+        vkd3d_free(value.data);
+        return;
+    }
+
+    if (disk_cache_begin(&disk_cache))
+    {
+        if (disk_cache_put(&disk_cache, key->data, key->size, value.data, value.size))
+            disk_cache_end(&disk_cache);
+        else
+            disk_cache_disable(&disk_cache);
+    }
+    vkd3d_free(value.data);
+}
@@ -4917,6 +4917,7 @@ static bool hlsl_ctx_init(struct hlsl_ctx *ctx, struct vkd3d_shader_source_list
     ctx->location.source_name = source_files->sources[0];
     ctx->location.line = ctx->location.column = 1;
     vkd3d_string_buffer_cache_init(&ctx->string_buffers);
+    vkd3d_shader_arena_init(&ctx->arena);
 
     list_init(&ctx->scopes);
 
@@ -5046,6 +5047,8 @@ static void hlsl_ctx_cleanup(struct hlsl_ctx *ctx)
     }
 
     vkd3d_free(ctx->constant_defs.regs);
+
+    vkd3d_shader_arena_cleanup(&ctx->arena);
 }
 
 static int hlsl_ctx_parse(struct hlsl_ctx *ctx, struct vkd3d_shader_source_list *source_list,
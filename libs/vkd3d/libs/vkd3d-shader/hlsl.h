@@ -1100,6 +1100,8 @@ struct hlsl_ctx
     struct vkd3d_shader_message_context *message_context;
     /* Cache for temporary string allocations. */
     struct vkd3d_string_buffer_cache string_buffers;
+    /* Scratch memory for the codegen passes, released with the context. */
+    struct vkd3d_shader_arena arena;
     /* A value from enum vkd3d_result with the current success/failure result of the whole
      *   compilation.
      * It is initialized to VKD3D_OK and set to an error code in case a call to hlsl_fixme() or
@@ -1760,9 +1760,18 @@ struct copy_propagation_var_def
     struct copy_propagation_component_trace traces[];
 };
 
+struct copy_propagation_scope
+{
+    struct rb_tree var_defs;
+    /* The variable definitions are allocated from the context arena, and
+     * released when the scope is popped. */
+    struct vkd3d_shader_arena_mark arena_mark;
+};
+
 struct copy_propagation_state
 {
-    struct rb_tree *scope_var_defs;
+    struct hlsl_ctx *ctx;
+    struct copy_propagation_scope *scopes;
     size_t scope_count, scopes_capacity;
     struct hlsl_ir_node *stop;
     bool stopped;
@@ -1784,23 +1793,29 @@ static void copy_propagation_var_def_destroy(struct rb_entry *entry, void *conte
 
     for (i = 0; i < component_count; ++i)
         vkd3d_free(var_def->traces[i].records);
-    vkd3d_free(var_def);
 }
 
 static size_t copy_propagation_push_scope(struct copy_propagation_state *state, struct hlsl_ctx *ctx)
 {
-    if (!(hlsl_array_reserve(ctx, (void **)&state->scope_var_defs, &state->scopes_capacity,
-            state->scope_count + 1, sizeof(*state->scope_var_defs))))
+    struct copy_propagation_scope *scope;
+
+    if (!(hlsl_array_reserve(ctx, (void **)&state->scopes, &state->scopes_capacity,
+            state->scope_count + 1, sizeof(*state->scopes))))
         return false;
 
-    rb_init(&state->scope_var_defs[state->scope_count++], copy_propagation_var_def_compare);
+    scope = &state->scopes[state->scope_count++];
+    rb_init(&scope->var_defs, copy_propagation_var_def_compare);
+    vkd3d_shader_arena_get_mark(&ctx->arena, &scope->arena_mark);
 
     return state->scope_count;
 }
 
 static size_t copy_propagation_pop_scope(struct copy_propagation_state *state)
 {
-    rb_destroy(&state->scope_var_defs[--state->scope_count], copy_propagation_var_def_destroy, NULL);
+    struct copy_propagation_scope *scope = &state->scopes[--state->scope_count];
+
+    rb_destroy(&scope->var_defs, copy_propagation_var_def_destroy, NULL);
+    vkd3d_shader_arena_rewind(&state->ctx->arena, &scope->arena_mark);
 
     return state->scope_count;
 }
@@ -1808,6 +1823,7 @@ static size_t copy_propagation_pop_scope(struct copy_propagation_state *state)
 static bool copy_propagation_state_init(struct copy_propagation_state *state, struct hlsl_ctx *ctx)
 {
     memset(state, 0, sizeof(*state));
+    state->ctx = ctx;
 
     return copy_propagation_push_scope(state, ctx);
 }
@@ -1816,7 +1832,7 @@ static void copy_propagation_state_destroy(struct copy_propagation_state *state)
 {
     while (copy_propagation_pop_scope(state));
 
-    vkd3d_free(state->scope_var_defs);
+    vkd3d_free(state->scopes);
 }
 
 static struct copy_propagation_value *copy_propagation_get_value_at_time(
@@ -1838,7 +1854,7 @@ static struct copy_propagation_value *copy_propagation_get_value(const struct co
 {
     for (size_t i = state->scope_count - 1; i < state->scope_count; i--)
     {
-        struct rb_tree *tree = &state->scope_var_defs[i];
+        struct rb_tree *tree = &state->scopes[i].var_defs;
         struct rb_entry *entry = rb_get(tree, var);
         if (entry)
         {
@@ -1865,7 +1881,7 @@ static struct copy_propagation_value *copy_propagation_get_value(const struct co
 static struct copy_propagation_var_def *copy_propagation_create_var_def(struct hlsl_ctx *ctx,
         struct copy_propagation_state *state, struct hlsl_ir_var *var)
 {
-    struct rb_tree *tree = &state->scope_var_defs[state->scope_count - 1];
+    struct rb_tree *tree = &state->scopes[state->scope_count - 1].var_defs;
     struct rb_entry *entry = rb_get(tree, var);
     struct copy_propagation_var_def *var_def;
     unsigned int component_count = hlsl_type_component_count(var->data_type);
@@ -1874,8 +1890,12 @@ static struct copy_propagation_var_def *copy_propagation_create_var_def(struct h
     if (entry)
         return RB_ENTRY_VALUE(entry, struct copy_propagation_var_def, entry);
 
-    if (!(var_def = hlsl_alloc(ctx, offsetof(struct copy_propagation_var_def, traces[component_count]))))
+    if (!(var_def = vkd3d_shader_arena_calloc(&ctx->arena, 1,
+            offsetof(struct copy_propagation_var_def, traces[component_count]))))
+    {
+        ctx->result = VKD3D_ERROR_OUT_OF_MEMORY;
         return NULL;
+    }
 
     var_def->var = var;
 
@@ -452,18 +452,15 @@ bool vsir_program_init(struct vsir_program *program, const struct vkd3d_shader_c
     }
 
     vkd3d_shader_source_list_init(&program->source_files);
+    vkd3d_shader_arena_init(&program->arena);
 
     return true;
 }
 
 void vsir_program_cleanup(struct vsir_program *program)
 {
-    size_t i;
-
     if (program->free_parameters)
         vkd3d_free((void *)program->parameters);
-    for (i = 0; i < program->block_name_count; ++i)
-        vkd3d_free((void *)program->block_names[i]);
     vkd3d_free(program->block_names);
     vkd3d_shader_source_list_cleanup(&program->source_files);
     shader_instruction_array_destroy(&program->instructions);
@@ -471,6 +468,7 @@ void vsir_program_cleanup(struct vsir_program *program)
     shader_signature_cleanup(&program->output_signature);
     shader_signature_cleanup(&program->patch_constant_signature);
     vkd3d_shader_free_scan_descriptor_info1(&program->descriptors);
+    vkd3d_shader_arena_cleanup(&program->arena);
 }
 
 const struct vkd3d_shader_parameter1 *vsir_program_get_parameter(
@@ -3587,6 +3585,7 @@ struct cf_flattener
     const char **block_names;
     size_t block_name_capacity;
     size_t block_name_count;
+    struct vkd3d_string_buffer block_name_buffer;
 
     unsigned int branch_id;
     unsigned int loop_id;
@@ -3784,7 +3783,7 @@ static struct cf_flattener_info *cf_flattener_find_innermost_breakable_cf_constr
 static void VKD3D_PRINTF_FUNC(3, 4) cf_flattener_create_block_name(struct cf_flattener *flattener,
         unsigned int block_id, const char *fmt, ...)
 {
-    struct vkd3d_string_buffer buffer;
+    struct vkd3d_string_buffer *buffer;
     size_t block_name_count;
     va_list args;
 
@@ -3798,12 +3797,13 @@ static void VKD3D_PRINTF_FUNC(3, 4) cf_flattener_create_block_name(struct cf_fla
             (block_name_count - flattener->block_name_count) * sizeof(*flattener->block_names));
     flattener->block_name_count = block_name_count;
 
-    vkd3d_string_buffer_init(&buffer);
+    buffer = &flattener->block_name_buffer;
+    vkd3d_string_buffer_clear(buffer);
     va_start(args, fmt);
-    vkd3d_string_buffer_vprintf(&buffer, fmt, args);
+    vkd3d_string_buffer_vprintf(buffer, fmt, args);
     va_end(args);
 
-    flattener->block_names[block_id] = buffer.buffer;
+    flattener->block_names[block_id] = vkd3d_shader_arena_strdup(&flattener->program->arena, buffer->buffer);
 }
 
 static enum vkd3d_result cf_flattener_iterate_instruction_array(struct cf_flattener *flattener,
@@ -4162,6 +4162,7 @@ static enum vkd3d_result vsir_program_flatten_control_flow_constructs(struct vsi
 
     VKD3D_ASSERT(program->cf_type == VSIR_CF_STRUCTURED);
 
+    vkd3d_string_buffer_init(&flattener.block_name_buffer);
     if ((result = cf_flattener_iterate_instruction_array(&flattener, message_context)) >= 0)
     {
         vkd3d_free(program->instructions.elements);
@@ -4177,6 +4178,7 @@ static enum vkd3d_result vsir_program_flatten_control_flow_constructs(struct vsi
     }
 
     vkd3d_free(flattener.control_flow_info);
+    vkd3d_string_buffer_cleanup(&flattener.block_name_buffer);
     /* Simpler to always free these in vsir_program_cleanup(). */
     program->block_names = flattener.block_names;
     program->block_name_count = flattener.block_name_count;
@@ -4612,7 +4614,8 @@ struct vsir_block
     uint32_t *dominates;
 };
 
-static enum vkd3d_result vsir_block_init(struct vsir_block *block, unsigned int label, size_t block_count)
+static enum vkd3d_result vsir_block_init(struct vsir_block *block, unsigned int label,
+        size_t block_count, struct vkd3d_shader_arena *arena)
 {
     size_t byte_count;
 
@@ -4627,7 +4630,7 @@ static enum vkd3d_result vsir_block_init(struct vsir_block *block, unsigned int
     vsir_block_list_init(&block->predecessors);
     vsir_block_list_init(&block->successors);
 
-    if (!(block->dominates = vkd3d_malloc(byte_count)))
+    if (!(block->dominates = vkd3d_shader_arena_alloc(arena, byte_count)))
         return VKD3D_ERROR_OUT_OF_MEMORY;
 
     memset(block->dominates, 0xff, byte_count);
@@ -4641,7 +4644,6 @@ static void vsir_block_cleanup(struct vsir_block *block)
         return;
     vsir_block_list_cleanup(&block->predecessors);
     vsir_block_list_cleanup(&block->successors);
-    vkd3d_free(block->dominates);
 }
 
 static int block_compare(const void *ptr1, const void *ptr2)
@@ -4850,6 +4852,10 @@ struct vsir_cfg
     struct vsir_cfg_structure_list structured_program;
 
     struct vsir_cfg_emit_target *target;
+
+    /* The block array, the dominance bitmaps and the loop header map are
+     * allocated from the program arena, and released in vsir_cfg_cleanup(). */
+    struct vkd3d_shader_arena_mark arena_mark;
 };
 
 static void vsir_cfg_cleanup(struct vsir_cfg *cfg)
@@ -4866,13 +4872,13 @@ static void vsir_cfg_cleanup(struct vsir_cfg *cfg)
 
     vsir_cfg_structure_list_cleanup(&cfg->structured_program);
 
-    vkd3d_free(cfg->blocks);
     vkd3d_free(cfg->loops);
-    vkd3d_free(cfg->loops_by_header);
     vkd3d_free(cfg->loop_intervals);
 
     if (TRACE_ON())
         vkd3d_string_buffer_cleanup(&cfg->debug_buffer);
+
+    vkd3d_shader_arena_rewind(&cfg->program->arena, &cfg->arena_mark);
 }
 
 static enum vkd3d_result vsir_cfg_add_loop_interval(struct vsir_cfg *cfg, unsigned int begin,
@@ -5062,7 +5068,8 @@ static enum vkd3d_result vsir_cfg_init(struct vsir_cfg *cfg, struct vsir_program
 
     vsir_block_list_init(&cfg->order);
 
-    if (!(cfg->blocks = vkd3d_calloc(cfg->block_count, sizeof(*cfg->blocks))))
+    vkd3d_shader_arena_get_mark(&program->arena, &cfg->arena_mark);
+    if (!(cfg->blocks = vkd3d_shader_arena_calloc(&program->arena, cfg->block_count, sizeof(*cfg->blocks))))
         return VKD3D_ERROR_OUT_OF_MEMORY;
 
     if (TRACE_ON())
@@ -5088,7 +5095,7 @@ static enum vkd3d_result vsir_cfg_init(struct vsir_cfg *cfg, struct vsir_program
                 VKD3D_ASSERT(label <= cfg->block_count);
                 current_block = &cfg->blocks[label - 1];
                 VKD3D_ASSERT(current_block->label == 0);
-                if ((ret = vsir_block_init(current_block, label, program->block_count)) < 0)
+                if ((ret = vsir_block_init(current_block, label, program->block_count, &program->arena)) < 0)
                     goto fail;
                 current_block->begin = &program->instructions.elements[i + 1];
                 if (!cfg->entry)
@@ -5274,7 +5281,8 @@ static enum vkd3d_result vsir_cfg_compute_loops(struct vsir_cfg *cfg)
 {
     size_t i, j, k;
 
-    if (!(cfg->loops_by_header = vkd3d_calloc(cfg->block_count, sizeof(*cfg->loops_by_header))))
+    if (!(cfg->loops_by_header = vkd3d_shader_arena_calloc(&cfg->program->arena,
+            cfg->block_count, sizeof(*cfg->loops_by_header))))
         return VKD3D_ERROR_OUT_OF_MEMORY;
     memset(cfg->loops_by_header, 0xff, cfg->block_count * sizeof(*cfg->loops_by_header));
 
@@ -985,6 +985,7 @@ struct vkd3d_spirv_builder
     uint32_t source_name_id;
     uint32_t main_function_id;
     struct rb_tree declarations;
+    struct vkd3d_shader_arena *arena;
     uint32_t type_sampler_id;
     uint32_t type_bool_id;
     uint32_t type_void_id;
@@ -1170,13 +1171,6 @@ static int vkd3d_spirv_declaration_compare(const void *key, const struct rb_entr
     return memcmp(&a->parameters, &b->parameters, a->parameter_count * sizeof(*a->parameters));
 }
 
-static void vkd3d_spirv_declaration_free(struct rb_entry *entry, void *context)
-{
-    struct vkd3d_spirv_declaration *d = RB_ENTRY_VALUE(entry, struct vkd3d_spirv_declaration, entry);
-
-    vkd3d_free(d);
-}
-
 static void vkd3d_spirv_insert_declaration(struct vkd3d_spirv_builder *builder,
         const struct vkd3d_spirv_declaration *declaration)
 {
@@ -1184,14 +1178,11 @@ static void vkd3d_spirv_insert_declaration(struct vkd3d_spirv_builder *builder,
 
     VKD3D_ASSERT(declaration->parameter_count <= ARRAY_SIZE(declaration->parameters));
 
-    if (!(d = vkd3d_malloc(sizeof(*d))))
+    if (!(d = vkd3d_shader_arena_alloc(builder->arena, sizeof(*d))))
         return;
     memcpy(d, declaration, sizeof(*d));
     if (rb_put(&builder->declarations, d, &d->entry) == -1)
-    {
         ERR("Failed to insert declaration entry.\n");
-        vkd3d_free(d);
-    }
 }
 
 static uint32_t vkd3d_spirv_build_once1(struct vkd3d_spirv_builder *builder,
@@ -2583,7 +2574,7 @@ static uint32_t vkd3d_spirv_get_type_id_for_data_type(struct vkd3d_spirv_builder
 }
 
 static void vkd3d_spirv_builder_init(struct vkd3d_spirv_builder *builder,
-        const char *entry_point, const char *source_name)
+        struct vkd3d_shader_arena *arena, const char *entry_point, const char *source_name)
 {
     vkd3d_spirv_stream_init(&builder->debug_stream);
     vkd3d_spirv_stream_init(&builder->annotation_stream);
@@ -2597,6 +2588,7 @@ static void vkd3d_spirv_builder_init(struct vkd3d_spirv_builder *builder,
     builder->current_id = 1;
 
     rb_init(&builder->declarations, vkd3d_spirv_declaration_compare);
+    builder->arena = arena;
 
     vkd3d_spirv_build_op_source(builder, source_name);
     builder->main_function_id = vkd3d_spirv_alloc_id(builder);
@@ -2626,7 +2618,7 @@ static void vkd3d_spirv_builder_free(struct vkd3d_spirv_builder *builder)
 
     vkd3d_free(builder->capabilities);
 
-    rb_destroy(&builder->declarations, vkd3d_spirv_declaration_free, NULL);
+    rb_destroy(&builder->declarations, NULL, NULL);
 
     vkd3d_free(builder->iface);
 }
@@ -2878,13 +2870,6 @@ static int vkd3d_symbol_compare(const void *key, const struct rb_entry *entry)
     return memcmp(&a->key, &b->key, sizeof(a->key));
 }
 
-static void vkd3d_symbol_free(struct rb_entry *entry, void *context)
-{
-    struct vkd3d_symbol *s = RB_ENTRY_VALUE(entry, struct vkd3d_symbol, entry);
-
-    vkd3d_free(s);
-}
-
 static void vkd3d_symbol_make_register(struct vkd3d_symbol *symbol,
         const struct vkd3d_shader_register *reg)
 {
@@ -2962,11 +2947,11 @@ static void vkd3d_symbol_make_combined_sampler(struct vkd3d_symbol *symbol,
     symbol->key.combined_sampler.sampler_index = sampler_index;
 }
 
-static struct vkd3d_symbol *vkd3d_symbol_dup(const struct vkd3d_symbol *symbol)
+static struct vkd3d_symbol *vkd3d_symbol_dup(struct vkd3d_shader_arena *arena, const struct vkd3d_symbol *symbol)
 {
     struct vkd3d_symbol *s;
 
-    if (!(s = vkd3d_malloc(sizeof(*s))))
+    if (!(s = vkd3d_shader_arena_alloc(arena, sizeof(*s))))
         return NULL;
 
     return memcpy(s, symbol, sizeof(*s));
@@ -3144,15 +3129,12 @@ static void spirv_compiler_destroy(struct spirv_compiler *compiler)
 
     vkd3d_spirv_builder_free(&compiler->spirv_builder);
 
-    rb_destroy(&compiler->symbol_table, vkd3d_symbol_free, NULL);
+    rb_destroy(&compiler->symbol_table, NULL, NULL);
 
     vkd3d_free(compiler->spec_constants);
 
     vkd3d_string_buffer_cache_cleanup(&compiler->string_buffers);
 
-    vkd3d_free(compiler->ssa_register_info);
-    vkd3d_free(compiler->block_label_ids);
-
     vkd3d_free(compiler);
 }
 
@@ -3192,7 +3174,7 @@ static struct spirv_compiler *spirv_compiler_create(struct vsir_program *program
         compiler->spirv_target_info = target_info;
     }
 
-    vkd3d_spirv_builder_init(&compiler->spirv_builder,
+    vkd3d_spirv_builder_init(&compiler->spirv_builder, &program->arena,
             spirv_compiler_get_entry_point_name(compiler), compile_info->source_name);
 
     compiler->formatting = VKD3D_SHADER_COMPILE_OPTION_FORMATTING_INDENT
@@ -3638,11 +3620,11 @@ static const struct vkd3d_symbol *spirv_compiler_put_symbol(struct spirv_compile
 {
     struct vkd3d_symbol *s;
 
-    s = vkd3d_symbol_dup(symbol);
+    if (!(s = vkd3d_symbol_dup(&compiler->program->arena, symbol)))
+        return NULL;
     if (rb_put(&compiler->symbol_table, s, &s->entry) == -1)
     {
         ERR("Failed to insert symbol entry (%s).\n", debug_vkd3d_symbol(symbol));
-        vkd3d_free(s);
         return NULL;
     }
     return s;
@@ -6499,7 +6481,8 @@ static void spirv_compiler_emit_temps(struct spirv_compiler *compiler, uint32_t
 static void spirv_compiler_allocate_ssa_register_ids(struct spirv_compiler *compiler, unsigned int count)
 {
     VKD3D_ASSERT(!compiler->ssa_register_info);
-    if (!(compiler->ssa_register_info = vkd3d_calloc(count, sizeof(*compiler->ssa_register_info))))
+    if (!(compiler->ssa_register_info = vkd3d_shader_arena_calloc(&compiler->program->arena,
+            count, sizeof(*compiler->ssa_register_info))))
     {
         ERR("Failed to allocate SSA register value id array, count %u.\n", count);
         spirv_compiler_error(compiler, VKD3D_SHADER_ERROR_SPV_OUT_OF_MEMORY,
@@ -8617,7 +8600,8 @@ static bool spirv_compiler_init_blocks(struct spirv_compiler *compiler, unsigned
 {
     compiler->block_count = block_count;
 
-    if (!(compiler->block_label_ids = vkd3d_calloc(block_count, sizeof(*compiler->block_label_ids))))
+    if (!(compiler->block_label_ids = vkd3d_shader_arena_calloc(&compiler->program->arena,
+            block_count, sizeof(*compiler->block_label_ids))))
         return false;
 
     return true;
@@ -22,6 +22,9 @@
 
 #include <stdio.h>
 #include <math.h>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
 
 static inline int char_to_int(char c)
 {
@@ -1935,15 +1938,23 @@ int vkd3d_shader_compile(const struct vkd3d_shader_compile_info *compile_info,
     {
         uint64_t config_flags = vkd3d_shader_init_config_flags();
         struct vkd3d_shader_code reflection_data = {0};
+        struct vkd3d_bytecode_buffer cache_key;
         struct vsir_program program;
 
-        if (!(ret = vsir_parse(compile_info, config_flags, &dump_data,
+        if (vkd3d_shader_disk_cache_lookup(compile_info, config_flags, &cache_key, out, &message_context))
+        {
+            ret = VKD3D_OK;
+        }
+        else if (!(ret = vsir_parse(compile_info, config_flags, &dump_data,
                 &message_context, &program, &reflection_data)))
         {
             ret = vsir_program_compile(&program, &reflection_data, config_flags, compile_info, out, &message_context);
+            if (ret >= 0)
+                vkd3d_shader_disk_cache_store(&cache_key, out, &message_context);
             vkd3d_shader_free_shader_code(&reflection_data);
             vsir_program_cleanup(&program);
         }
+        vkd3d_free(cache_key.data);
     }
 
     if (ret >= 0)
@@ -1956,6 +1967,139 @@ int vkd3d_shader_compile(const struct vkd3d_shader_compile_info *compile_info,
     return ret;
 }
 
+struct vkd3d_shader_batch
+{
+    const struct vkd3d_shader_compile_info *compile_infos;
+    struct vkd3d_shader_code *out;
+    char **messages;
+    int *results;
+    unsigned int count;
+    unsigned int next;
+};
+
+static void vkd3d_shader_batch_compile(struct vkd3d_shader_batch *batch)
+{
+    unsigned int i;
+
+    while ((i = vkd3d_atomic_increment_u32(&batch->next) - 1) < batch->count)
+        batch->results[i] = vkd3d_shader_compile(&batch->compile_infos[i],
+                &batch->out[i], batch->messages ? &batch->messages[i] : NULL);
+}
+
+static unsigned int vkd3d_shader_get_cpu_count(void)
+{
+#ifdef _WIN32
+    SYSTEM_INFO info;
+
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors;
+#else
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+
+    return count > 0 ? count : 1;
+#endif
+}
+
+#ifdef _WIN32
+static DWORD WINAPI vkd3d_shader_batch_thread(void *arg)
+{
+    vkd3d_shader_batch_compile(arg);
+    return 0;
+}
+#else
+static void *vkd3d_shader_batch_thread(void *arg)
+{
+    vkd3d_shader_batch_compile(arg);
+    return NULL;
+}
+#endif
+
+int vkd3d_shader_compile_batch(const struct vkd3d_shader_compile_info *compile_infos,
+        unsigned int count, unsigned int thread_count, struct vkd3d_shader_code *out, char **messages, int *results)
+{
+    struct vkd3d_shader_batch batch;
+    unsigned int i, started = 0;
+    int *results_buffer = NULL;
+    int ret = VKD3D_OK;
+#ifdef _WIN32
+    HANDLE *threads;
+#else
+    pthread_t *threads;
+#endif
+
+    TRACE("compile_infos %p, count %u, thread_count %u, out %p, messages %p, results %p.\n",
+            compile_infos, count, thread_count, out, messages, results);
+
+    if (!count)
+        return VKD3D_OK;
+
+    if (!results && !(results = results_buffer = vkd3d_calloc(count, sizeof(*results))))
+        return VKD3D_ERROR_OUT_OF_MEMORY;
+
+    batch.compile_infos = compile_infos;
+    batch.out = out;
+    batch.messages = messages;
+    batch.results = results;
+    batch.count = count;
+    batch.next = 0;
+
+    if (!thread_count)
+        thread_count = vkd3d_shader_get_cpu_count();
+    thread_count = min(thread_count, count);
+
+    /* The calling thread takes part in the compilation as well. If creating
+     * the other threads fails, it simply does more of the work. */
+    if (thread_count > 1 && (threads = vkd3d_calloc(thread_count - 1, sizeof(*threads))))
+    {
+        for (started = 0; started < thread_count - 1; ++started)
+        {
+#ifdef _WIN32
+            if (!(threads[started] = CreateThread(NULL, 0, vkd3d_shader_batch_thread, &batch, 0, NULL)))
+            {
+                WARN("Failed to create thread, error %lu.\n", GetLastError());
+                break;
+            }
+#else
+            int rc;
+
+            if ((rc = pthread_create(&threads[started], NULL, vkd3d_shader_batch_thread, &batch)))
+            {
+                WARN("Failed to create thread, error %d.\n", rc);
+                break;
+            }
+#endif
+        }
+    }
+    else
+    {
+        threads = NULL;
+    }
+
+    vkd3d_shader_batch_compile(&batch);
+
+    for (i = 0; i < started; ++i)
+    {
+#ifdef _WIN32
+        WaitForSingleObject(threads[i], INFINITE);
+        CloseHandle(threads[i]);
+#else
+        pthread_join(threads[i], NULL);
+#endif
+    }
+    vkd3d_free(threads);
+
+    TRACE("Compiled %u shaders using %u threads.\n", count, started + 1);
+
+    for (i = 0; i < count; ++i)
+    {
+        if ((ret = results[i]) < 0)
+            break;
+    }
+    vkd3d_free(results_buffer);
+
+    return ret < 0 ? ret : VKD3D_OK;
+}
+
 void vkd3d_shader_free_scan_combined_resource_sampler_info(
         struct vkd3d_shader_scan_combined_resource_sampler_info *info)
 {
@@ -2279,6 +2423,88 @@ void vkd3d_shader_set_log_callback(PFN_vkd3d_log callback)
     vkd3d_dbg_set_log_callback(callback);
 }
 
+void *vkd3d_shader_arena_alloc_chunk(struct vkd3d_shader_arena *arena, size_t size)
+{
+    size_t header_size = align(sizeof(struct vkd3d_shader_arena_chunk), VKD3D_SHADER_ARENA_ALIGNMENT);
+    struct vkd3d_shader_arena_chunk *chunk;
+    uint8_t *ptr;
+
+    if (size > SIZE_MAX / 2 - header_size)
+    {
+        ERR("Invalid allocation size %zu.\n", size);
+        return NULL;
+    }
+    size = align(size, VKD3D_SHADER_ARENA_ALIGNMENT);
+
+    /* Large allocations get a chunk of their own, so that the rest of the
+     * current chunk is not wasted. The chunk still goes at the head of the
+     * list, so that rewinding releases it. */
+    if (size > VKD3D_SHADER_ARENA_CHUNK_SIZE / 4)
+    {
+        if (!(chunk = vkd3d_malloc(header_size + size)))
+            return NULL;
+        chunk->next = arena->chunks;
+        arena->chunks = chunk;
+        return (uint8_t *)chunk + header_size;
+    }
+
+    if (!(chunk = vkd3d_malloc(header_size + VKD3D_SHADER_ARENA_CHUNK_SIZE)))
+        return NULL;
+    chunk->next = arena->chunks;
+    arena->chunks = chunk;
+
+    ptr = (uint8_t *)chunk + header_size;
+    arena->ptr = ptr + size;
+    arena->remaining = VKD3D_SHADER_ARENA_CHUNK_SIZE - size;
+    return ptr;
+}
+
+void *vkd3d_shader_arena_calloc(struct vkd3d_shader_arena *arena, size_t count, size_t size)
+{
+    void *ptr;
+
+    if (size && count > SIZE_MAX / size)
+    {
+        ERR("Invalid allocation size %zu x %zu.\n", count, size);
+        return NULL;
+    }
+
+    if ((ptr = vkd3d_shader_arena_alloc(arena, count * size)))
+        memset(ptr, 0, count * size);
+    return ptr;
+}
+
+char *vkd3d_shader_arena_strdup(struct vkd3d_shader_arena *arena, const char *string)
+{
+    size_t len = strlen(string) + 1;
+    char *ptr;
+
+    if ((ptr = vkd3d_shader_arena_alloc(arena, len)))
+        memcpy(ptr, string, len);
+    return ptr;
+}
+
+/* Release everything allocated after "mark" was taken. */
+void vkd3d_shader_arena_rewind(struct vkd3d_shader_arena *arena, const struct vkd3d_shader_arena_mark *mark)
+{
+    struct vkd3d_shader_arena_chunk *chunk;
+
+    while ((chunk = arena->chunks) != mark->chunks)
+    {
+        arena->chunks = chunk->next;
+        vkd3d_free(chunk);
+    }
+    arena->ptr = mark->ptr;
+    arena->remaining = mark->remaining;
+}
+
+void vkd3d_shader_arena_cleanup(struct vkd3d_shader_arena *arena)
+{
+    struct vkd3d_shader_arena_mark empty = {0};
+
+    vkd3d_shader_arena_rewind(arena, &empty);
+}
+
 static struct vkd3d_shader_param_node *shader_param_allocator_node_create(
         struct vkd3d_shader_param_allocator *allocator)
 {
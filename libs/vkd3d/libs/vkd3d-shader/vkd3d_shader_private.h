@@ -1393,6 +1393,67 @@ static inline bool register_is_ssa(const struct vkd3d_shader_register *reg)
     return reg->type == VKD3DSPR_SSA;
 }
 
+/* A bump allocator for data which lives until the end of a compilation, or
+ * until the arena is rewound to a previously taken mark. Individual
+ * allocations are never freed. */
+#define VKD3D_SHADER_ARENA_ALIGNMENT 16
+#define VKD3D_SHADER_ARENA_CHUNK_SIZE 0x4000
+
+struct vkd3d_shader_arena_chunk
+{
+    struct vkd3d_shader_arena_chunk *next;
+};
+
+struct vkd3d_shader_arena
+{
+    struct vkd3d_shader_arena_chunk *chunks;
+    uint8_t *ptr;
+    size_t remaining;
+};
+
+struct vkd3d_shader_arena_mark
+{
+    struct vkd3d_shader_arena_chunk *chunks;
+    uint8_t *ptr;
+    size_t remaining;
+};
+
+void *vkd3d_shader_arena_alloc_chunk(struct vkd3d_shader_arena *arena, size_t size);
+void *vkd3d_shader_arena_calloc(struct vkd3d_shader_arena *arena, size_t count, size_t size);
+void vkd3d_shader_arena_cleanup(struct vkd3d_shader_arena *arena);
+void vkd3d_shader_arena_rewind(struct vkd3d_shader_arena *arena, const struct vkd3d_shader_arena_mark *mark);
+char *vkd3d_shader_arena_strdup(struct vkd3d_shader_arena *arena, const char *string);
+
+static inline void vkd3d_shader_arena_init(struct vkd3d_shader_arena *arena)
+{
+    memset(arena, 0, sizeof(*arena));
+}
+
+static inline void *vkd3d_shader_arena_alloc(struct vkd3d_shader_arena *arena, size_t size)
+{
+    uint8_t *ptr;
+
+    /* "remaining" is always a multiple of the alignment, so the rounded
+     * size still fits. An exact fit goes through the slow path, which keeps
+     * zero-sized allocations on a fresh arena from returning NULL. */
+    if (size >= arena->remaining)
+        return vkd3d_shader_arena_alloc_chunk(arena, size);
+
+    ptr = arena->ptr;
+    size = align(size, VKD3D_SHADER_ARENA_ALIGNMENT);
+    arena->ptr += size;
+    arena->remaining -= size;
+    return ptr;
+}
+
+static inline void vkd3d_shader_arena_get_mark(const struct vkd3d_shader_arena *arena,
+        struct vkd3d_shader_arena_mark *mark)
+{
+    mark->chunks = arena->chunks;
+    mark->ptr = arena->ptr;
+    mark->remaining = arena->remaining;
+}
+
 struct vkd3d_shader_param_node
 {
     struct vkd3d_shader_param_node *next;
@@ -1599,6 +1660,9 @@ struct vsir_program
     struct vkd3d_shader_source_list source_files;
     const char **block_names;
     size_t block_name_count;
+
+    /* Nodes and scratch data which live until the program is cleaned up. */
+    struct vkd3d_shader_arena arena;
 };
 
 enum vkd3d_result vsir_allocate_temp_registers(struct vsir_program *program,
@@ -1837,6 +1901,12 @@ enum vkd3d_md5_variant
 
 void vkd3d_compute_md5(const void *dxbc, size_t size, uint32_t checksum[4], enum vkd3d_md5_variant variant);
 
+bool vkd3d_shader_disk_cache_lookup(const struct vkd3d_shader_compile_info *compile_info, uint64_t config_flags,
+        struct vkd3d_bytecode_buffer *key, struct vkd3d_shader_code *out,
+        struct vkd3d_shader_message_context *message_context);
+void vkd3d_shader_disk_cache_store(const struct vkd3d_bytecode_buffer *key, const struct vkd3d_shader_code *code,
+        const struct vkd3d_shader_message_context *message_context);
+
 int preproc_lexer_parse(const struct vkd3d_shader_compile_info *compile_info,
         struct vkd3d_shader_code *out, struct vkd3d_shader_message_context *message_context);
 
@@ -129,15 +129,7 @@ unsigned int vkd3d_shader_cache_decref(struct vkd3d_shader_cache *cache)
 
 static uint64_t vkd3d_shader_cache_hash_key(const void *key, size_t size)
 {
-    static const uint64_t fnv_prime = 0x00000100000001b3;
-    uint64_t hash = 0xcbf29ce484222325;
-    const uint8_t *k = key;
-    size_t i;
-
-    for (i = 0; i < size; ++i)
-        hash = (hash ^ k[i]) * fnv_prime;
-
-    return hash;
+    return vkd3d_hash_bytes(key, size, 0);
 }
 
 static void vkd3d_shader_cache_lock(struct vkd3d_shader_cache *cache)
@@ -123,6 +123,56 @@ static const struct object_ops shared_map_ops =
 
 static struct list shared_map_list = LIST_INIT( shared_map_list );
 
+/* file holding a relocated copy of a PE image, shared by all processes mapping it at the same address */
+struct reloc_map
+{
+    struct object   obj;             /* object header */
+    struct fd      *fd;              /* file descriptor of the mapped PE file */
+    file_pos_t      size;            /* size of the PE file when the copy was created */
+    time_t          ctime;           /* change time of the PE file when the copy was created */
+    unsigned int    ctime_nsec;      /* nanoseconds part of the change time */
+    struct file    *file;            /* temp file holding the relocated image, writable until filled */
+    struct file    *read_file;       /* read-only file for mapping the relocated image */
+    struct process *filler;          /* process filling the contents */
+    client_ptr_t    base;            /* address the image is relocated for */
+    int             state;           /* RELOC_MAP_* state */
+    struct list     entry;           /* entry in global reloc maps list */
+};
+
+#define RELOC_MAP_EMPTY    0         /* contents not filled yet */
+#define RELOC_MAP_FILLING  1         /* a client is filling the contents */
+#define RELOC_MAP_READY    2         /* contents can be mapped */
+
+static void reloc_map_dump( struct object *obj, int verbose );
+static void reloc_map_destroy( struct object *obj );
+
+static const struct object_ops reloc_map_ops =
+{
+    sizeof(struct reloc_map),  /* size */
+    &no_type,                  /* type */
+    reloc_map_dump,            /* dump */
+    no_add_queue,              /* add_queue */
+    NULL,                      /* remove_queue */
+    NULL,                      /* signaled */
+    NULL,                      /* satisfied */
+    no_signal,                 /* signal */
+    no_get_fd,                 /* get_fd */
+    default_get_sync,          /* get_sync */
+    default_map_access,        /* map_access */
+    default_get_sd,            /* get_sd */
+    default_set_sd,            /* set_sd */
+    no_get_full_name,          /* get_full_name */
+    no_lookup_name,            /* lookup_name */
+    no_link_name,              /* link_name */
+    NULL,                      /* unlink_name */
+    no_open_file,              /* open_file */
+    no_kernel_obj_list,        /* get_kernel_obj_list */
+    no_close_handle,           /* close_handle */
+    reloc_map_destroy          /* destroy */
+};
+
+static struct list reloc_map_list = LIST_INIT( reloc_map_list );
+
 /* memory view mapped in client address space */
 struct memory_view
 {
@@ -130,6 +180,7 @@ struct memory_view
     struct fd      *fd;              /* fd for mapped file */
     struct ranges  *committed;       /* list of committed ranges in this mapping */
     struct shared_map *shared;       /* temp file for shared PE mapping */
+    struct reloc_map *reloc;         /* temp file for relocated PE mapping */
     struct pe_image_info image;      /* image info (for PE image mapping) */
     unsigned int    flags;           /* SEC_* flags */
     client_ptr_t    base;            /* view base address (in process addr space) */
@@ -163,6 +214,7 @@ struct mapping
     struct pe_image_info image;      /* image info (for PE image mapping) */
     struct ranges       *committed;  /* list of committed ranges in this mapping */
     struct shared_map   *shared;     /* temp file for shared PE mapping */
+    struct reloc_map    *reloc;      /* temp file for relocated PE mapping */
     char                *exp_name;   /* export name (for PE image mapping) */
     data_size_t          exp_len;    /* length of export name (for PE image mapping) */
 };
@@ -302,6 +354,38 @@ static void shared_map_destroy( struct object *obj )
     list_remove( &shared->entry );
 }
 
+static void reloc_map_dump( struct object *obj, int verbose )
+{
+    struct reloc_map *reloc = (struct reloc_map *)obj;
+    fprintf( stderr, "Relocated mapping fd=%p file=%p base=%08x%08x state=%d\n",
+             reloc->fd, reloc->file, (unsigned int)(reloc->base >> 32), (unsigned int)reloc->base,
+             reloc->state );
+}
+
+static void reloc_map_destroy( struct object *obj )
+{
+    struct reloc_map *reloc = (struct reloc_map *)obj;
+
+    release_object( reloc->fd );
+    if (reloc->file) release_object( reloc->file );
+    release_object( reloc->read_file );
+    if (reloc->filler) release_object( reloc->filler );
+    list_remove( &reloc->entry );
+}
+
+/* set the state of a relocated mapping, dropping the writable file once it's filled */
+static void reloc_map_set_state( struct reloc_map *reloc, int state )
+{
+    reloc->state = state;
+    if (reloc->filler) release_object( reloc->filler );
+    reloc->filler = NULL;
+    if (state == RELOC_MAP_READY && reloc->file)
+    {
+        release_object( reloc->file );
+        reloc->file = NULL;
+    }
+}
+
 /* extend a file beyond the current end of file */
 int grow_file( int unix_fd, file_pos_t new_size )
 {
@@ -358,8 +442,8 @@ static int check_current_dir_for_exec(void)
     return (ret != MAP_FAILED);
 }
 
-/* create a temp file for anonymous mappings */
-static int create_temp_file( file_pos_t size )
+/* create a temp file for anonymous mappings, optionally with a second read-only fd to it */
+static int create_temp_file( file_pos_t size, int *read_fd )
 {
     static int temp_dir_fd = -1;
     char tmpfn[16];
@@ -383,7 +467,7 @@ static int create_temp_file( file_pos_t size )
     fd = make_temp_file( tmpfn );
     if (fd != -1)
     {
-        if (!grow_file( fd, size ))
+        if (!grow_file( fd, size ) || (read_fd && (*read_fd = open( tmpfn, O_RDONLY )) == -1))
         {
             close( fd );
             fd = -1;
@@ -486,6 +570,7 @@ static void free_memory_view( struct memory_view *view )
     if (view->fd) release_object( view->fd );
     if (view->committed) release_object( view->committed );
     if (view->shared) release_object( view->shared );
+    if (view->reloc) release_object( view->reloc );
     list_remove( &view->entry );
     free( view );
 }
@@ -510,6 +595,80 @@ static struct shared_map *get_shared_file( struct fd *fd )
     return NULL;
 }
 
+/* get the change time and size identifying the contents of a mapped file */
+static int get_reloc_file_id( struct fd *fd, file_pos_t *size, time_t *ctime, unsigned int *ctime_nsec )
+{
+    struct stat st;
+    int unix_fd;
+
+    if ((unix_fd = get_unix_fd( fd )) == -1) return 0;
+    if (fstat( unix_fd, &st ) == -1)
+    {
+        file_set_error();
+        return 0;
+    }
+    *size = st.st_size;
+    *ctime = st.st_ctime;
+#ifdef HAVE_STRUCT_STAT_ST_CTIM
+    *ctime_nsec = st.st_ctim.tv_nsec;
+#elif defined(HAVE_STRUCT_STAT_ST_CTIMESPEC)
+    *ctime_nsec = st.st_ctimespec.tv_nsec;
+#else
+    *ctime_nsec = 0;
+#endif
+    return 1;
+}
+
+/* find or create the relocated PE mapping for a given mapping and load address */
+static struct reloc_map *get_reloc_file( struct mapping *mapping, client_ptr_t base )
+{
+    struct reloc_map *reloc;
+    struct file *file, *read_file;
+    unsigned int ctime_nsec;
+    int unix_fd, read_fd;
+    file_pos_t size;
+    time_t ctime;
+
+    /* the file contents may have been replaced since the copy was made */
+    if (!get_reloc_file_id( mapping->fd, &size, &ctime, &ctime_nsec )) return NULL;
+
+    LIST_FOR_EACH_ENTRY( reloc, &reloc_map_list, struct reloc_map, entry )
+    {
+        if (reloc->base != base || !is_same_file_fd( reloc->fd, mapping->fd )) continue;
+        if (reloc->size != size || reloc->ctime != ctime || reloc->ctime_nsec != ctime_nsec) continue;
+        return (struct reloc_map *)grab_object( reloc );
+    }
+
+    if ((unix_fd = create_temp_file( mapping->image.map_size, &read_fd )) == -1) return NULL;
+    if (!(file = create_file_for_fd( unix_fd, FILE_GENERIC_READ|FILE_GENERIC_WRITE, 0 )))
+    {
+        close( read_fd );
+        return NULL;
+    }
+    if (!(read_file = create_file_for_fd( read_fd, FILE_GENERIC_READ|FILE_GENERIC_EXECUTE, 0 )))
+    {
+        release_object( file );
+        return NULL;
+    }
+    if (!(reloc = alloc_object( &reloc_map_ops )))
+    {
+        release_object( file );
+        release_object( read_file );
+        return NULL;
+    }
+    reloc->fd         = (struct fd *)grab_object( mapping->fd );
+    reloc->size       = size;
+    reloc->ctime      = ctime;
+    reloc->ctime_nsec = ctime_nsec;
+    reloc->file       = file;
+    reloc->read_file  = read_file;
+    reloc->filler     = NULL;
+    reloc->base       = base;
+    reloc->state      = RELOC_MAP_EMPTY;
+    list_add_head( &reloc_map_list, &reloc->entry );
+    return reloc;
+}
+
 /* return the size of the memory mapping and file range of a given section */
 static inline void get_section_sizes( const IMAGE_SECTION_HEADER *sec, size_t align_mask,
                                       size_t *map_size, off_t *file_start, size_t *file_size )
@@ -649,7 +808,7 @@ static int build_shared_mapping( struct mapping *mapping, size_t align_mask, int
 
     /* create a temp file for the mapping */
 
-    if ((shared_fd = create_temp_file( total_size )) == -1) return 0;
+    if ((shared_fd = create_temp_file( total_size, NULL )) == -1) return 0;
     if (!(file = create_file_for_fd( shared_fd, FILE_GENERIC_READ|FILE_GENERIC_WRITE, 0 ))) return 0;
 
     if (!(buffer = malloc( max_size ))) goto error;
@@ -1056,6 +1215,7 @@ static struct mapping *create_mapping( struct object *root, const struct unicode
     mapping->size        = size;
     mapping->fd          = NULL;
     mapping->shared      = NULL;
+    mapping->reloc       = NULL;
     mapping->committed   = NULL;
     mapping->exp_name    = NULL;
     mapping->exp_len     = 0;
@@ -1123,7 +1283,7 @@ static struct mapping *create_mapping( struct object *root, const struct unicode
         }
         if ((flags & SEC_RESERVE) && !(mapping->committed = create_ranges())) goto error;
         mapping->size = round_size( mapping->size, page_mask );
-        if ((unix_fd = create_temp_file( mapping->size )) == -1) goto error;
+        if ((unix_fd = create_temp_file( mapping->size, NULL )) == -1) goto error;
         if (!(mapping->fd = create_anonymous_fd( &mapping_fd_ops, unix_fd, &mapping->obj,
                                                  FILE_SYNCHRONOUS_IO_NONALERT ))) goto error;
         allow_fd_caching( mapping->fd );
@@ -1147,6 +1307,7 @@ struct mapping *create_fd_mapping( struct object *root, const struct unicode_str
     if (get_error() == STATUS_OBJECT_NAME_EXISTS) return mapping;  /* Nothing else to do */
 
     mapping->shared    = NULL;
+    mapping->reloc     = NULL;
     mapping->committed = NULL;
     mapping->exp_name  = NULL;
     mapping->exp_len   = 0;
@@ -1261,6 +1422,7 @@ static void mapping_destroy( struct object *obj )
     if (mapping->fd) release_object( mapping->fd );
     if (mapping->committed) release_object( mapping->committed );
     if (mapping->shared) release_object( mapping->shared );
+    if (mapping->reloc) release_object( mapping->reloc );
     free( mapping->exp_name );
 }
 
@@ -1599,6 +1761,73 @@ DECL_HANDLER(get_image_map_address)
     release_object( mapping );
 }
 
+/* get the file holding a relocated copy of an image mapping */
+DECL_HANDLER(get_image_reloc_file)
+{
+    struct mapping *mapping;
+    struct reloc_map *reloc;
+
+    if (!(mapping = get_mapping_obj( current->process, req->handle, SECTION_MAP_READ ))) return;
+
+    if (!(mapping->flags & SEC_IMAGE) || mapping->shared || !mapping->fd ||
+        is_fd_removable( mapping->fd ) || req->base == mapping->image.base)
+    {
+        set_error( STATUS_INVALID_PARAMETER );
+        goto done;
+    }
+
+    if (!(reloc = get_reloc_file( mapping, req->base ))) goto done;
+    if (mapping->reloc != reloc)
+    {
+        if (mapping->reloc) release_object( mapping->reloc );
+        mapping->reloc = (struct reloc_map *)grab_object( reloc );
+    }
+
+    /* don't wait forever for a process that died while filling the copy */
+    if (reloc->state == RELOC_MAP_FILLING && reloc->filler->end_time)
+        reloc_map_set_state( reloc, RELOC_MAP_EMPTY );
+
+    switch (reloc->state)
+    {
+    case RELOC_MAP_EMPTY:
+        /* the caller relocates the image itself and fills the file, it's the only one allowed to write it */
+        if ((reply->file = alloc_handle( current->process, reloc->file, GENERIC_READ|GENERIC_WRITE, 0 )))
+        {
+            reloc->state  = RELOC_MAP_FILLING;
+            reloc->filler = (struct process *)grab_object( current->process );
+            reply->ready  = 0;
+        }
+        break;
+    case RELOC_MAP_FILLING:
+        set_error( STATUS_PENDING );
+        break;
+    case RELOC_MAP_READY:
+        reply->file  = alloc_handle( current->process, reloc->read_file, GENERIC_READ|GENERIC_EXECUTE, 0 );
+        reply->ready = 1;
+        break;
+    }
+    release_object( reloc );
+
+done:
+    release_object( mapping );
+}
+
+/* mark the relocated copy of an image mapping as filled */
+DECL_HANDLER(set_image_reloc_file_ready)
+{
+    struct mapping *mapping;
+
+    if (!(mapping = get_mapping_obj( current->process, req->handle, SECTION_MAP_READ ))) return;
+
+    if (mapping->reloc && mapping->reloc->base == req->base && mapping->reloc->state == RELOC_MAP_FILLING &&
+        mapping->reloc->filler == current->process)
+        reloc_map_set_state( mapping->reloc, req->success ? RELOC_MAP_READY : RELOC_MAP_EMPTY );
+    else
+        set_error( STATUS_INVALID_PARAMETER );
+
+    release_object( mapping );
+}
+
 /* add a memory view in the current process */
 DECL_HANDLER(map_view)
 {
@@ -1632,6 +1861,7 @@ DECL_HANDLER(map_view)
         view->fd        = !is_fd_removable( mapping->fd ) ? (struct fd *)grab_object( mapping->fd ) : NULL;
         view->committed = mapping->committed ? (struct ranges *)grab_object( mapping->committed ) : NULL;
         view->shared    = NULL;
+        view->reloc     = NULL;
         add_process_view( current, view );
     }
 
@@ -1669,6 +1899,9 @@ DECL_HANDLER(map_image_view)
         view->fd        = !is_fd_removable( mapping->fd ) ? (struct fd *)grab_object( mapping->fd ) : NULL;
         view->committed = NULL;
         view->shared    = mapping->shared ? (struct shared_map *)grab_object( mapping->shared ) : NULL;
+        view->reloc     = NULL;
+        if (mapping->reloc && mapping->reloc->base == req->base && mapping->reloc->state == RELOC_MAP_READY)
+            view->reloc = (struct reloc_map *)grab_object( mapping->reloc );
         view->image     = mapping->image;
         if (add_process_view( current, view ))
         {
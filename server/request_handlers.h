@@ -74,6 +74,8 @@ DECL_HANDLER(create_mapping);
 DECL_HANDLER(open_mapping);
 DECL_HANDLER(get_mapping_info);
 DECL_HANDLER(get_image_map_address);
+DECL_HANDLER(get_image_reloc_file);
+DECL_HANDLER(set_image_reloc_file_ready);
 DECL_HANDLER(map_view);
 DECL_HANDLER(map_image_view);
 DECL_HANDLER(map_builtin_view);
@@ -384,6 +386,8 @@ static const req_handler req_handlers[REQ_NB_REQUESTS] =
     (req_handler)req_open_mapping,
     (req_handler)req_get_mapping_info,
     (req_handler)req_get_image_map_address,
+    (req_handler)req_get_image_reloc_file,
+    (req_handler)req_set_image_reloc_file_ready,
     (req_handler)req_map_view,
     (req_handler)req_map_image_view,
     (req_handler)req_map_builtin_view,
@@ -1099,6 +1103,16 @@ C_ASSERT( offsetof(struct get_image_map_address_request, handle) == 12 );
 C_ASSERT( sizeof(struct get_image_map_address_request) == 16 );
 C_ASSERT( offsetof(struct get_image_map_address_reply, addr) == 8 );
 C_ASSERT( sizeof(struct get_image_map_address_reply) == 16 );
+C_ASSERT( offsetof(struct get_image_reloc_file_request, handle) == 12 );
+C_ASSERT( offsetof(struct get_image_reloc_file_request, base) == 16 );
+C_ASSERT( sizeof(struct get_image_reloc_file_request) == 24 );
+C_ASSERT( offsetof(struct get_image_reloc_file_reply, file) == 8 );
+C_ASSERT( offsetof(struct get_image_reloc_file_reply, ready) == 12 );
+C_ASSERT( sizeof(struct get_image_reloc_file_reply) == 16 );
+C_ASSERT( offsetof(struct set_image_reloc_file_ready_request, handle) == 12 );
+C_ASSERT( offsetof(struct set_image_reloc_file_ready_request, base) == 16 );
+C_ASSERT( offsetof(struct set_image_reloc_file_ready_request, success) == 24 );
+C_ASSERT( sizeof(struct set_image_reloc_file_ready_request) == 32 );
 C_ASSERT( offsetof(struct map_view_request, mapping) == 12 );
 C_ASSERT( offsetof(struct map_view_request, access) == 16 );
 C_ASSERT( offsetof(struct map_view_request, base) == 24 );
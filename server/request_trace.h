@@ -900,6 +900,25 @@ static void dump_get_image_map_address_reply( const struct get_image_map_address
     dump_uint64( " addr=", &req->addr );
 }
 
+static void dump_get_image_reloc_file_request( const struct get_image_reloc_file_request *req )
+{
+    fprintf( stderr, " handle=%04x", req->handle );
+    dump_uint64( ", base=", &req->base );
+}
+
+static void dump_get_image_reloc_file_reply( const struct get_image_reloc_file_reply *req )
+{
+    fprintf( stderr, " file=%04x", req->file );
+    fprintf( stderr, ", ready=%d", req->ready );
+}
+
+static void dump_set_image_reloc_file_ready_request( const struct set_image_reloc_file_ready_request *req )
+{
+    fprintf( stderr, " handle=%04x", req->handle );
+    dump_uint64( ", base=", &req->base );
+    fprintf( stderr, ", success=%d", req->success );
+}
+
 static void dump_map_view_request( const struct map_view_request *req )
 {
     fprintf( stderr, " mapping=%04x", req->mapping );
@@ -3572,6 +3591,8 @@ static const dump_func req_dumpers[REQ_NB_REQUESTS] =
     (dump_func)dump_open_mapping_request,
     (dump_func)dump_get_mapping_info_request,
     (dump_func)dump_get_image_map_address_request,
+    (dump_func)dump_get_image_reloc_file_request,
+    (dump_func)dump_set_image_reloc_file_ready_request,
     (dump_func)dump_map_view_request,
     (dump_func)dump_map_image_view_request,
     (dump_func)dump_map_builtin_view_request,
@@ -3882,6 +3903,8 @@ static const dump_func reply_dumpers[REQ_NB_REQUESTS] =
     (dump_func)dump_open_mapping_reply,
     (dump_func)dump_get_mapping_info_reply,
     (dump_func)dump_get_image_map_address_reply,
+    (dump_func)dump_get_image_reloc_file_reply,
+    NULL,
     NULL,
     NULL,
     NULL,
@@ -4192,6 +4215,8 @@ static const char * const req_names[REQ_NB_REQUESTS] =
     "open_mapping",
     "get_mapping_info",
     "get_image_map_address",
+    "get_image_reloc_file",
+    "set_image_reloc_file_ready",
     "map_view",
     "map_image_view",
     "map_builtin_view",